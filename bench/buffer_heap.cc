@@ -0,0 +1,351 @@
+// Allocation latency and fragmentation of buffer sub-allocation. A set of
+// live buffers, sized log-uniformly from 256 B to 64 KiB, is churned in
+// rounds: free a batch of random buffers, then allocate as many new ones.
+//
+//   device buffers   one SoftwareDevice::newBuffer per buffer, the way
+//                    every buffer is its own driver allocation today.
+//   tlsf             TlsfAllocator alone over one range, 256 B granularity.
+//   tlsf, aligned    the same with one request in eight 64 KiB aligned.
+//   buffer heap      BufferHeap placing buffers in 64 MiB software heaps.
+//
+// "alloc ns" and "free ns" are per call. Fragmentation is the share of free
+// space outside the largest free block. Every live buffer is checked for its
+// size and alignment and against overlapping another. The "defragment" line
+// moves the aligned TLSF run's defragmentation candidates down where they
+// can go and shows what that recovered; "trim" releases the emptied heaps.
+//
+//   bench_buffer_heap [live buffers] [rounds]
+#include <Gfx/BufferHeap.hpp>
+#include <Gfx/SoftwareBackend.hpp>
+#include <Gfx/TlsfAllocator.hpp>
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdint>
+#include <cstdlib>
+#include <iomanip>
+#include <iostream>
+#include <memory>
+#include <random>
+#include <string>
+#include <utility>
+#include <vector>
+
+namespace {
+
+using Clock = std::chrono::steady_clock;
+
+constexpr std::size_t kBatch = 512;
+constexpr std::uint64_t kGranularity = 256;
+constexpr std::uint64_t kLargeAlignment = 64 * 1024;
+constexpr std::uint64_t kRangeSize = std::uint64_t{192} << 20;
+
+double seconds(Clock::time_point start) {
+  return std::chrono::duration<double>(Clock::now() - start).count();
+}
+
+struct Request {
+  std::uint64_t size;
+  std::uint64_t alignment;
+};
+
+// Drawn up front so the timed loops only allocate and free. Victims are
+// indices into the live set as it shrinks over a batch of frees.
+struct Workload {
+  std::vector<Request> requests;
+  std::vector<std::uint32_t> victims;
+};
+
+Workload makeWorkload(std::size_t live, int rounds, bool aligned) {
+  std::mt19937_64 random(11);
+  std::uniform_real_distribution<double> exponent(8.0, 16.0);
+  Workload workload;
+  const std::size_t requestCount = live + kBatch * rounds;
+  workload.requests.reserve(requestCount);
+  for (std::size_t i = 0; i < requestCount; ++i) {
+    const auto size = static_cast<std::uint64_t>(std::exp2(exponent(random)));
+    const bool large = aligned && random() % 8 == 0;
+    workload.requests.push_back(
+        {size, large ? kLargeAlignment : kGranularity});
+  }
+  workload.victims.reserve(kBatch * rounds);
+  for (int round = 0; round < rounds; ++round) {
+    for (std::size_t i = 0; i < kBatch; ++i) {
+      workload.victims.push_back(
+          static_cast<std::uint32_t>(random() % (live - i)));
+    }
+  }
+  return workload;
+}
+
+struct Result {
+  double allocNs;
+  double freeNs;
+  std::size_t failed;
+  bool correct;
+};
+
+struct Live {
+  std::uint64_t begin;
+  std::uint64_t end;
+  Request request;
+};
+
+// Sorted by address, nothing overlaps, and each range is large and aligned
+// enough for its request.
+bool checkRanges(std::vector<Live> ranges) {
+  std::sort(ranges.begin(), ranges.end(),
+            [](const Live &a, const Live &b) { return a.begin < b.begin; });
+  for (std::size_t i = 0; i < ranges.size(); ++i) {
+    const Live &range = ranges[i];
+    if (range.end - range.begin < range.request.size ||
+        range.begin % range.request.alignment != 0 ||
+        (i + 1 < ranges.size() && range.end > ranges[i + 1].begin)) {
+      return false;
+    }
+  }
+  return true;
+}
+
+// Adapter provides Handle, allocate(Request), free(Handle &) and
+// range(const Handle &) returning the address range the handle covers.
+template <typename Adapter>
+Result churn(Adapter &adapter, const Workload &workload, std::size_t live,
+             int rounds,
+             std::vector<std::pair<typename Adapter::Handle, Request>>
+                 &handles) {
+  std::size_t failed = 0;
+  std::size_t next = 0;
+  handles.clear();
+  handles.reserve(live);
+  for (; next < live; ++next) {
+    const Request &request = workload.requests[next];
+    handles.emplace_back(adapter.allocate(request), request);
+    failed += handles.back().first ? 0 : 1;
+  }
+
+  double allocSeconds = 0.0;
+  double freeSeconds = 0.0;
+  const std::uint32_t *pVictim = workload.victims.data();
+  for (int round = 0; round < rounds; ++round) {
+    Clock::time_point start = Clock::now();
+    for (std::size_t i = 0; i < kBatch; ++i) {
+      auto &victim = handles[*pVictim++];
+      adapter.free(victim.first);
+      victim = std::move(handles.back());
+      handles.pop_back();
+    }
+    freeSeconds += seconds(start);
+
+    start = Clock::now();
+    for (std::size_t i = 0; i < kBatch; ++i, ++next) {
+      const Request &request = workload.requests[next];
+      handles.emplace_back(adapter.allocate(request), request);
+    }
+    allocSeconds += seconds(start);
+    for (std::size_t i = live - kBatch; i < live; ++i) {
+      failed += handles[i].first ? 0 : 1;
+    }
+  }
+
+  std::vector<Live> ranges;
+  for (const auto &[handle, request] : handles) {
+    if (handle) {
+      const auto [begin, end] = adapter.range(handle);
+      ranges.push_back({begin, end, request});
+    }
+  }
+  const double calls = static_cast<double>(kBatch) * rounds;
+  return {allocSeconds / calls * 1e9, freeSeconds / calls * 1e9, failed,
+          checkRanges(std::move(ranges))};
+}
+
+template <typename Handle>
+std::size_t validCount(const std::vector<std::pair<Handle, Request>> &handles) {
+  return static_cast<std::size_t>(
+      std::count_if(handles.begin(), handles.end(), [](const auto &entry) {
+        return static_cast<bool>(entry.first);
+      }));
+}
+
+struct DeviceAdapter {
+  using Handle = std::unique_ptr<Gfx::Buffer>;
+
+  Handle allocate(const Request &request) {
+    return device.newBuffer(request.size);
+  }
+  static void free(Handle &handle) { handle.reset(); }
+  static std::pair<std::uint64_t, std::uint64_t> range(const Handle &handle) {
+    const auto begin = reinterpret_cast<std::uint64_t>(handle->contents());
+    return {begin, begin + handle->length()};
+  }
+
+  Gfx::SoftwareDevice device;
+};
+
+struct TlsfAdapter {
+  using Handle = Gfx::TlsfAllocator::Allocation;
+
+  Handle allocate(const Request &request) {
+    return allocator.allocate(request.size, request.alignment);
+  }
+  void free(Handle &handle) { allocator.free(handle); }
+  static std::pair<std::uint64_t, std::uint64_t> range(const Handle &handle) {
+    return {handle.offset, handle.offset + handle.size};
+  }
+
+  Gfx::TlsfAllocator allocator{kRangeSize, kGranularity};
+};
+
+struct HeapAdapter {
+  using Handle = Gfx::HeapBuffer;
+
+  Handle allocate(const Request &request) {
+    return heap.newBuffer(request.size);
+  }
+  static void free(Handle &handle) { handle.reset(); }
+  static std::pair<std::uint64_t, std::uint64_t> range(const Handle &handle) {
+    const auto begin =
+        reinterpret_cast<std::uint64_t>(handle.buffer()->contents());
+    return {begin, begin + handle.buffer()->length()};
+  }
+
+  Gfx::SoftwareDevice device;
+  Gfx::BufferHeap heap{&device};
+};
+
+void printRow(const std::string &name, const Result &result,
+              double heapMegabytes, std::size_t freeBlocks,
+              double largestFreeMegabytes, double fragmentation) {
+  std::cout << std::left << std::setw(16) << name << std::right
+            << std::setw(9) << result.allocNs << std::setw(9)
+            << result.freeNs << std::setw(8) << result.failed;
+  if (heapMegabytes > 0.0) {
+    std::cout << std::setw(9) << heapMegabytes << std::setw(8) << freeBlocks
+              << std::setw(10) << largestFreeMegabytes << std::setw(8)
+              << fragmentation * 100.0 << "%";
+  } else {
+    std::cout << std::setw(9) << "-" << std::setw(8) << "-" << std::setw(10)
+              << "-" << std::setw(9) << "-";
+  }
+  std::cout << "  " << (result.correct ? "ok" : "WRONG") << "\n";
+}
+
+}  // namespace
+
+int main(int argc, char *argv[]) {
+  const std::size_t live =
+      argc > 1 ? std::strtoull(argv[1], nullptr, 10) : 8192;
+  const int rounds = argc > 2 ? std::atoi(argv[2]) : 200;
+  if (live < kBatch) {
+    std::cerr << "need at least " << kBatch << " live buffers\n";
+    return EXIT_FAILURE;
+  }
+
+  const Workload workload = makeWorkload(live, rounds, false);
+  const Workload alignedWorkload = makeWorkload(live, rounds, true);
+  std::cout << live << " live buffers, " << rounds << " rounds of "
+            << kBatch << " frees and allocations\n"
+            << "allocator        alloc ns  free ns  failed  heap MB  blocks"
+               "  free max  fragm.  output\n"
+            << std::fixed << std::setprecision(1);
+  constexpr double kMegabyte = 1024.0 * 1024.0;
+  bool allCorrect = true;
+
+  {
+    DeviceAdapter adapter;
+    std::vector<std::pair<DeviceAdapter::Handle, Request>> handles;
+    const Result result = churn(adapter, workload, live, rounds, handles);
+    printRow("device buffers", result, 0.0, 0, 0.0, 0.0);
+    allCorrect = allCorrect && result.correct;
+  }
+
+  for (const bool aligned : {false, true}) {
+    TlsfAdapter adapter;
+    std::vector<std::pair<TlsfAdapter::Handle, Request>> handles;
+    const Result result = churn(adapter, aligned ? alignedWorkload : workload,
+                                live, rounds, handles);
+    const Gfx::TlsfAllocator::Statistics statistics =
+        adapter.allocator.statistics();
+    const bool consistent = statistics.allocationCount == validCount(handles);
+    printRow(aligned ? "tlsf, aligned" : "tlsf",
+             {result.allocNs, result.freeNs, result.failed,
+              result.correct && consistent},
+             statistics.size / kMegabyte, statistics.freeBlockCount,
+             statistics.largestFreeBlock / kMegabyte,
+             adapter.allocator.fragmentation());
+    allCorrect = allCorrect && result.correct && consistent;
+    if (!aligned) {
+      continue;
+    }
+
+    // Moves each candidate the way a copy would: allocate its new place,
+    // then free the old one. Moves that would not go down are undone.
+    const double before = adapter.allocator.fragmentation();
+    std::size_t moved = 0;
+    std::uint64_t movedBytes = 0;
+    for (const Gfx::TlsfAllocator::Allocation &candidate :
+         adapter.allocator.defragmentationCandidates(live / 4)) {
+      const auto it = std::find_if(
+          handles.begin(), handles.end(), [&candidate](const auto &entry) {
+            return entry.first.node == candidate.node;
+          });
+      const Gfx::TlsfAllocator::Allocation target =
+          adapter.allocator.allocate(it->second.size, it->second.alignment);
+      if (target.offset > candidate.offset) {
+        adapter.allocator.free(target);
+        continue;
+      }
+      if (!target) {
+        continue;
+      }
+      adapter.allocator.free(it->first);
+      it->first = target;
+      ++moved;
+      movedBytes += target.size;
+    }
+    std::vector<Live> ranges;
+    for (const auto &[handle, request] : handles) {
+      if (handle) {
+        ranges.push_back(
+            {handle.offset, handle.offset + handle.size, request});
+      }
+    }
+    const bool movedCorrect = checkRanges(std::move(ranges));
+    std::cout << "defragment: moved " << moved << " allocations ("
+              << movedBytes / kMegabyte << " MB), fragmentation "
+              << before * 100.0 << "% -> "
+              << adapter.allocator.fragmentation() * 100.0
+              << "%, free blocks " << statistics.freeBlockCount << " -> "
+              << adapter.allocator.statistics().freeBlockCount << "  "
+              << (movedCorrect ? "ok" : "WRONG") << "\n";
+    allCorrect = allCorrect && movedCorrect;
+  }
+
+  {
+    HeapAdapter adapter;
+    std::vector<std::pair<HeapAdapter::Handle, Request>> handles;
+    const Result result = churn(adapter, workload, live, rounds, handles);
+    const Gfx::BufferHeapStatistics statistics = adapter.heap.statistics();
+    const bool consistent = statistics.bufferCount == validCount(handles);
+    printRow("buffer heap",
+             {result.allocNs, result.freeNs, result.failed,
+              result.correct && consistent},
+             statistics.heapBytes / kMegabyte, statistics.freeBlockCount,
+             statistics.largestFreeBlock / kMegabyte,
+             statistics.fragmentation);
+    std::cout << "buffer heap: " << statistics.heapCount << " heaps, "
+              << statistics.usedBytes / kMegabyte << " MB placed for "
+              << statistics.requestedBytes / kMegabyte << " MB requested\n";
+    allCorrect = allCorrect && result.correct && consistent;
+    handles.clear();
+    const std::uint64_t released = adapter.heap.trim();
+    const bool trimmed = released == statistics.heapBytes &&
+                         adapter.heap.statistics().heapCount == 0;
+    std::cout << "trim: released " << released / kMegabyte << " MB  "
+              << (trimmed ? "ok" : "WRONG") << "\n";
+    allCorrect = allCorrect && trimmed;
+  }
+  return allCorrect ? EXIT_SUCCESS : EXIT_FAILURE;
+}
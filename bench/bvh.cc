@@ -0,0 +1,371 @@
+// Builds a Bvh over two million-triangle meshes and reports build time and
+// tree quality:
+//
+//   terrain  a displaced height-field grid, evenly tessellated.
+//   soup     small triangles scattered uniformly through a cube, the worst
+//            case for overlapping bounds.
+//
+// For each mesh the build runs on 1 to max threads; the SAH cost and node
+// count are compared against the single-threaded build, which they have to
+// match. Every tree built is checked to hold each triangle in exactly one
+// leaf whose bounds contain it, and to have every node's bounds contain its
+// children's. A second table shows how the bin count trades build time for
+// SAH cost. Finally rays and boxes are cast against the terrain and some of
+// the answers checked against brute force. Any failed check fails the run.
+//
+//   bench_bvh [triangles] [max threads]
+#include <Gfx/Bvh.hpp>
+#include <Gfx/JobSystem.hpp>
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdint>
+#include <cstdlib>
+#include <iomanip>
+#include <iostream>
+#include <random>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace {
+
+using Clock = std::chrono::steady_clock;
+
+constexpr int kBuilds = 3;
+constexpr std::size_t kRays = 100000;
+constexpr std::size_t kCheckedRays = 64;
+constexpr std::size_t kBoxes = 10000;
+constexpr std::size_t kCheckedBoxes = 64;
+
+double seconds(Clock::time_point start) {
+  return std::chrono::duration<double>(Clock::now() - start).count();
+}
+
+struct Mesh {
+  std::string name;
+  std::vector<Gfx::PackedFloat3> vertices;
+  std::vector<std::uint32_t> indices;
+
+  [[nodiscard]] std::size_t triangleCount() const {
+    return indices.size() / 3;
+  }
+};
+
+Mesh makeTerrain(std::size_t triangles) {
+  const auto side = static_cast<std::uint32_t>(
+      std::max(2.0, std::sqrt(static_cast<double>(triangles) / 2.0)));
+  Mesh mesh{"terrain", {}, {}};
+  mesh.vertices.reserve(static_cast<std::size_t>(side + 1) * (side + 1));
+  for (std::uint32_t y = 0; y <= side; ++y) {
+    for (std::uint32_t x = 0; x <= side; ++x) {
+      const float u = static_cast<float>(x) / static_cast<float>(side);
+      const float v = static_cast<float>(y) / static_cast<float>(side);
+      const float height = 0.1F * std::sin(u * 25.0F) * std::cos(v * 17.0F) +
+                           0.02F * std::sin(u * 140.0F + v * 90.0F);
+      mesh.vertices.push_back({u, height, v});
+    }
+  }
+  mesh.indices.reserve(static_cast<std::size_t>(side) * side * 6);
+  for (std::uint32_t y = 0; y < side; ++y) {
+    for (std::uint32_t x = 0; x < side; ++x) {
+      const std::uint32_t corner = y * (side + 1) + x;
+      mesh.indices.insert(mesh.indices.end(),
+                          {corner, corner + side + 1, corner + 1, corner + 1,
+                           corner + side + 1, corner + side + 2});
+    }
+  }
+  return mesh;
+}
+
+Mesh makeSoup(std::size_t triangles) {
+  std::mt19937 random(7);
+  std::uniform_real_distribution<float> position(0.0F, 1.0F);
+  const float size = 2.0F / std::cbrt(static_cast<float>(triangles));
+  std::uniform_real_distribution<float> offset(-size, size);
+  Mesh mesh{"soup", {}, {}};
+  mesh.vertices.reserve(triangles * 3);
+  mesh.indices.reserve(triangles * 3);
+  for (std::size_t i = 0; i < triangles; ++i) {
+    const Gfx::PackedFloat3 center{position(random), position(random),
+                                   position(random)};
+    for (int corner = 0; corner < 3; ++corner) {
+      mesh.indices.push_back(static_cast<std::uint32_t>(mesh.vertices.size()));
+      mesh.vertices.push_back({center.x + offset(random),
+                               center.y + offset(random),
+                               center.z + offset(random)});
+    }
+  }
+  return mesh;
+}
+
+// Best of kBuilds, in milliseconds.
+double build(Gfx::Bvh &bvh, const Mesh &mesh, Gfx::JobSystem *pJobSystem,
+             const Gfx::BvhBuildOptions &options) {
+  double best = INFINITY;
+  for (int i = 0; i < kBuilds; ++i) {
+    const auto start = Clock::now();
+    bvh.buildFromTriangles(mesh.vertices.data(), mesh.indices.data(),
+                           mesh.triangleCount(), pJobSystem, options);
+    best = std::min(best, seconds(start) * 1e3);
+  }
+  return best;
+}
+
+Gfx::AxisAlignedBoundingBox triangleBounds(const Mesh &mesh,
+                                           std::size_t triangle) {
+  Gfx::AxisAlignedBoundingBox bounds;
+  for (std::size_t corner = 0; corner < 3; ++corner) {
+    const Gfx::PackedFloat3 &p = mesh.vertices[mesh.indices[triangle * 3 +
+                                                            corner]];
+    bounds.min = {std::min(bounds.min.x, p.x), std::min(bounds.min.y, p.y),
+                  std::min(bounds.min.z, p.z)};
+    bounds.max = {std::max(bounds.max.x, p.x), std::max(bounds.max.y, p.y),
+                  std::max(bounds.max.z, p.z)};
+  }
+  return bounds;
+}
+
+bool contains(const Gfx::AxisAlignedBoundingBox &outer,
+              const Gfx::AxisAlignedBoundingBox &inner) {
+  return outer.min.x <= inner.min.x && outer.min.y <= inner.min.y &&
+         outer.min.z <= inner.min.z && outer.max.x >= inner.max.x &&
+         outer.max.y >= inner.max.y && outer.max.z >= inner.max.z;
+}
+
+// Whether every triangle is in exactly one leaf, whose bounds contain it,
+// and every interior node's bounds contain its children's.
+bool validTree(const Gfx::Bvh &bvh, const Mesh &mesh) {
+  const Gfx::BvhNodeArray &nodes = bvh.nodes();
+  const std::vector<std::uint32_t> &primitives = bvh.primitiveIndices();
+  if (nodes.empty() || primitives.size() != mesh.triangleCount()) {
+    return false;
+  }
+  std::vector<std::uint8_t> seen(mesh.triangleCount(), 0);
+  std::vector<std::uint32_t> stack = {0};
+  while (!stack.empty()) {
+    const Gfx::BvhNode &node = nodes[stack.back()];
+    stack.pop_back();
+    if (node.isLeaf()) {
+      if (std::size_t{node.leftFirst} + node.count > primitives.size()) {
+        return false;
+      }
+      for (std::uint32_t i = node.leftFirst; i < node.leftFirst + node.count;
+           ++i) {
+        const std::uint32_t triangle = primitives[i];
+        if (triangle >= seen.size() || seen[triangle]++ != 0 ||
+            !contains(node.bounds(), triangleBounds(mesh, triangle))) {
+          return false;
+        }
+      }
+      continue;
+    }
+    for (const std::uint32_t child : {node.leftFirst, node.leftFirst + 1}) {
+      if (child >= nodes.size() ||
+          !contains(node.bounds(), nodes[child].bounds())) {
+        return false;
+      }
+      stack.push_back(child);
+    }
+  }
+  return std::all_of(seen.begin(), seen.end(),
+                     [](std::uint8_t count) { return count == 1; });
+}
+
+// Returns whether every build matched the single-threaded one and was valid.
+bool scaling(const Mesh &mesh, std::size_t maxThreads) {
+  std::cout << "\n"
+            << mesh.name << ", " << mesh.triangleCount() << " triangles\n"
+            << std::setw(8) << "threads" << std::setw(10) << "ms"
+            << std::setw(10) << "Mtri/s" << std::setw(10) << "speedup"
+            << std::setw(10) << "nodes" << std::setw(10) << "SAH"
+            << std::setw(8) << "tree" << std::setw(7) << "valid" << "\n";
+  bool allOk = true;
+  double serialTime = 0.0;
+  std::size_t serialNodes = 0;
+  float serialCost = 0.0F;
+  for (std::size_t threads = 1; threads <= maxThreads; threads *= 2) {
+    Gfx::JobSystem jobSystem(threads);
+    Gfx::Bvh bvh;
+    const double time = build(bvh, mesh, &jobSystem, {});
+    if (threads == 1) {
+      serialTime = time;
+      serialNodes = bvh.nodes().size();
+      serialCost = bvh.sahCost();
+    }
+    // Only the summation order of the SAH cost depends on the thread count.
+    const bool same =
+        bvh.nodes().size() == serialNodes &&
+        std::abs(bvh.sahCost() - serialCost) <= 1e-5F * serialCost;
+    const bool valid = validTree(bvh, mesh);
+    std::cout << std::setw(8) << threads << std::fixed << std::setprecision(1)
+              << std::setw(10) << time << std::setw(10)
+              << static_cast<double>(mesh.triangleCount()) / time / 1e3
+              << std::setprecision(2) << std::setw(10) << serialTime / time
+              << std::setw(10) << bvh.nodes().size() << std::setw(10)
+              << bvh.sahCost() << std::setw(8) << (same ? "same" : "DIFFERS")
+              << std::setw(7) << (valid ? "ok" : "WRONG") << "\n";
+    allOk = allOk && same && valid;
+  }
+  return allOk;
+}
+
+// Returns whether every tree was valid.
+bool binCounts(const Mesh &mesh, Gfx::JobSystem &jobSystem) {
+  std::cout << "\n"
+            << mesh.name << " by bin count, " << jobSystem.threadCount()
+            << " threads\n"
+            << std::setw(8) << "bins" << std::setw(10) << "ms"
+            << std::setw(10) << "SAH" << std::setw(7) << "valid" << "\n";
+  bool allValid = true;
+  for (const std::uint32_t bins : {4U, 8U, 16U, 32U}) {
+    Gfx::Bvh bvh;
+    const double time = build(bvh, mesh, &jobSystem, {.binCount = bins});
+    const bool valid = validTree(bvh, mesh);
+    std::cout << std::setw(8) << bins << std::fixed << std::setprecision(1)
+              << std::setw(10) << time << std::setprecision(2)
+              << std::setw(10) << bvh.sahCost() << std::setw(7)
+              << (valid ? "ok" : "WRONG") << "\n";
+    allValid = allValid && valid;
+  }
+  return allValid;
+}
+
+struct Ray {
+  Gfx::Float4 origin;
+  Gfx::Float4 direction;
+};
+
+// Closest hit along ray, or infinity.
+float castRay(const Gfx::Bvh &bvh, const Mesh &mesh, const Ray &ray) {
+  float tMax = INFINITY;
+  bvh.raycast(ray.origin, ray.direction, tMax,
+              [&](std::uint32_t triangle, float &t) {
+                const std::uint32_t *pCorners = &mesh.indices[triangle * 3];
+                return Gfx::intersectTriangle(
+                    ray.origin, ray.direction, mesh.vertices[pCorners[0]],
+                    mesh.vertices[pCorners[1]], mesh.vertices[pCorners[2]],
+                    t, t);
+              });
+  return tMax;
+}
+
+float castRayBruteForce(const Mesh &mesh, const Ray &ray) {
+  float tMax = INFINITY;
+  for (std::size_t i = 0; i < mesh.indices.size(); i += 3) {
+    Gfx::intersectTriangle(ray.origin, ray.direction,
+                           mesh.vertices[mesh.indices[i]],
+                           mesh.vertices[mesh.indices[i + 1]],
+                           mesh.vertices[mesh.indices[i + 2]], tMax, tMax);
+  }
+  return tMax;
+}
+
+bool triangleOverlaps(const Mesh &mesh, std::size_t triangle,
+                      const Gfx::AxisAlignedBoundingBox &box) {
+  const Gfx::AxisAlignedBoundingBox bounds = triangleBounds(mesh, triangle);
+  return bounds.min.x <= box.max.x && bounds.max.x >= box.min.x &&
+         bounds.min.y <= box.max.y && bounds.max.y >= box.min.y &&
+         bounds.min.z <= box.max.z && bounds.max.z >= box.min.z;
+}
+
+// Returns whether every checked query matched brute force.
+bool queries(const Mesh &mesh, Gfx::JobSystem &jobSystem) {
+  Gfx::Bvh bvh;
+  build(bvh, mesh, &jobSystem, {});
+
+  // Rays from above, at random points of the terrain, slightly slanted.
+  std::mt19937 random(3);
+  std::uniform_real_distribution<float> unit(0.0F, 1.0F);
+  std::vector<Ray> rays(kRays);
+  for (Ray &ray : rays) {
+    const Gfx::Float4 target(unit(random), 0.0F, unit(random), 0.0F);
+    ray.origin = target + Gfx::Float4(0.3F * unit(random) - 0.15F, 1.0F,
+                                      0.3F * unit(random) - 0.15F, 0.0F);
+    const Gfx::Float4 direction = target - ray.origin;
+    ray.direction =
+        direction * (1.0F / std::sqrt(Gfx::dot3(direction, direction)));
+  }
+
+  std::size_t hits = 0;
+  auto start = Clock::now();
+  for (const Ray &ray : rays) {
+    hits += castRay(bvh, mesh, ray) != INFINITY ? 1 : 0;
+  }
+  const double rayTime = seconds(start);
+  std::size_t rayMatches = 0;
+  for (std::size_t i = 0; i < kCheckedRays; ++i) {
+    rayMatches += castRay(bvh, mesh, rays[i]) ==
+                          castRayBruteForce(mesh, rays[i])
+                      ? 1
+                      : 0;
+  }
+
+  std::vector<Gfx::AxisAlignedBoundingBox> boxes(kBoxes);
+  for (Gfx::AxisAlignedBoundingBox &box : boxes) {
+    const float x = unit(random);
+    const float z = unit(random);
+    box = {{x, -1.0F, z}, {x + 0.01F, 1.0F, z + 0.01F}};
+  }
+  // forEachOverlap reports the primitives of overlapping leaves; the exact
+  // test picks the triangles that overlap themselves.
+  const auto overlapping = [&](const Gfx::AxisAlignedBoundingBox &box) {
+    std::size_t count = 0;
+    bvh.forEachOverlap(box, [&](std::uint32_t triangle) {
+      count += triangleOverlaps(mesh, triangle, box) ? 1 : 0;
+    });
+    return count;
+  };
+  std::size_t found = 0;
+  start = Clock::now();
+  for (const Gfx::AxisAlignedBoundingBox &box : boxes) {
+    found += overlapping(box);
+  }
+  const double boxTime = seconds(start);
+  std::size_t boxMatches = 0;
+  for (std::size_t i = 0; i < kCheckedBoxes; ++i) {
+    std::size_t expected = 0;
+    for (std::size_t triangle = 0; triangle < mesh.triangleCount();
+         ++triangle) {
+      expected += triangleOverlaps(mesh, triangle, boxes[i]) ? 1 : 0;
+    }
+    boxMatches += overlapping(boxes[i]) == expected ? 1 : 0;
+  }
+
+  std::cout << "\n"
+            << mesh.name << " queries, one thread\n"
+            << std::fixed << std::setprecision(2) << "  rays:  "
+            << static_cast<double>(kRays) / rayTime / 1e6 << " Mrays/s, "
+            << hits << "/" << kRays << " hit, " << rayMatches << "/"
+            << kCheckedRays << " match brute force\n"
+            << "  boxes: " << static_cast<double>(kBoxes) / boxTime / 1e6
+            << " Mboxes/s, " << found << " overlaps, " << boxMatches << "/"
+            << kCheckedBoxes << " match brute force\n";
+  return rayMatches == kCheckedRays && boxMatches == kCheckedBoxes;
+}
+
+}  // namespace
+
+int main(int argc, char *argv[]) {
+  const std::size_t triangles =
+      argc > 1 ? static_cast<std::size_t>(std::max(2, std::atoi(argv[1])))
+               : 1000000;
+  const std::size_t maxThreads =
+      argc > 2 ? static_cast<std::size_t>(std::max(1, std::atoi(argv[2])))
+               : std::max(1U, std::thread::hardware_concurrency());
+
+  std::cout << "hardware threads: " << std::thread::hardware_concurrency()
+            << "\n";
+  const Mesh meshes[] = {makeTerrain(triangles), makeSoup(triangles)};
+  bool allOk = true;
+  for (const Mesh &mesh : meshes) {
+    allOk &= scaling(mesh, maxThreads);
+  }
+  Gfx::JobSystem jobSystem(maxThreads);
+  for (const Mesh &mesh : meshes) {
+    allOk &= binCounts(mesh, jobSystem);
+  }
+  allOk &= queries(meshes[0], jobSystem);
+  return allOk ? EXIT_SUCCESS : EXIT_FAILURE;
+}
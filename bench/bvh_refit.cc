@@ -0,0 +1,278 @@
+// Per-frame cost of keeping an InstanceBvh current while instances move,
+// against rebuilding it and refitting all of it.
+//
+// Every frame a number of random instances take a small step; the table
+// shows the time to set their transforms and refit, per frame and per moved
+// instance, on 1 to max threads. Afterwards the partially refit tree is
+// compared with a full refit of the same topology, which it has to match
+// exactly. Its bounds have to contain every instance, and rays cast into it
+// have to hit the same instances at the same distances as in a tree rebuilt
+// from scratch. The last lines show how far the SAH cost drifts when
+// instances keep wandering and the tree is only refit, checked the same way.
+// Any failed check fails the run.
+//
+//   bench_bvh_refit [instances] [max threads]
+#include <Gfx/InstanceBvh.hpp>
+#include <Gfx/JobSystem.hpp>
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdint>
+#include <cstdlib>
+#include <cstring>
+#include <iomanip>
+#include <iostream>
+#include <random>
+#include <thread>
+#include <utility>
+#include <vector>
+
+namespace {
+
+using Clock = std::chrono::steady_clock;
+
+constexpr int kFrames = 20;
+constexpr int kDriftFrames = 100;
+constexpr float kWorldSize = 1000.0F;
+constexpr std::size_t kCheckedRays = 256;
+
+double seconds(Clock::time_point start) {
+  return std::chrono::duration<double>(Clock::now() - start).count();
+}
+
+struct Scene {
+  explicit Scene(std::size_t instanceCount)
+      : localBounds(instanceCount), transforms(instanceCount) {
+    std::mt19937 random(11);
+    std::uniform_real_distribution<float> position(0.0F, kWorldSize);
+    std::uniform_real_distribution<float> size(0.5F, 2.0F);
+    std::uniform_real_distribution<float> angle(0.0F, 6.2831853F);
+    for (std::size_t i = 0; i < instanceCount; ++i) {
+      const float extent = size(random);
+      localBounds[i] = {{-extent, -extent, -extent}, {extent, extent, extent}};
+      transforms[i] =
+          (Gfx::Float4x4::translation(position(random), position(random),
+                                      position(random)) *
+           Gfx::Float4x4::rotation({0.0F, 1.0F, 0.0F}, angle(random)))
+              .toPacked();
+    }
+  }
+
+  std::vector<Gfx::AxisAlignedBoundingBox> localBounds;
+  std::vector<Gfx::PackedFloat4x3> transforms;
+};
+
+// Moves count random instances by up to step in each direction.
+void moveInstances(Gfx::InstanceBvh &bvh, std::size_t count, float step,
+                   std::mt19937 &random) {
+  std::uniform_int_distribution<std::uint32_t> pick(
+      0, static_cast<std::uint32_t>(bvh.instanceCount() - 1));
+  std::uniform_real_distribution<float> offset(-step, step);
+  for (std::size_t i = 0; i < count; ++i) {
+    const std::uint32_t instance = pick(random);
+    Gfx::PackedFloat4x3 transform = bvh.transform(instance);
+    transform.columns[3].x += offset(random);
+    transform.columns[3].y += offset(random);
+    transform.columns[3].z += offset(random);
+    bvh.setTransform(instance, transform);
+  }
+}
+
+// Whether every node matches a full refit of the same tree.
+bool matchesFullRefit(const Gfx::InstanceBvh &bvh) {
+  std::vector<Gfx::AxisAlignedBoundingBox> worldBounds(bvh.instanceCount());
+  for (std::uint32_t i = 0; i < worldBounds.size(); ++i) {
+    worldBounds[i] = bvh.worldBounds(i);
+  }
+  Gfx::Bvh reference = bvh.bvh();
+  reference.refit(worldBounds.data());
+  return std::memcmp(reference.nodes().data(), bvh.bvh().nodes().data(),
+                     reference.nodes().size() * sizeof(Gfx::BvhNode)) == 0;
+}
+
+bool contains(const Gfx::AxisAlignedBoundingBox &outer,
+              const Gfx::AxisAlignedBoundingBox &inner) {
+  return outer.min.x <= inner.min.x && outer.min.y <= inner.min.y &&
+         outer.min.z <= inner.min.z && outer.max.x >= inner.max.x &&
+         outer.max.y >= inner.max.y && outer.max.z >= inner.max.z;
+}
+
+// Whether every leaf contains the world bounds of its instances and every
+// interior node the bounds of its children.
+bool boundsContainInstances(const Gfx::InstanceBvh &bvh) {
+  const Gfx::BvhNodeArray &nodes = bvh.bvh().nodes();
+  const std::vector<std::uint32_t> &instances = bvh.bvh().primitiveIndices();
+  std::vector<std::uint32_t> stack = {0};
+  while (!stack.empty()) {
+    const Gfx::BvhNode &node = nodes[stack.back()];
+    stack.pop_back();
+    if (node.isLeaf()) {
+      for (std::uint32_t i = node.leftFirst; i < node.leftFirst + node.count;
+           ++i) {
+        if (!contains(node.bounds(), bvh.worldBounds(instances[i]))) {
+          return false;
+        }
+      }
+      continue;
+    }
+    for (const std::uint32_t child : {node.leftFirst, node.leftFirst + 1}) {
+      if (!contains(node.bounds(), nodes[child].bounds())) {
+        return false;
+      }
+      stack.push_back(child);
+    }
+  }
+  return true;
+}
+
+struct Hit {
+  float t = INFINITY;
+  std::uint32_t instance = 0;
+
+  bool operator==(const Hit &) const = default;
+};
+
+// Nearest instance whose world bounds the ray enters.
+Hit castRay(const Gfx::InstanceBvh &bvh, Gfx::Float4 origin,
+            Gfx::Float4 direction) {
+  Hit hit;
+  bvh.bvh().raycast(
+      origin, direction, hit.t, [&](std::uint32_t instance, float &tMax) {
+        const Gfx::AxisAlignedBoundingBox &box = bvh.worldBounds(instance);
+        const float *pMin = &box.min.x;
+        const float *pMax = &box.max.x;
+        float entry = 0.0F;
+        float exit = tMax;
+        for (int axis = 0; axis < 3; ++axis) {
+          float near = (pMin[axis] - origin[axis]) / direction[axis];
+          float far = (pMax[axis] - origin[axis]) / direction[axis];
+          if (near > far) {
+            std::swap(near, far);
+          }
+          entry = near > entry ? near : entry;
+          exit = far < exit ? far : exit;
+        }
+        if (entry > exit || entry >= tMax) {
+          return false;
+        }
+        tMax = entry;
+        hit.instance = instance;
+        return true;
+      });
+  return hit;
+}
+
+// Whether rays from outside the world, each aimed at a random instance, hit
+// the same instances at the same distances as in a tree rebuilt from the
+// current transforms.
+bool hitsMatchRebuild(const Gfx::InstanceBvh &bvh) {
+  Gfx::InstanceBvh rebuilt = bvh;
+  rebuilt.rebuild();
+  std::mt19937 random(17);
+  std::uniform_real_distribution<float> position(0.0F, kWorldSize);
+  std::uniform_int_distribution<std::uint32_t> pick(
+      0, static_cast<std::uint32_t>(bvh.instanceCount() - 1));
+  for (std::size_t i = 0; i < kCheckedRays; ++i) {
+    const Gfx::Float4 origin(-kWorldSize, position(random), position(random),
+                             0.0F);
+    const Gfx::AxisAlignedBoundingBox &box = bvh.worldBounds(pick(random));
+    const Gfx::Float4 target(0.5F * (box.min.x + box.max.x),
+                             0.5F * (box.min.y + box.max.y),
+                             0.5F * (box.min.z + box.max.z), 0.0F);
+    const Gfx::Float4 toTarget = target - origin;
+    const Gfx::Float4 direction =
+        toTarget * (1.0F / std::sqrt(Gfx::dot3(toTarget, toTarget)));
+    const Hit hit = castRay(bvh, origin, direction);
+    if (hit.t == INFINITY || !(hit == castRay(rebuilt, origin, direction))) {
+      return false;
+    }
+  }
+  return true;
+}
+
+}  // namespace
+
+int main(int argc, char *argv[]) {
+  const std::size_t instanceCount =
+      argc > 1 ? static_cast<std::size_t>(std::max(2, std::atoi(argv[1])))
+               : 1000000;
+  const std::size_t maxThreads =
+      argc > 2 ? static_cast<std::size_t>(std::max(1, std::atoi(argv[2])))
+               : std::max(1U, std::thread::hardware_concurrency());
+
+  const Scene scene(instanceCount);
+  std::cout << "hardware threads: " << std::thread::hardware_concurrency()
+            << ", instances: " << instanceCount << "\n";
+
+  {
+    Gfx::JobSystem jobSystem(maxThreads);
+    Gfx::InstanceBvh bvh;
+    auto start = Clock::now();
+    bvh.build(scene.localBounds.data(), scene.transforms.data(),
+              instanceCount, &jobSystem);
+    const double buildTime = seconds(start);
+    std::vector<std::uint32_t> all(instanceCount);
+    for (std::uint32_t i = 0; i < all.size(); ++i) {
+      all[i] = i;
+    }
+    std::mt19937 random(5);
+    moveInstances(bvh, instanceCount, 1.0F, random);
+    start = Clock::now();
+    bvh.refit(&jobSystem);
+    const double refitTime = seconds(start);
+    std::cout << std::fixed << std::setprecision(2) << "rebuild: "
+              << buildTime * 1e3 << " ms, refit of every instance: "
+              << refitTime * 1e3 << " ms, " << maxThreads << " threads\n";
+  }
+
+  std::cout << std::setw(10) << "moved" << std::setw(9) << "threads"
+            << std::setw(12) << "us/frame" << std::setw(14) << "ns/instance"
+            << std::setw(8) << "tree" << std::setw(8) << "bounds"
+            << std::setw(8) << "hits" << "\n";
+  bool allOk = true;
+  for (std::size_t moved = 1; moved <= instanceCount; moved *= 10) {
+    for (std::size_t threads = 1; threads <= maxThreads; threads *= 2) {
+      Gfx::JobSystem jobSystem(threads);
+      Gfx::InstanceBvh bvh;
+      bvh.build(scene.localBounds.data(), scene.transforms.data(),
+                instanceCount, &jobSystem);
+      std::mt19937 random(9);
+      const auto start = Clock::now();
+      for (int frame = 0; frame < kFrames; ++frame) {
+        moveInstances(bvh, moved, 1.0F, random);
+        bvh.refit(&jobSystem);
+      }
+      const double frameTime = seconds(start) / kFrames;
+      const bool exact = matchesFullRefit(bvh);
+      const bool bounded = boundsContainInstances(bvh);
+      const bool sameHits = hitsMatchRebuild(bvh);
+      std::cout << std::setw(10) << moved << std::setw(9) << threads
+                << std::fixed << std::setprecision(1) << std::setw(12)
+                << frameTime * 1e6 << std::setw(14)
+                << frameTime * 1e9 / static_cast<double>(moved)
+                << std::setw(8) << (exact ? "exact" : "DIFFERS")
+                << std::setw(8) << (bounded ? "ok" : "WRONG") << std::setw(8)
+                << (sameHits ? "same" : "DIFFERS") << "\n";
+      allOk = allOk && exact && bounded && sameHits;
+    }
+  }
+
+  // Every frame a tenth of the instances wander; only refit.
+  Gfx::InstanceBvh bvh;
+  bvh.build(scene.localBounds.data(), scene.transforms.data(), instanceCount);
+  const float builtCost = bvh.bvh().sahCost();
+  std::mt19937 random(13);
+  for (int frame = 0; frame < kDriftFrames; ++frame) {
+    moveInstances(bvh, instanceCount / 10, 5.0F, random);
+    bvh.refit();
+  }
+  const float driftedCost = bvh.bvh().sahCost();
+  const bool driftedOk = boundsContainInstances(bvh) && hitsMatchRebuild(bvh);
+  bvh.rebuild();
+  std::cout << std::setprecision(2) << "SAH after " << kDriftFrames
+            << " frames of refits: " << driftedCost << " (built: "
+            << builtCost << ", rebuilt: " << bvh.bvh().sahCost() << "), "
+            << (driftedOk ? "ok" : "WRONG") << "\n";
+  return allOk && driftedOk ? EXIT_SUCCESS : EXIT_FAILURE;
+}
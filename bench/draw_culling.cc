@@ -0,0 +1,210 @@
+// Cost of culling a scene of small boxes against a camera frustum and writing
+// the indirect draw arguments of the visible ones, once per SIMD level the
+// CPU supports:
+//
+//   serial   DrawCuller::cull() on the calling thread.
+//   xN       the same spread over a job system with N threads.
+//
+// Every box's draw has its index as baseInstance. The arguments are written
+// into a shared buffer behind their count, as a GPU would read them, and
+// checked against a double precision reference: every box clearly inside
+// the frustum must be drawn, in order and with its own arguments, and no box
+// clearly outside. Boxes within a rounding error of a plane may go either
+// way.
+//
+//   bench_draw_culling [objects] [max threads]
+#include <Gfx/DrawCuller.hpp>
+#include <Gfx/JobSystem.hpp>
+#include <Gfx/SoftwareBackend.hpp>
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdint>
+#include <cstdlib>
+#include <cstring>
+#include <iomanip>
+#include <iostream>
+#include <random>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace {
+
+using Clock = std::chrono::steady_clock;
+
+constexpr int kFrames = 20;
+// Where the count goes; the arguments follow it.
+constexpr std::size_t kArgumentsOffset = 16;
+// Reference distances within this of a plane are not checked.
+constexpr double kTolerance = 1e-2;
+
+double seconds(Clock::time_point start) {
+  return std::chrono::duration<double>(Clock::now() - start).count();
+}
+
+// Metal-style perspective projection looking down -z, clip z from 0 to w.
+Gfx::Float4x4 perspective(float fovY, float aspect, float near, float far) {
+  const float f = 1.0F / std::tan(fovY / 2.0F);
+  return {{{f / aspect, 0.0F, 0.0F, 0.0F},
+           {0.0F, f, 0.0F, 0.0F},
+           {0.0F, 0.0F, far / (near - far), -1.0F},
+           {0.0F, 0.0F, near * far / (near - far), 0.0F}}};
+}
+
+// Boxes of up to 4 units scattered over a 1000 unit cube around the camera.
+void fillScene(Gfx::DrawCuller &culler, std::size_t objectCount) {
+  culler.resize(objectCount);
+  std::mt19937 random(7);
+  std::uniform_real_distribution<float> position(-500.0F, 500.0F);
+  std::uniform_real_distribution<float> extent(0.25F, 2.0F);
+  std::uniform_int_distribution<std::uint32_t> indexCount(12, 3000);
+  for (std::size_t i = 0; i < objectCount; ++i) {
+    const float x = position(random);
+    const float y = position(random);
+    const float z = position(random);
+    const float e = extent(random);
+    culler.setBounds(i, {{x - e, y - e, z - e}, {x + e, y + e, z + e}});
+    Gfx::DrawIndexedPrimitivesIndirectArguments &arguments =
+        culler.indexedArguments()[i];
+    arguments.indexCount = indexCount(random) * 3;
+    arguments.indexStart = static_cast<std::uint32_t>(i % 64) * 9000;
+    arguments.baseVertex = static_cast<std::int32_t>(i % 16) * 1000;
+    arguments.baseInstance = static_cast<std::uint32_t>(i);
+  }
+}
+
+enum class Visibility : std::uint8_t { Inside, Outside, Either };
+
+std::vector<Visibility> reference(Gfx::DrawCuller &culler,
+                                  const Gfx::Frustum &frustum) {
+  std::vector<Visibility> visibility(culler.count());
+  for (std::size_t i = 0; i < culler.count(); ++i) {
+    const double min[3] = {culler.minX()[i], culler.minY()[i],
+                           culler.minZ()[i]};
+    const double max[3] = {culler.maxX()[i], culler.maxY()[i],
+                           culler.maxZ()[i]};
+    double nearest = 1e30;
+    for (const Gfx::Float4 &plane : frustum.planes) {
+      // Distance of the box corner furthest along the plane's normal.
+      double distance = plane.w();
+      for (int axis = 0; axis < 3; ++axis) {
+        distance +=
+            plane[axis] * (plane[axis] >= 0.0F ? max[axis] : min[axis]);
+      }
+      nearest = std::min(nearest, distance);
+    }
+    visibility[i] = nearest >= kTolerance    ? Visibility::Inside
+                    : nearest <= -kTolerance ? Visibility::Outside
+                                             : Visibility::Either;
+  }
+  return visibility;
+}
+
+bool check(Gfx::DrawCuller &culler, const std::vector<Visibility> &visibility,
+           Gfx::Buffer &buffer, std::uint32_t returnedCount) {
+  const auto *pContents = static_cast<const std::byte *>(buffer.contents());
+  std::uint32_t count = 0;
+  std::memcpy(&count, pContents, sizeof(count));
+  if (count != returnedCount) {
+    return false;
+  }
+  const auto *pArguments =
+      reinterpret_cast<const Gfx::DrawIndexedPrimitivesIndirectArguments *>(
+          pContents + kArgumentsOffset);
+  std::size_t next = 0;
+  for (std::uint32_t i = 0; i < count; ++i) {
+    const std::size_t object = pArguments[i].baseInstance;
+    if (object < next || object >= culler.count() ||
+        visibility[object] == Visibility::Outside ||
+        std::memcmp(&pArguments[i], &culler.indexedArguments()[object],
+                    sizeof(pArguments[i])) != 0) {
+      return false;
+    }
+    // Everything skipped since the previous draw must not be inside.
+    for (; next < object; ++next) {
+      if (visibility[next] == Visibility::Inside) {
+        return false;
+      }
+    }
+    next = object + 1;
+  }
+  for (; next < culler.count(); ++next) {
+    if (visibility[next] == Visibility::Inside) {
+      return false;
+    }
+  }
+  return true;
+}
+
+void printRow(const std::string &mode, std::size_t objectCount, double time,
+              std::uint32_t visibleCount, bool correct) {
+  std::cout << std::setw(14) << mode << std::fixed << std::setprecision(3)
+            << std::setw(10) << time * 1e3 << std::setprecision(0)
+            << std::setw(12) << static_cast<double>(objectCount) / time / 1e6
+            << std::setw(10) << visibleCount << std::setw(9)
+            << (correct ? "ok" : "WRONG") << "\n";
+}
+
+}  // namespace
+
+int main(int argc, char *argv[]) {
+  const std::size_t objectCount =
+      argc > 1 ? static_cast<std::size_t>(std::max(1, std::atoi(argv[1])))
+               : 1000000;
+  const std::size_t maxThreads =
+      argc > 2 ? static_cast<std::size_t>(std::max(1, std::atoi(argv[2])))
+               : std::max(1U, std::thread::hardware_concurrency());
+
+  Gfx::DrawCuller culler;
+  fillScene(culler, objectCount);
+  const Gfx::Float4x4 view =
+      Gfx::Float4x4::rotation({0.0F, 1.0F, 0.0F}, 0.6F);
+  const Gfx::Frustum frustum = Gfx::Frustum::fromViewProjection(
+      perspective(1.0F, 16.0F / 9.0F, 0.1F, 400.0F) * view);
+  const std::vector<Visibility> visibility = reference(culler, frustum);
+
+  Gfx::SoftwareBuffer buffer(kArgumentsOffset +
+                             objectCount * Gfx::indirectArgumentsSize(
+                                               culler.type()));
+  std::cout << "hardware threads: " << std::thread::hardware_concurrency()
+            << ", objects: " << objectCount << "\n"
+            << std::setw(14) << "mode" << std::setw(10) << "ms"
+            << std::setw(12) << "Mobjects/s" << std::setw(10) << "visible"
+            << std::setw(9) << "output" << "\n";
+  const Gfx::SimdLevel best = Gfx::simdLevel();
+  bool allCorrect = true;
+  for (const Gfx::SimdLevel level :
+       {Gfx::SimdLevel::Scalar, Gfx::SimdLevel::SSE, Gfx::SimdLevel::AVX2,
+        Gfx::SimdLevel::NEON}) {
+    if (!Gfx::setSimdLevel(level)) {
+      continue;
+    }
+    auto run = [&](const std::string &mode, Gfx::JobSystem *pJobSystem) {
+      std::uint32_t visibleCount = 0;
+      double bestTime = 1e30;
+      // The first, untimed frame faults the output pages in.
+      for (int frame = -1; frame < kFrames; ++frame) {
+        std::memset(buffer.contents(), 0xFF, kArgumentsOffset);
+        const auto start = Clock::now();
+        visibleCount =
+            culler.cull(frustum, &buffer, kArgumentsOffset, 0, pJobSystem);
+        if (frame >= 0) {
+          bestTime = std::min(bestTime, seconds(start));
+        }
+      }
+      const bool correct = check(culler, visibility, buffer, visibleCount);
+      printRow(mode, objectCount, bestTime, visibleCount, correct);
+      allCorrect = allCorrect && correct;
+    };
+    const std::string name = Gfx::simdLevelName(level);
+    run(name + " serial", nullptr);
+    for (std::size_t threads = 2; threads <= maxThreads; threads *= 2) {
+      Gfx::JobSystem jobSystem(threads);
+      run(name + " x" + std::to_string(threads), &jobSystem);
+    }
+  }
+  Gfx::setSimdLevel(best);
+  return allCorrect ? EXIT_SUCCESS : EXIT_FAILURE;
+}
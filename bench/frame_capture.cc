@@ -0,0 +1,180 @@
+// Throughput of frame readback with FrameCapture against the headless
+// software backend. Each frame is cleared to a color of its own and drawn
+// offscreen, then read back through the staging ring and encoded on the
+// worker thread:
+//
+//   present      Renderer::draw to a view, without capture, for reference.
+//   raw          the staging copy as is.
+//   png          8-bit RGBA PNG.
+//   png, drop    PNG, skipping frames while every staging buffer is busy.
+//
+// "loop fps" is the frame loop's rate and "capture fps" the rate of frames
+// encoded, measured until the last one is done. Every raw frame is compared
+// with its clear color and every PNG checked for its expected size. Files are
+// written only if a directory is given.
+//
+//   bench_frame_capture [width] [height] [frames] [directory]
+#include <Gfx/FrameCapture.hpp>
+#include <Gfx/PixelConversion.hpp>
+#include <Gfx/Renderer.hpp>
+#include <Gfx/SoftwareBackend.hpp>
+
+#include <chrono>
+#include <cstdint>
+#include <cstdlib>
+#include <cstring>
+#include <iomanip>
+#include <iostream>
+#include <string>
+#include <vector>
+
+namespace {
+
+using Clock = std::chrono::steady_clock;
+
+constexpr Gfx::PixelFormat kPixelFormat = Gfx::PixelFormat::BGRA8Unorm_sRGB;
+
+double seconds(Clock::time_point start) {
+  return std::chrono::duration<double>(Clock::now() - start).count();
+}
+
+Gfx::ClearColor frameColor(std::uint64_t frameIndex) {
+  const double red = static_cast<double>(frameIndex % 256) / 255.0;
+  return Gfx::ClearColor::Make(red, 0.5, 1.0 - red, 1.0);
+}
+
+struct Result {
+  double loopFps;
+  double captureFps;
+  std::uint64_t encoded;
+  std::uint64_t dropped;
+  std::size_t bytesPerFrame;
+  bool correct;
+};
+
+Result run(std::uint32_t width, std::uint32_t height, int frames,
+           Gfx::CaptureFileFormat fileFormat, bool dropWhenBusy,
+           const std::string &directory) {
+  Gfx::SoftwareDevice device;
+  Gfx::FrameCaptureDescriptor descriptor;
+  descriptor.width = width;
+  descriptor.height = height;
+  descriptor.pixelFormat = kPixelFormat;
+  descriptor.fileFormat = fileFormat;
+  descriptor.directory = directory;
+  descriptor.dropWhenBusy = dropWhenBusy;
+  Gfx::FrameCapture capture(&device, descriptor);
+  // Destroyed first: it waits for frames in flight, which draw into the
+  // capture's texture whether or not they were captured.
+  Gfx::Renderer renderer(&device);
+
+  // Only the worker thread touches these until finish() returns.
+  std::size_t bytesPerFrame = 0;
+  bool correct = true;
+  const std::size_t pixelCount = std::size_t{width} * height;
+  const std::size_t pixelSize = Gfx::bytesPerPixel(kPixelFormat);
+  // Scanlines in stored blocks of up to 65535 bytes with 5-byte headers, plus
+  // the signature, the chunks and the zlib header and checksum.
+  const std::size_t scanlineBytes = (1 + 4 * std::size_t{width}) * height;
+  const std::size_t pngSize =
+      scanlineBytes + (scanlineBytes + 65534) / 65535 * 5 + 76;
+  capture.setEncodedHandler([&](std::uint64_t frameIndex,
+                                const std::vector<std::uint8_t> &encoded) {
+    bytesPerFrame = encoded.size();
+    if (fileFormat == Gfx::CaptureFileFormat::Png) {
+      correct = correct && encoded.size() == pngSize;
+      return;
+    }
+    const Gfx::ClearColor color = frameColor(frameIndex);
+    const float rgba[4] = {
+        static_cast<float>(color.red), static_cast<float>(color.green),
+        static_cast<float>(color.blue), static_cast<float>(color.alpha)};
+    std::uint8_t expected[16];
+    Gfx::convertPixels(Gfx::PixelFormat::RGBA32Float, rgba, kPixelFormat,
+                       expected, 1);
+    correct = correct && encoded.size() == pixelCount * pixelSize;
+    for (std::size_t i = 0; correct && i < pixelCount; ++i) {
+      correct = std::memcmp(&encoded[i * pixelSize], expected, pixelSize) == 0;
+    }
+  });
+
+  const Clock::time_point start = Clock::now();
+  for (int frame = 0; frame < frames; ++frame) {
+    renderer.drawOffscreen(&capture,
+                           frameColor(static_cast<std::uint64_t>(frame)));
+  }
+  const double loopSeconds = seconds(start);
+  capture.finish();
+  const double captureSeconds = seconds(start);
+
+  const std::uint64_t encoded = capture.encodedFrameCount();
+  return {frames / loopSeconds,
+          static_cast<double>(encoded) / captureSeconds,
+          encoded,
+          capture.droppedFrameCount(),
+          bytesPerFrame,
+          correct};
+}
+
+double presentFps(std::uint32_t width, std::uint32_t height, int frames) {
+  Gfx::SoftwareDevice device;
+  Gfx::SoftwareView view(width, height, kPixelFormat);
+  Gfx::Renderer renderer(&device);
+  const Clock::time_point start = Clock::now();
+  for (int frame = 0; frame < frames; ++frame) {
+    view.setClearColor(frameColor(static_cast<std::uint64_t>(frame)));
+    renderer.draw(&view);
+  }
+  return frames / seconds(start);
+}
+
+}  // namespace
+
+int main(int argc, char *argv[]) {
+  const int widthArgument = argc > 1 ? std::atoi(argv[1]) : 1280;
+  const int heightArgument = argc > 2 ? std::atoi(argv[2]) : 720;
+  const int frames = argc > 3 ? std::atoi(argv[3]) : 200;
+  const std::string directory = argc > 4 ? argv[4] : "";
+  if (widthArgument <= 0 || heightArgument <= 0 || frames <= 0) {
+    std::cerr << "usage: bench_frame_capture [width] [height] [frames] "
+                 "[directory]\n"
+                 "width, height and frames must be positive\n";
+    return EXIT_FAILURE;
+  }
+  const auto width = static_cast<std::uint32_t>(widthArgument);
+  const auto height = static_cast<std::uint32_t>(heightArgument);
+
+  std::cout << frames << " frames of " << width << "x" << height << " "
+            << Gfx::pixelFormatName(kPixelFormat)
+            << (directory.empty() ? ", not written" : ", written to ")
+            << directory << "\n"
+            << "mode          loop fps  capture fps  encoded  dropped"
+               "  MB/frame  output\n"
+            << std::fixed << std::setprecision(1);
+  std::cout << "present    " << std::setw(11)
+            << presentFps(width, height, frames) << "\n";
+
+  struct Mode {
+    const char *pName;
+    Gfx::CaptureFileFormat fileFormat;
+    bool dropWhenBusy;
+  };
+  bool allCorrect = true;
+  for (const Mode &mode :
+       {Mode{"raw", Gfx::CaptureFileFormat::Raw, false},
+        Mode{"png", Gfx::CaptureFileFormat::Png, false},
+        Mode{"png, drop", Gfx::CaptureFileFormat::Png, true}}) {
+    const Result result =
+        run(width, height, frames, mode.fileFormat, mode.dropWhenBusy,
+            directory);
+    std::cout << std::left << std::setw(11) << mode.pName << std::right
+              << std::setw(11) << result.loopFps << std::setw(13)
+              << result.captureFps << std::setw(9) << result.encoded
+              << std::setw(9) << result.dropped << std::setw(10)
+              << std::setprecision(2) << result.bytesPerFrame / 1e6
+              << std::setprecision(1) << "  "
+              << (result.correct ? "ok" : "WRONG") << "\n";
+    allCorrect = allCorrect && result.correct;
+  }
+  return allCorrect ? EXIT_SUCCESS : EXIT_FAILURE;
+}
@@ -0,0 +1,48 @@
+// Measures the CPU cost of Renderer::draw against the headless software
+// backend.
+//
+//   bench_frame_loop [width] [height] [frames]
+#include <Gfx/Renderer.hpp>
+#include <Gfx/SoftwareBackend.hpp>
+
+#include <algorithm>
+#include <chrono>
+#include <cstdint>
+#include <cstdlib>
+#include <iostream>
+#include <vector>
+
+int main(int argc, char *argv[]) {
+  const auto width =
+      static_cast<std::uint32_t>(argc > 1 ? std::atoi(argv[1]) : 512);
+  const auto height =
+      static_cast<std::uint32_t>(argc > 2 ? std::atoi(argv[2]) : 512);
+  const int frames = argc > 3 ? std::atoi(argv[3]) : 2000;
+
+  Gfx::SoftwareDevice device;
+  Gfx::SoftwareView view(width, height, Gfx::PixelFormat::BGRA8Unorm_sRGB);
+  view.setClearColor(Gfx::ClearColor::Make(1.0, 1.0, 0.0, 1.0));
+  Gfx::Renderer renderer(&device);
+
+  std::vector<double> samples;
+  samples.reserve(static_cast<std::size_t>(frames));
+  for (int i = 0; i < frames; ++i) {
+    const auto start = std::chrono::steady_clock::now();
+    renderer.draw(&view);
+    const auto end = std::chrono::steady_clock::now();
+    samples.push_back(
+        std::chrono::duration<double, std::micro>(end - start).count());
+  }
+
+  std::sort(samples.begin(), samples.end());
+  double total = 0.0;
+  for (double sample : samples) {
+    total += sample;
+  }
+  std::cout << "frames:    " << view.presentedCount() << " (" << width << "x"
+            << height << ")\n"
+            << "mean:      " << total / static_cast<double>(frames) << " us\n"
+            << "p50:       " << samples[samples.size() / 2] << " us\n"
+            << "p99:       " << samples[samples.size() * 99 / 100] << " us\n";
+  return 0;
+}
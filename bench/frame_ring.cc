@@ -0,0 +1,54 @@
+// Shows how frame throughput scales with the depth of the renderer's frame
+// ring when the software backend simulates GPU completion latency.
+//
+//   bench_frame_ring [gpu latency us] [cpu work us] [frames]
+#include <Gfx/Renderer.hpp>
+#include <Gfx/SoftwareBackend.hpp>
+
+#include <chrono>
+#include <cstdlib>
+#include <iostream>
+
+namespace {
+
+void spinFor(std::chrono::microseconds duration) {
+  const auto end = std::chrono::steady_clock::now() + duration;
+  while (std::chrono::steady_clock::now() < end) {
+  }
+}
+
+}  // namespace
+
+int main(int argc, char *argv[]) {
+  const std::chrono::microseconds gpuLatency(argc > 1 ? std::atoi(argv[1])
+                                                      : 2000);
+  const std::chrono::microseconds cpuWork(argc > 2 ? std::atoi(argv[2])
+                                                   : 1500);
+  const int frames = argc > 3 ? std::atoi(argv[3]) : 300;
+
+  std::cout << "gpu latency " << gpuLatency.count() << " us, cpu work "
+            << cpuWork.count() << " us, " << frames << " frames\n";
+
+  for (std::size_t depth = 1; depth <= 4; ++depth) {
+    Gfx::SoftwareDevice device(gpuLatency);
+    Gfx::SoftwareView view(256, 256, Gfx::PixelFormat::BGRA8Unorm_sRGB,
+                           depth + 1);
+    const auto start = std::chrono::steady_clock::now();
+    {
+      Gfx::Renderer renderer(&device, depth);
+      // The simulated CPU work writes per-frame data, so it can only start
+      // once the frame's slot has been released by the GPU.
+      renderer.setFrameUpdateHandler(
+          [cpuWork](const Gfx::FrameResources &) { spinFor(cpuWork); });
+      for (int i = 0; i < frames; ++i) {
+        renderer.draw(&view);
+      }
+    }
+    const double seconds =
+        std::chrono::duration<double>(std::chrono::steady_clock::now() - start)
+            .count();
+    std::cout << "frames in flight " << depth << ": " << frames / seconds
+              << " fps\n";
+  }
+  return 0;
+}
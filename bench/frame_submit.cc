@@ -0,0 +1,103 @@
+// Counts backend messages, resource retains (each paired with a release on
+// completion), buffer allocations and time per draw call for scenes of
+// growing size, with command buffers that retain what they reference and with
+// the FrameSubmitter default of unretained references.
+//
+// Every draw binds its own vertex buffer plus the frame's uniform buffer.
+// Once every 60 frames the scene replaces one object's buffer, handing the
+// old one to FrameSubmitter::releaseWhenComplete().
+//
+//   bench_frame_submit [gpu latency us] [frames]
+#include <Gfx/CountingBackend.hpp>
+#include <Gfx/Renderer.hpp>
+#include <Gfx/SoftwareBackend.hpp>
+
+#include <chrono>
+#include <cstdlib>
+#include <iomanip>
+#include <iostream>
+#include <memory>
+#include <utility>
+#include <vector>
+
+namespace {
+
+constexpr std::size_t kObjectBufferLength = 3 * 4 * sizeof(float);
+constexpr std::uint64_t kSceneEditInterval = 60;
+
+void run(std::chrono::microseconds gpuLatency, int frames, std::size_t draws,
+         bool retainedReferences) {
+  Gfx::SoftwareDevice softwareDevice(gpuLatency);
+  Gfx::CountingDevice device(&softwareDevice);
+  Gfx::SoftwareView view(64, 64, Gfx::PixelFormat::BGRA8Unorm);
+
+  std::vector<std::unique_ptr<Gfx::Buffer>> objects;
+  objects.reserve(draws);
+  for (std::size_t i = 0; i < draws; ++i) {
+    objects.push_back(device.newBuffer(kObjectBufferLength));
+  }
+
+  Gfx::Renderer renderer(&device, Gfx::Renderer::kDefaultMaxFramesInFlight,
+                         retainedReferences);
+  std::uint64_t frameNumber = 0;
+  renderer.setFrameUpdateHandler([&](const Gfx::FrameResources &) {
+    if (++frameNumber % kSceneEditInterval == 0) {
+      auto &pObject = objects[frameNumber / kSceneEditInterval % draws];
+      renderer.frameSubmitter().releaseWhenComplete(
+          std::exchange(pObject, device.newBuffer(kObjectBufferLength)));
+    }
+  });
+  renderer.setEncodeHandler([&objects](Gfx::RenderCommandEncoder *pEncoder,
+                                       const Gfx::FrameResources &resources) {
+    pEncoder->setVertexBuffer(resources.pUniformBuffer, 0, 1);
+    for (const auto &pObject : objects) {
+      pEncoder->setVertexBuffer(pObject.get(), 0, 0);
+      pEncoder->drawPrimitives(Gfx::PrimitiveType::Triangle, 0, 3);
+    }
+  });
+
+  device.resetStatistics();
+  const auto start = std::chrono::steady_clock::now();
+  for (int i = 0; i < frames; ++i) {
+    renderer.draw(&view);
+  }
+  const auto end = std::chrono::steady_clock::now();
+  renderer.frameSubmitter().waitForFence(
+      renderer.frameSubmitter().currentFence());
+  const Gfx::CountingStatistics stats = device.statistics();
+
+  const auto perDraw = [&stats](std::uint64_t value) {
+    return static_cast<double>(value) / static_cast<double>(stats.drawCalls);
+  };
+  std::cout << std::setw(8) << draws << std::setw(12)
+            << (retainedReferences ? "retained" : "unretained") << std::fixed
+            << std::setprecision(3) << std::setw(12)
+            << perDraw(stats.messages) << std::setw(12)
+            << perDraw(stats.retains) << std::setw(12)
+            << perDraw(stats.bufferAllocations) << std::setprecision(1)
+            << std::setw(12)
+            << std::chrono::duration<double, std::nano>(end - start).count() /
+                   static_cast<double>(stats.drawCalls)
+            << "\n";
+}
+
+}  // namespace
+
+int main(int argc, char *argv[]) {
+  const std::chrono::microseconds gpuLatency(argc > 1 ? std::atoi(argv[1])
+                                                      : 0);
+  const int frames = argc > 2 ? std::atoi(argv[2]) : 600;
+
+  std::cout << "frames: " << frames << ", gpu latency: " << gpuLatency.count()
+            << " us\n"
+            << std::setw(8) << "draws" << std::setw(12) << "references"
+            << std::setw(12) << "msgs/draw" << std::setw(12) << "retains/drw"
+            << std::setw(12) << "allocs/draw" << std::setw(12) << "ns/draw"
+            << "\n";
+  for (std::size_t draws : {1, 10, 100, 1000, 10000}) {
+    for (bool retainedReferences : {true, false}) {
+      run(gpuLatency, frames, draws, retainedReferences);
+    }
+  }
+  return 0;
+}
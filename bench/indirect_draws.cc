@@ -0,0 +1,218 @@
+// CPU cost per frame of submitting a static scene of 10k to 200k draws
+// against the headless software backend:
+//
+//   direct    every draw encoded every frame with ParallelPassEncoder.
+//   icb       IndirectDrawEncoder with nothing dirty: one
+//             executeCommandsInBuffer() a frame.
+//   icb 1%    a contiguous 1% of the draws changes every frame and is
+//             re-encoded in the frame's slot.
+//   icb all   every draw is marked dirty every frame, the worst case of
+//             re-encoding ranges over the job system.
+//
+// Each draw binds a shared mesh and its own slice of a uniform buffer. The
+// time covers everything the CPU does for the pass up to endEncoding(),
+// including re-encoding; "commands" counts indirect commands re-encoded per
+// frame. The last frame of every run is checked to execute exactly the
+// command stream a direct encode of the scene's current state executes.
+//
+//   bench_indirect_draws [max threads] [frames]
+#include <Gfx/IndirectDrawEncoder.hpp>
+#include <Gfx/JobSystem.hpp>
+#include <Gfx/ParallelPassEncoder.hpp>
+#include <Gfx/SoftwareBackend.hpp>
+
+#include <algorithm>
+#include <chrono>
+#include <cstdint>
+#include <cstdlib>
+#include <iomanip>
+#include <iostream>
+#include <memory>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace {
+
+using Clock = std::chrono::steady_clock;
+
+constexpr std::size_t kMatrixLength = 16 * sizeof(float);
+constexpr std::size_t kFrameCount = 3;
+
+enum class Mode : std::uint8_t { Direct, Static, Partial, All };
+
+struct Result {
+  double usPerFrame;
+  double commandsPerFrame;
+  bool same;
+};
+
+struct Scene {
+  explicit Scene(std::size_t drawCount)
+      : vertexStarts(drawCount, 0),
+        pQueue(device.newCommandQueue()),
+        pMesh(device.newBuffer(64 * 4 * sizeof(float))),
+        pUniforms(device.newBuffer(drawCount * kMatrixLength)) {}
+
+  [[nodiscard]] std::size_t drawCount() const { return vertexStarts.size(); }
+
+  // The only per-draw state that changes.
+  std::vector<std::uint32_t> vertexStarts;
+  Gfx::SoftwareDevice device;
+  Gfx::SoftwareView view{64, 64, Gfx::PixelFormat::BGRA8Unorm};
+  std::unique_ptr<Gfx::CommandQueue> pQueue;
+  std::unique_ptr<Gfx::Buffer> pMesh;
+  std::unique_ptr<Gfx::Buffer> pUniforms;
+};
+
+void encodeDirect(const Scene &scene, Gfx::RenderCommandEncoder *pEncoder,
+                  std::size_t begin, std::size_t end) {
+  for (std::size_t i = begin; i < end; ++i) {
+    pEncoder->setVertexBuffer(scene.pMesh.get(), 0, 0);
+    pEncoder->setVertexBuffer(scene.pUniforms.get(), i * kMatrixLength, 1);
+    pEncoder->drawPrimitives(Gfx::PrimitiveType::Triangle,
+                             scene.vertexStarts[i], 3);
+  }
+}
+
+void encodeIndirect(const Scene &scene, Gfx::IndirectCommandBuffer *pCommands,
+                    std::size_t begin, std::size_t end) {
+  for (std::size_t i = begin; i < end; ++i) {
+    pCommands->setVertexBuffer(i, scene.pMesh.get(), 0, 0);
+    pCommands->setVertexBuffer(i, scene.pUniforms.get(), i * kMatrixLength,
+                               1);
+    pCommands->drawPrimitives(i, Gfx::PrimitiveType::Triangle,
+                              scene.vertexStarts[i], 3, 1, 0);
+  }
+}
+
+// Digest of the scene's current state encoded directly.
+std::uint64_t referenceDigest(Scene &scene) {
+  auto *pCommandBuffer =
+      static_cast<Gfx::SoftwareCommandBuffer *>(scene.pQueue->commandBuffer());
+  Gfx::RenderCommandEncoder *pEncoder = pCommandBuffer->renderCommandEncoder(
+      scene.view.currentRenderPassDescriptor());
+  encodeDirect(scene, pEncoder, 0, scene.drawCount());
+  pEncoder->endEncoding();
+  pCommandBuffer->commit();
+  pCommandBuffer->waitUntilCompleted();
+  return pCommandBuffer->executionDigest();
+}
+
+Result run(Scene &scene, Mode mode, std::size_t threads, int frames) {
+  std::fill(scene.vertexStarts.begin(), scene.vertexStarts.end(), 0);
+  Gfx::JobSystem jobSystem(threads);
+  Gfx::ParallelPassEncoder directEncoder(&jobSystem);
+  Gfx::IndirectDrawEncoder indirectEncoder(&scene.device, kFrameCount,
+                                           {.maxVertexBufferBindCount = 2});
+  indirectEncoder.addResource(scene.pMesh.get());
+  indirectEncoder.addResource(scene.pUniforms.get());
+  indirectEncoder.setDrawList(
+      scene.drawCount(),
+      [&scene](Gfx::IndirectCommandBuffer *pCommands, std::size_t,
+               std::size_t begin, std::size_t end) {
+        encodeIndirect(scene, pCommands, begin, end);
+      });
+  const std::size_t windowLength = std::max<std::size_t>(
+      1, scene.drawCount() / 100);
+
+  std::chrono::nanoseconds encodeTime{0};
+  std::size_t commands = 0;
+  std::uint64_t digest = 0;
+  // The first kFrameCount frames encode every slot and aren't timed.
+  for (int frame = -static_cast<int>(kFrameCount); frame < frames; ++frame) {
+    const std::size_t slot =
+        static_cast<std::size_t>(frame + kFrameCount) % kFrameCount;
+    if (frame >= 0 && mode == Mode::Partial) {
+      const std::size_t begin =
+          static_cast<std::size_t>(frame) * 7919 %
+          (scene.drawCount() - windowLength + 1);
+      for (std::size_t i = begin; i < begin + windowLength; ++i) {
+        scene.vertexStarts[i] = static_cast<std::uint32_t>(frame % 16) * 3;
+      }
+      indirectEncoder.markDirty(begin, begin + windowLength);
+    } else if (frame >= 0 && mode == Mode::All) {
+      indirectEncoder.markDirty(0, scene.drawCount());
+    }
+
+    auto *pCommandBuffer = static_cast<Gfx::SoftwareCommandBuffer *>(
+        scene.pQueue->commandBuffer());
+    const Gfx::RenderPassDescriptor descriptor =
+        scene.view.currentRenderPassDescriptor();
+    const auto start = Clock::now();
+    std::size_t frameCommands = 0;
+    if (mode == Mode::Direct) {
+      directEncoder.encode(
+          pCommandBuffer, descriptor, scene.drawCount(),
+          [&scene](Gfx::RenderCommandEncoder *pEncoder, std::size_t begin,
+                   std::size_t end) {
+            encodeDirect(scene, pEncoder, begin, end);
+          });
+    } else {
+      frameCommands = indirectEncoder.update(slot, &jobSystem);
+      Gfx::RenderCommandEncoder *pEncoder =
+          pCommandBuffer->renderCommandEncoder(descriptor);
+      indirectEncoder.execute(pEncoder, slot);
+      pEncoder->endEncoding();
+    }
+    if (frame >= 0) {
+      encodeTime += Clock::now() - start;
+      commands += frameCommands;
+    }
+    pCommandBuffer->commit();
+    pCommandBuffer->waitUntilCompleted();
+    digest = pCommandBuffer->executionDigest();
+  }
+  return {static_cast<double>(encodeTime.count()) / 1000.0 / frames,
+          static_cast<double>(commands) / frames,
+          digest == referenceDigest(scene)};
+}
+
+const char *modeName(Mode mode) {
+  switch (mode) {
+    case Mode::Direct:
+      return "direct";
+    case Mode::Static:
+      return "icb";
+    case Mode::Partial:
+      return "icb 1%";
+    case Mode::All:
+      return "icb all";
+  }
+  return "";
+}
+
+}  // namespace
+
+int main(int argc, char *argv[]) {
+  const std::size_t maxThreads =
+      argc > 1 ? static_cast<std::size_t>(std::max(1, std::atoi(argv[1])))
+               : std::max(1U, std::thread::hardware_concurrency());
+  const int frames = argc > 2 ? std::max(1, std::atoi(argv[2])) : 20;
+
+  std::cout << "frames: " << frames
+            << ", hardware threads: " << std::thread::hardware_concurrency()
+            << "\n"
+            << std::setw(8) << "draws" << std::setw(10) << "mode"
+            << std::setw(9) << "threads" << std::setw(12) << "us/frame"
+            << std::setw(11) << "commands" << std::setw(8) << "order"
+            << "\n";
+  bool allSame = true;
+  for (const std::size_t draws : {10000, 50000, 200000}) {
+    Scene scene(draws);
+    for (const Mode mode :
+         {Mode::Direct, Mode::Static, Mode::Partial, Mode::All}) {
+      for (std::size_t threads = 1; threads <= maxThreads; threads *= 2) {
+        const Result result = run(scene, mode, threads, frames);
+        std::cout << std::setw(8) << draws << std::setw(10) << modeName(mode)
+                  << std::setw(9) << threads << std::fixed
+                  << std::setprecision(1) << std::setw(12)
+                  << result.usPerFrame << std::setprecision(0)
+                  << std::setw(11) << result.commandsPerFrame << std::setw(8)
+                  << (result.same ? "same" : "DIFFERS") << "\n";
+        allSame = allSame && result.same;
+      }
+    }
+  }
+  return allSame ? EXIT_SUCCESS : EXIT_FAILURE;
+}
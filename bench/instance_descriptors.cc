@@ -0,0 +1,265 @@
+// Cost of filling an instance buffer for an instance acceleration structure
+// every frame, in each descriptor layout:
+//
+//   aos      a naive loop over an array of instance structs that assigns
+//            descriptor fields one by one through the buffer's contents.
+//   soa      InstanceDescriptorWriter on the calling thread.
+//   soa xN   InstanceDescriptorWriter spread over N job system threads.
+//
+// GB/s counts the descriptor bytes written. The "memset" line is a plain
+// write of the same number of bytes, roughly what the memory system allows;
+// a fill close to it is bound by bandwidth rather than by assembling the
+// descriptors. Every writer's output is compared byte for byte with the
+// naive loop's, and any difference fails the run.
+//
+//   bench_instance_descriptors [instances] [max threads]
+#include <Gfx/InstanceDescriptors.hpp>
+#include <Gfx/JobSystem.hpp>
+#include <Gfx/SoftwareBackend.hpp>
+
+#include <algorithm>
+#include <chrono>
+#include <cstdlib>
+#include <cstring>
+#include <iomanip>
+#include <iostream>
+#include <random>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace {
+
+using Clock = std::chrono::steady_clock;
+
+constexpr int kFrames = 20;
+
+double seconds(Clock::time_point start) {
+  return std::chrono::duration<double>(Clock::now() - start).count();
+}
+
+// Everything a game might keep per instance, one struct each.
+struct Instance {
+  Gfx::PackedFloat4x3 transform;
+  Gfx::InstanceOptions options;
+  std::uint32_t mask;
+  std::uint32_t intersectionFunctionTableOffset;
+  std::uint32_t accelerationStructureIndex;
+  std::uint32_t userID;
+  std::uint32_t motionTransformsStartIndex;
+  std::uint32_t motionTransformsCount;
+  Gfx::MotionBorderMode motionStartBorderMode;
+  Gfx::MotionBorderMode motionEndBorderMode;
+  float motionStartTime;
+  float motionEndTime;
+};
+
+std::vector<Instance> makeInstances(std::size_t count) {
+  std::mt19937 random(3);
+  std::uniform_real_distribution<float> value(-100.0F, 100.0F);
+  std::uniform_int_distribution<std::uint32_t> small(0, 15);
+  std::vector<Instance> instances(count);
+  for (std::size_t i = 0; i < count; ++i) {
+    Instance &instance = instances[i];
+    for (Gfx::PackedFloat3 &column : instance.transform.columns) {
+      column = {value(random), value(random), value(random)};
+    }
+    instance.options = small(random) % 2 == 0
+                           ? Gfx::InstanceOptions::Opaque
+                           : Gfx::InstanceOptions::NonOpaque |
+                                 Gfx::InstanceOptions::DisableTriangleCulling;
+    instance.mask = 1U << small(random) % 8;
+    instance.intersectionFunctionTableOffset = small(random);
+    instance.accelerationStructureIndex = small(random) * 37;
+    instance.userID = static_cast<std::uint32_t>(i) * 7 + 1;
+    instance.motionTransformsStartIndex = static_cast<std::uint32_t>(i) * 2;
+    instance.motionTransformsCount = 2;
+    instance.motionStartBorderMode = Gfx::MotionBorderMode::Clamp;
+    instance.motionEndBorderMode = small(random) % 2 == 0
+                                       ? Gfx::MotionBorderMode::Clamp
+                                       : Gfx::MotionBorderMode::Vanish;
+    instance.motionStartTime = 0.0F;
+    instance.motionEndTime = value(random);
+  }
+  return instances;
+}
+
+void fillWriter(const std::vector<Instance> &instances,
+                Gfx::InstanceDescriptorWriter &writer) {
+  writer.resize(instances.size());
+  for (std::size_t i = 0; i < instances.size(); ++i) {
+    const Instance &instance = instances[i];
+    writer.transforms()[i] = instance.transform;
+    writer.options()[i] = instance.options;
+    writer.masks()[i] = instance.mask;
+    writer.intersectionFunctionTableOffsets()[i] =
+        instance.intersectionFunctionTableOffset;
+    writer.accelerationStructureIndices()[i] =
+        instance.accelerationStructureIndex;
+    writer.userIDs()[i] = instance.userID;
+    writer.motionTransformsStartIndices()[i] =
+        instance.motionTransformsStartIndex;
+    writer.motionTransformsCounts()[i] = instance.motionTransformsCount;
+    writer.motionStartBorderModes()[i] = instance.motionStartBorderMode;
+    writer.motionEndBorderModes()[i] = instance.motionEndBorderMode;
+    writer.motionStartTimes()[i] = instance.motionStartTime;
+    writer.motionEndTimes()[i] = instance.motionEndTime;
+  }
+}
+
+void writeNaive(const std::vector<Instance> &instances,
+                Gfx::InstanceDescriptorType type, void *pContents) {
+  switch (type) {
+    case Gfx::InstanceDescriptorType::Default: {
+      auto *pDescriptors =
+          static_cast<Gfx::AccelerationStructureInstanceDescriptor *>(
+              pContents);
+      for (std::size_t i = 0; i < instances.size(); ++i) {
+        pDescriptors[i].transformationMatrix = instances[i].transform;
+        pDescriptors[i].options = instances[i].options;
+        pDescriptors[i].mask = instances[i].mask;
+        pDescriptors[i].intersectionFunctionTableOffset =
+            instances[i].intersectionFunctionTableOffset;
+        pDescriptors[i].accelerationStructureIndex =
+            instances[i].accelerationStructureIndex;
+      }
+      break;
+    }
+    case Gfx::InstanceDescriptorType::UserID: {
+      auto *pDescriptors =
+          static_cast<Gfx::AccelerationStructureUserIDInstanceDescriptor *>(
+              pContents);
+      for (std::size_t i = 0; i < instances.size(); ++i) {
+        pDescriptors[i].transformationMatrix = instances[i].transform;
+        pDescriptors[i].options = instances[i].options;
+        pDescriptors[i].mask = instances[i].mask;
+        pDescriptors[i].intersectionFunctionTableOffset =
+            instances[i].intersectionFunctionTableOffset;
+        pDescriptors[i].accelerationStructureIndex =
+            instances[i].accelerationStructureIndex;
+        pDescriptors[i].userID = instances[i].userID;
+      }
+      break;
+    }
+    case Gfx::InstanceDescriptorType::Motion: {
+      auto *pDescriptors =
+          static_cast<Gfx::AccelerationStructureMotionInstanceDescriptor *>(
+              pContents);
+      for (std::size_t i = 0; i < instances.size(); ++i) {
+        pDescriptors[i].options = instances[i].options;
+        pDescriptors[i].mask = instances[i].mask;
+        pDescriptors[i].intersectionFunctionTableOffset =
+            instances[i].intersectionFunctionTableOffset;
+        pDescriptors[i].accelerationStructureIndex =
+            instances[i].accelerationStructureIndex;
+        pDescriptors[i].userID = instances[i].userID;
+        pDescriptors[i].motionTransformsStartIndex =
+            instances[i].motionTransformsStartIndex;
+        pDescriptors[i].motionTransformsCount =
+            instances[i].motionTransformsCount;
+        pDescriptors[i].motionStartBorderMode =
+            instances[i].motionStartBorderMode;
+        pDescriptors[i].motionEndBorderMode = instances[i].motionEndBorderMode;
+        pDescriptors[i].motionStartTime = instances[i].motionStartTime;
+        pDescriptors[i].motionEndTime = instances[i].motionEndTime;
+      }
+      break;
+    }
+  }
+}
+
+// Best time of kFrames calls, after one untimed call that faults the pages
+// in.
+template <typename Function>
+double bestFrameTime(Function &&function) {
+  function();
+  double best = 1e30;
+  for (int frame = 0; frame < kFrames; ++frame) {
+    const auto start = Clock::now();
+    function();
+    best = std::min(best, seconds(start));
+  }
+  return best;
+}
+
+void printRow(const std::string &name, std::size_t bytes, double time,
+              const char *pCheck) {
+  std::cout << std::setw(10) << name << std::fixed << std::setprecision(2)
+            << std::setw(10) << time * 1e3 << std::setw(10)
+            << static_cast<double>(bytes) / time / 1e9 << std::setw(9)
+            << pCheck << "\n";
+}
+
+const char *typeName(Gfx::InstanceDescriptorType type) {
+  switch (type) {
+    case Gfx::InstanceDescriptorType::Default:
+      return "default";
+    case Gfx::InstanceDescriptorType::UserID:
+      return "user ID";
+    case Gfx::InstanceDescriptorType::Motion:
+      return "motion";
+  }
+  return "";
+}
+
+}  // namespace
+
+int main(int argc, char *argv[]) {
+  const std::size_t instanceCount =
+      argc > 1 ? static_cast<std::size_t>(std::max(1, std::atoi(argv[1])))
+               : 1000000;
+  const std::size_t maxThreads =
+      argc > 2 ? static_cast<std::size_t>(std::max(1, std::atoi(argv[2])))
+               : std::max(1U, std::thread::hardware_concurrency());
+
+  const std::vector<Instance> instances = makeInstances(instanceCount);
+  Gfx::InstanceDescriptorWriter writer;
+  fillWriter(instances, writer);
+  const std::size_t capacity =
+      instanceCount *
+      Gfx::instanceDescriptorSize(Gfx::InstanceDescriptorType::UserID);
+  Gfx::SoftwareBuffer buffer(capacity);
+  std::vector<std::byte> reference(capacity);
+
+  std::cout << "hardware threads: " << std::thread::hardware_concurrency()
+            << ", instances: " << instanceCount << "\n";
+  bool allSame = true;
+  for (const Gfx::InstanceDescriptorType type :
+       {Gfx::InstanceDescriptorType::Default,
+        Gfx::InstanceDescriptorType::UserID,
+        Gfx::InstanceDescriptorType::Motion}) {
+    const std::size_t bytes =
+        instanceCount * Gfx::instanceDescriptorSize(type);
+    std::cout << typeName(type) << " descriptors, "
+              << Gfx::instanceDescriptorSize(type) << " bytes\n"
+              << std::setw(10) << "writer" << std::setw(10) << "ms"
+              << std::setw(10) << "GB/s" << std::setw(9) << "output" << "\n";
+
+    printRow("memset", bytes, bestFrameTime([&] {
+               std::memset(buffer.contents(), 0, bytes);
+             }),
+             "");
+    printRow("aos", bytes, bestFrameTime([&] {
+               writeNaive(instances, type, buffer.contents());
+             }),
+             "");
+    // The reference is packed by the naive loop into zeroed memory of its
+    // own, padding included.
+    std::fill(reference.begin(), reference.end(), std::byte{0});
+    writeNaive(instances, type, reference.data());
+
+    for (std::size_t threads = 1; threads <= maxThreads; threads *= 2) {
+      Gfx::JobSystem jobSystem(threads);
+      std::memset(buffer.contents(), 0, bytes);
+      const double time = bestFrameTime([&] {
+        writer.write(type, &buffer, 0, threads > 1 ? &jobSystem : nullptr);
+      });
+      const bool same =
+          std::memcmp(reference.data(), buffer.contents(), bytes) == 0;
+      printRow(threads == 1 ? "soa" : "soa x" + std::to_string(threads),
+               bytes, time, same ? "same" : "DIFFERS");
+      allSame = allSame && same;
+    }
+  }
+  return allSame ? EXIT_SUCCESS : EXIT_FAILURE;
+}
@@ -0,0 +1,107 @@
+// Checks that JobSystem reuses its job records over many frames instead of
+// allocating more, with jobs submitted on one thread and run on others:
+//
+//   for      parallelFor(64, 1) a frame from the main thread, as
+//            ParallelPassEncoder and IndirectDrawEncoder submit theirs.
+//   nested   64 jobs a frame from the main thread that each submit a child,
+//            so workers allocate jobs too.
+//
+// No frame has more jobs in flight than a block holds, so "blocks", the job
+// blocks allocated by the end, must be at most one for every thread that
+// submits jobs.
+//
+//   bench_job_pool [max threads] [frames]
+#include <Gfx/JobSystem.hpp>
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <cstdlib>
+#include <iomanip>
+#include <iostream>
+#include <thread>
+
+namespace {
+
+using Clock = std::chrono::steady_clock;
+
+constexpr std::size_t kJobsPerFrame = 64;
+
+enum class Mode : std::uint8_t { For, Nested };
+
+struct Result {
+  double usPerFrame;
+  std::size_t blocks;
+  bool ok;
+};
+
+void runFrame(Gfx::JobSystem &jobSystem, Mode mode,
+              std::atomic<std::uint64_t> &work) {
+  if (mode == Mode::For) {
+    jobSystem.parallelFor(kJobsPerFrame, 1,
+                          [&work](std::size_t begin, std::size_t end) {
+                            work.fetch_add(end - begin,
+                                           std::memory_order_relaxed);
+                          });
+    return;
+  }
+  Gfx::JobCounter counter;
+  for (std::size_t i = 0; i < kJobsPerFrame; ++i) {
+    jobSystem.run(
+        [&jobSystem, &counter, &work] {
+          work.fetch_add(1, std::memory_order_relaxed);
+          jobSystem.run(
+              [&work] { work.fetch_add(1, std::memory_order_relaxed); },
+              &counter);
+        },
+        &counter);
+  }
+  jobSystem.wait(counter);
+}
+
+Result run(Mode mode, std::size_t threads, int frames) {
+  Gfx::JobSystem jobSystem(threads);
+  std::atomic<std::uint64_t> work = 0;
+  const auto start = Clock::now();
+  for (int frame = 0; frame < frames; ++frame) {
+    runFrame(jobSystem, mode, work);
+  }
+  const double elapsed =
+      std::chrono::duration<double, std::micro>(Clock::now() - start)
+          .count();
+  const std::size_t blocks = jobSystem.jobBlockCount();
+  const std::uint64_t jobsPerFrame =
+      mode == Mode::For ? kJobsPerFrame : 2 * kJobsPerFrame;
+  return {elapsed / frames, blocks,
+          blocks <= threads &&
+              work.load() == jobsPerFrame * static_cast<std::uint64_t>(frames)};
+}
+
+}  // namespace
+
+int main(int argc, char *argv[]) {
+  const std::size_t maxThreads =
+      argc > 1 ? static_cast<std::size_t>(std::max(1, std::atoi(argv[1])))
+               : std::max(4U, std::thread::hardware_concurrency());
+  const int frames = argc > 2 ? std::max(1, std::atoi(argv[2])) : 10000;
+
+  std::cout << "frames: " << frames << ", jobs a frame: " << kJobsPerFrame
+            << "\n"
+            << std::setw(8) << "mode" << std::setw(9) << "threads"
+            << std::setw(12) << "us/frame" << std::setw(8) << "blocks"
+            << std::setw(6) << "" << "\n";
+  bool allOk = true;
+  for (const Mode mode : {Mode::For, Mode::Nested}) {
+    for (std::size_t threads = 1; threads <= maxThreads; threads *= 2) {
+      const Result result = run(mode, threads, frames);
+      std::cout << std::setw(8) << (mode == Mode::For ? "for" : "nested")
+                << std::setw(9) << threads << std::fixed
+                << std::setprecision(2) << std::setw(12) << result.usPerFrame
+                << std::setw(8) << result.blocks << std::setw(6)
+                << (result.ok ? "ok" : "WRONG") << "\n";
+      allOk = allOk && result.ok;
+    }
+  }
+  return allOk ? EXIT_SUCCESS : EXIT_FAILURE;
+}
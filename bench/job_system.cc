@@ -0,0 +1,167 @@
+// Measures JobSystem throughput and scaling for 1 to 64 threads:
+//
+//   spawn   empty jobs submitted by the main thread, which then waits.
+//   tree    empty jobs spawning two children each until a fixed depth, so
+//           most jobs reach other threads by being stolen.
+//   for     parallelFor over a compute-bound loop; speedup is against the
+//           single-threaded run.
+//   graph   a frame-shaped dependency chain: a stage of cull jobs, a stage of
+//           encode jobs waiting on it, then one main-thread job waiting on
+//           those.
+//
+// Thread counts above the hardware thread count are oversubscribed and only
+// show scheduling overhead.
+//
+//   bench_job_system [max threads] [spawn jobs]
+#include <Gfx/JobSystem.hpp>
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <cstdlib>
+#include <iomanip>
+#include <iostream>
+#include <thread>
+
+namespace {
+
+using Clock = std::chrono::steady_clock;
+
+constexpr int kTreeDepth = 17;
+constexpr std::size_t kTreeJobs = (std::size_t{1} << (kTreeDepth + 1)) - 2;
+constexpr std::size_t kForCount = std::size_t{1} << 22;
+constexpr std::size_t kForGrain = 4096;
+constexpr int kGraphFrames = 200;
+constexpr int kGraphJobsPerStage = 64;
+
+double seconds(Clock::time_point start) {
+  return std::chrono::duration<double>(Clock::now() - start).count();
+}
+
+double spawn(Gfx::JobSystem &jobSystem, std::size_t jobs) {
+  Gfx::JobCounter counter;
+  const auto start = Clock::now();
+  for (std::size_t i = 0; i < jobs; ++i) {
+    jobSystem.run([] {}, &counter);
+  }
+  jobSystem.wait(counter);
+  return static_cast<double>(jobs) / seconds(start);
+}
+
+struct Tree {
+  Gfx::JobSystem *pJobSystem;
+  Gfx::JobCounter *pCounter;
+
+  void node(int depth) const {
+    if (depth == 0) {
+      return;
+    }
+    for (int i = 0; i < 2; ++i) {
+      pJobSystem->run([this, depth] { node(depth - 1); }, pCounter);
+    }
+  }
+};
+
+double tree(Gfx::JobSystem &jobSystem) {
+  Gfx::JobCounter counter;
+  const Tree tree{&jobSystem, &counter};
+  const auto start = Clock::now();
+  tree.node(kTreeDepth);
+  jobSystem.wait(counter);
+  return static_cast<double>(kTreeJobs) / seconds(start);
+}
+
+double parallelFor(Gfx::JobSystem &jobSystem, std::uint64_t &checksum) {
+  std::atomic<std::uint64_t> sum = 0;
+  const auto start = Clock::now();
+  jobSystem.parallelFor(
+      kForCount, kForGrain, [&sum](std::size_t begin, std::size_t end) {
+        std::uint64_t local = 0;
+        for (std::size_t i = begin; i < end; ++i) {
+          std::uint64_t x = i * 0x9E3779B97F4A7C15ULL;
+          for (int round = 0; round < 16; ++round) {
+            x ^= x >> 29;
+            x *= 0xBF58476D1CE4E5B9ULL;
+          }
+          local += x;
+        }
+        sum.fetch_add(local, std::memory_order_relaxed);
+      });
+  const double elapsed = seconds(start);
+  checksum = sum.load();
+  return elapsed;
+}
+
+// Returns microseconds per frame; fails if the main-thread job ran elsewhere.
+double graph(Gfx::JobSystem &jobSystem, bool &mainThreadOnly) {
+  std::atomic<std::uint64_t> work = 0;
+  const auto stageJob = [&work] {
+    work.fetch_add(1, std::memory_order_relaxed);
+  };
+  mainThreadOnly = true;
+  const auto start = Clock::now();
+  for (int frame = 0; frame < kGraphFrames; ++frame) {
+    Gfx::JobCounter culled;
+    Gfx::JobCounter encoded;
+    Gfx::JobCounter presented;
+    for (int i = 0; i < kGraphJobsPerStage; ++i) {
+      jobSystem.run(stageJob, &culled);
+    }
+    for (int i = 0; i < kGraphJobsPerStage; ++i) {
+      jobSystem.run(stageJob, &encoded, &culled);
+    }
+    jobSystem.runOnMainThread(
+        [&] { mainThreadOnly &= jobSystem.currentThreadIndex() == 0; },
+        &presented, &encoded);
+    jobSystem.wait(presented);
+  }
+  return seconds(start) * 1e6 / kGraphFrames;
+}
+
+}  // namespace
+
+int main(int argc, char *argv[]) {
+  const std::size_t maxThreads =
+      argc > 1 ? static_cast<std::size_t>(std::max(1, std::atoi(argv[1])))
+               : 64;
+  const std::size_t spawnJobs =
+      argc > 2 ? static_cast<std::size_t>(std::atoi(argv[2])) : 1000000;
+
+  std::cout << "hardware threads: " << std::thread::hardware_concurrency()
+            << ", spawn jobs: " << spawnJobs << ", tree jobs: " << kTreeJobs
+            << "\n"
+            << std::setw(8) << "threads" << std::setw(14) << "spawn Mjob/s"
+            << std::setw(14) << "tree Mjob/s" << std::setw(10) << "for ms"
+            << std::setw(10) << "speedup" << std::setw(14) << "graph us/frm"
+            << "\n";
+  double serialFor = 0.0;
+  std::uint64_t serialChecksum = 0;
+  for (std::size_t threads = 1; threads <= maxThreads; threads *= 2) {
+    Gfx::JobSystem jobSystem(threads);
+    const double spawnRate = spawn(jobSystem, spawnJobs);
+    const double treeRate = tree(jobSystem);
+    std::uint64_t checksum = 0;
+    const double forTime = parallelFor(jobSystem, checksum);
+    bool mainThreadOnly = false;
+    const double graphTime = graph(jobSystem, mainThreadOnly);
+    if (threads == 1) {
+      serialFor = forTime;
+      serialChecksum = checksum;
+    }
+    std::cout << std::setw(8) << threads << std::fixed << std::setprecision(2)
+              << std::setw(14) << spawnRate / 1e6 << std::setw(14)
+              << treeRate / 1e6 << std::setprecision(1) << std::setw(10)
+              << forTime * 1e3 << std::setprecision(2) << std::setw(10)
+              << serialFor / forTime << std::setprecision(1) << std::setw(14)
+              << graphTime;
+    if (checksum != serialChecksum) {
+      std::cout << "  parallelFor result differs";
+    }
+    if (!mainThreadOnly) {
+      std::cout << "  main-thread job ran on a worker";
+    }
+    std::cout << "\n";
+  }
+  return 0;
+}
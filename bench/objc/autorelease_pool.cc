@@ -0,0 +1,176 @@
+// Measures what wrapping each frame in an autorelease pool costs, and how many
+// objects reach the pool, for the ways the frame loop can scope it:
+//
+//   NSAutoreleasePool  - a pool object allocated and released every frame
+//   scoped             - an NS::ScopedAutoreleasePool opened every frame
+//   scoped + drain()   - one NS::ScopedAutoreleasePool drained every frame
+//
+// Each frame autoreleases [transients] objects, standing in for the command
+// buffer, encoder and descriptors Metal hands out. A second table counts the
+// strings createMenuBar() autoreleases with run-time and constant titles.
+//
+//   bench_autorelease_pool [frames] [transients]
+#define NS_PRIVATE_IMPLEMENTATION
+#include <Foundation/NSPrivate.hpp>
+
+#include <Foundation/NSAutoreleasePool.hpp>
+#include <Foundation/NSObject.hpp>
+#include <Foundation/NSString.hpp>
+
+#include <MockObjC.hpp>
+
+#include <chrono>
+#include <cstdlib>
+#include <iomanip>
+#include <iostream>
+
+namespace Bench {
+
+class Transient : public NS::Referencing<Transient> {
+ public:
+  static Transient *alloc() {
+    return NS::Object::alloc<Transient>("Transient");
+  }
+  Transient *init() { return NS::Object::init<Transient>(); }
+
+  static Transient *transient() { return alloc()->init()->autorelease(); }
+};
+
+void encodeFrame(int transients) {
+  for (int i = 0; i < transients; ++i) {
+    Transient::transient();
+  }
+}
+
+std::size_t poolObjectPerFrame(int frames, int transients) {
+  std::size_t objectsPerScope = 0;
+  for (int i = 0; i < frames; ++i) {
+    NS::AutoreleasePool *pPool = NS::AutoreleasePool::alloc()->init();
+    encodeFrame(transients);
+    objectsPerScope = MockObjC::autoreleasePoolObjectCount();
+    pPool->release();
+  }
+  return objectsPerScope;
+}
+
+std::size_t scopedPerFrame(int frames, int transients) {
+  std::size_t objectsPerScope = 0;
+  for (int i = 0; i < frames; ++i) {
+    NS::ScopedAutoreleasePool pool;
+    encodeFrame(transients);
+    objectsPerScope = MockObjC::autoreleasePoolObjectCount();
+  }
+  return objectsPerScope;
+}
+
+std::size_t scopedDrained(int frames, int transients) {
+  std::size_t objectsPerScope = 0;
+  NS::ScopedAutoreleasePool pool;
+  for (int i = 0; i < frames; ++i) {
+    encodeFrame(transients);
+    objectsPerScope = MockObjC::autoreleasePoolObjectCount();
+    pool.drain();
+  }
+  return objectsPerScope;
+}
+
+// Returns the number of objects the last frame autoreleased into its scope.
+using FrameLoop = std::size_t (*)(int frames, int transients);
+
+void reportFrameLoop(const char *name, FrameLoop pLoop, int frames,
+                     int transients) {
+  MockObjC::resetStatistics();
+  const auto start = std::chrono::steady_clock::now();
+  const std::size_t objectsPerScope = pLoop(frames, transients);
+  const auto end = std::chrono::steady_clock::now();
+  const MockObjC::Statistics stats = MockObjC::statistics();
+
+  const auto perFrame = [frames](std::uint64_t value) {
+    return static_cast<double>(value) / frames;
+  };
+  std::cout << std::left << std::setw(20) << name << std::right << std::fixed
+            << std::setprecision(1) << std::setw(10)
+            << std::chrono::duration<double, std::nano>(end - start).count() /
+                   frames
+            << std::setw(10) << perFrame(stats.messagesSent) << std::setw(10)
+            << perFrame(stats.allocations) << std::setw(10)
+            << objectsPerScope << std::setw(10)
+            << stats.poolObjectsHighWater << std::setw(10)
+            << stats.poolDepthHighWater << "\n";
+}
+
+// The titles createMenuBar() builds, first as run-time strings and then the
+// way it builds them now.
+void menuTitlesRuntime(const NS::String *pAppName) {
+  using NS::StringEncoding::UTF8StringEncoding;
+  const char *titles[] = {"Appname", "q", "Window", "Close Window", "w", "Foo",
+                          "f",       "00 - Window"};
+  for (const char *title : titles) {
+    NS::String::string(title, UTF8StringEncoding);
+  }
+  NS::String::string("Quit ", UTF8StringEncoding)
+      ->stringByAppendingString(pAppName);
+}
+
+void menuTitlesConstant(const NS::String *pAppName) {
+  using NS::MakeConstantString;
+  const NS::String *titles[] = {
+      MakeConstantString("Appname"), MakeConstantString("q"),
+      MakeConstantString("Window"),  MakeConstantString("Close Window"),
+      MakeConstantString("w"),       MakeConstantString("Foo"),
+      MakeConstantString("f"),       MakeConstantString("00 - Window")};
+  for (const NS::String *pTitle : titles) {
+    asm volatile("" : : "r"(pTitle));
+  }
+  MakeConstantString("Quit ")->stringByAppendingString(pAppName);
+}
+
+void reportMenuTitles(const char *name, void (*pBuild)(const NS::String *)) {
+  const NS::String *pAppName = NS::MakeConstantString("Metal");
+  NS::ScopedAutoreleasePool pool;
+  // Constant strings are created once per process; keep that out of the
+  // numbers.
+  pBuild(pAppName);
+  pool.drain();
+
+  MockObjC::resetStatistics();
+  pBuild(pAppName);
+  const std::size_t autoreleased = MockObjC::autoreleasePoolObjectCount();
+  pool.drain();
+  const MockObjC::Statistics stats = MockObjC::statistics();
+
+  std::cout << std::left << std::setw(20) << name << std::right
+            << std::setw(10) << stats.messagesSent << std::setw(10)
+            << stats.allocations << std::setw(14) << autoreleased << "\n";
+}
+
+}  // namespace Bench
+
+int main(int argc, char *argv[]) {
+  const int frames = argc > 1 ? std::atoi(argv[1]) : 100000;
+  const int transients = argc > 2 ? std::atoi(argv[2]) : 4;
+
+  MockObjC::defineClass("Transient");
+
+  std::cout << "frames: " << frames << ", transients/frame: " << transients
+            << "\n"
+            << std::left << std::setw(20) << "pool" << std::right
+            << std::setw(10) << "ns/frame" << std::setw(10) << "msgs/frm"
+            << std::setw(10) << "allocs" << std::setw(10) << "in scope"
+            << std::setw(10) << "max objs" << std::setw(10) << "max depth"
+            << "\n";
+  Bench::reportFrameLoop("NSAutoreleasePool", &Bench::poolObjectPerFrame,
+                         frames, transients);
+  Bench::reportFrameLoop("scoped", &Bench::scopedPerFrame, frames, transients);
+  Bench::reportFrameLoop("scoped + drain()", &Bench::scopedDrained, frames,
+                         transients);
+
+  std::cout << "\n"
+            << std::left << std::setw(20) << "menu titles" << std::right
+            << std::setw(10) << "messages" << std::setw(10) << "allocs"
+            << std::setw(14) << "autoreleased"
+            << "\n";
+  Bench::reportMenuTitles("run-time strings", &Bench::menuTitlesRuntime);
+  Bench::reportMenuTitles("constant strings", &Bench::menuTitlesConstant);
+  return 0;
+}
@@ -0,0 +1,90 @@
+// Compares objc_msgSend dispatch against NS_PRIVATE_CACHED_DISPATCH (IMP
+// looked up once per thread and called directly) and against a plain
+// function call, on a fake class registered with the mock runtime.
+//
+//   bench_cached_dispatch [calls]
+#define NS_PRIVATE_IMPLEMENTATION
+#define NS_PRIVATE_CACHED_DISPATCH
+#include <Foundation/NSPrivate.hpp>
+
+#include <Foundation/NSObject.hpp>
+
+#include <MockObjC.hpp>
+
+#include <chrono>
+#include <cstdlib>
+#include <iomanip>
+#include <iostream>
+
+namespace Bench {
+
+NS::UInteger counterIncrement(id self, SEL) {
+  return ++*MockObjC::ivars<NS::UInteger>(self);
+}
+
+class Counter : public NS::Referencing<Counter> {
+ public:
+  static Counter *alloc() { return NS::Object::alloc<Counter>("Counter"); }
+  Counter *init() { return NS::Object::init<Counter>(); }
+
+  NS::UInteger increment() {
+    return NS::Object::sendMessage<NS::UInteger>(this, s_increment);
+  }
+  NS::UInteger incrementCached() {
+    return NS::Object::sendMessageCached<NS::UInteger>(this, s_increment);
+  }
+
+ private:
+  static inline SEL s_increment = sel_registerName("increment");
+};
+
+// Keeps the compiler from inlining the baseline into the loop.
+NS::UInteger (*volatile g_pDirect)(id, SEL) = &counterIncrement;
+
+template <typename _Call>
+void report(const char *name, int calls, _Call call) {
+  MockObjC::resetStatistics();
+  const auto start = std::chrono::steady_clock::now();
+  NS::UInteger sum = 0;
+  for (int i = 0; i < calls; ++i) {
+    sum += call();
+  }
+  const auto end = std::chrono::steady_clock::now();
+  const MockObjC::Statistics stats = MockObjC::statistics();
+
+  const double ns = std::chrono::duration<double, std::nano>(end - start)
+                        .count() /
+                    static_cast<double>(calls);
+  std::cout << std::left << std::setw(16) << name << std::right
+            << std::setw(12) << std::fixed << std::setprecision(2) << ns
+            << std::setw(12) << stats.messagesSent << std::setw(12)
+            << stats.methodLookups << "  (" << sum << ")\n";
+}
+
+}  // namespace Bench
+
+int main(int argc, char *argv[]) {
+  const int calls = argc > 1 ? std::atoi(argv[1]) : 10000000;
+
+  MockObjC::defineClass("Counter", MockObjC::rootClass(),
+                        sizeof(NS::UInteger));
+  MockObjC::addMethod(objc_lookUpClass("Counter"), "increment",
+                      &Bench::counterIncrement);
+  Bench::Counter *pCounter = Bench::Counter::alloc()->init();
+
+  std::cout << "calls: " << calls << "\n"
+            << std::left << std::setw(16) << "dispatch" << std::right
+            << std::setw(12) << "ns/call" << std::setw(12) << "messages"
+            << std::setw(12) << "lookups"
+            << "\n";
+  Bench::report("objc_msgSend", calls,
+                [pCounter] { return pCounter->increment(); });
+  Bench::report("cached IMP", calls,
+                [pCounter] { return pCounter->incrementCached(); });
+  Bench::report("direct call", calls, [pCounter] {
+    return Bench::g_pDirect(reinterpret_cast<id>(pCounter), nullptr);
+  });
+
+  pCounter->release();
+  return 0;
+}
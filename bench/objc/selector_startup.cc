@@ -0,0 +1,91 @@
+// Counts selector registrations and measures the time spent in static
+// initialization before main() for the metal-cpp private headers. Built twice:
+// bench_selector_startup uses the default eager registration and
+// bench_selector_startup_lazy defines the *_PRIVATE_LAZY_SELECTORS macros.
+#define NS_PRIVATE_IMPLEMENTATION
+#define MTL_PRIVATE_IMPLEMENTATION
+#define MTK_PRIVATE_IMPLEMENTATION
+#define CA_PRIVATE_IMPLEMENTATION
+#include <Foundation/NSPrivate.hpp>
+
+#include <AppKit/AppKitPrivate.hpp>
+#include <Metal/MTLHeaderBridge.hpp>
+#include <MetalKit/MetalKitPrivate.hpp>
+#include <QuartzCore/CAPrivate.hpp>
+
+#include <MockObjC.hpp>
+
+#include <chrono>
+#include <iostream>
+
+namespace {
+
+std::chrono::steady_clock::time_point g_startTime;
+
+// Runs ahead of every default priority static initializer in the program.
+__attribute__((constructor(101))) void recordStartTime() {
+  g_startTime = std::chrono::steady_clock::now();
+}
+
+}  // namespace
+
+// The selectors one frame of Renderer::draw sends through the Metal backend.
+namespace MTL {
+void touchFrameSelectors() {
+  const SEL selectors[] = {
+      _MTL_PRIVATE_SEL(commandBuffer),
+      _MTL_PRIVATE_SEL(addCompletedHandler_),
+      _MTL_PRIVATE_SEL(renderPassDescriptor),
+      _MTL_PRIVATE_SEL(colorAttachments),
+      _MTL_PRIVATE_SEL(objectAtIndexedSubscript_),
+      _MTL_PRIVATE_SEL(setTexture_),
+      _MTL_PRIVATE_SEL(setLoadAction_),
+      _MTL_PRIVATE_SEL(setStoreAction_),
+      _MTL_PRIVATE_SEL(setClearColor_),
+      _MTL_PRIVATE_SEL(renderCommandEncoderWithDescriptor_),
+      _MTL_PRIVATE_SEL(endEncoding),
+      _MTL_PRIVATE_SEL(presentDrawable_),
+      _MTL_PRIVATE_SEL(commit),
+  };
+  for (SEL selector : selectors) {
+    asm volatile("" : : "r"(selector));
+  }
+}
+}  // namespace MTL
+
+namespace MTK {
+void touchFrameSelectors() {
+  const SEL selectors[] = {
+      _MTK_PRIVATE_SEL(currentDrawable),
+      _MTK_PRIVATE_SEL(clearColor),
+  };
+  for (SEL selector : selectors) {
+    asm volatile("" : : "r"(selector));
+  }
+}
+}  // namespace MTK
+
+int main() {
+  const auto mainTime = std::chrono::steady_clock::now();
+  const MockObjC::Statistics beforeMain = MockObjC::statistics();
+
+  MTL::touchFrameSelectors();
+  MTK::touchFrameSelectors();
+  const MockObjC::Statistics afterFrame = MockObjC::statistics();
+
+#if defined(MTL_PRIVATE_LAZY_SELECTORS)
+  std::cout << "mode:                      lazy\n";
+#else
+  std::cout << "mode:                      eager\n";
+#endif
+  std::cout << "registrations before main: " << beforeMain.selectorRegistrations
+            << "\n"
+            << "class lookups before main: " << beforeMain.classLookups << "\n"
+            << "pre-main time:             "
+            << std::chrono::duration<double, std::micro>(mainTime - g_startTime)
+                   .count()
+            << " us\n"
+            << "registrations after frame: " << afterFrame.selectorRegistrations
+            << "\n";
+  return 0;
+}
@@ -0,0 +1,161 @@
+// Counts the runtime messages NS::SharedPtr sends compared to hand-written
+// retain/release for the same ownership pattern: a list of owned objects,
+// grown one element at a time, plus a second list sharing every object.
+//
+// SharedPtr must send exactly what the manual code does. Taking every handle
+// by value costs two more retain/release pairs per object, and moving the
+// handles instead of sharing them saves the manual code's one pair. Every
+// scenario must free all its objects.
+//
+//   bench_shared_ptr [objects]
+#define NS_PRIVATE_IMPLEMENTATION
+#include <Foundation/NSPrivate.hpp>
+
+#include <Foundation/NSObject.hpp>
+#include <Foundation/NSSharedPtr.hpp>
+
+#include <MockObjC.hpp>
+
+#include <algorithm>
+#include <cstdint>
+#include <cstdlib>
+#include <iomanip>
+#include <iostream>
+#include <utility>
+#include <vector>
+
+namespace Bench {
+
+class Widget : public NS::Referencing<Widget> {
+ public:
+  static Widget *alloc() { return NS::Object::alloc<Widget>("Widget"); }
+  Widget *init() { return NS::Object::init<Widget>(); }
+};
+
+void manual(int count) {
+  std::vector<Widget *> owned;
+  for (int i = 0; i < count; ++i) {
+    owned.push_back(Widget::alloc()->init());
+  }
+  std::vector<Widget *> shared;
+  for (Widget *pWidget : owned) {
+    shared.push_back(pWidget->retain());
+  }
+  for (Widget *pWidget : owned) {
+    pWidget->release();
+  }
+  for (Widget *pWidget : shared) {
+    pWidget->release();
+  }
+}
+
+void sharedPtr(int count) {
+  std::vector<NS::SharedPtr<Widget>> owned;
+  for (int i = 0; i < count; ++i) {
+    owned.push_back(NS::TransferPtr(Widget::alloc()->init()));
+  }
+  std::vector<NS::SharedPtr<Widget>> shared(owned.begin(), owned.end());
+  owned.clear();
+  shared.clear();
+}
+
+// Same as sharedPtr(), but every handle also takes a by-value detour, the
+// pattern that costs a retain/release pair per call.
+void sharedPtrByValue(int count) {
+  std::vector<NS::SharedPtr<Widget>> owned;
+  auto append = [&owned](NS::SharedPtr<Widget> pWidget) {
+    owned.push_back(pWidget);
+  };
+  for (int i = 0; i < count; ++i) {
+    NS::SharedPtr<Widget> pWidget = NS::TransferPtr(Widget::alloc()->init());
+    append(pWidget);
+  }
+  std::vector<NS::SharedPtr<Widget>> shared(owned.begin(), owned.end());
+  owned.clear();
+  shared.clear();
+}
+
+// The owning list moves every handle into the second one, which shares
+// nothing.
+void sharedPtrMoved(int count) {
+  std::vector<NS::SharedPtr<Widget>> owned;
+  for (int i = 0; i < count; ++i) {
+    NS::SharedPtr<Widget> pWidget = NS::TransferPtr(Widget::alloc()->init());
+    owned.push_back(std::move(pWidget));
+  }
+  std::vector<NS::SharedPtr<Widget>> moved;
+  for (NS::SharedPtr<Widget> &pWidget : owned) {
+    moved.push_back(std::move(pWidget));
+  }
+  owned.clear();
+  moved.clear();
+}
+
+struct Counts {
+  std::uint64_t messages;
+  std::uint64_t retains;
+  std::uint64_t releases;
+  std::uint64_t leaked;
+
+  bool operator==(const Counts &) const = default;
+};
+
+Counts run(void (*pScenario)(int), int count) {
+  MockObjC::resetStatistics();
+  pScenario(count);
+  const MockObjC::Statistics stats = MockObjC::statistics();
+  return {stats.messagesSent, stats.retains, stats.releases,
+          stats.allocations - stats.deallocations};
+}
+
+void printCounts(const char *name, const Counts &counts) {
+  std::cout << std::left << std::setw(20) << name << std::right
+            << std::setw(10) << counts.messages << std::setw(10)
+            << counts.retains << std::setw(10) << counts.releases
+            << std::setw(10) << counts.leaked;
+}
+
+// Prints the row, and what was expected if it differs.
+bool report(const char *name, const Counts &counts, const Counts &expected) {
+  printCounts(name, counts);
+  const bool ok = counts == expected;
+  std::cout << std::setw(7) << (ok ? "ok" : "WRONG") << "\n";
+  if (!ok) {
+    printCounts("  expected", expected);
+    std::cout << "\n";
+  }
+  return ok;
+}
+
+}  // namespace Bench
+
+int main(int argc, char *argv[]) {
+  const int count = argc > 1 ? std::max(1, std::atoi(argv[1])) : 1000;
+  const auto objects = static_cast<std::uint64_t>(count);
+
+  MockObjC::defineClass("Widget");
+
+  std::cout << "objects: " << count << "\n"
+            << std::left << std::setw(20) << "scenario" << std::right
+            << std::setw(10) << "messages" << std::setw(10) << "retains"
+            << std::setw(10) << "releases" << std::setw(10) << "leaked"
+            << "\n";
+  // Every count is relative to the manual code, which must not leak either.
+  const Bench::Counts manual = Bench::run(&Bench::manual, count);
+  Bench::Counts expected = manual;
+  expected.leaked = 0;
+  bool allOk = Bench::report("manual", manual, expected);
+  allOk &= Bench::report("SharedPtr", Bench::run(&Bench::sharedPtr, count),
+                         expected);
+  allOk &= Bench::report("SharedPtr by value",
+                         Bench::run(&Bench::sharedPtrByValue, count),
+                         {expected.messages + 4 * objects,
+                          expected.retains + 2 * objects,
+                          expected.releases + 2 * objects, 0});
+  allOk &= Bench::report("SharedPtr moved",
+                         Bench::run(&Bench::sharedPtrMoved, count),
+                         {expected.messages - 2 * objects,
+                          expected.retains - objects,
+                          expected.releases - objects, 0});
+  return allOk ? EXIT_SUCCESS : EXIT_FAILURE;
+}
@@ -0,0 +1,138 @@
+// Times encoding one render pass of 10k to 200k draws with
+// ParallelPassEncoder on a growing number of threads. Every draw writes its
+// model matrix into the frame's uniform buffer, binds its slot and the shared
+// mesh and draws, so a range costs about the same on any thread.
+//
+// The executed command stream of each run is hashed and compared against the
+// same draws encoded serially on one RenderCommandEncoder, since the renderer
+// relies on draws executing in list order. Any difference fails.
+//
+//   bench_parallel_encode [max threads] [passes]
+#include <Gfx/JobSystem.hpp>
+#include <Gfx/ParallelPassEncoder.hpp>
+#include <Gfx/SoftwareBackend.hpp>
+
+#include <algorithm>
+#include <chrono>
+#include <cstdint>
+#include <cstdlib>
+#include <cstring>
+#include <iomanip>
+#include <iostream>
+#include <memory>
+#include <thread>
+
+namespace {
+
+constexpr std::size_t kMatrixLength = 16 * sizeof(float);
+
+struct Result {
+  double nsPerPass;
+  std::uint64_t digest;
+};
+
+// Shared by every thread count so the digests, which hash buffer addresses,
+// are comparable.
+struct Scene {
+  explicit Scene(std::size_t drawCount)
+      : draws(drawCount),
+        pQueue(device.newCommandQueue()),
+        pMesh(device.newBuffer(3 * 4 * sizeof(float))),
+        pUniforms(device.newBuffer(draws * kMatrixLength)) {}
+
+  std::size_t draws;
+  Gfx::SoftwareDevice device;
+  Gfx::SoftwareView view{64, 64, Gfx::PixelFormat::BGRA8Unorm};
+  std::unique_ptr<Gfx::CommandQueue> pQueue;
+  std::unique_ptr<Gfx::Buffer> pMesh;
+  std::unique_ptr<Gfx::Buffer> pUniforms;
+};
+
+void encodeRange(Scene &scene, Gfx::RenderCommandEncoder *pEncoder,
+                 std::size_t begin, std::size_t end) {
+  auto *pMatrices = static_cast<float *>(scene.pUniforms->contents());
+  for (std::size_t i = begin; i < end; ++i) {
+    float matrix[16] = {};
+    matrix[0] = matrix[5] = matrix[10] = matrix[15] = 1.0F;
+    matrix[12] = static_cast<float>(i);
+    std::memcpy(pMatrices + i * 16, matrix, sizeof(matrix));
+    pEncoder->setVertexBuffer(scene.pUniforms.get(), i * kMatrixLength, 1);
+    pEncoder->setVertexBuffer(scene.pMesh.get(), 0, 0);
+    pEncoder->drawPrimitives(Gfx::PrimitiveType::Triangle, 0, 3);
+  }
+}
+
+// Digest of every draw encoded in order on one encoder.
+std::uint64_t serialDigest(Scene &scene) {
+  auto *pCommandBuffer =
+      static_cast<Gfx::SoftwareCommandBuffer *>(scene.pQueue->commandBuffer());
+  Gfx::RenderCommandEncoder *pEncoder = pCommandBuffer->renderCommandEncoder(
+      scene.view.currentRenderPassDescriptor());
+  encodeRange(scene, pEncoder, 0, scene.draws);
+  pEncoder->endEncoding();
+  pCommandBuffer->commit();
+  pCommandBuffer->waitUntilCompleted();
+  return pCommandBuffer->executionDigest();
+}
+
+Result run(Scene &scene, std::size_t threads, int passes) {
+  Gfx::JobSystem jobSystem(threads);
+  Gfx::ParallelPassEncoder encoder(&jobSystem);
+  const auto encodeSceneRange = [&scene](Gfx::RenderCommandEncoder *pEncoder,
+                                         std::size_t begin, std::size_t end) {
+    encodeRange(scene, pEncoder, begin, end);
+  };
+
+  Result result{};
+  std::chrono::nanoseconds encodeTime{0};
+  for (int i = 0; i < passes; ++i) {
+    auto *pCommandBuffer = static_cast<Gfx::SoftwareCommandBuffer *>(
+        scene.pQueue->commandBuffer());
+    const Gfx::RenderPassDescriptor descriptor =
+        scene.view.currentRenderPassDescriptor();
+    const auto start = std::chrono::steady_clock::now();
+    encoder.encode(pCommandBuffer, descriptor, scene.draws, encodeSceneRange);
+    encodeTime += std::chrono::steady_clock::now() - start;
+    pCommandBuffer->commit();
+    pCommandBuffer->waitUntilCompleted();
+    result.digest = pCommandBuffer->executionDigest();
+  }
+  result.nsPerPass = static_cast<double>(encodeTime.count()) / passes;
+  return result;
+}
+
+}  // namespace
+
+int main(int argc, char *argv[]) {
+  const std::size_t maxThreads =
+      argc > 1 ? std::max(1, std::atoi(argv[1]))
+               : std::max(1U, std::thread::hardware_concurrency());
+  const int passes = argc > 2 ? std::max(1, std::atoi(argv[2])) : 20;
+
+  std::cout << "passes: " << passes
+            << ", hardware threads: " << std::thread::hardware_concurrency()
+            << "\n"
+            << std::setw(8) << "draws" << std::setw(8) << "threads"
+            << std::setw(12) << "us/pass" << std::setw(12) << "ns/draw"
+            << std::setw(10) << "speedup" << std::setw(8) << "order"
+            << "\n";
+  bool allOk = true;
+  for (std::size_t draws : {10000, 50000, 200000}) {
+    Scene scene(draws);
+    const std::uint64_t expected = serialDigest(scene);
+    const Result serial = run(scene, 1, passes);
+    for (std::size_t threads = 1; threads <= maxThreads; threads *= 2) {
+      const Result result =
+          threads == 1 ? serial : run(scene, threads, passes);
+      std::cout << std::setw(8) << draws << std::setw(8) << threads
+                << std::fixed << std::setprecision(1) << std::setw(12)
+                << result.nsPerPass / 1000.0 << std::setw(12)
+                << result.nsPerPass / static_cast<double>(draws)
+                << std::setprecision(2) << std::setw(10)
+                << serial.nsPerPass / result.nsPerPass << std::setw(8)
+                << (result.digest == expected ? "same" : "DIFFERS") << "\n";
+      allOk = allOk && result.digest == expected;
+    }
+  }
+  return allOk ? EXIT_SUCCESS : EXIT_FAILURE;
+}
@@ -0,0 +1,245 @@
+// Frame times while a scene's materials stream in, each with its own render
+// pipeline, against a software device whose pipeline compiles take a fixed
+// time:
+//
+//   sync    PipelineCache without a job system: a material's first frame
+//           compiles its pipeline before it can draw.
+//   async   PipelineCache on a job system: new materials draw with the
+//           fallback pipeline until theirs has compiled in the background.
+//
+// Frames are paced at 60 Hz, like a loop synced to the display, so
+// background compiles get the same wall time in both modes; frame times only
+// cover the frame's own work. "fallback" is the share of draws that went out
+// with the fallback, "ready" the first frame that drew everything with its
+// own pipeline. One material has no vertex function and must fail to
+// compile. Afterwards every pipeline is checked to have been compiled from
+// its own descriptor.
+//
+// The second table times lookups of ready pipelines by key from a growing
+// number of threads at once.
+//
+//   bench_pipeline_cache [max threads] [compile time us] [frames]
+#include <Gfx/JobSystem.hpp>
+#include <Gfx/PipelineCache.hpp>
+#include <Gfx/SoftwareBackend.hpp>
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <cstdlib>
+#include <iomanip>
+#include <iostream>
+#include <memory>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace {
+
+using Clock = std::chrono::steady_clock;
+
+constexpr std::size_t kMaterialCount = 64;
+constexpr std::size_t kMaterialsPerFrame = 8;
+constexpr std::size_t kDrawCount = 10000;
+// Has no vertex function.
+constexpr std::size_t kBrokenMaterial = 37;
+constexpr std::chrono::microseconds kFrameInterval{16667};
+
+struct Result {
+  double meanMs;
+  double worstMs;
+  double fallbackShare;
+  int readyFrame;
+  bool ok;
+};
+
+Gfx::RenderPipelineDescriptor materialDescriptor(std::size_t material) {
+  Gfx::RenderPipelineDescriptor descriptor;
+  descriptor.vertexFunction =
+      material == kBrokenMaterial ? "" : "vertex_main";
+  descriptor.fragmentFunction = "fragment_" + std::to_string(material);
+  descriptor.vertexDescriptor.attributes = {
+      {Gfx::VertexFormat::Float3, 0, 0},
+      {Gfx::VertexFormat::Float2, 12, 0}};
+  descriptor.vertexDescriptor.layouts = {{20}};
+  descriptor.colorAttachment.pixelFormat = Gfx::PixelFormat::BGRA8Unorm_sRGB;
+  if (material % 4 == 3) {
+    descriptor.colorAttachment.blendingEnabled = true;
+    descriptor.colorAttachment.sourceRGBBlendFactor =
+        Gfx::BlendFactor::SourceAlpha;
+    descriptor.colorAttachment.destinationRGBBlendFactor =
+        Gfx::BlendFactor::OneMinusSourceAlpha;
+  }
+  descriptor.sampleCount = material % 32 >= 16 ? 4 : 1;
+  return descriptor;
+}
+
+struct Scene {
+  explicit Scene(std::chrono::microseconds compileTime)
+      : device({}, compileTime), pQueue(device.newCommandQueue()) {
+    for (std::size_t i = 0; i < kMaterialCount; ++i) {
+      descriptors.push_back(materialDescriptor(i));
+      keys.push_back(Gfx::hashRenderPipelineDescriptor(descriptors.back()));
+    }
+    Gfx::RenderPipelineDescriptor fallbackDescriptor;
+    fallbackDescriptor.vertexFunction = "vertex_main";
+    fallbackDescriptor.fragmentFunction = "fragment_fallback";
+    pFallback = device.newRenderPipelineState(fallbackDescriptor);
+  }
+
+  Gfx::SoftwareDevice device;
+  Gfx::SoftwareView view{64, 64, Gfx::PixelFormat::BGRA8Unorm_sRGB};
+  std::unique_ptr<Gfx::CommandQueue> pQueue;
+  std::vector<Gfx::RenderPipelineDescriptor> descriptors;
+  std::vector<std::uint64_t> keys;
+  std::unique_ptr<Gfx::RenderPipelineState> pFallback;
+};
+
+// Every pipeline compiled from its own descriptor, except the broken one.
+bool checkPipelines(const Scene &scene, const Gfx::PipelineCache &cache) {
+  for (std::size_t i = 0; i < kMaterialCount; ++i) {
+    const Gfx::PipelineCache::Status expected =
+        i == kBrokenMaterial ? Gfx::PipelineCache::Status::Failed
+                             : Gfx::PipelineCache::Status::Ready;
+    if (cache.status(scene.keys[i]) != expected) {
+      return false;
+    }
+    const auto *pState = static_cast<const Gfx::SoftwareRenderPipelineState *>(
+        cache.find(scene.keys[i]));
+    if (pState != nullptr && Gfx::hashRenderPipelineDescriptor(
+                                 pState->descriptor()) != scene.keys[i]) {
+      return false;
+    }
+  }
+  return cache.size() == kMaterialCount;
+}
+
+Result run(Scene &scene, bool async, std::size_t threads, int frames) {
+  Gfx::JobSystem jobSystem(threads);
+  Gfx::PipelineCache cache(&scene.device, async ? &jobSystem : nullptr);
+  std::chrono::nanoseconds total{0};
+  std::chrono::nanoseconds worst{0};
+  std::size_t fallbackDraws = 0;
+  int readyFrame = -1;
+  for (int frame = 0; frame < frames; ++frame) {
+    const std::size_t materials = std::min(
+        kMaterialCount, (static_cast<std::size_t>(frame) + 1) *
+                            kMaterialsPerFrame);
+    const auto start = Clock::now();
+    auto *pCommandBuffer = scene.pQueue->commandBuffer();
+    Gfx::RenderCommandEncoder *pEncoder = pCommandBuffer->renderCommandEncoder(
+        scene.view.currentRenderPassDescriptor());
+    std::size_t frameFallbacks = 0;
+    for (std::size_t i = 0; i < kDrawCount; ++i) {
+      const std::size_t material = i * materials / kDrawCount;
+      Gfx::RenderPipelineState *pState =
+          cache.pipeline(scene.keys[material], scene.descriptors[material],
+                         scene.pFallback.get());
+      frameFallbacks += pState == scene.pFallback.get() &&
+                                material != kBrokenMaterial
+                            ? 1
+                            : 0;
+      pEncoder->setRenderPipelineState(pState);
+      pEncoder->drawPrimitives(Gfx::PrimitiveType::Triangle, 0, 3);
+    }
+    pEncoder->endEncoding();
+    pCommandBuffer->commit();
+    pCommandBuffer->waitUntilCompleted();
+    const auto elapsed = Clock::now() - start;
+    total += elapsed;
+    worst = std::max<std::chrono::nanoseconds>(worst, elapsed);
+    std::this_thread::sleep_until(start + kFrameInterval);
+    fallbackDraws += frameFallbacks;
+    if (readyFrame < 0 && frameFallbacks == 0 &&
+        materials == kMaterialCount) {
+      readyFrame = frame;
+    }
+  }
+  cache.wait();
+  return {std::chrono::duration<double, std::milli>(total).count() / frames,
+          std::chrono::duration<double, std::milli>(worst).count(),
+          static_cast<double>(fallbackDraws) /
+              static_cast<double>(kDrawCount * frames),
+          readyFrame, checkPipelines(scene, cache)};
+}
+
+// Nanoseconds per lookup of a ready pipeline, every thread looking up all
+// materials over and over.
+double timeLookups(Scene &scene, std::size_t threads) {
+  constexpr std::size_t kLookups = 1 << 20;
+  Gfx::PipelineCache cache(&scene.device, nullptr);
+  for (const Gfx::RenderPipelineDescriptor &descriptor : scene.descriptors) {
+    cache.prepare(descriptor);
+  }
+  std::atomic<std::size_t> found = 0;
+  std::vector<std::thread> workers;
+  const auto start = Clock::now();
+  for (std::size_t t = 0; t < threads; ++t) {
+    workers.emplace_back([&scene, &cache, &found, t] {
+      std::size_t hits = 0;
+      for (std::size_t i = 0; i < kLookups; ++i) {
+        hits += cache.find(scene.keys[(i + t) % kMaterialCount]) != nullptr
+                    ? 1
+                    : 0;
+      }
+      found.fetch_add(hits, std::memory_order_relaxed);
+    });
+  }
+  for (std::thread &worker : workers) {
+    worker.join();
+  }
+  const auto end = Clock::now();
+  return std::chrono::duration<double, std::nano>(end - start).count() /
+         static_cast<double>(kLookups);
+}
+
+}  // namespace
+
+int main(int argc, char *argv[]) {
+  const std::size_t maxThreads =
+      argc > 1 ? static_cast<std::size_t>(std::max(1, std::atoi(argv[1])))
+               : std::max(1U, std::thread::hardware_concurrency());
+  const std::chrono::microseconds compileTime(
+      argc > 2 ? std::max(0, std::atoi(argv[2])) : 5000);
+  const int frames = argc > 3 ? std::max(1, std::atoi(argv[3])) : 60;
+
+  Scene scene(compileTime);
+  std::cout << "materials: " << kMaterialCount << " (" << kMaterialsPerFrame
+            << " new a frame), draws: " << kDrawCount
+            << ", compile time: " << compileTime.count()
+            << " us, frames: " << frames << "\n"
+            << std::setw(7) << "mode" << std::setw(9) << "threads"
+            << std::setw(10) << "mean ms" << std::setw(10) << "worst ms"
+            << std::setw(10) << "fallback" << std::setw(7) << "ready"
+            << std::setw(6) << "" << "\n";
+  bool allOk = true;
+  for (const bool async : {false, true}) {
+    // The main thread only takes part while it waits, so async runs need a
+    // worker.
+    for (std::size_t threads = async ? 2 : 1;
+         threads <= std::max<std::size_t>(maxThreads, 2); threads *= 2) {
+      const Result result = run(scene, async, threads, frames);
+      std::cout << std::setw(7) << (async ? "async" : "sync") << std::setw(9)
+                << threads << std::fixed << std::setprecision(2)
+                << std::setw(10) << result.meanMs << std::setw(10)
+                << result.worstMs << std::setprecision(1) << std::setw(9)
+                << result.fallbackShare * 100.0 << "%" << std::setw(7)
+                << result.readyFrame << std::setw(6)
+                << (result.ok ? "ok" : "WRONG") << "\n";
+      allOk = allOk && result.ok;
+      if (!async) {
+        break;
+      }
+    }
+  }
+
+  std::cout << "\n"
+            << std::setw(9) << "threads" << std::setw(14) << "ns/lookup"
+            << "\n";
+  for (std::size_t threads = 1; threads <= maxThreads; threads *= 2) {
+    std::cout << std::setw(9) << threads << std::fixed << std::setprecision(2)
+              << std::setw(14) << timeLookups(scene, threads) << "\n";
+  }
+  return allOk ? EXIT_SUCCESS : EXIT_FAILURE;
+}
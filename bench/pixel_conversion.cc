@@ -0,0 +1,278 @@
+// Throughput of convertPixels for the pairs texture uploads and readbacks
+// hit most, at every SIMD level the CPU supports.
+//
+// GB/s counts the bytes read plus the bytes written. The source pixels are
+// random colors in [-0.1, 1.1] with some HDR values, encoded into the source
+// format. Every level's output is compared with the scalar one's, and with
+// decoding to RGBA32Float and encoding from it in two calls, which the
+// direct kernels have to match. After the table, the float formats and the
+// sRGB encoder are checked exhaustively:
+//
+//   halves    every RGBA16Float value decodes and re-encodes to itself, and
+//             every float encodes as the scalar code does.
+//   sRGB      floats in [0, 1] encode to the nearest sRGB code, computed in
+//             double precision.
+//   8-bit     every byte survives unorm and sRGB round trips.
+//
+//   bench_pixel_conversion [pixels]
+#include <Gfx/Math.hpp>
+#include <Gfx/PixelConversion.hpp>
+
+#include <chrono>
+#include <cmath>
+#include <cstdint>
+#include <cstdlib>
+#include <cstring>
+#include <iomanip>
+#include <iostream>
+#include <random>
+#include <string>
+#include <vector>
+
+namespace {
+
+using Clock = std::chrono::steady_clock;
+using Gfx::PixelFormat;
+
+constexpr int kFrames = 10;
+constexpr Gfx::SimdLevel kLevels[] = {Gfx::SimdLevel::Scalar,
+                                      Gfx::SimdLevel::SSE,
+                                      Gfx::SimdLevel::AVX2,
+                                      Gfx::SimdLevel::NEON};
+
+double seconds(Clock::time_point start) {
+  return std::chrono::duration<double>(Clock::now() - start).count();
+}
+
+struct Pair {
+  PixelFormat source;
+  PixelFormat destination;
+};
+
+const Pair kPairs[] = {
+    {PixelFormat::RGBA8Unorm, PixelFormat::BGRA8Unorm},
+    {PixelFormat::BGRA8Unorm_sRGB, PixelFormat::RGBA8Unorm},
+    {PixelFormat::RGBA8Unorm, PixelFormat::BGRA8Unorm_sRGB},
+    {PixelFormat::RGBA8Unorm, PixelFormat::RGBA32Float},
+    {PixelFormat::RGBA32Float, PixelFormat::RGBA8Unorm},
+    {PixelFormat::BGRA8Unorm_sRGB, PixelFormat::RGBA32Float},
+    {PixelFormat::RGBA32Float, PixelFormat::BGRA8Unorm_sRGB},
+    {PixelFormat::RGBA16Float, PixelFormat::RGBA32Float},
+    {PixelFormat::RGBA32Float, PixelFormat::RGBA16Float},
+    {PixelFormat::RGBA16Float, PixelFormat::BGRA8Unorm_sRGB},
+    {PixelFormat::RGB10A2Unorm, PixelFormat::BGR10A2Unorm},
+    {PixelFormat::RGB10A2Unorm, PixelFormat::BGRA8Unorm},
+    {PixelFormat::RGBA32Float, PixelFormat::RGB10A2Unorm},
+    {PixelFormat::RG11B10Float, PixelFormat::RGBA16Float},
+    {PixelFormat::RGBA32Float, PixelFormat::RG11B10Float},
+    {PixelFormat::Depth32Float, PixelFormat::Depth16Unorm},
+    {PixelFormat::Depth16Unorm, PixelFormat::RGBA32Float},
+};
+
+std::vector<float> makeColors(std::size_t pixelCount) {
+  std::mt19937 random(5);
+  std::uniform_real_distribution<float> value(-0.1F, 1.1F);
+  std::uniform_real_distribution<float> hdr(1.0F, 70000.0F);
+  std::vector<float> colors(4 * pixelCount);
+  for (std::size_t i = 0; i < colors.size(); ++i) {
+    colors[i] = i % 61 == 0 ? hdr(random) : value(random);
+  }
+  return colors;
+}
+
+std::vector<std::byte> encode(const std::vector<float> &colors,
+                              PixelFormat pixelFormat) {
+  std::vector<std::byte> pixels(colors.size() / 4 *
+                                Gfx::bytesPerPixel(pixelFormat));
+  Gfx::convertPixels(PixelFormat::RGBA32Float, colors.data(), pixelFormat,
+                     pixels.data(), colors.size() / 4);
+  return pixels;
+}
+
+// Source and destination bytes per second, in GB/s.
+double measure(const Pair &pair, const std::vector<std::byte> &source,
+               std::vector<std::byte> &destination, std::size_t pixelCount) {
+  Gfx::convertPixels(pair.source, source.data(), pair.destination,
+                     destination.data(), pixelCount);
+  const Clock::time_point start = Clock::now();
+  for (int frame = 0; frame < kFrames; ++frame) {
+    Gfx::convertPixels(pair.source, source.data(), pair.destination,
+                       destination.data(), pixelCount);
+  }
+  const double bytes = static_cast<double>(source.size() + destination.size());
+  return bytes * kFrames / seconds(start) / 1e9;
+}
+
+// Bit patterns 0 to 0xFFFF, each as all four channels of one pixel.
+bool checkHalves() {
+  std::vector<std::uint16_t> halves(4 * 65536);
+  for (std::size_t i = 0; i < halves.size(); ++i) {
+    halves[i] = static_cast<std::uint16_t>(i / 4);
+  }
+  std::vector<float> floats(halves.size());
+  std::vector<std::uint16_t> roundTrip(halves.size());
+  Gfx::convertPixels(PixelFormat::RGBA16Float, halves.data(),
+                     PixelFormat::RGBA32Float, floats.data(), 65536);
+  Gfx::convertPixels(PixelFormat::RGBA32Float, floats.data(),
+                     PixelFormat::RGBA16Float, roundTrip.data(), 65536);
+  for (std::size_t i = 0; i < halves.size(); ++i) {
+    const bool isNan = (halves[i] & 0x7C00) == 0x7C00 && (halves[i] & 0x3FF);
+    // NaNs come back quiet.
+    if (roundTrip[i] != (isNan ? halves[i] | 0x200 : halves[i])) {
+      return false;
+    }
+  }
+  return true;
+}
+
+// Float bit patterns in steps of stride, encoded to halves, against the
+// scalar encoder.
+bool checkHalfEncode(std::uint32_t stride,
+                     const std::vector<std::uint16_t> *pReference,
+                     std::vector<std::uint16_t> &halves) {
+  std::vector<float> floats;
+  for (std::uint64_t bits = 0; bits <= 0xFFFFFFFF; bits += stride) {
+    const auto pattern = static_cast<std::uint32_t>(bits);
+    float value;
+    std::memcpy(&value, &pattern, sizeof(value));
+    floats.push_back(value);
+  }
+  floats.resize(floats.size() / 4 * 4);
+  halves.resize(floats.size());
+  Gfx::convertPixels(PixelFormat::RGBA32Float, floats.data(),
+                     PixelFormat::RGBA16Float, halves.data(),
+                     floats.size() / 4);
+  return pReference == nullptr || halves == *pReference;
+}
+
+double srgbFromLinear(double value) {
+  return value <= 0.0031308 ? value * 12.92
+                            : 1.055 * std::pow(value, 1.0 / 2.4) - 0.055;
+}
+
+// Every stride-th float in [0, 1], as the red channel.
+bool checkSrgbEncode(std::uint32_t stride) {
+  constexpr std::size_t kBatch = 4096;
+  std::vector<float> colors(4 * kBatch, 1.0F);
+  std::vector<std::uint8_t> codes(4 * kBatch);
+  std::uint32_t bits = 0;
+  while (bits <= 0x3F800000) {
+    std::size_t count = 0;
+    for (; count < kBatch && bits <= 0x3F800000; ++count, bits += stride) {
+      std::memcpy(&colors[4 * count], &bits, sizeof(float));
+    }
+    Gfx::convertPixels(PixelFormat::RGBA32Float, colors.data(),
+                       PixelFormat::RGBA8Unorm_sRGB, codes.data(), count);
+    for (std::size_t i = 0; i < count; ++i) {
+      const double expected =
+          std::floor(srgbFromLinear(colors[4 * i]) * 255.0 + 0.5);
+      if (codes[4 * i] != expected) {
+        return false;
+      }
+    }
+  }
+  return true;
+}
+
+bool checkBytes() {
+  std::vector<std::uint8_t> bytes(4 * 256);
+  for (std::size_t i = 0; i < bytes.size(); ++i) {
+    bytes[i] = static_cast<std::uint8_t>(i / 4);
+  }
+  std::vector<float> floats(bytes.size());
+  std::vector<std::uint8_t> roundTrip(bytes.size());
+  for (PixelFormat pixelFormat :
+       {PixelFormat::RGBA8Unorm, PixelFormat::BGRA8Unorm_sRGB}) {
+    Gfx::convertPixels(pixelFormat, bytes.data(), PixelFormat::RGBA32Float,
+                       floats.data(), 256);
+    Gfx::convertPixels(PixelFormat::RGBA32Float, floats.data(), pixelFormat,
+                       roundTrip.data(), 256);
+    if (roundTrip != bytes) {
+      return false;
+    }
+  }
+  return true;
+}
+
+const char *verdict(bool passed) { return passed ? "ok" : "FAILED"; }
+
+}  // namespace
+
+int main(int argc, char **argv) {
+  const std::size_t pixelCount =
+      argc > 1 ? std::strtoull(argv[1], nullptr, 10) : std::size_t{1} << 20;
+  const Gfx::SimdLevel best = Gfx::simdLevel();
+  const std::vector<float> colors = makeColors(pixelCount);
+
+  std::cout << pixelCount << " pixels, GB/s read + written\n"
+            << std::left << std::setw(34) << "pair" << std::right;
+  for (Gfx::SimdLevel level : kLevels) {
+    if (Gfx::isSimdLevelSupported(level)) {
+      std::cout << std::setw(9) << Gfx::simdLevelName(level);
+    }
+  }
+  std::cout << "  output\n";
+
+  bool allSame = true;
+  for (const Pair &pair : kPairs) {
+    const std::vector<std::byte> source = encode(colors, pair.source);
+    std::vector<std::byte> destination(pixelCount *
+                                       Gfx::bytesPerPixel(pair.destination));
+
+    // Decoding and encoding in two calls never takes a direct kernel.
+    Gfx::setSimdLevel(Gfx::SimdLevel::Scalar);
+    std::vector<float> decoded(4 * pixelCount);
+    std::vector<std::byte> reference(destination.size());
+    Gfx::convertPixels(pair.source, source.data(), PixelFormat::RGBA32Float,
+                       decoded.data(), pixelCount);
+    Gfx::convertPixels(PixelFormat::RGBA32Float, decoded.data(),
+                       pair.destination, reference.data(), pixelCount);
+
+    const std::string name = std::string(Gfx::pixelFormatName(pair.source)) +
+                             " -> " + Gfx::pixelFormatName(pair.destination);
+    std::cout << std::left << std::setw(34) << name << std::right
+              << std::fixed << std::setprecision(2);
+    bool same = true;
+    for (Gfx::SimdLevel level : kLevels) {
+      if (!Gfx::setSimdLevel(level)) {
+        continue;
+      }
+      std::cout << std::setw(9)
+                << measure(pair, source, destination, pixelCount);
+      same = same && destination == reference;
+    }
+    std::cout << "  " << (same ? "same" : "DIFFERS") << "\n";
+    allSame = allSame && same;
+  }
+
+  bool halvesPassed = true;
+  bool halfEncodePassed = true;
+  bool srgbPassed = true;
+  bool bytesPassed = true;
+  std::vector<std::uint16_t> scalarHalves;
+  std::vector<std::uint16_t> halves;
+  for (Gfx::SimdLevel level : kLevels) {
+    if (!Gfx::setSimdLevel(level)) {
+      continue;
+    }
+    const bool isScalar = level == Gfx::SimdLevel::Scalar;
+    halvesPassed = halvesPassed && checkHalves();
+    halfEncodePassed =
+        checkHalfEncode(997, isScalar ? nullptr : &scalarHalves, halves) &&
+        halfEncodePassed;
+    if (isScalar) {
+      scalarHalves = halves;
+    }
+    srgbPassed = srgbPassed && checkSrgbEncode(61);
+    bytesPassed = bytesPassed && checkBytes();
+  }
+  Gfx::setSimdLevel(best);
+
+  std::cout << "\nhalves " << verdict(halvesPassed && halfEncodePassed)
+            << ", sRGB " << verdict(srgbPassed) << ", 8-bit "
+            << verdict(bytesPassed) << "\n";
+  return allSame && halvesPassed && halfEncodePassed && srgbPassed &&
+                 bytesPassed
+             ? EXIT_SUCCESS
+             : EXIT_FAILURE;
+}
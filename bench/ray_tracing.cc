@@ -0,0 +1,471 @@
+// Rays per second of the CPU ray tracer on an instanced scene: a terrain
+// mesh, a few thousand instances of a rock mesh scattered over it and some
+// bounding-box instances, behind one InstanceAccelerationStructure.
+//
+// "primary" rays come from a pinhole camera, ordered in 2x2 pixel quads so
+// each packet of four is coherent; "random" rays start anywhere in the
+// scene and go anywhere, which is the worst case for packets. Each kind is
+// traced in packets on 1 to max threads and one ray at a time on the calling
+// thread. Packet results have to match the single-ray ones exactly, and
+// "reference" checks kReferenceRays of the single-ray hits, spread over the
+// image, against a brute force over every primitive of every instance the
+// ray enters: the instance has to be the same and the distance equal to
+// within rounding. Any mismatch fails.
+// Passing an image path writes the primary hits as a PPM.
+//
+//   bench_ray_tracing [width] [max threads] [image.ppm]
+#include <Gfx/JobSystem.hpp>
+#include <Gfx/RayTracing.hpp>
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdlib>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <random>
+#include <string>
+#include <thread>
+#include <utility>
+#include <vector>
+
+namespace {
+
+using Clock = std::chrono::steady_clock;
+
+constexpr int kRepeats = 3;
+constexpr float kTerrainSize = 400.0F;
+constexpr std::uint32_t kTerrainResolution = 512;
+constexpr std::uint32_t kRockInstances = 4000;
+constexpr std::uint32_t kBoxInstances = 200;
+constexpr std::size_t kReferenceRays = 128;
+constexpr float kDistanceTolerance = 1e-4F;
+
+double seconds(Clock::time_point start) {
+  return std::chrono::duration<double>(Clock::now() - start).count();
+}
+
+float terrainHeight(float x, float z) {
+  return 8.0F * std::sin(x * 0.05F) * std::cos(z * 0.04F) +
+         2.0F * std::sin(x * 0.31F + z * 0.17F);
+}
+
+struct Mesh {
+  std::vector<Gfx::PackedFloat3> vertices;
+  std::vector<std::uint32_t> indices;
+
+  [[nodiscard]] Gfx::TriangleGeometryDescriptor descriptor() const {
+    Gfx::TriangleGeometryDescriptor result;
+    result.pVertices = vertices.data();
+    result.pIndices = indices.data();
+    result.triangleCount = indices.size() / 3;
+    return result;
+  }
+};
+
+Mesh makeTerrain() {
+  Mesh mesh;
+  const std::uint32_t n = kTerrainResolution;
+  for (std::uint32_t row = 0; row <= n; ++row) {
+    for (std::uint32_t column = 0; column <= n; ++column) {
+      const float x = kTerrainSize * static_cast<float>(column) / n;
+      const float z = kTerrainSize * static_cast<float>(row) / n;
+      mesh.vertices.push_back({x, terrainHeight(x, z), z});
+    }
+  }
+  for (std::uint32_t row = 0; row < n; ++row) {
+    for (std::uint32_t column = 0; column < n; ++column) {
+      const std::uint32_t i = row * (n + 1) + column;
+      mesh.indices.insert(mesh.indices.end(),
+                          {i, i + n + 1, i + 1, i + 1, i + n + 1, i + n + 2});
+    }
+  }
+  return mesh;
+}
+
+// A lumpy sphere of radius about 1.
+Mesh makeRock() {
+  Mesh mesh;
+  constexpr std::uint32_t kRings = 16;
+  constexpr std::uint32_t kSegments = 24;
+  for (std::uint32_t ring = 0; ring <= kRings; ++ring) {
+    const float theta = 3.14159265F * static_cast<float>(ring) / kRings;
+    for (std::uint32_t segment = 0; segment <= kSegments; ++segment) {
+      const float phi = 6.2831853F * static_cast<float>(segment) / kSegments;
+      const float radius = 1.0F + 0.15F * std::sin(5.0F * phi + 3.0F * theta);
+      mesh.vertices.push_back({radius * std::sin(theta) * std::cos(phi),
+                               radius * std::cos(theta),
+                               radius * std::sin(theta) * std::sin(phi)});
+    }
+  }
+  for (std::uint32_t ring = 0; ring < kRings; ++ring) {
+    for (std::uint32_t segment = 0; segment < kSegments; ++segment) {
+      const std::uint32_t i = ring * (kSegments + 1) + segment;
+      mesh.indices.insert(mesh.indices.end(),
+                          {i, i + kSegments + 1, i + 1, i + 1,
+                           i + kSegments + 1, i + kSegments + 2});
+    }
+  }
+  return mesh;
+}
+
+Gfx::AxisAlignedBoundingBox meshBounds(const Mesh &mesh) {
+  Gfx::Float4 lower = Gfx::Float4::fromPacked(mesh.vertices.front(), 0.0F);
+  Gfx::Float4 upper = lower;
+  for (const Gfx::PackedFloat3 &vertex : mesh.vertices) {
+    lower = min(lower, Gfx::Float4::fromPacked(vertex, 0.0F));
+    upper = max(upper, Gfx::Float4::fromPacked(vertex, 0.0F));
+  }
+  return {lower.toPacked(), upper.toPacked()};
+}
+
+struct Scene {
+  Scene() : terrain(makeTerrain()), rock(makeRock()) {
+    std::vector<Gfx::AxisAlignedBoundingBox> boxes;
+    for (int i = 0; i < 4; ++i) {
+      const float offset = static_cast<float>(i) * 1.5F;
+      boxes.push_back({{offset, 0.0F, 0.0F}, {offset + 1.0F, 3.0F, 1.0F}});
+    }
+    structures[0].build(terrain.descriptor());
+    structures[1].build(rock.descriptor());
+    structures[2].build(Gfx::BoundingBoxGeometryDescriptor{
+        boxes.data(), boxes.size()});
+    objectBounds[0] = meshBounds(terrain);
+    objectBounds[1] = meshBounds(rock);
+    objectBounds[2] = {boxes.front().min, boxes.back().max};
+
+    std::mt19937 random(17);
+    std::uniform_real_distribution<float> position(0.0F, kTerrainSize);
+    std::uniform_real_distribution<float> scale(0.5F, 3.0F);
+    std::uniform_real_distribution<float> angle(0.0F, 6.2831853F);
+    Gfx::AccelerationStructureInstanceDescriptor terrainInstance;
+    terrainInstance.transformationMatrix = Gfx::Float4x4::identity().toPacked();
+    instances.push_back(terrainInstance);
+    for (std::uint32_t i = 0; i < kRockInstances + kBoxInstances; ++i) {
+      const float x = position(random);
+      const float z = position(random);
+      const float size = scale(random);
+      Gfx::AccelerationStructureInstanceDescriptor instance;
+      instance.transformationMatrix =
+          (Gfx::Float4x4::translation(x, terrainHeight(x, z), z) *
+           Gfx::Float4x4::rotation({0.0F, 1.0F, 0.0F}, angle(random)) *
+           Gfx::Float4x4::scale(size, size, size))
+              .toPacked();
+      instance.accelerationStructureIndex = i < kRockInstances ? 1 : 2;
+      instances.push_back(instance);
+    }
+  }
+
+  void build(Gfx::JobSystem *pJobSystem) {
+    const Gfx::PrimitiveAccelerationStructure *pStructures[] = {
+        &structures[0], &structures[1], &structures[2]};
+    accelerationStructure.build(instances.data(), instances.size(),
+                                pStructures, pJobSystem);
+  }
+
+  Mesh terrain;
+  Mesh rock;
+  Gfx::PrimitiveAccelerationStructure structures[3];
+  // Of each structure's geometry, for the brute-force reference.
+  Gfx::AxisAlignedBoundingBox objectBounds[3];
+  std::vector<Gfx::AccelerationStructureInstanceDescriptor> instances;
+  Gfx::InstanceAccelerationStructure accelerationStructure;
+};
+
+// Primary rays of a camera above the terrain corner, 2x2 quads in a row.
+std::vector<Gfx::Ray> primaryRays(std::uint32_t width, std::uint32_t height) {
+  const Gfx::Float4 eye(-20.0F, 60.0F, -20.0F, 0.0F);
+  const Gfx::Float4 target(kTerrainSize * 0.5F, 0.0F, kTerrainSize * 0.5F,
+                           0.0F);
+  const Gfx::Float4 forward = target - eye;
+  const Gfx::Float4 w = forward * (1.0F / std::sqrt(dot3(forward, forward)));
+  const Gfx::Float4 across = cross3(w, Gfx::Float4(0.0F, 1.0F, 0.0F, 0.0F));
+  const Gfx::Float4 u = across * (1.0F / std::sqrt(dot3(across, across)));
+  const Gfx::Float4 v = cross3(u, w);
+  const float aspect = static_cast<float>(width) / static_cast<float>(height);
+
+  std::vector<Gfx::Ray> rays(static_cast<std::size_t>(width) * height);
+  std::size_t next = 0;
+  for (std::uint32_t y = 0; y < height; y += 2) {
+    for (std::uint32_t x = 0; x < width; x += 2) {
+      for (std::uint32_t quad = 0; quad < 4; ++quad) {
+        const std::uint32_t px = x + quad % 2;
+        const std::uint32_t py = y + quad / 2;
+        const float sx = (2.0F * (static_cast<float>(px) + 0.5F) /
+                              static_cast<float>(width) -
+                          1.0F) *
+                         aspect * 0.6F;
+        const float sy = (1.0F - 2.0F * (static_cast<float>(py) + 0.5F) /
+                                     static_cast<float>(height)) *
+                         0.6F;
+        Gfx::Ray &ray = rays[next++];
+        ray.origin = eye.toPacked();
+        ray.direction = (w + u * sx + v * sy).toPacked();
+      }
+    }
+  }
+  return rays;
+}
+
+std::vector<Gfx::Ray> randomRays(std::size_t count) {
+  std::mt19937 random(23);
+  std::uniform_real_distribution<float> position(0.0F, kTerrainSize);
+  std::uniform_real_distribution<float> height(0.0F, 30.0F);
+  std::uniform_real_distribution<float> direction(-1.0F, 1.0F);
+  std::vector<Gfx::Ray> rays(count);
+  for (Gfx::Ray &ray : rays) {
+    ray.origin = {position(random), height(random), position(random)};
+    ray.direction = {direction(random), direction(random), direction(random)};
+  }
+  return rays;
+}
+
+// Best time of kRepeats runs in packets.
+double tracePackets(const Scene &scene, const std::vector<Gfx::Ray> &rays,
+                    std::vector<Gfx::Intersection> &hits,
+                    Gfx::JobSystem *pJobSystem) {
+  hits.resize(rays.size());
+  double best = 1e30;
+  for (int repeat = 0; repeat < kRepeats; ++repeat) {
+    const auto start = Clock::now();
+    scene.accelerationStructure.intersect(rays.data(), hits.data(),
+                                          rays.size(), 0xFF, pJobSystem);
+    best = std::min(best, seconds(start));
+  }
+  return best;
+}
+
+double traceSingle(const Scene &scene, const std::vector<Gfx::Ray> &rays,
+                   std::vector<Gfx::Intersection> &hits) {
+  hits.resize(rays.size());
+  const auto start = Clock::now();
+  for (std::size_t i = 0; i < rays.size(); ++i) {
+    hits[i] = scene.accelerationStructure.intersect(rays[i]);
+  }
+  return seconds(start);
+}
+
+std::size_t countMatches(const std::vector<Gfx::Intersection> &a,
+                         const std::vector<Gfx::Intersection> &b) {
+  std::size_t matches = 0;
+  for (std::size_t i = 0; i < a.size(); ++i) {
+    matches += a[i].primitiveIndex == b[i].primitiveIndex &&
+               a[i].instanceIndex == b[i].instanceIndex &&
+               (a[i].distance == b[i].distance || !a[i].hit());
+  }
+  return matches;
+}
+
+// Slab test; on a hit, lower is where the ray enters the box.
+bool intersectBox(Gfx::Float4 origin, Gfx::Float4 direction,
+                  const Gfx::AxisAlignedBoundingBox &box, float &lower,
+                  float upper) {
+  for (int axis = 0; axis < 3; ++axis) {
+    float near = ((&box.min.x)[axis] - origin[axis]) / direction[axis];
+    float far = ((&box.max.x)[axis] - origin[axis]) / direction[axis];
+    if (near > far) {
+      std::swap(near, far);
+    }
+    lower = std::max(lower, near);
+    upper = std::min(upper, far);
+  }
+  return lower <= upper;
+}
+
+// Nearest hit of one ray without either level of hierarchy: every instance
+// transformed into object space and every primitive in it tested.
+Gfx::Intersection bruteForce(const Scene &scene, const Gfx::Ray &ray) {
+  Gfx::Intersection result;
+  float nearest = ray.maxDistance;
+  for (std::uint32_t index = 0; index < scene.instances.size(); ++index) {
+    const Gfx::AccelerationStructureInstanceDescriptor &instance =
+        scene.instances[index];
+    const Gfx::Float4x4 toObject =
+        Gfx::Float4x4::fromPacked(instance.transformationMatrix)
+            .affineInverse();
+    const Gfx::Float4 origin =
+        toObject * Gfx::Float4::fromPacked(ray.origin, 1.0F);
+    const Gfx::Float4 direction =
+        toObject * Gfx::Float4::fromPacked(ray.direction, 0.0F);
+    float enter = ray.minDistance;
+    if (!intersectBox(origin, direction,
+                      scene.objectBounds[instance.accelerationStructureIndex],
+                      enter, nearest)) {
+      continue;
+    }
+    const Gfx::PrimitiveAccelerationStructure &structure =
+        scene.structures[instance.accelerationStructureIndex];
+    for (std::uint32_t primitive = 0;
+         primitive < structure.triangles().size(); ++primitive) {
+      const auto &triangle = structure.triangles()[primitive];
+      const Gfx::Float4 vertex = Gfx::Float4::fromPacked(triangle.vertex, 0.0F);
+      const Gfx::Float4 edge1 = Gfx::Float4::fromPacked(triangle.edge1, 0.0F);
+      const Gfx::Float4 edge2 = Gfx::Float4::fromPacked(triangle.edge2, 0.0F);
+      const Gfx::Float4 p = cross3(direction, edge2);
+      const float determinant = dot3(edge1, p);
+      if (std::abs(determinant) < 1e-12F) {
+        continue;
+      }
+      const Gfx::Float4 s = origin - vertex;
+      const float u = dot3(s, p) / determinant;
+      const Gfx::Float4 q = cross3(s, edge1);
+      const float v = dot3(direction, q) / determinant;
+      const float t = dot3(edge2, q) / determinant;
+      if (0.0F <= u && 0.0F <= v && u + v <= 1.0F && ray.minDistance < t &&
+          t < nearest) {
+        nearest = t;
+        result = {t, primitive, index, u, v};
+      }
+    }
+    for (std::uint32_t primitive = 0; primitive < structure.boxes().size();
+         ++primitive) {
+      float lower = ray.minDistance;
+      if (intersectBox(origin, direction, structure.boxes()[primitive], lower,
+                       nearest) &&
+          lower < nearest) {
+        nearest = lower;
+        result = {lower, primitive, index, 0.0F, 0.0F};
+      }
+    }
+  }
+  return result;
+}
+
+// Checks every step-th hit, so the brute force stays quick at any width.
+std::size_t countReferenceMatches(const Scene &scene,
+                                  const std::vector<Gfx::Ray> &rays,
+                                  const std::vector<Gfx::Intersection> &hits,
+                                  std::size_t step) {
+  std::size_t matches = 0;
+  for (std::size_t i = 0; i < rays.size(); i += step) {
+    const Gfx::Intersection expected = bruteForce(scene, rays[i]);
+    const Gfx::Intersection &hit = hits[i];
+    matches += hit.hit() == expected.hit() &&
+               (!hit.hit() ||
+                (hit.instanceIndex == expected.instanceIndex &&
+                 std::abs(hit.distance - expected.distance) <=
+                     kDistanceTolerance * std::max(1.0F, expected.distance)));
+  }
+  return matches;
+}
+
+void writeImage(const char *pPath, std::uint32_t width, std::uint32_t height,
+                const std::vector<Gfx::Intersection> &hits) {
+  std::vector<unsigned char> pixels(static_cast<std::size_t>(width) * height *
+                                    3);
+  std::size_t next = 0;
+  for (std::uint32_t y = 0; y < height; y += 2) {
+    for (std::uint32_t x = 0; x < width; x += 2) {
+      for (std::uint32_t quad = 0; quad < 4; ++quad) {
+        const Gfx::Intersection &hit = hits[next++];
+        const std::size_t pixel =
+            (static_cast<std::size_t>(y + quad / 2) * width + x + quad % 2) *
+            3;
+        if (!hit.hit()) {
+          pixels[pixel] = 120;
+          pixels[pixel + 1] = 160;
+          pixels[pixel + 2] = 220;
+          continue;
+        }
+        const float fog = std::clamp(1.0F - hit.distance / 700.0F, 0.1F, 1.0F);
+        const std::uint32_t hash = hit.instanceIndex * 2654435761U;
+        const float tint[3] = {
+            hit.instanceIndex == 0 ? 0.4F : 0.5F + (hash >> 24) / 512.0F,
+            hit.instanceIndex == 0 ? 0.7F : 0.5F + (hash >> 16 & 255) / 512.0F,
+            hit.instanceIndex == 0 ? 0.3F : 0.5F + (hash >> 8 & 255) / 512.0F};
+        for (int channel = 0; channel < 3; ++channel) {
+          pixels[pixel + channel] =
+              static_cast<unsigned char>(255.0F * tint[channel] * fog);
+        }
+      }
+    }
+  }
+  std::ofstream file(pPath, std::ios::binary);
+  file << "P6\n" << width << " " << height << "\n255\n";
+  file.write(reinterpret_cast<const char *>(pixels.data()),
+             static_cast<std::streamsize>(pixels.size()));
+}
+
+}  // namespace
+
+int main(int argc, char *argv[]) {
+  const std::uint32_t width =
+      argc > 1 ? static_cast<std::uint32_t>(std::max(2, std::atoi(argv[1])) &
+                                            ~1)
+               : 512;
+  const std::uint32_t height = width * 3 / 4 & ~1U;
+  const std::size_t maxThreads =
+      argc > 2 ? static_cast<std::size_t>(std::max(1, std::atoi(argv[2])))
+               : std::max(1U, std::thread::hardware_concurrency());
+
+  Scene scene;
+  {
+    Gfx::JobSystem jobSystem(maxThreads);
+    const auto start = Clock::now();
+    scene.build(&jobSystem);
+    std::cout << "hardware threads: " << std::thread::hardware_concurrency()
+              << ", triangles: "
+              << scene.terrain.indices.size() / 3 +
+                     kRockInstances * (scene.rock.indices.size() / 3)
+              << " in " << scene.accelerationStructure.instanceCount()
+              << " instances, top level built in " << std::fixed
+              << std::setprecision(2) << seconds(start) * 1e3 << " ms\n";
+  }
+
+  const std::vector<Gfx::Ray> primary = primaryRays(width, height);
+  const std::vector<Gfx::Ray> random = randomRays(primary.size());
+  std::vector<Gfx::Intersection> primaryHits;
+  bool allOk = true;
+  for (const auto &[pName, pRays] :
+       {std::pair{"primary", &primary}, std::pair{"random", &random}}) {
+    std::vector<Gfx::Intersection> single;
+    const double singleTime = traceSingle(scene, *pRays, single);
+    const auto hitCount = std::count_if(
+        single.begin(), single.end(),
+        [](const Gfx::Intersection &hit) { return hit.hit(); });
+    std::cout << pName << " rays: " << pRays->size() << ", hits: " << hitCount
+              << "\n"
+              << std::setw(10) << "mode" << std::setw(9) << "threads"
+              << std::setw(12) << "Mrays/s" << std::setw(10) << "speedup"
+              << std::setw(18) << "matches" << "\n"
+              << std::setw(10) << "single" << std::setw(9) << 1
+              << std::setprecision(2) << std::setw(12)
+              << static_cast<double>(pRays->size()) / singleTime / 1e6
+              << std::setw(10) << 1.0 << "\n";
+    const std::size_t step = std::max<std::size_t>(
+        1, pRays->size() / kReferenceRays);
+    const std::size_t referenceMatches =
+        countReferenceMatches(scene, *pRays, single, step);
+    const std::size_t referenceCount = (pRays->size() + step - 1) / step;
+    std::cout << std::setw(10) << "reference" << std::setw(9) << ""
+              << std::setw(12) << "" << std::setw(10) << "" << std::setw(18)
+              << (std::to_string(referenceMatches) + "/" +
+                  std::to_string(referenceCount))
+              << "\n";
+    allOk = allOk && referenceMatches == referenceCount;
+    for (std::size_t threads = 1; threads <= maxThreads; threads *= 2) {
+      Gfx::JobSystem jobSystem(threads);
+      std::vector<Gfx::Intersection> hits;
+      const double time = tracePackets(scene, *pRays, hits, &jobSystem);
+      const std::size_t matches = countMatches(hits, single);
+      std::cout << std::setw(10) << "packet" << std::setw(9) << threads
+                << std::setw(12)
+                << static_cast<double>(pRays->size()) / time / 1e6
+                << std::setw(10) << singleTime / time << std::setw(18)
+                << (std::to_string(matches) + "/" +
+                    std::to_string(hits.size()))
+                << "\n";
+      allOk = allOk && matches == hits.size();
+      if (pRays == &primary) {
+        primaryHits = std::move(hits);
+      }
+    }
+  }
+
+  if (argc > 3) {
+    writeImage(argv[3], width, height, primaryHits);
+    std::cout << "wrote " << argv[3] << "\n";
+  }
+  return allOk ? EXIT_SUCCESS : EXIT_FAILURE;
+}
@@ -0,0 +1,179 @@
+// Counts backend messages and retains per draw for a pass of 10k to 200k
+// draws that sets all of its state before every draw, encoded straight into
+// the encoder and through a RenderStateFilter:
+//
+//   sorted    draws ordered by mesh and texture, as after sorting a
+//             RenderQueue, so neighbours mostly share both.
+//   shuffled  the same draws in random order; only the pass-wide state
+//             repeats.
+//
+// Every draw sets the viewport, scissor rect, cull mode and winding, which
+// are the same for the whole pass, binds its mesh and texture, and binds the
+// pass's uniform buffer at its own offset. The filtered pass has to execute
+// exactly what the unfiltered one does; "order" compares their digests.
+//
+//   bench_render_state_filter [passes]
+#include <Gfx/CountingBackend.hpp>
+#include <Gfx/RenderStateFilter.hpp>
+#include <Gfx/SoftwareBackend.hpp>
+
+#include <algorithm>
+#include <chrono>
+#include <cstdint>
+#include <cstdlib>
+#include <iomanip>
+#include <iostream>
+#include <memory>
+#include <random>
+#include <vector>
+
+namespace {
+
+using Clock = std::chrono::steady_clock;
+
+constexpr std::size_t kMatrixLength = 16 * sizeof(float);
+constexpr std::size_t kMeshCount = 64;
+constexpr std::size_t kTextureCount = 256;
+
+struct Draw {
+  std::uint32_t mesh;
+  std::uint32_t texture;
+};
+
+struct Result {
+  double messagesPerDraw;
+  double retainsPerDraw;
+  double nsPerDraw;
+  Gfx::RenderStateFilterStatistics filtered;
+  std::uint64_t digest;
+};
+
+struct Scene {
+  Scene(std::size_t drawCount, bool shuffled)
+      : draws(drawCount),
+        pQueue(device.newCommandQueue()),
+        pUniforms(device.newBuffer(drawCount * kMatrixLength)) {
+    for (std::size_t i = 0; i < kMeshCount; ++i) {
+      meshes.push_back(device.newBuffer(64 * 4 * sizeof(float)));
+    }
+    for (std::size_t i = 0; i < kTextureCount; ++i) {
+      textures.push_back(
+          device.newTexture(4, 4, Gfx::PixelFormat::RGBA8Unorm));
+    }
+    // Each mesh is drawn with a few textures, each texture with one mesh.
+    for (std::size_t i = 0; i < drawCount; ++i) {
+      const auto texture =
+          static_cast<std::uint32_t>(i * kTextureCount / drawCount);
+      draws[i] = {static_cast<std::uint32_t>(
+                      texture * kMeshCount / kTextureCount),
+                  texture};
+    }
+    if (shuffled) {
+      std::shuffle(draws.begin(), draws.end(), std::mt19937(42));
+    }
+  }
+
+  std::vector<Draw> draws;
+  Gfx::SoftwareDevice softwareDevice;
+  Gfx::CountingDevice device{&softwareDevice};
+  Gfx::SoftwareView view{64, 64, Gfx::PixelFormat::BGRA8Unorm};
+  std::unique_ptr<Gfx::CommandQueue> pQueue;
+  std::unique_ptr<Gfx::Buffer> pUniforms;
+  std::vector<std::unique_ptr<Gfx::Buffer>> meshes;
+  std::vector<std::unique_ptr<Gfx::Texture>> textures;
+};
+
+void encode(const Scene &scene, Gfx::RenderCommandEncoder *pEncoder) {
+  const Gfx::Viewport viewport{0.0, 0.0, 64.0, 64.0, 0.0, 1.0};
+  const Gfx::ScissorRect scissorRect{0, 0, 64, 64};
+  for (std::size_t i = 0; i < scene.draws.size(); ++i) {
+    const Draw &draw = scene.draws[i];
+    pEncoder->setViewport(viewport);
+    pEncoder->setScissorRect(scissorRect);
+    pEncoder->setCullMode(Gfx::CullMode::Back);
+    pEncoder->setFrontFacingWinding(Gfx::Winding::CounterClockwise);
+    pEncoder->setVertexBuffer(scene.meshes[draw.mesh].get(), 0, 0);
+    pEncoder->setVertexBuffer(scene.pUniforms.get(), i * kMatrixLength, 1);
+    pEncoder->setFragmentTexture(scene.textures[draw.texture].get(), 0);
+    pEncoder->drawPrimitives(Gfx::PrimitiveType::Triangle, 0, 3);
+  }
+}
+
+Result run(Scene &scene, bool filtered, int passes) {
+  Gfx::RenderStateFilter filter;
+  std::chrono::nanoseconds encodeTime{0};
+  std::uint64_t digest = 0;
+  scene.device.resetStatistics();
+  for (int pass = 0; pass < passes; ++pass) {
+    auto *pCommandBuffer = static_cast<Gfx::CountingCommandBuffer *>(
+        scene.pQueue->commandBuffer());
+    const Gfx::RenderPassDescriptor descriptor =
+        scene.view.currentRenderPassDescriptor();
+    const auto start = Clock::now();
+    Gfx::RenderCommandEncoder *pEncoder =
+        pCommandBuffer->renderCommandEncoder(descriptor);
+    if (filtered) {
+      filter.reset(pEncoder);
+      pEncoder = &filter;
+    }
+    encode(scene, pEncoder);
+    pEncoder->endEncoding();
+    encodeTime += Clock::now() - start;
+    pCommandBuffer->commit();
+    pCommandBuffer->waitUntilCompleted();
+    digest = static_cast<Gfx::SoftwareCommandBuffer *>(
+                 pCommandBuffer->commandBuffer())
+                 ->executionDigest();
+  }
+  const Gfx::CountingStatistics stats = scene.device.statistics();
+  const auto perDraw = [&stats](std::uint64_t value) {
+    return static_cast<double>(value) / static_cast<double>(stats.drawCalls);
+  };
+  return {perDraw(stats.messages), perDraw(stats.retains),
+          static_cast<double>(encodeTime.count()) /
+              static_cast<double>(stats.drawCalls),
+          filter.statistics(), digest};
+}
+
+}  // namespace
+
+int main(int argc, char *argv[]) {
+  const int passes = argc > 1 ? std::max(1, std::atoi(argv[1])) : 10;
+
+  std::cout << "passes: " << passes << "\n"
+            << std::setw(8) << "draws" << std::setw(10) << "order"
+            << std::setw(10) << "filter" << std::setw(11) << "msgs/draw"
+            << std::setw(13) << "retains/draw" << std::setw(12)
+            << "dropped/drw" << std::setw(12) << "offsets/drw"
+            << std::setw(10) << "ns/draw" << std::setw(9) << "digest"
+            << "\n";
+  bool allSame = true;
+  for (const std::size_t draws : {10000, 50000, 200000}) {
+    for (const bool shuffled : {false, true}) {
+      Scene scene(draws, shuffled);
+      const Result direct = run(scene, false, passes);
+      for (const bool filtered : {false, true}) {
+        const Result result = filtered ? run(scene, true, passes) : direct;
+        const bool same = result.digest == direct.digest;
+        const double drawCount = static_cast<double>(draws) * passes;
+        std::cout << std::setw(8) << draws << std::setw(10)
+                  << (shuffled ? "shuffled" : "sorted") << std::setw(10)
+                  << (filtered ? "on" : "off") << std::fixed
+                  << std::setprecision(2) << std::setw(11)
+                  << result.messagesPerDraw << std::setw(13)
+                  << result.retainsPerDraw << std::setw(12)
+                  << static_cast<double>(result.filtered.eliminated()) /
+                         drawCount
+                  << std::setw(12)
+                  << static_cast<double>(
+                         result.filtered.vertexBufferOffsets) /
+                         drawCount
+                  << std::setprecision(1) << std::setw(10)
+                  << result.nsPerDraw << std::setw(9)
+                  << (same ? "same" : "DIFFERS") << "\n";
+        allSame = allSame && same;
+      }
+    }
+  }
+  return allSame ? EXIT_SUCCESS : EXIT_FAILURE;
+}
@@ -0,0 +1,86 @@
+// Destroys a Renderer while its frames are still in flight on a software
+// device with GPU completion latency. Each frame executes the renderer's
+// indirect command buffers and binds its per-draw uniforms, so destruction
+// has to wait for every frame before it frees either.
+//
+// "teardown" is how long the renderer took to destroy, "presented" the
+// frames the view had presented by then, which must be all of them. Build
+// with -fsanitize=address to also catch memory freed while the queue still
+// reads it.
+//
+//   bench_renderer_teardown [draws] [gpu latency us]
+#include <Gfx/Renderer.hpp>
+#include <Gfx/SoftwareBackend.hpp>
+
+#include <algorithm>
+#include <chrono>
+#include <cstdlib>
+#include <iomanip>
+#include <iostream>
+#include <memory>
+
+namespace {
+
+using Clock = std::chrono::steady_clock;
+
+constexpr std::size_t kUniformLength = 256;
+
+}  // namespace
+
+int main(int argc, char *argv[]) {
+  const std::size_t drawCount =
+      static_cast<std::size_t>(argc > 1 ? std::max(1, std::atoi(argv[1]))
+                                        : 1000);
+  const std::chrono::microseconds gpuLatency(
+      argc > 2 ? std::max(1, std::atoi(argv[2])) : 20000);
+
+  std::cout << "draws: " << drawCount << ", gpu latency: "
+            << gpuLatency.count() << " us\n"
+            << std::setw(10) << "in flight" << std::setw(13) << "teardown ms"
+            << std::setw(11) << "presented" << std::setw(6) << "" << "\n";
+  bool allOk = true;
+  for (std::size_t depth = 1;
+       depth <= Gfx::Renderer::kDefaultMaxFramesInFlight; ++depth) {
+    Gfx::SoftwareDevice device(gpuLatency);
+    Gfx::SoftwareView view(64, 64, Gfx::PixelFormat::BGRA8Unorm, depth + 1);
+    const std::unique_ptr<Gfx::Buffer> pMesh =
+        device.newBuffer(64 * 4 * sizeof(float));
+
+    auto pRenderer = std::make_unique<Gfx::Renderer>(&device, depth);
+    pRenderer->setDrawUniformCapacity(kUniformLength);
+    pRenderer->setIndirectDrawList(
+        drawCount, [&pMesh](Gfx::IndirectCommandBuffer *pCommands,
+                            std::size_t, std::size_t begin, std::size_t end) {
+          for (std::size_t i = begin; i < end; ++i) {
+            pCommands->setVertexBuffer(i, pMesh.get(), 0, 0);
+            pCommands->drawPrimitives(i, Gfx::PrimitiveType::Triangle, 0, 3,
+                                      1, 0);
+          }
+        });
+    pRenderer->indirectDraws()->addResource(pMesh.get());
+    pRenderer->setEncodeHandler([](Gfx::RenderCommandEncoder *pEncoder,
+                                   const Gfx::FrameResources &resources) {
+      const Gfx::UniformAllocation uniforms =
+          resources.pDrawUniforms->allocate(kUniformLength);
+      pEncoder->setVertexBuffer(uniforms.pBuffer, uniforms.offset, 1);
+      pEncoder->drawPrimitives(Gfx::PrimitiveType::Triangle, 0, 3);
+    });
+    // Every frame of the ring is still queued when the renderer goes.
+    for (std::size_t i = 0; i < depth; ++i) {
+      pRenderer->draw(&view);
+    }
+    const auto start = Clock::now();
+    pRenderer.reset();
+    const double teardownMs =
+        std::chrono::duration<double, std::milli>(Clock::now() - start)
+            .count();
+
+    const std::uint64_t presented = view.presentedCount();
+    const bool ok = presented == depth;
+    std::cout << std::setw(10) << depth << std::fixed << std::setprecision(2)
+              << std::setw(13) << teardownMs << std::setw(11) << presented
+              << std::setw(6) << (ok ? "ok" : "WRONG") << "\n";
+    allOk = allOk && ok;
+  }
+  return allOk ? EXIT_SUCCESS : EXIT_FAILURE;
+}
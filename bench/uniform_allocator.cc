@@ -0,0 +1,303 @@
+// Contention of per-draw constant allocation across encoding threads. Each
+// frame, N threads split 64k draws between them; every draw allocates a
+// slice for its 64-byte model matrix and writes it:
+//
+//   atomic      UniformAllocator, one fetch-add per draw.
+//   block       a UniformBlockAllocator per thread over the same allocator,
+//               one fetch-add per 64 draws.
+//   mutex       the same bump pointer behind a std::mutex.
+//   new buffer  a SoftwareDevice buffer per draw, released after the frame.
+//
+// ns/draw is wall time per draw across all threads, so a flat column means
+// allocation doesn't serialize the threads. With fewer cores than threads it
+// also includes time slicing. After every frame each slice is checked for its
+// alignment and against overlapping another, and its matrix read back.
+//
+//   bench_uniform_allocator [max threads] [frames]
+#include <Gfx/SoftwareBackend.hpp>
+#include <Gfx/UniformAllocator.hpp>
+
+#include <algorithm>
+#include <atomic>
+#include <barrier>
+#include <chrono>
+#include <cstdint>
+#include <cstdlib>
+#include <cstring>
+#include <iomanip>
+#include <iostream>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace {
+
+using Clock = std::chrono::steady_clock;
+
+constexpr std::size_t kDrawsPerFrame = 64 * 1024;
+constexpr std::size_t kFramesInFlight = 3;
+constexpr std::size_t kMatrixFloats = 16;
+
+double seconds(Clock::time_point start) {
+  return std::chrono::duration<double>(Clock::now() - start).count();
+}
+
+// Where a draw's matrix went: a position in some buffer, and its contents.
+struct Slice {
+  const void *pBuffer;
+  std::size_t offset;
+  float *pMatrix;
+};
+
+class AtomicStrategy {
+ public:
+  explicit AtomicStrategy(Gfx::Device *pDevice)
+      : _allocator(pDevice, kDrawsPerFrame * Gfx::UniformAllocator::
+                                                 kDefaultAlignment,
+                   kFramesInFlight) {}
+
+  void beginFrame(std::size_t slot) { _allocator.beginFrame(slot); }
+  Slice allocate(std::size_t /*thread*/) {
+    const Gfx::UniformAllocation allocation =
+        _allocator.allocate(kMatrixFloats * sizeof(float));
+    return {allocation.pBuffer, allocation.offset,
+            static_cast<float *>(allocation.pContents)};
+  }
+  void endFrame() {}
+  [[nodiscard]] std::size_t alignment() const {
+    return _allocator.alignment();
+  }
+
+ private:
+  Gfx::UniformAllocator _allocator;
+};
+
+class BlockStrategy {
+ public:
+  BlockStrategy(Gfx::Device *pDevice, std::size_t threads)
+      : _allocator(pDevice, kDrawsPerFrame * Gfx::UniformAllocator::
+                                                 kDefaultAlignment,
+                   kFramesInFlight),
+        _threads(threads) {
+    for (ThreadBlock &thread : _threads) {
+      thread.pAllocator =
+          std::make_unique<Gfx::UniformBlockAllocator>(&_allocator);
+    }
+  }
+
+  void beginFrame(std::size_t slot) {
+    _allocator.beginFrame(slot);
+    for (ThreadBlock &thread : _threads) {
+      thread.pAllocator->reset();
+    }
+  }
+  Slice allocate(std::size_t thread) {
+    const Gfx::UniformAllocation allocation =
+        _threads[thread].pAllocator->allocate(kMatrixFloats * sizeof(float));
+    return {allocation.pBuffer, allocation.offset,
+            static_cast<float *>(allocation.pContents)};
+  }
+  void endFrame() {}
+  [[nodiscard]] std::size_t alignment() const {
+    return _allocator.alignment();
+  }
+
+ private:
+  // Each thread's block on its own cache line.
+  struct alignas(64) ThreadBlock {
+    std::unique_ptr<Gfx::UniformBlockAllocator> pAllocator;
+  };
+
+  Gfx::UniformAllocator _allocator;
+  std::vector<ThreadBlock> _threads;
+};
+
+class MutexStrategy {
+ public:
+  explicit MutexStrategy(Gfx::Device *pDevice)
+      : _pBuffer(pDevice->newBuffer(kFramesInFlight * kBytesPerFrame)),
+        _pContents(static_cast<std::uint8_t *>(_pBuffer->contents())) {}
+
+  void beginFrame(std::size_t slot) {
+    _frameOffset = slot * kBytesPerFrame;
+    _head = 0;
+  }
+  Slice allocate(std::size_t /*thread*/) {
+    std::size_t offset;
+    {
+      std::lock_guard<std::mutex> lock(_mutex);
+      offset = _frameOffset + _head;
+      _head += Gfx::UniformAllocator::kDefaultAlignment;
+    }
+    return {_pBuffer.get(), offset,
+            reinterpret_cast<float *>(_pContents + offset)};
+  }
+  void endFrame() {}
+  [[nodiscard]] static std::size_t alignment() {
+    return Gfx::UniformAllocator::kDefaultAlignment;
+  }
+
+ private:
+  static constexpr std::size_t kBytesPerFrame =
+      kDrawsPerFrame * Gfx::UniformAllocator::kDefaultAlignment;
+
+  std::unique_ptr<Gfx::Buffer> _pBuffer;
+  std::uint8_t *_pContents;
+  std::mutex _mutex;
+  std::size_t _frameOffset = 0;
+  std::size_t _head = 0;
+};
+
+class BufferStrategy {
+ public:
+  BufferStrategy(Gfx::Device *pDevice, std::size_t threads)
+      : _pDevice(pDevice), _buffers(threads) {}
+
+  void beginFrame(std::size_t /*slot*/) {}
+  Slice allocate(std::size_t thread) {
+    std::vector<std::unique_ptr<Gfx::Buffer>> &buffers = _buffers[thread];
+    buffers.push_back(_pDevice->newBuffer(kMatrixFloats * sizeof(float)));
+    return {buffers.back().get(), 0,
+            static_cast<float *>(buffers.back()->contents())};
+  }
+  void endFrame() {
+    for (auto &buffers : _buffers) {
+      buffers.clear();
+    }
+  }
+  [[nodiscard]] static std::size_t alignment() { return 1; }
+
+ private:
+  Gfx::Device *_pDevice;
+  std::vector<std::vector<std::unique_ptr<Gfx::Buffer>>> _buffers;
+};
+
+// Every slice is aligned, apart from every other in its buffer, and holds
+// the matrix written for its draw.
+bool checkSlices(const std::vector<std::vector<Slice>> &slices,
+                 std::size_t alignment) {
+  std::vector<Slice> all;
+  for (std::size_t thread = 0; thread < slices.size(); ++thread) {
+    for (std::size_t i = 0; i < slices[thread].size(); ++i) {
+      const Slice &slice = slices[thread][i];
+      if (slice.pMatrix == nullptr || slice.offset % alignment != 0 ||
+          slice.pMatrix[12] != static_cast<float>(thread) ||
+          slice.pMatrix[13] != static_cast<float>(i)) {
+        return false;
+      }
+      all.push_back(slice);
+    }
+  }
+  std::sort(all.begin(), all.end(), [](const Slice &a, const Slice &b) {
+    return a.pBuffer != b.pBuffer ? a.pBuffer < b.pBuffer
+                                  : a.offset < b.offset;
+  });
+  for (std::size_t i = 1; i < all.size(); ++i) {
+    if (all[i].pBuffer == all[i - 1].pBuffer &&
+        all[i].offset - all[i - 1].offset < kMatrixFloats * sizeof(float)) {
+      return false;
+    }
+  }
+  return true;
+}
+
+struct Result {
+  double nsPerDraw;
+  bool correct;
+};
+
+template <typename Strategy>
+Result run(Strategy &strategy, std::size_t threads, int frames) {
+  std::vector<std::vector<Slice>> slices(threads);
+  const std::size_t drawsPerThread = kDrawsPerFrame / threads;
+  for (std::vector<Slice> &threadSlices : slices) {
+    threadSlices.reserve(drawsPerThread);
+  }
+
+  // The main thread waits at both barriers without drawing: once to start
+  // a frame, once for every thread to finish it.
+  std::barrier sync(static_cast<std::ptrdiff_t>(threads + 1));
+  std::atomic<bool> stopping = false;
+  std::vector<std::thread> workers;
+  for (std::size_t thread = 0; thread < threads; ++thread) {
+    workers.emplace_back([&, thread] {
+      for (;;) {
+        sync.arrive_and_wait();
+        if (stopping.load(std::memory_order_relaxed)) {
+          return;
+        }
+        std::vector<Slice> &threadSlices = slices[thread];
+        threadSlices.clear();
+        for (std::size_t i = 0; i < drawsPerThread; ++i) {
+          const Slice slice = strategy.allocate(thread);
+          float matrix[kMatrixFloats] = {};
+          matrix[0] = matrix[5] = matrix[10] = matrix[15] = 1.0F;
+          matrix[12] = static_cast<float>(thread);
+          matrix[13] = static_cast<float>(i);
+          std::memcpy(slice.pMatrix, matrix, sizeof(matrix));
+          threadSlices.push_back(slice);
+        }
+        sync.arrive_and_wait();
+      }
+    });
+  }
+
+  double totalSeconds = 0.0;
+  bool correct = true;
+  for (int frame = 0; frame < frames; ++frame) {
+    strategy.beginFrame(static_cast<std::size_t>(frame) % kFramesInFlight);
+    const Clock::time_point start = Clock::now();
+    sync.arrive_and_wait();
+    sync.arrive_and_wait();
+    totalSeconds += seconds(start);
+    correct = correct && checkSlices(slices, strategy.alignment());
+    strategy.endFrame();
+  }
+  stopping = true;
+  sync.arrive_and_wait();
+  for (std::thread &worker : workers) {
+    worker.join();
+  }
+  const double draws =
+      static_cast<double>(drawsPerThread * threads) * frames;
+  return {totalSeconds / draws * 1e9, correct};
+}
+
+}  // namespace
+
+int main(int argc, char *argv[]) {
+  const std::size_t maxThreads =
+      argc > 1 ? std::max(1, std::atoi(argv[1]))
+               : std::max(4U, std::thread::hardware_concurrency());
+  const int frames = argc > 2 ? std::atoi(argv[2]) : 20;
+
+  std::cout << kDrawsPerFrame << " draws per frame, " << frames
+            << " frames, hardware threads: "
+            << std::thread::hardware_concurrency() << "\n"
+            << "threads  atomic ns/draw  block ns/draw  mutex ns/draw"
+               "  buffer ns/draw  output\n"
+            << std::fixed << std::setprecision(1);
+  Gfx::SoftwareDevice device;
+  bool allCorrect = true;
+  for (std::size_t threads = 1; threads <= maxThreads; threads *= 2) {
+    AtomicStrategy atomic(&device);
+    BlockStrategy block(&device, threads);
+    MutexStrategy mutex(&device);
+    BufferStrategy buffer(&device, threads);
+    const Result atomicResult = run(atomic, threads, frames);
+    const Result blockResult = run(block, threads, frames);
+    const Result mutexResult = run(mutex, threads, frames);
+    const Result bufferResult = run(buffer, threads, frames);
+    const bool correct = atomicResult.correct && blockResult.correct &&
+                         mutexResult.correct && bufferResult.correct;
+    std::cout << std::setw(7) << threads << std::setw(16)
+              << atomicResult.nsPerDraw << std::setw(15)
+              << blockResult.nsPerDraw << std::setw(15)
+              << mutexResult.nsPerDraw << std::setw(16)
+              << bufferResult.nsPerDraw << "  "
+              << (correct ? "ok" : "WRONG") << "\n";
+    allCorrect = allCorrect && correct;
+  }
+  return allCorrect ? EXIT_SUCCESS : EXIT_FAILURE;
+}
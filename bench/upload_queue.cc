@@ -0,0 +1,266 @@
+// Streaming throughput of many small uploads against the headless software
+// backend, whose queues take a fixed latency per command buffer like a GPU
+// would. Uploads of 256 B to 64 KiB are appended to random destination
+// buffers:
+//
+//   direct      a staging buffer and a command buffer per upload.
+//   queue       UploadQueue with its default ring.
+//   queue, 1    one staging buffer, so every batch waits for the previous.
+//   queue, 4t   four threads uploading through one UploadQueue.
+//
+// "copies" counts blit copies after merging. Once everything is committed a
+// command buffer on a second queue waits for the last upload with
+// encodeWait(), copies every destination back and the copy is compared with
+// the source data.
+//
+//   bench_upload_queue [MiB] [latency us]
+#include <Gfx/SoftwareBackend.hpp>
+#include <Gfx/UploadQueue.hpp>
+
+#include <algorithm>
+#include <chrono>
+#include <cstdint>
+#include <cstdlib>
+#include <cstring>
+#include <iomanip>
+#include <iostream>
+#include <iterator>
+#include <memory>
+#include <random>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace {
+
+using Clock = std::chrono::steady_clock;
+
+constexpr std::size_t kDestinationCount = 16;
+constexpr std::size_t kMinUpload = 256;
+constexpr std::size_t kMaxUpload = 64 * 1024;
+
+double seconds(Clock::time_point start) {
+  return std::chrono::duration<double>(Clock::now() - start).count();
+}
+
+struct Upload {
+  std::size_t destination;
+  std::size_t offset;
+  std::size_t size;
+};
+
+// The same stream of uploads for every mode, filling each destination from
+// the start.
+struct Workload {
+  std::vector<std::vector<std::uint8_t>> sources;
+  std::vector<Upload> uploads;
+};
+
+Workload makeWorkload(std::size_t totalBytes) {
+  Workload workload;
+  const std::size_t destinationSize = totalBytes / kDestinationCount;
+  std::mt19937_64 random(7);
+  std::vector<std::size_t> cursors(kDestinationCount, 0);
+  for (std::size_t i = 0; i < kDestinationCount; ++i) {
+    std::vector<std::uint8_t> &source = workload.sources.emplace_back();
+    source.resize(destinationSize);
+    for (std::uint8_t &byte : source) {
+      byte = static_cast<std::uint8_t>(random());
+    }
+  }
+  std::uniform_int_distribution<std::size_t> sizes(kMinUpload / 4,
+                                                   kMaxUpload / 4);
+  std::uniform_int_distribution<std::size_t> destinations(
+      0, kDestinationCount - 1);
+  for (;;) {
+    std::size_t destination = destinations(random);
+    // Consecutive uploads often continue one another, as a mesh's chunks
+    // would.
+    if (!workload.uploads.empty() && random() % 2 == 0) {
+      destination = workload.uploads.back().destination;
+    }
+    std::size_t &cursor = cursors[destination];
+    if (cursor == destinationSize) {
+      const auto full = std::count(cursors.begin(), cursors.end(),
+                                   destinationSize);
+      if (static_cast<std::size_t>(full) == kDestinationCount) {
+        return workload;
+      }
+      continue;
+    }
+    const std::size_t size = std::min(sizes(random) * 4, destinationSize -
+                                                             cursor);
+    workload.uploads.push_back({destination, cursor, size});
+    cursor += size;
+  }
+}
+
+struct Result {
+  double mibPerSecond;
+  std::uint64_t commandBuffers;
+  std::uint64_t copies;
+  std::uint64_t stalls;
+  bool correct;
+};
+
+// Waits for value of pEvent on the GPU side of another queue, then reads
+// every destination back.
+bool verify(Gfx::Device *pDevice, const Workload &workload,
+            const std::vector<std::unique_ptr<Gfx::Buffer>> &destinations,
+            Gfx::SharedEvent *pEvent, std::uint64_t value) {
+  const std::size_t destinationSize = workload.sources.front().size();
+  std::unique_ptr<Gfx::CommandQueue> pQueue = pDevice->newCommandQueue();
+  std::unique_ptr<Gfx::Buffer> pReadback =
+      pDevice->newBuffer(destinationSize * kDestinationCount);
+  Gfx::CommandBuffer *pCommandBuffer = pQueue->commandBuffer();
+  if (pEvent != nullptr) {
+    pCommandBuffer->encodeWait(pEvent, value);
+  }
+  Gfx::BlitCommandEncoder *pBlit = pCommandBuffer->blitCommandEncoder();
+  for (std::size_t i = 0; i < kDestinationCount; ++i) {
+    pBlit->copyFromBuffer(destinations[i].get(), 0, pReadback.get(),
+                          i * destinationSize, destinationSize);
+  }
+  pBlit->endEncoding();
+  pCommandBuffer->commit();
+  pCommandBuffer->waitUntilCompleted();
+  const auto *pBytes = static_cast<const std::uint8_t *>(pReadback->contents());
+  for (std::size_t i = 0; i < kDestinationCount; ++i) {
+    if (std::memcmp(pBytes + i * destinationSize, workload.sources[i].data(),
+                    destinationSize) != 0) {
+      return false;
+    }
+  }
+  return true;
+}
+
+std::vector<std::unique_ptr<Gfx::Buffer>> newDestinations(
+    Gfx::Device *pDevice, const Workload &workload) {
+  std::vector<std::unique_ptr<Gfx::Buffer>> destinations;
+  for (const std::vector<std::uint8_t> &source : workload.sources) {
+    destinations.push_back(pDevice->newBuffer(source.size()));
+  }
+  return destinations;
+}
+
+Result runDirect(std::chrono::microseconds latency, const Workload &workload,
+                 std::size_t totalBytes) {
+  Gfx::SoftwareDevice device(latency);
+  std::unique_ptr<Gfx::CommandQueue> pQueue = device.newCommandQueue();
+  std::vector<std::unique_ptr<Gfx::Buffer>> destinations =
+      newDestinations(&device, workload);
+  std::vector<std::unique_ptr<Gfx::Buffer>> staging;
+  staging.reserve(workload.uploads.size());
+
+  const Clock::time_point start = Clock::now();
+  Gfx::CommandBuffer *pCommandBuffer = nullptr;
+  for (const Upload &upload : workload.uploads) {
+    std::unique_ptr<Gfx::Buffer> &pStaging =
+        staging.emplace_back(device.newBuffer(upload.size));
+    std::memcpy(pStaging->contents(),
+                workload.sources[upload.destination].data() + upload.offset,
+                upload.size);
+    pCommandBuffer = pQueue->commandBuffer();
+    Gfx::BlitCommandEncoder *pBlit = pCommandBuffer->blitCommandEncoder();
+    pBlit->copyFromBuffer(pStaging.get(), 0,
+                          destinations[upload.destination].get(),
+                          upload.offset, upload.size);
+    pBlit->endEncoding();
+    pCommandBuffer->commit();
+  }
+  if (pCommandBuffer != nullptr) {
+    pCommandBuffer->waitUntilCompleted();
+  }
+  const double elapsed = seconds(start);
+
+  const bool correct =
+      verify(&device, workload, destinations, nullptr, 0);
+  return {static_cast<double>(totalBytes) / (1 << 20) / elapsed,
+          workload.uploads.size(), workload.uploads.size(), 0, correct};
+}
+
+Result runQueue(std::chrono::microseconds latency, const Workload &workload,
+                std::size_t totalBytes, std::size_t stagingBufferCount,
+                std::size_t threads) {
+  Gfx::SoftwareDevice device(latency);
+  std::vector<std::unique_ptr<Gfx::Buffer>> destinations =
+      newDestinations(&device, workload);
+  Gfx::UploadQueueDescriptor descriptor;
+  descriptor.stagingBufferCount = stagingBufferCount;
+  Gfx::UploadQueue queue(&device, descriptor);
+
+  const Clock::time_point start = Clock::now();
+  auto uploadRange = [&](std::size_t begin, std::size_t end) {
+    for (std::size_t i = begin; i < end; ++i) {
+      const Upload &upload = workload.uploads[i];
+      queue.upload(destinations[upload.destination].get(), upload.offset,
+                   workload.sources[upload.destination].data() +
+                       upload.offset,
+                   upload.size);
+    }
+  };
+  std::vector<std::thread> workers;
+  const std::size_t count = workload.uploads.size();
+  for (std::size_t thread = 1; thread < threads; ++thread) {
+    workers.emplace_back(uploadRange, count * thread / threads,
+                         count * (thread + 1) / threads);
+  }
+  uploadRange(0, count / threads);
+  for (std::thread &worker : workers) {
+    worker.join();
+  }
+  const std::uint64_t last = queue.flush();
+  queue.wait(last);
+  const double elapsed = seconds(start);
+
+  const bool correct =
+      verify(&device, workload, destinations, queue.event(), last);
+  const Gfx::UploadQueueStatistics statistics = queue.statistics();
+  return {static_cast<double>(totalBytes) / (1 << 20) / elapsed,
+          statistics.batchCount, statistics.copyCount, statistics.stallCount,
+          correct && statistics.uploadCount == count};
+}
+
+void print(const std::string &mode, const Result &result) {
+  std::cout << std::left << std::setw(12) << mode << std::right
+            << std::setw(10) << result.mibPerSecond << std::setw(17)
+            << result.commandBuffers << std::setw(9) << result.copies
+            << std::setw(8) << result.stalls << "  "
+            << (result.correct ? "ok" : "WRONG") << "\n";
+}
+
+}  // namespace
+
+int main(int argc, char *argv[]) {
+  const int mebibyteArgument = argc > 1 ? std::atoi(argv[1]) : 64;
+  const int latencyArgument = argc > 2 ? std::atoi(argv[2]) : 200;
+  if (mebibyteArgument <= 0 || latencyArgument < 0) {
+    std::cerr << "usage: bench_upload_queue [MiB] [latency us]\n"
+                 "MiB must be positive and the latency not negative\n";
+    return EXIT_FAILURE;
+  }
+  const auto mebibytes = static_cast<std::size_t>(mebibyteArgument);
+  const std::chrono::microseconds latency(latencyArgument);
+  const std::size_t totalBytes = mebibytes << 20;
+  const Workload workload = makeWorkload(totalBytes);
+
+  std::cout << workload.uploads.size() << " uploads, " << mebibytes
+            << " MiB, " << latency.count()
+            << " us per command buffer\n"
+               "mode             MiB/s  command buffers   copies  stalls"
+               "  output\n"
+            << std::fixed << std::setprecision(1);
+  const Result results[] = {
+      runDirect(latency, workload, totalBytes),
+      runQueue(latency, workload, totalBytes, 3, 1),
+      runQueue(latency, workload, totalBytes, 1, 1),
+      runQueue(latency, workload, totalBytes, 3, 4),
+  };
+  const char *modes[] = {"direct", "queue", "queue, 1", "queue, 4t"};
+  bool allCorrect = true;
+  for (std::size_t i = 0; i < std::size(results); ++i) {
+    print(modes[i], results[i]);
+    allCorrect = allCorrect && results[i].correct;
+  }
+  return allCorrect ? EXIT_SUCCESS : EXIT_FAILURE;
+}
@@ -30,7 +30,11 @@
 //-------------------------------------------------------------------------------------------------------------------------------------------------------------
 
 #define _APPKIT_PRIVATE_CLS(symbol) (Private::Class::s_k##symbol)
+#if defined(NS_PRIVATE_LAZY_SELECTORS)
+#define _APPKIT_PRIVATE_SEL(accessor) (Private::Selector::s_k##accessor())
+#else
 #define _APPKIT_PRIVATE_SEL(accessor) (Private::Selector::s_k##accessor)
+#endif  // NS_PRIVATE_LAZY_SELECTORS
 
 //-------------------------------------------------------------------------------------------------------------------------------------------------------------
 
@@ -63,6 +67,19 @@
 
 #endif  // NS_PRIVATE_IMPLEMENTATION
 
+#if defined(NS_PRIVATE_LAZY_SELECTORS)
+
+// Selectors are registered lazily, see NS_PRIVATE_LAZY_SELECTORS in
+// Foundation/NSPrivate.hpp.
+#undef _APPKIT_PRIVATE_DEF_SEL
+#define _APPKIT_PRIVATE_DEF_SEL(accessor, symbol)           \
+  inline SEL s_k##accessor() {                              \
+    static const SEL s_selector = sel_registerName(symbol); \
+    return s_selector;                                      \
+  }
+
+#endif  // NS_PRIVATE_LAZY_SELECTORS
+
 //-------------------------------------------------------------------------------------------------------------------------------------------------------------
 
 namespace NS::Private::Class {
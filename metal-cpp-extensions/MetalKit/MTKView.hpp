@@ -198,7 +198,7 @@ _NS_INLINE MTK::ViewDelegate* MTK::View::delegate() const
 
 _NS_INLINE CA::MetalDrawable* MTK::View::currentDrawable() const
 {
-	return NS::Object::sendMessage< CA::MetalDrawable* >( this, _MTK_PRIVATE_SEL( currentDrawable ) );
+	return NS::Object::sendMessageCached< CA::MetalDrawable* >( this, _MTK_PRIVATE_SEL( currentDrawable ) );
 }
 
 _NS_INLINE void MTK::View::setFramebufferOnly( bool framebufferOnly )
@@ -278,7 +278,7 @@ _NS_INLINE void MTK::View::setClearColor( MTL::ClearColor clearColor )
 
 _NS_INLINE MTL::ClearColor MTK::View::clearColor() const
 {
-	return NS::Object::sendMessage< MTL::ClearColor >( this, _MTK_PRIVATE_SEL( clearColor) );
+	return NS::Object::sendMessageCached< MTL::ClearColor >( this, _MTK_PRIVATE_SEL( clearColor) );
 }
 
 _NS_INLINE void MTK::View::setClearDepth( double clearDepth )
@@ -318,7 +318,7 @@ _NS_INLINE void MTK::View::releaseDrawables() const
 
 _NS_INLINE MTL::RenderPassDescriptor* MTK::View::currentRenderPassDescriptor() const
 {
-	return NS::Object::sendMessage< MTL::RenderPassDescriptor* >( this, _MTK_PRIVATE_SEL( currentRenderPassDescriptor ) );
+	return NS::Object::sendMessageCached< MTL::RenderPassDescriptor* >( this, _MTK_PRIVATE_SEL( currentRenderPassDescriptor ) );
 }
 
 _NS_INLINE void MTK::View::setPreferredFramesPerSecond( NS::Integer preferredFramesPerSecond )
@@ -30,7 +30,11 @@
 //-------------------------------------------------------------------------------------------------------------------------------------------------------------
 
 #define _MTK_PRIVATE_CLS( symbol )				   ( Private::Class::s_k ## symbol )
+#if defined( MTK_PRIVATE_LAZY_SELECTORS )
+#define _MTK_PRIVATE_SEL( accessor )				 ( Private::Selector::s_k ## accessor() )
+#else
 #define _MTK_PRIVATE_SEL( accessor )				 ( Private::Selector::s_k ## accessor )
+#endif // MTK_PRIVATE_LAZY_SELECTORS
 
 //-------------------------------------------------------------------------------------------------------------------------------------------------------------
 
@@ -60,6 +64,16 @@
 
 #endif // MTK_PRIVATE_IMPLEMENTATION
 
+#if defined( MTK_PRIVATE_LAZY_SELECTORS )
+
+// Selectors are registered lazily, see NS_PRIVATE_LAZY_SELECTORS in
+// Foundation/NSPrivate.hpp.
+#undef _MTK_PRIVATE_DEF_SEL
+#define _MTK_PRIVATE_DEF_SEL( accessor, symbol )	 inline SEL s_k ## accessor() \
+													 { static const SEL s_selector = sel_registerName( symbol ); return s_selector; }
+
+#endif // MTK_PRIVATE_LAZY_SELECTORS
+
 //-------------------------------------------------------------------------------------------------------------------------------------------------------------
 
 namespace MTK::Private::Class {
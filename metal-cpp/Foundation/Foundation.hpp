@@ -38,6 +38,7 @@
 #include "NSPrivate.hpp"
 #include "NSProcessInfo.hpp"
 #include "NSRange.hpp"
+#include "NSSharedPtr.hpp"
 #include "NSString.hpp"
 #include "NSTypes.hpp"
 #include "NSURL.hpp"
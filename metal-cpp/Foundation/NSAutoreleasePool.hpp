@@ -43,8 +43,33 @@ public:
 
     static void             showPools();
 };
+
+// Stack-scoped pool built on the runtime entry points @autoreleasepool compiles to. Unlike
+// AutoreleasePool it is not an object: opening and closing the scope sends no messages and
+// allocates nothing. drain() releases what was autoreleased so far and keeps the scope open,
+// so one guard can serve every iteration of a loop.
+class ScopedAutoreleasePool
+{
+public:
+    ScopedAutoreleasePool();
+    ~ScopedAutoreleasePool();
+
+    ScopedAutoreleasePool(const ScopedAutoreleasePool&) = delete;
+    ScopedAutoreleasePool& operator=(const ScopedAutoreleasePool&) = delete;
+
+    static void*           operator new(size_t) = delete;
+    static void*           operator new[](size_t) = delete;
+
+    void                   drain();
+
+private:
+    void*                  m_pContext;
+};
 }
 
+extern "C" void* objc_autoreleasePoolPush(void);
+extern "C" void  objc_autoreleasePoolPop(void* pContext);
+
 //-------------------------------------------------------------------------------------------------------------------------------------------------------------
 
 _NS_INLINE NS::AutoreleasePool* NS::AutoreleasePool::alloc()
@@ -81,3 +106,25 @@ _NS_INLINE void NS::AutoreleasePool::showPools()
 }
 
 //-------------------------------------------------------------------------------------------------------------------------------------------------------------
+
+_NS_INLINE NS::ScopedAutoreleasePool::ScopedAutoreleasePool()
+    : m_pContext(objc_autoreleasePoolPush())
+{
+}
+
+//-------------------------------------------------------------------------------------------------------------------------------------------------------------
+
+_NS_INLINE NS::ScopedAutoreleasePool::~ScopedAutoreleasePool()
+{
+    objc_autoreleasePoolPop(m_pContext);
+}
+
+//-------------------------------------------------------------------------------------------------------------------------------------------------------------
+
+_NS_INLINE void NS::ScopedAutoreleasePool::drain()
+{
+    objc_autoreleasePoolPop(m_pContext);
+    m_pContext = objc_autoreleasePoolPush();
+}
+
+//-------------------------------------------------------------------------------------------------------------------------------------------------------------
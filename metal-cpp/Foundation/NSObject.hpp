@@ -29,6 +29,7 @@
 #include <objc/message.h>
 #include <objc/runtime.h>
 
+#include <cstdint>
 #include <type_traits>
 
 //-------------------------------------------------------------------------------------------------------------------------------------------------------------
@@ -83,6 +84,8 @@ protected:
     static _Ret sendMessage(const void* pObj, SEL selector, _Args... args);
     template <typename _Ret, typename... _Args>
     static _Ret sendMessageSafe(const void* pObj, SEL selector, _Args... args);
+    template <typename _Ret, typename... _Args>
+    static _Ret sendMessageCached(const void* pObj, SEL selector, _Args... args);
 
 private:
     Object() = delete;
@@ -95,6 +98,46 @@ private:
 
 //-------------------------------------------------------------------------------------------------------------------------------------------------------------
 
+#if defined(NS_PRIVATE_CACHED_DISPATCH)
+
+namespace NS
+{
+namespace Private
+{
+    // Direct-mapped, per-thread cache of resolved method implementations keyed by receiver class and
+    // selector. Entries are never invalidated, so only route selectors whose implementation does not
+    // change at run time (no swizzling, no categories loaded later) through sendMessageCached.
+    struct MethodCacheEntry
+    {
+        ::Class cls;
+        SEL     selector;
+        IMP     imp;
+    };
+
+    constexpr std::uintptr_t kMethodCacheSize = 256;
+
+    inline IMP lookUpMethodImplementation(const void* pObj, SEL selector)
+    {
+        static thread_local MethodCacheEntry s_cache[kMethodCacheSize] = {};
+
+        ::Class               cls = object_getClass(static_cast<id>(const_cast<void*>(pObj)));
+        const std::uintptr_t  hash = (reinterpret_cast<std::uintptr_t>(cls) >> 4) ^ (reinterpret_cast<std::uintptr_t>(selector) >> 3);
+        MethodCacheEntry&     entry = s_cache[hash & (kMethodCacheSize - 1)];
+
+        if ((entry.cls != cls) || (entry.selector != selector))
+        {
+            entry = { cls, selector, class_getMethodImplementation(cls, selector) };
+        }
+
+        return entry.imp;
+    }
+} // Private
+} // NS
+
+#endif // NS_PRIVATE_CACHED_DISPATCH
+
+//-------------------------------------------------------------------------------------------------------------------------------------------------------------
+
 template <class _Class, class _Base /* = Object */>
 _NS_INLINE _Class* NS::Referencing<_Class, _Base>::retain()
 {
@@ -244,6 +287,37 @@ _NS_INLINE _Ret NS::Object::sendMessageSafe(const void* pObj, SEL selector, _Arg
 
 //-------------------------------------------------------------------------------------------------------------------------------------------------------------
 
+template <typename _Ret, typename... _Args>
+_NS_INLINE _Ret NS::Object::sendMessageCached(const void* pObj, SEL selector, _Args... args)
+{
+#if defined(NS_PRIVATE_CACHED_DISPATCH)
+    // Messaging nil yields a zeroed result, exactly like objc_msgSend.
+    if (nullptr == pObj)
+    {
+        if constexpr (!std::is_void<_Ret>::value)
+        {
+            return _Ret();
+        }
+        else
+        {
+            return;
+        }
+    }
+
+    // Calling the IMP through a correctly typed pointer needs neither the _fpret nor the _stret
+    // trampoline: the compiler applies the platform ABI for _Ret itself.
+    using MethodProc = _Ret (*)(const void*, SEL, _Args...);
+
+    const MethodProc pProc = reinterpret_cast<MethodProc>(Private::lookUpMethodImplementation(pObj, selector));
+
+    return (*pProc)(pObj, selector, args...);
+#else
+    return sendMessage<_Ret>(pObj, selector, args...);
+#endif // NS_PRIVATE_CACHED_DISPATCH
+}
+
+//-------------------------------------------------------------------------------------------------------------------------------------------------------------
+
 template <class _Class>
 _NS_INLINE _Class* NS::Object::alloc(const char* pClassName)
 {
@@ -27,7 +27,11 @@
 //-------------------------------------------------------------------------------------------------------------------------------------------------------------
 
 #define _NS_PRIVATE_CLS(symbol) (Private::Class::s_k##symbol)
+#if defined(NS_PRIVATE_LAZY_SELECTORS)
+#define _NS_PRIVATE_SEL(accessor) (Private::Selector::s_k##accessor())
+#else
 #define _NS_PRIVATE_SEL(accessor) (Private::Selector::s_k##accessor)
+#endif // NS_PRIVATE_LAZY_SELECTORS
 
 //-------------------------------------------------------------------------------------------------------------------------------------------------------------
 
@@ -58,6 +62,21 @@
 
 #endif // NS_PRIVATE_IMPLEMENTATION
 
+#if defined(NS_PRIVATE_LAZY_SELECTORS)
+
+// Register each selector the first time it is used rather than from a static
+// initializer, so start-up only pays for the selectors the program touches.
+// Every translation unit must agree on this setting.
+#undef _NS_PRIVATE_DEF_SEL
+#define _NS_PRIVATE_DEF_SEL(accessor, symbol)                   \
+    inline SEL s_k##accessor()                                  \
+    {                                                           \
+        static const SEL s_selector = sel_registerName(symbol); \
+        return s_selector;                                      \
+    }
+
+#endif // NS_PRIVATE_LAZY_SELECTORS
+
 //-------------------------------------------------------------------------------------------------------------------------------------------------------------
 
 namespace NS
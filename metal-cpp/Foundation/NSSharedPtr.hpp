@@ -0,0 +1,302 @@
+//-------------------------------------------------------------------------------------------------------------------------------------------------------------
+//
+// Foundation/NSSharedPtr.hpp
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+//-------------------------------------------------------------------------------------------------------------------------------------------------------------
+
+#pragma once
+
+//-------------------------------------------------------------------------------------------------------------------------------------------------------------
+
+#include "NSDefines.hpp"
+
+#include <cstddef>
+#include <type_traits>
+
+//-------------------------------------------------------------------------------------------------------------------------------------------------------------
+
+namespace NS
+{
+template <class _Class>
+class SharedPtr;
+
+// Adopts the +1 reference returned by alloc/init, new* and copy methods without sending retain.
+template <class _Class>
+SharedPtr<_Class> TransferPtr(_Class* pObject);
+
+// Takes a new reference to an object the caller does not own, e.g. an autoreleased return value.
+template <class _Class>
+SharedPtr<_Class> RetainPtr(_Class* pObject);
+
+// Owning handle for NS::Referencing objects. Copies send retain, destruction sends release, and moves
+// hand the reference over without messaging the object at all.
+template <class _Class>
+class SharedPtr
+{
+public:
+    SharedPtr() = default;
+    SharedPtr(std::nullptr_t);
+    ~SharedPtr();
+
+    SharedPtr(const SharedPtr& other);
+    template <class _OtherClass, typename = std::enable_if_t<std::is_convertible_v<_OtherClass*, _Class*>>>
+    SharedPtr(const SharedPtr<_OtherClass>& other);
+
+    SharedPtr(SharedPtr&& other) noexcept;
+    template <class _OtherClass, typename = std::enable_if_t<std::is_convertible_v<_OtherClass*, _Class*>>>
+    SharedPtr(SharedPtr<_OtherClass>&& other) noexcept;
+
+    SharedPtr& operator=(const SharedPtr& other);
+    template <class _OtherClass, typename = std::enable_if_t<std::is_convertible_v<_OtherClass*, _Class*>>>
+    SharedPtr& operator=(const SharedPtr<_OtherClass>& other);
+    SharedPtr& operator=(SharedPtr&& other) noexcept;
+    template <class _OtherClass, typename = std::enable_if_t<std::is_convertible_v<_OtherClass*, _Class*>>>
+    SharedPtr& operator=(SharedPtr<_OtherClass>&& other) noexcept;
+    SharedPtr& operator=(std::nullptr_t);
+
+    _Class*    get() const;
+    _Class*    operator->() const;
+    explicit   operator bool() const;
+
+    void       reset();
+    _Class*    detach();
+    void       swap(SharedPtr& other) noexcept;
+
+private:
+    template <class _OtherClass>
+    friend class SharedPtr;
+    template <class _OtherClass>
+    friend SharedPtr<_OtherClass> TransferPtr(_OtherClass* pObject);
+    template <class _OtherClass>
+    friend SharedPtr<_OtherClass> RetainPtr(_OtherClass* pObject);
+
+    _Class* m_pObject = nullptr;
+};
+
+template <class _ClassLhs, class _ClassRhs>
+bool operator==(const SharedPtr<_ClassLhs>& lhs, const SharedPtr<_ClassRhs>& rhs);
+template <class _Class>
+bool operator==(const SharedPtr<_Class>& lhs, std::nullptr_t);
+}
+
+//-------------------------------------------------------------------------------------------------------------------------------------------------------------
+
+template <class _Class>
+_NS_INLINE NS::SharedPtr<_Class> NS::TransferPtr(_Class* pObject)
+{
+    SharedPtr<_Class> ptr;
+    ptr.m_pObject = pObject;
+
+    return ptr;
+}
+
+//-------------------------------------------------------------------------------------------------------------------------------------------------------------
+
+template <class _Class>
+_NS_INLINE NS::SharedPtr<_Class> NS::RetainPtr(_Class* pObject)
+{
+    SharedPtr<_Class> ptr;
+    ptr.m_pObject = pObject ? pObject->retain() : nullptr;
+
+    return ptr;
+}
+
+//-------------------------------------------------------------------------------------------------------------------------------------------------------------
+
+template <class _Class>
+_NS_INLINE NS::SharedPtr<_Class>::SharedPtr(std::nullptr_t)
+{
+}
+
+//-------------------------------------------------------------------------------------------------------------------------------------------------------------
+
+template <class _Class>
+_NS_INLINE NS::SharedPtr<_Class>::~SharedPtr()
+{
+    if (m_pObject)
+    {
+        m_pObject->release();
+    }
+}
+
+//-------------------------------------------------------------------------------------------------------------------------------------------------------------
+
+template <class _Class>
+_NS_INLINE NS::SharedPtr<_Class>::SharedPtr(const SharedPtr& other)
+    : m_pObject(other.m_pObject ? other.m_pObject->retain() : nullptr)
+{
+}
+
+//-------------------------------------------------------------------------------------------------------------------------------------------------------------
+
+template <class _Class>
+template <class _OtherClass, typename>
+_NS_INLINE NS::SharedPtr<_Class>::SharedPtr(const SharedPtr<_OtherClass>& other)
+    : m_pObject(other.m_pObject ? static_cast<_Class*>(other.m_pObject->retain()) : nullptr)
+{
+}
+
+//-------------------------------------------------------------------------------------------------------------------------------------------------------------
+
+template <class _Class>
+_NS_INLINE NS::SharedPtr<_Class>::SharedPtr(SharedPtr&& other) noexcept
+    : m_pObject(other.m_pObject)
+{
+    other.m_pObject = nullptr;
+}
+
+//-------------------------------------------------------------------------------------------------------------------------------------------------------------
+
+template <class _Class>
+template <class _OtherClass, typename>
+_NS_INLINE NS::SharedPtr<_Class>::SharedPtr(SharedPtr<_OtherClass>&& other) noexcept
+    : m_pObject(other.m_pObject)
+{
+    other.m_pObject = nullptr;
+}
+
+//-------------------------------------------------------------------------------------------------------------------------------------------------------------
+
+template <class _Class>
+_NS_INLINE NS::SharedPtr<_Class>& NS::SharedPtr<_Class>::operator=(const SharedPtr& other)
+{
+    // Re-assigning the object already held is a no-op rather than a retain/release round trip.
+    if (m_pObject != other.m_pObject)
+    {
+        SharedPtr(other).swap(*this);
+    }
+
+    return *this;
+}
+
+//-------------------------------------------------------------------------------------------------------------------------------------------------------------
+
+template <class _Class>
+template <class _OtherClass, typename>
+_NS_INLINE NS::SharedPtr<_Class>& NS::SharedPtr<_Class>::operator=(const SharedPtr<_OtherClass>& other)
+{
+    if (m_pObject != other.m_pObject)
+    {
+        SharedPtr(other).swap(*this);
+    }
+
+    return *this;
+}
+
+//-------------------------------------------------------------------------------------------------------------------------------------------------------------
+
+template <class _Class>
+_NS_INLINE NS::SharedPtr<_Class>& NS::SharedPtr<_Class>::operator=(SharedPtr&& other) noexcept
+{
+    SharedPtr(static_cast<SharedPtr&&>(other)).swap(*this);
+
+    return *this;
+}
+
+//-------------------------------------------------------------------------------------------------------------------------------------------------------------
+
+template <class _Class>
+template <class _OtherClass, typename>
+_NS_INLINE NS::SharedPtr<_Class>& NS::SharedPtr<_Class>::operator=(SharedPtr<_OtherClass>&& other) noexcept
+{
+    SharedPtr(static_cast<SharedPtr<_OtherClass>&&>(other)).swap(*this);
+
+    return *this;
+}
+
+//-------------------------------------------------------------------------------------------------------------------------------------------------------------
+
+template <class _Class>
+_NS_INLINE NS::SharedPtr<_Class>& NS::SharedPtr<_Class>::operator=(std::nullptr_t)
+{
+    reset();
+
+    return *this;
+}
+
+//-------------------------------------------------------------------------------------------------------------------------------------------------------------
+
+template <class _Class>
+_NS_INLINE _Class* NS::SharedPtr<_Class>::get() const
+{
+    return m_pObject;
+}
+
+//-------------------------------------------------------------------------------------------------------------------------------------------------------------
+
+template <class _Class>
+_NS_INLINE _Class* NS::SharedPtr<_Class>::operator->() const
+{
+    return m_pObject;
+}
+
+//-------------------------------------------------------------------------------------------------------------------------------------------------------------
+
+template <class _Class>
+_NS_INLINE NS::SharedPtr<_Class>::operator bool() const
+{
+    return nullptr != m_pObject;
+}
+
+//-------------------------------------------------------------------------------------------------------------------------------------------------------------
+
+template <class _Class>
+_NS_INLINE void NS::SharedPtr<_Class>::reset()
+{
+    if (m_pObject)
+    {
+        m_pObject->release();
+        m_pObject = nullptr;
+    }
+}
+
+//-------------------------------------------------------------------------------------------------------------------------------------------------------------
+
+template <class _Class>
+_NS_INLINE _Class* NS::SharedPtr<_Class>::detach()
+{
+    _Class* pObject = m_pObject;
+    m_pObject = nullptr;
+
+    return pObject;
+}
+
+//-------------------------------------------------------------------------------------------------------------------------------------------------------------
+
+template <class _Class>
+_NS_INLINE void NS::SharedPtr<_Class>::swap(SharedPtr& other) noexcept
+{
+    _Class* pObject = m_pObject;
+    m_pObject = other.m_pObject;
+    other.m_pObject = pObject;
+}
+
+//-------------------------------------------------------------------------------------------------------------------------------------------------------------
+
+template <class _ClassLhs, class _ClassRhs>
+_NS_INLINE bool NS::operator==(const SharedPtr<_ClassLhs>& lhs, const SharedPtr<_ClassRhs>& rhs)
+{
+    return lhs.get() == rhs.get();
+}
+
+//-------------------------------------------------------------------------------------------------------------------------------------------------------------
+
+template <class _Class>
+_NS_INLINE bool NS::operator==(const SharedPtr<_Class>& lhs, std::nullptr_t)
+{
+    return nullptr == lhs.get();
+}
+
+//-------------------------------------------------------------------------------------------------------------------------------------------------------------
@@ -323,7 +323,7 @@ _MTL_INLINE void MTL::CommandBuffer::enqueue()
 // method: commit
 _MTL_INLINE void MTL::CommandBuffer::commit()
 {
-    Object::sendMessage<void>(this, _MTL_PRIVATE_SEL(commit));
+    Object::sendMessageCached<void>(this, _MTL_PRIVATE_SEL(commit));
 }
 
 // method: addScheduledHandler:
@@ -335,7 +335,7 @@ _MTL_INLINE void MTL::CommandBuffer::addScheduledHandler(const MTL::CommandBuffe
 // method: presentDrawable:
 _MTL_INLINE void MTL::CommandBuffer::presentDrawable(const MTL::Drawable* drawable)
 {
-    Object::sendMessage<void>(this, _MTL_PRIVATE_SEL(presentDrawable_), drawable);
+    Object::sendMessageCached<void>(this, _MTL_PRIVATE_SEL(presentDrawable_), drawable);
 }
 
 // method: presentDrawable:atTime:
@@ -389,7 +389,7 @@ _MTL_INLINE MTL::BlitCommandEncoder* MTL::CommandBuffer::blitCommandEncoder()
 // method: renderCommandEncoderWithDescriptor:
 _MTL_INLINE MTL::RenderCommandEncoder* MTL::CommandBuffer::renderCommandEncoder(const MTL::RenderPassDescriptor* renderPassDescriptor)
 {
-    return Object::sendMessage<MTL::RenderCommandEncoder*>(this, _MTL_PRIVATE_SEL(renderCommandEncoderWithDescriptor_), renderPassDescriptor);
+    return Object::sendMessageCached<MTL::RenderCommandEncoder*>(this, _MTL_PRIVATE_SEL(renderCommandEncoderWithDescriptor_), renderPassDescriptor);
 }
 
 // method: computeCommandEncoderWithDescriptor:
@@ -431,7 +431,7 @@ _MTL_INLINE void MTL::CommandBuffer::encodeSignalEvent(const MTL::Event* event,
 // method: parallelRenderCommandEncoderWithDescriptor:
 _MTL_INLINE MTL::ParallelRenderCommandEncoder* MTL::CommandBuffer::parallelRenderCommandEncoder(const MTL::RenderPassDescriptor* renderPassDescriptor)
 {
-    return Object::sendMessage<MTL::ParallelRenderCommandEncoder*>(this, _MTL_PRIVATE_SEL(parallelRenderCommandEncoderWithDescriptor_), renderPassDescriptor);
+    return Object::sendMessageCached<MTL::ParallelRenderCommandEncoder*>(this, _MTL_PRIVATE_SEL(parallelRenderCommandEncoderWithDescriptor_), renderPassDescriptor);
 }
 
 // method: resourceStateCommandEncoder
@@ -79,7 +79,7 @@ _MTL_INLINE void MTL::CommandEncoder::setLabel(const NS::String* label)
 // method: endEncoding
 _MTL_INLINE void MTL::CommandEncoder::endEncoding()
 {
-    Object::sendMessage<void>(this, _MTL_PRIVATE_SEL(endEncoding));
+    Object::sendMessageCached<void>(this, _MTL_PRIVATE_SEL(endEncoding));
 }
 
 // method: insertDebugSignpost:
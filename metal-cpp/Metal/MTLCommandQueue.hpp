@@ -67,13 +67,13 @@ _MTL_INLINE MTL::Device* MTL::CommandQueue::device() const
 // method: commandBuffer
 _MTL_INLINE MTL::CommandBuffer* MTL::CommandQueue::commandBuffer()
 {
-    return Object::sendMessage<MTL::CommandBuffer*>(this, _MTL_PRIVATE_SEL(commandBuffer));
+    return Object::sendMessageCached<MTL::CommandBuffer*>(this, _MTL_PRIVATE_SEL(commandBuffer));
 }
 
 // method: commandBufferWithDescriptor:
 _MTL_INLINE MTL::CommandBuffer* MTL::CommandQueue::commandBuffer(const MTL::CommandBufferDescriptor* descriptor)
 {
-    return Object::sendMessage<MTL::CommandBuffer*>(this, _MTL_PRIVATE_SEL(commandBufferWithDescriptor_), descriptor);
+    return Object::sendMessageCached<MTL::CommandBuffer*>(this, _MTL_PRIVATE_SEL(commandBufferWithDescriptor_), descriptor);
 }
 
 // method: commandBufferWithUnretainedReferences
@@ -54,7 +54,7 @@ public:
 // method: renderCommandEncoder
 _MTL_INLINE MTL::RenderCommandEncoder* MTL::ParallelRenderCommandEncoder::renderCommandEncoder()
 {
-    return Object::sendMessage<MTL::RenderCommandEncoder*>(this, _MTL_PRIVATE_SEL(renderCommandEncoder));
+    return Object::sendMessageCached<MTL::RenderCommandEncoder*>(this, _MTL_PRIVATE_SEL(renderCommandEncoder));
 }
 
 // method: setColorStoreAction:atIndex:
@@ -29,7 +29,11 @@
 //-------------------------------------------------------------------------------------------------------------------------------------------------------------
 
 #define _MTL_PRIVATE_CLS(symbol) (Private::Class::s_k##symbol)
+#if defined(MTL_PRIVATE_LAZY_SELECTORS)
+#define _MTL_PRIVATE_SEL(accessor) (Private::Selector::s_k##accessor())
+#else
 #define _MTL_PRIVATE_SEL(accessor) (Private::Selector::s_k##accessor)
+#endif // MTL_PRIVATE_LAZY_SELECTORS
 
 //-------------------------------------------------------------------------------------------------------------------------------------------------------------
 
@@ -89,6 +93,20 @@ namespace Private
 
 #endif // MTL_PRIVATE_IMPLEMENTATION
 
+#if defined(MTL_PRIVATE_LAZY_SELECTORS)
+
+// Selectors are registered lazily, see NS_PRIVATE_LAZY_SELECTORS in
+// Foundation/NSPrivate.hpp.
+#undef _MTL_PRIVATE_DEF_SEL
+#define _MTL_PRIVATE_DEF_SEL(accessor, symbol)                  \
+    inline SEL s_k##accessor()                                  \
+    {                                                           \
+        static const SEL s_selector = sel_registerName(symbol); \
+        return s_selector;                                      \
+    }
+
+#endif // MTL_PRIVATE_LAZY_SELECTORS
+
 //-------------------------------------------------------------------------------------------------------------------------------------------------------------
 
 namespace MTL
@@ -366,7 +366,7 @@ _MTL_INLINE void MTL::RenderCommandEncoder::setVertexBytes(const void* bytes, NS
 // method: setVertexBuffer:offset:atIndex:
 _MTL_INLINE void MTL::RenderCommandEncoder::setVertexBuffer(const MTL::Buffer* buffer, NS::UInteger offset, NS::UInteger index)
 {
-    Object::sendMessage<void>(this, _MTL_PRIVATE_SEL(setVertexBuffer_offset_atIndex_), buffer, offset, index);
+    Object::sendMessageCached<void>(this, _MTL_PRIVATE_SEL(setVertexBuffer_offset_atIndex_), buffer, offset, index);
 }
 
 // method: setVertexBufferOffset:atIndex:
@@ -672,7 +672,7 @@ _MTL_INLINE void MTL::RenderCommandEncoder::drawPrimitives(MTL::PrimitiveType pr
 // method: drawPrimitives:vertexStart:vertexCount:
 _MTL_INLINE void MTL::RenderCommandEncoder::drawPrimitives(MTL::PrimitiveType primitiveType, NS::UInteger vertexStart, NS::UInteger vertexCount)
 {
-    Object::sendMessage<void>(this, _MTL_PRIVATE_SEL(drawPrimitives_vertexStart_vertexCount_), primitiveType, vertexStart, vertexCount);
+    Object::sendMessageCached<void>(this, _MTL_PRIVATE_SEL(drawPrimitives_vertexStart_vertexCount_), primitiveType, vertexStart, vertexCount);
 }
 
 // method: drawIndexedPrimitives:indexCount:indexType:indexBuffer:indexBufferOffset:instanceCount:
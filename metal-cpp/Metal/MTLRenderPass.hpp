@@ -292,7 +292,7 @@ _MTL_INLINE MTL::Texture* MTL::RenderPassAttachmentDescriptor::texture() const
 
 _MTL_INLINE void MTL::RenderPassAttachmentDescriptor::setTexture(const MTL::Texture* texture)
 {
-    Object::sendMessage<void>(this, _MTL_PRIVATE_SEL(setTexture_), texture);
+    Object::sendMessageCached<void>(this, _MTL_PRIVATE_SEL(setTexture_), texture);
 }
 
 // property: level
@@ -380,7 +380,7 @@ _MTL_INLINE MTL::LoadAction MTL::RenderPassAttachmentDescriptor::loadAction() co
 
 _MTL_INLINE void MTL::RenderPassAttachmentDescriptor::setLoadAction(MTL::LoadAction loadAction)
 {
-    Object::sendMessage<void>(this, _MTL_PRIVATE_SEL(setLoadAction_), loadAction);
+    Object::sendMessageCached<void>(this, _MTL_PRIVATE_SEL(setLoadAction_), loadAction);
 }
 
 // property: storeAction
@@ -391,7 +391,7 @@ _MTL_INLINE MTL::StoreAction MTL::RenderPassAttachmentDescriptor::storeAction()
 
 _MTL_INLINE void MTL::RenderPassAttachmentDescriptor::setStoreAction(MTL::StoreAction storeAction)
 {
-    Object::sendMessage<void>(this, _MTL_PRIVATE_SEL(setStoreAction_), storeAction);
+    Object::sendMessageCached<void>(this, _MTL_PRIVATE_SEL(setStoreAction_), storeAction);
 }
 
 // property: storeActionOptions
@@ -425,7 +425,7 @@ _MTL_INLINE MTL::ClearColor MTL::RenderPassColorAttachmentDescriptor::clearColor
 
 _MTL_INLINE void MTL::RenderPassColorAttachmentDescriptor::setClearColor(MTL::ClearColor clearColor)
 {
-    Object::sendMessage<void>(this, _MTL_PRIVATE_SEL(setClearColor_), clearColor);
+    Object::sendMessageCached<void>(this, _MTL_PRIVATE_SEL(setClearColor_), clearColor);
 }
 
 // static method: alloc
@@ -511,7 +511,7 @@ _MTL_INLINE MTL::RenderPassColorAttachmentDescriptorArray* MTL::RenderPassColorA
 // method: objectAtIndexedSubscript:
 _MTL_INLINE MTL::RenderPassColorAttachmentDescriptor* MTL::RenderPassColorAttachmentDescriptorArray::object(NS::UInteger attachmentIndex)
 {
-    return Object::sendMessage<MTL::RenderPassColorAttachmentDescriptor*>(this, _MTL_PRIVATE_SEL(objectAtIndexedSubscript_), attachmentIndex);
+    return Object::sendMessageCached<MTL::RenderPassColorAttachmentDescriptor*>(this, _MTL_PRIVATE_SEL(objectAtIndexedSubscript_), attachmentIndex);
 }
 
 // method: setObject:atIndexedSubscript:
@@ -626,13 +626,13 @@ _MTL_INLINE MTL::RenderPassDescriptor* MTL::RenderPassDescriptor::init()
 // static method: renderPassDescriptor
 _MTL_INLINE MTL::RenderPassDescriptor* MTL::RenderPassDescriptor::renderPassDescriptor()
 {
-    return Object::sendMessage<MTL::RenderPassDescriptor*>(_MTL_PRIVATE_CLS(MTLRenderPassDescriptor), _MTL_PRIVATE_SEL(renderPassDescriptor));
+    return Object::sendMessageCached<MTL::RenderPassDescriptor*>(_MTL_PRIVATE_CLS(MTLRenderPassDescriptor), _MTL_PRIVATE_SEL(renderPassDescriptor));
 }
 
 // property: colorAttachments
 _MTL_INLINE MTL::RenderPassColorAttachmentDescriptorArray* MTL::RenderPassDescriptor::colorAttachments() const
 {
-    return Object::sendMessage<MTL::RenderPassColorAttachmentDescriptorArray*>(this, _MTL_PRIVATE_SEL(colorAttachments));
+    return Object::sendMessageCached<MTL::RenderPassColorAttachmentDescriptorArray*>(this, _MTL_PRIVATE_SEL(colorAttachments));
 }
 
 // property: depthAttachment
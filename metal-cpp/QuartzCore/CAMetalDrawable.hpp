@@ -51,7 +51,7 @@ _CA_INLINE CA::MetalLayer* CA::MetalDrawable::layer() const
 
 _CA_INLINE MTL::Texture* CA::MetalDrawable::texture() const
 {
-    return Object::sendMessage<MTL::Texture*>(this, _MTL_PRIVATE_SEL(texture));
+    return Object::sendMessageCached<MTL::Texture*>(this, _MTL_PRIVATE_SEL(texture));
 }
 
 //-------------------------------------------------------------------------------------------------------------------------------------------------------------
@@ -29,7 +29,11 @@
 //-------------------------------------------------------------------------------------------------------------------------------------------------------------
 
 #define _CA_PRIVATE_CLS(symbol) (Private::Class::s_k##symbol)
+#if defined(CA_PRIVATE_LAZY_SELECTORS)
+#define _CA_PRIVATE_SEL(accessor) (Private::Selector::s_k##accessor())
+#else
 #define _CA_PRIVATE_SEL(accessor) (Private::Selector::s_k##accessor)
+#endif // CA_PRIVATE_LAZY_SELECTORS
 
 //-------------------------------------------------------------------------------------------------------------------------------------------------------------
 
@@ -60,6 +64,20 @@
 
 #endif // CA_PRIVATE_IMPLEMENTATION
 
+#if defined(CA_PRIVATE_LAZY_SELECTORS)
+
+// Selectors are registered lazily, see NS_PRIVATE_LAZY_SELECTORS in
+// Foundation/NSPrivate.hpp.
+#undef _CA_PRIVATE_DEF_SEL
+#define _CA_PRIVATE_DEF_SEL(accessor, symbol)                   \
+    inline SEL s_k##accessor()                                  \
+    {                                                           \
+        static const SEL s_selector = sel_registerName(symbol); \
+        return s_selector;                                      \
+    }
+
+#endif // CA_PRIVATE_LAZY_SELECTORS
+
 //-------------------------------------------------------------------------------------------------------------------------------------------------------------
 
 namespace CA
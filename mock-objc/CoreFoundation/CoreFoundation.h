@@ -0,0 +1,23 @@
+#pragma once
+
+// Minimal CoreFoundation types used by the metal-cpp headers.
+
+#include <stdint.h>
+
+typedef const void *CFTypeRef;
+typedef const struct __CFString *CFStringRef;
+typedef double CFTimeInterval;
+typedef long CFIndex;
+typedef unsigned char Boolean;
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// Backs the CFSTR()-style NS::String::string(const char*) overload. The mock
+// returns an immortal NSString instance wrapping the literal.
+CFStringRef __CFStringMakeConstantString(const char *cStr);
+
+#ifdef __cplusplus
+}
+#endif
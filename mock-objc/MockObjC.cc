@@ -0,0 +1,812 @@
+#include "MockObjC.hpp"
+
+#include <CoreFoundation/CoreFoundation.h>
+#include <objc/message.h>
+#include <objc/runtime.h>
+
+#include <atomic>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <new>
+#include <shared_mutex>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+struct objc_selector {
+  explicit objc_selector(std::string_view selectorName) : name(selectorName) {}
+
+  std::string name;
+  std::atomic<std::uint64_t> sendCount{0};
+};
+
+struct objc_class : objc_object {
+  Class superclass = nullptr;
+  std::string name;
+  bool isMeta = false;
+  std::size_t instanceExtraBytes = 0;
+  std::unordered_map<SEL, IMP> methods;
+};
+
+namespace MockObjC {
+
+namespace {
+
+// Every instance is preceded by a header holding its retain count, and its
+// indexed ivars start one alignment unit after the isa pointer.
+constexpr std::size_t kObjectAlignment = 16;
+constexpr std::uintptr_t kImmortal = UINTPTR_MAX;
+
+struct ObjectHeader {
+  std::atomic<std::uintptr_t> retainCount;
+};
+static_assert(sizeof(ObjectHeader) <= kObjectAlignment);
+
+ObjectHeader *header(id obj) {
+  return reinterpret_cast<ObjectHeader *>(reinterpret_cast<char *>(obj) -
+                                          kObjectAlignment);
+}
+
+bool isClassObject(id obj) { return obj->isa->isMeta; }
+
+struct StringHash {
+  using is_transparent = void;
+
+  std::size_t operator()(std::string_view value) const {
+    return std::hash<std::string_view>{}(value);
+  }
+};
+
+template <typename _Value>
+using StringMap =
+    std::unordered_map<std::string, _Value, StringHash, std::equal_to<>>;
+
+struct Runtime {
+  Runtime();
+
+  SEL internSelector(std::string_view name);
+  Class allocateClass(Class superclass, std::string_view name);
+  void registerClass(Class cls);
+  IMP findMethod(Class cls, SEL sel);
+
+  // Guards the selector and class tables and every class' method table.
+  std::shared_mutex mutex;
+  StringMap<std::unique_ptr<objc_selector>> selectors;
+  StringMap<Class> classes;
+
+  std::mutex associationMutex;
+  std::map<id, std::map<const void *, id>> associations;
+
+  std::mutex constantStringMutex;
+  StringMap<id> constantStrings;
+
+  Class rootClass = nullptr;
+  Class autoreleasePoolClass = nullptr;
+  Class stringClass = nullptr;
+
+  std::atomic<std::uint64_t> selectorRegistrations{0};
+  std::atomic<std::uint64_t> classLookups{0};
+  std::atomic<std::uint64_t> messagesSent{0};
+  std::atomic<std::uint64_t> methodLookups{0};
+  std::atomic<std::uint64_t> allocations{0};
+  std::atomic<std::uint64_t> deallocations{0};
+  std::atomic<std::uint64_t> retains{0};
+  std::atomic<std::uint64_t> releases{0};
+  std::atomic<std::uint64_t> autoreleases{0};
+  std::atomic<std::uint64_t> poolPushes{0};
+  std::atomic<std::uint64_t> poolObjectsHighWater{0};
+  std::atomic<std::uint64_t> poolDepthHighWater{0};
+};
+
+// Selectors are registered from static initializers, so the runtime has to
+// be constructed on first use rather than as a global.
+Runtime &runtime() {
+  static Runtime s_runtime;
+  return s_runtime;
+}
+
+void updateHighWater(std::atomic<std::uint64_t> &highWater,
+                     std::uint64_t value) {
+  std::uint64_t current = highWater.load(std::memory_order_relaxed);
+  while (current < value &&
+         !highWater.compare_exchange_weak(current, value,
+                                          std::memory_order_relaxed)) {
+  }
+}
+
+// Like the real runtime, every thread keeps one stack of autoreleased objects
+// and pools are just boundaries into it, so pushing and popping a pool never
+// allocates once the stack has grown to its working size.
+struct AutoreleaseStack {
+  std::vector<id> objects;
+  std::vector<std::size_t> boundaries;
+};
+
+thread_local AutoreleaseStack t_autoreleaseStack;
+
+template <typename _Ret, typename... _Args>
+_Ret send(const void *pObj, SEL selector, _Args... args) {
+  using SendMessageProc = _Ret (*)(const void *, SEL, _Args...);
+  return reinterpret_cast<SendMessageProc>(&objc_msgSend)(pObj, selector,
+                                                          args...);
+}
+
+[[noreturn]] void unrecognizedSelector(id self, SEL sel) {
+  std::fprintf(stderr, "mock-objc: %c[%s %s]: unrecognized selector sent\n",
+               isClassObject(self) ? '+' : '-', self->isa->name.c_str(),
+               sel->name.c_str());
+  std::abort();
+}
+
+// Stands in for _objc_msgForward: what class_getMethodImplementation returns
+// for selectors nobody implements.
+void forwardingTrap(id self, SEL sel) { unrecognizedSelector(self, sel); }
+
+// NSObject
+
+id rootAlloc(id self, SEL) {
+  Class cls = reinterpret_cast<Class>(self);
+  return class_createInstance(cls, cls->instanceExtraBytes);
+}
+
+id rootNew(id self, SEL) {
+  static SEL s_alloc = sel_registerName("alloc");
+  static SEL s_init = sel_registerName("init");
+  return send<id>(send<id>(self, s_alloc), s_init);
+}
+
+id rootInit(id self, SEL) { return self; }
+
+id rootRetain(id self, SEL) {
+  if (isClassObject(self)) {
+    return self;
+  }
+  runtime().retains.fetch_add(1, std::memory_order_relaxed);
+  std::atomic<std::uintptr_t> &count = header(self)->retainCount;
+  if (count.load(std::memory_order_relaxed) != kImmortal) {
+    count.fetch_add(1, std::memory_order_relaxed);
+  }
+  return self;
+}
+
+void rootRelease(id self, SEL) {
+  if (isClassObject(self)) {
+    return;
+  }
+  runtime().releases.fetch_add(1, std::memory_order_relaxed);
+  std::atomic<std::uintptr_t> &count = header(self)->retainCount;
+  if (count.load(std::memory_order_relaxed) == kImmortal) {
+    return;
+  }
+  if (count.fetch_sub(1, std::memory_order_acq_rel) == 1) {
+    static SEL s_dealloc = sel_registerName("dealloc");
+    send<void>(self, s_dealloc);
+  }
+}
+
+id rootAutorelease(id self, SEL) {
+  runtime().autoreleases.fetch_add(1, std::memory_order_relaxed);
+  if (t_autoreleaseStack.boundaries.empty()) {
+    static std::once_flag s_warned;
+    std::call_once(s_warned, [] {
+      std::fputs("mock-objc: object autoreleased with no pool in place\n",
+                 stderr);
+    });
+    return self;
+  }
+  t_autoreleaseStack.objects.push_back(self);
+  return self;
+}
+
+std::uintptr_t rootRetainCount(id self, SEL) {
+  return isClassObject(self) ? kImmortal
+                             : header(self)->retainCount.load(
+                                   std::memory_order_relaxed);
+}
+
+void rootDealloc(id self, SEL) { object_dispose(self); }
+
+std::uintptr_t rootHash(id self, SEL) {
+  return reinterpret_cast<std::uintptr_t>(self);
+}
+
+bool rootIsEqual(id self, SEL, id other) { return self == other; }
+
+bool rootRespondsToSelector(id self, SEL, SEL sel) {
+  return class_respondsToSelector(object_getClass(self), sel);
+}
+
+id rootMethodSignatureForSelector(id, SEL, SEL) { return nullptr; }
+
+id rootDescription(id, SEL) { return nullptr; }
+
+Class rootClassMethod(id self, SEL) { return object_getClass(self); }
+
+// NSAutoreleasePool
+
+void *&poolToken(id pool) {
+  return *static_cast<void **>(object_getIndexedIvars(pool));
+}
+
+id poolInit(id self, SEL) {
+  poolToken(self) = objc_autoreleasePoolPush();
+  return self;
+}
+
+void poolAddObject(id, SEL, id object) {
+  if (!t_autoreleaseStack.boundaries.empty()) {
+    t_autoreleaseStack.objects.push_back(object);
+  }
+}
+
+void poolDrain(id self, SEL) {
+  objc_autoreleasePoolPop(poolToken(self));
+  object_dispose(self);
+}
+
+void poolShowPools(id, SEL) {
+  const AutoreleaseStack &stack = t_autoreleaseStack;
+  std::fprintf(stderr, "mock-objc: %zu autorelease pool(s) on this thread\n",
+               stack.boundaries.size());
+  for (std::size_t i = 0; i < stack.boundaries.size(); ++i) {
+    const std::size_t end = i + 1 < stack.boundaries.size()
+                                ? stack.boundaries[i + 1]
+                                : stack.objects.size();
+    std::fprintf(stderr, "  pool %zu: %zu object(s)\n", i + 1,
+                 end - stack.boundaries[i]);
+  }
+}
+
+// NSString
+
+std::string *&stringStorage(id string) {
+  return *static_cast<std::string **>(object_getIndexedIvars(string));
+}
+
+id stringInitWithCString(id self, SEL, const char *cString, std::uintptr_t) {
+  stringStorage(self) = new std::string(cString);
+  return self;
+}
+
+id stringWithCString(id self, SEL, const char *cString,
+                     std::uintptr_t encoding) {
+  static SEL s_alloc = sel_registerName("alloc");
+  static SEL s_autorelease = sel_registerName("autorelease");
+  id string = stringInitWithCString(send<id>(self, s_alloc), nullptr, cString,
+                                    encoding);
+  return send<id>(string, s_autorelease);
+}
+
+id stringByAppendingString(id self, SEL, id other) {
+  const std::string appended = *stringStorage(self) + *stringStorage(other);
+  return stringWithCString(reinterpret_cast<id>(self->isa), nullptr,
+                           appended.c_str(), 0);
+}
+
+const char *stringUTF8String(id self, SEL) {
+  return stringStorage(self)->c_str();
+}
+
+const char *stringCStringUsingEncoding(id self, SEL, std::uintptr_t) {
+  return stringStorage(self)->c_str();
+}
+
+std::uintptr_t stringLength(id self, SEL) {
+  return stringStorage(self)->size();
+}
+
+bool stringIsEqualToString(id self, SEL, id other) {
+  return other != nullptr && *stringStorage(self) == *stringStorage(other);
+}
+
+void stringDealloc(id self, SEL) {
+  delete stringStorage(self);
+  object_dispose(self);
+}
+
+template <typename _Ret, typename... _Args>
+void define(Class cls, Runtime &rt, const char *selector,
+            _Ret (*pFunction)(id, SEL, _Args...)) {
+  cls->methods[rt.internSelector(selector)] = reinterpret_cast<IMP>(pFunction);
+}
+
+Runtime::Runtime() {
+  rootClass = allocateClass(nullptr, "NSObject");
+  Class rootMeta = rootClass->isa;
+  define(rootMeta, *this, "alloc", &rootAlloc);
+  define(rootMeta, *this, "new", &rootNew);
+  define(rootClass, *this, "init", &rootInit);
+  define(rootClass, *this, "retain", &rootRetain);
+  define(rootClass, *this, "release", &rootRelease);
+  define(rootClass, *this, "autorelease", &rootAutorelease);
+  define(rootClass, *this, "retainCount", &rootRetainCount);
+  define(rootClass, *this, "dealloc", &rootDealloc);
+  define(rootClass, *this, "hash", &rootHash);
+  define(rootClass, *this, "isEqual:", &rootIsEqual);
+  define(rootClass, *this, "respondsToSelector:", &rootRespondsToSelector);
+  define(rootClass, *this, "methodSignatureForSelector:",
+         &rootMethodSignatureForSelector);
+  define(rootClass, *this, "description", &rootDescription);
+  define(rootClass, *this, "debugDescription", &rootDescription);
+  define(rootClass, *this, "class", &rootClassMethod);
+  registerClass(rootClass);
+
+  autoreleasePoolClass = allocateClass(rootClass, "NSAutoreleasePool");
+  autoreleasePoolClass->instanceExtraBytes = sizeof(void *);
+  define(autoreleasePoolClass->isa, *this, "addObject:", &poolAddObject);
+  define(autoreleasePoolClass->isa, *this, "showPools", &poolShowPools);
+  define(autoreleasePoolClass, *this, "init", &poolInit);
+  define(autoreleasePoolClass, *this, "addObject:", &poolAddObject);
+  define(autoreleasePoolClass, *this, "drain", &poolDrain);
+  define(autoreleasePoolClass, *this, "release", &poolDrain);
+  registerClass(autoreleasePoolClass);
+
+  stringClass = allocateClass(rootClass, "NSString");
+  stringClass->instanceExtraBytes = sizeof(std::string *);
+  define(stringClass->isa, *this, "stringWithCString:encoding:",
+         &stringWithCString);
+  define(stringClass, *this, "initWithCString:encoding:",
+         &stringInitWithCString);
+  define(stringClass, *this, "stringByAppendingString:",
+         &stringByAppendingString);
+  define(stringClass, *this, "UTF8String", &stringUTF8String);
+  define(stringClass, *this, "cStringUsingEncoding:",
+         &stringCStringUsingEncoding);
+  define(stringClass, *this, "length", &stringLength);
+  define(stringClass, *this, "isEqualToString:", &stringIsEqualToString);
+  define(stringClass, *this, "dealloc", &stringDealloc);
+  registerClass(stringClass);
+}
+
+SEL Runtime::internSelector(std::string_view name) {
+  std::unique_lock<std::shared_mutex> lock(mutex);
+  auto it = selectors.find(name);
+  if (it == selectors.end()) {
+    it = selectors
+             .emplace(std::string(name), std::make_unique<objc_selector>(name))
+             .first;
+  }
+  return it->second.get();
+}
+
+Class Runtime::allocateClass(Class superclass, std::string_view name) {
+  auto *pClass = new objc_class();
+  auto *pMeta = new objc_class();
+
+  pClass->name = name;
+  pClass->superclass = superclass;
+  pClass->isa = pMeta;
+  pClass->instanceExtraBytes =
+      superclass != nullptr ? superclass->instanceExtraBytes : 0;
+
+  // As in the real runtime, the root metaclass inherits from the root class
+  // (so class objects answer NSObject instance methods) and is its own isa.
+  pMeta->name = name;
+  pMeta->isMeta = true;
+  pMeta->superclass = superclass != nullptr ? superclass->isa : pClass;
+  pMeta->isa = superclass != nullptr ? superclass->isa->isa : pMeta;
+
+  return pClass;
+}
+
+void Runtime::registerClass(Class cls) {
+  std::unique_lock<std::shared_mutex> lock(mutex);
+  classes.emplace(cls->name, cls);
+}
+
+IMP Runtime::findMethod(Class cls, SEL sel) {
+  std::shared_lock<std::shared_mutex> lock(mutex);
+  for (Class current = cls; current != nullptr;
+       current = current->superclass) {
+    auto it = current->methods.find(sel);
+    if (it != current->methods.end()) {
+      return it->second;
+    }
+  }
+  return nullptr;
+}
+
+}  // namespace
+
+Statistics statistics() {
+  Runtime &rt = runtime();
+  return {
+      rt.selectorRegistrations.load(std::memory_order_relaxed),
+      rt.classLookups.load(std::memory_order_relaxed),
+      rt.messagesSent.load(std::memory_order_relaxed),
+      rt.methodLookups.load(std::memory_order_relaxed),
+      rt.allocations.load(std::memory_order_relaxed),
+      rt.deallocations.load(std::memory_order_relaxed),
+      rt.retains.load(std::memory_order_relaxed),
+      rt.releases.load(std::memory_order_relaxed),
+      rt.autoreleases.load(std::memory_order_relaxed),
+      rt.poolPushes.load(std::memory_order_relaxed),
+      rt.poolObjectsHighWater.load(std::memory_order_relaxed),
+      rt.poolDepthHighWater.load(std::memory_order_relaxed),
+  };
+}
+
+void resetStatistics() {
+  Runtime &rt = runtime();
+  for (auto *pCounter :
+       {&rt.selectorRegistrations, &rt.classLookups, &rt.messagesSent,
+        &rt.methodLookups, &rt.allocations, &rt.deallocations, &rt.retains,
+        &rt.releases, &rt.autoreleases, &rt.poolPushes,
+        &rt.poolObjectsHighWater, &rt.poolDepthHighWater}) {
+    pCounter->store(0, std::memory_order_relaxed);
+  }
+  std::shared_lock<std::shared_mutex> lock(rt.mutex);
+  for (auto &entry : rt.selectors) {
+    entry.second->sendCount.store(0, std::memory_order_relaxed);
+  }
+}
+
+std::size_t selectorCount() {
+  Runtime &rt = runtime();
+  std::shared_lock<std::shared_mutex> lock(rt.mutex);
+  return rt.selectors.size();
+}
+
+std::uint64_t messageCount(const char *selector) {
+  return sel_registerName(selector)->sendCount.load(std::memory_order_relaxed);
+}
+
+std::size_t autoreleasePoolObjectCount() {
+  const AutoreleaseStack &stack = t_autoreleaseStack;
+  return stack.boundaries.empty()
+             ? 0
+             : stack.objects.size() - stack.boundaries.back();
+}
+
+Class rootClass() { return runtime().rootClass; }
+
+Class defineClass(const char *name, Class superclass,
+                  std::size_t instanceExtraBytes) {
+  Class cls = objc_allocateClassPair(superclass, name, 0);
+  if (cls == nullptr) {
+    return nullptr;
+  }
+  cls->instanceExtraBytes = instanceExtraBytes;
+  objc_registerClassPair(cls);
+  return cls;
+}
+
+std::uintptr_t retainCount(const void *pObject) {
+  return rootRetainCount(static_cast<id>(const_cast<void *>(pObject)),
+                         nullptr);
+}
+
+}  // namespace MockObjC
+
+extern "C" {
+
+// Called by the objc_msgSend trampolines with a non-nil receiver.
+__attribute__((used, visibility("hidden"))) IMP mock_objc_lookUpImplementation(
+    id self, SEL sel) {
+  MockObjC::Runtime &rt = MockObjC::runtime();
+  rt.messagesSent.fetch_add(1, std::memory_order_relaxed);
+  sel->sendCount.fetch_add(1, std::memory_order_relaxed);
+
+  IMP imp = rt.findMethod(self->isa, sel);
+  if (imp == nullptr) {
+    MockObjC::unrecognizedSelector(self, sel);
+  }
+  return imp;
+}
+
+SEL sel_registerName(const char *str) {
+  MockObjC::Runtime &rt = MockObjC::runtime();
+  rt.selectorRegistrations.fetch_add(1, std::memory_order_relaxed);
+  return rt.internSelector(str);
+}
+
+const char *sel_getName(SEL sel) { return sel->name.c_str(); }
+
+Class objc_lookUpClass(const char *name) {
+  MockObjC::Runtime &rt = MockObjC::runtime();
+  rt.classLookups.fetch_add(1, std::memory_order_relaxed);
+
+  std::shared_lock<std::shared_mutex> lock(rt.mutex);
+  auto it = rt.classes.find(std::string_view(name));
+  return it != rt.classes.end() ? it->second : nullptr;
+}
+
+Class objc_getClass(const char *name) { return objc_lookUpClass(name); }
+
+Class objc_allocateClassPair(Class superclass, const char *name, size_t) {
+  if (objc_lookUpClass(name) != nullptr) {
+    return nullptr;
+  }
+  return MockObjC::runtime().allocateClass(superclass, name);
+}
+
+void objc_registerClassPair(Class cls) {
+  MockObjC::runtime().registerClass(cls);
+}
+
+const char *class_getName(Class cls) {
+  return cls != nullptr ? cls->name.c_str() : "nil";
+}
+
+Class class_getSuperclass(Class cls) {
+  return cls != nullptr ? cls->superclass : nullptr;
+}
+
+BOOL class_isMetaClass(Class cls) { return cls != nullptr && cls->isMeta; }
+
+BOOL class_addMethod(Class cls, SEL name, IMP imp, const char *) {
+  MockObjC::Runtime &rt = MockObjC::runtime();
+  std::unique_lock<std::shared_mutex> lock(rt.mutex);
+  return cls->methods.emplace(name, imp).second;
+}
+
+BOOL class_respondsToSelector(Class cls, SEL sel) {
+  return MockObjC::runtime().findMethod(cls, sel) != nullptr;
+}
+
+IMP class_getMethodImplementation(Class cls, SEL name) {
+  MockObjC::Runtime &rt = MockObjC::runtime();
+  rt.methodLookups.fetch_add(1, std::memory_order_relaxed);
+
+  IMP imp = rt.findMethod(cls, name);
+  return imp != nullptr ? imp
+                        : reinterpret_cast<IMP>(&MockObjC::forwardingTrap);
+}
+
+id class_createInstance(Class cls, size_t extraBytes) {
+  MockObjC::runtime().allocations.fetch_add(1, std::memory_order_relaxed);
+
+  const std::size_t size =
+      2 * MockObjC::kObjectAlignment + (extraBytes + 15) / 16 * 16;
+  auto *pStorage = static_cast<char *>(::operator new(
+      size, std::align_val_t{MockObjC::kObjectAlignment}));
+  std::memset(pStorage, 0, size);
+
+  new (pStorage) MockObjC::ObjectHeader{1};
+  auto obj = reinterpret_cast<id>(pStorage + MockObjC::kObjectAlignment);
+  obj->isa = cls;
+  return obj;
+}
+
+Class object_getClass(id obj) { return obj != nullptr ? obj->isa : nullptr; }
+
+void *object_getIndexedIvars(id obj) {
+  return reinterpret_cast<char *>(obj) + MockObjC::kObjectAlignment;
+}
+
+id object_dispose(id obj) {
+  if (obj == nullptr) {
+    return nullptr;
+  }
+  MockObjC::Runtime &rt = MockObjC::runtime();
+  rt.deallocations.fetch_add(1, std::memory_order_relaxed);
+
+  std::map<const void *, id> associated;
+  {
+    std::lock_guard<std::mutex> lock(rt.associationMutex);
+    auto it = rt.associations.find(obj);
+    if (it != rt.associations.end()) {
+      associated = std::move(it->second);
+      rt.associations.erase(it);
+    }
+  }
+  static SEL s_release = sel_registerName("release");
+  for (const auto &entry : associated) {
+    MockObjC::send<void>(entry.second, s_release);
+  }
+
+  ::operator delete(reinterpret_cast<char *>(obj) - MockObjC::kObjectAlignment,
+                    std::align_val_t{MockObjC::kObjectAlignment});
+  return nullptr;
+}
+
+void objc_setAssociatedObject(id object, const void *key, id value,
+                              objc_AssociationPolicy policy) {
+  static SEL s_retain = sel_registerName("retain");
+  static SEL s_release = sel_registerName("release");
+
+  // Copy policies are treated like retain; the mock has no NSCopying.
+  const bool retains = policy != OBJC_ASSOCIATION_ASSIGN;
+  if (retains && value != nullptr) {
+    MockObjC::send<id>(value, s_retain);
+  }
+
+  MockObjC::Runtime &rt = MockObjC::runtime();
+  id previous = nullptr;
+  {
+    std::lock_guard<std::mutex> lock(rt.associationMutex);
+    id &slot = rt.associations[object][key];
+    previous = std::exchange(slot, value);
+  }
+  if (retains && previous != nullptr) {
+    MockObjC::send<void>(previous, s_release);
+  }
+}
+
+id objc_getAssociatedObject(id object, const void *key) {
+  MockObjC::Runtime &rt = MockObjC::runtime();
+  std::lock_guard<std::mutex> lock(rt.associationMutex);
+  auto it = rt.associations.find(object);
+  if (it == rt.associations.end()) {
+    return nullptr;
+  }
+  auto value = it->second.find(key);
+  return value != it->second.end() ? value->second : nullptr;
+}
+
+// The entry points behind @autoreleasepool. The token is the pool's 1-based
+// depth on the calling thread.
+void *objc_autoreleasePoolPush(void) {
+  MockObjC::Runtime &rt = MockObjC::runtime();
+  MockObjC::AutoreleaseStack &stack = MockObjC::t_autoreleaseStack;
+  stack.boundaries.push_back(stack.objects.size());
+
+  rt.poolPushes.fetch_add(1, std::memory_order_relaxed);
+  MockObjC::updateHighWater(rt.poolDepthHighWater, stack.boundaries.size());
+  return reinterpret_cast<void *>(stack.boundaries.size());
+}
+
+void objc_autoreleasePoolPop(void *pContext) {
+  MockObjC::Runtime &rt = MockObjC::runtime();
+  MockObjC::AutoreleaseStack &stack = MockObjC::t_autoreleaseStack;
+  const auto depth = reinterpret_cast<std::size_t>(pContext);
+  if (depth == 0 || depth > stack.boundaries.size()) {
+    std::fprintf(stderr, "mock-objc: popping autorelease pool %zu of %zu\n",
+                 depth, stack.boundaries.size());
+    std::abort();
+  }
+
+  // Popping a pool also pops every pool pushed after it. Objects are
+  // released newest first, and a dealloc may autorelease more objects into
+  // the scope being drained, so the loop re-reads the stack each time.
+  static SEL s_release = sel_registerName("release");
+  while (stack.boundaries.size() >= depth) {
+    const std::size_t boundary = stack.boundaries.back();
+    MockObjC::updateHighWater(rt.poolObjectsHighWater,
+                              stack.objects.size() - boundary);
+    while (stack.objects.size() > boundary) {
+      id object = stack.objects.back();
+      stack.objects.pop_back();
+      MockObjC::send<void>(object, s_release);
+    }
+    stack.boundaries.pop_back();
+  }
+}
+
+CFStringRef __CFStringMakeConstantString(const char *cStr) {
+  MockObjC::Runtime &rt = MockObjC::runtime();
+  std::lock_guard<std::mutex> lock(rt.constantStringMutex);
+  auto it = rt.constantStrings.find(std::string_view(cStr));
+  if (it == rt.constantStrings.end()) {
+    id string = class_createInstance(rt.stringClass, sizeof(std::string *));
+    MockObjC::stringStorage(string) = new std::string(cStr);
+    MockObjC::header(string)->retainCount.store(MockObjC::kImmortal,
+                                                std::memory_order_relaxed);
+    it = rt.constantStrings.emplace(cStr, string).first;
+  }
+  return reinterpret_cast<CFStringRef>(it->second);
+}
+
+}  // extern "C"
+
+// objc_msgSend and friends have to forward their arguments untouched to the
+// resolved IMP, which is only possible as a register-preserving tail jump.
+#if defined(__x86_64__)
+// clang-format off
+asm(R"(
+    .pushsection .text
+    .p2align 4
+    .globl objc_msgSend
+    .type objc_msgSend, @function
+objc_msgSend:
+    testq   %rdi, %rdi
+    jz      1f
+    pushq   %rbp
+    movq    %rsp, %rbp
+    subq    $192, %rsp
+    movq    %rdi, 0(%rsp)
+    movq    %rsi, 8(%rsp)
+    movq    %rdx, 16(%rsp)
+    movq    %rcx, 24(%rsp)
+    movq    %r8, 32(%rsp)
+    movq    %r9, 40(%rsp)
+    movq    %rax, 48(%rsp)
+    movdqa  %xmm0, 64(%rsp)
+    movdqa  %xmm1, 80(%rsp)
+    movdqa  %xmm2, 96(%rsp)
+    movdqa  %xmm3, 112(%rsp)
+    movdqa  %xmm4, 128(%rsp)
+    movdqa  %xmm5, 144(%rsp)
+    movdqa  %xmm6, 160(%rsp)
+    movdqa  %xmm7, 176(%rsp)
+    call    mock_objc_lookUpImplementation@PLT
+    movq    %rax, %r11
+    movq    0(%rsp), %rdi
+    movq    8(%rsp), %rsi
+    movq    16(%rsp), %rdx
+    movq    24(%rsp), %rcx
+    movq    32(%rsp), %r8
+    movq    40(%rsp), %r9
+    movq    48(%rsp), %rax
+    movdqa  64(%rsp), %xmm0
+    movdqa  80(%rsp), %xmm1
+    movdqa  96(%rsp), %xmm2
+    movdqa  112(%rsp), %xmm3
+    movdqa  128(%rsp), %xmm4
+    movdqa  144(%rsp), %xmm5
+    movdqa  160(%rsp), %xmm6
+    movdqa  176(%rsp), %xmm7
+    leave
+    jmp     *%r11
+1:
+    xorl    %eax, %eax
+    xorl    %edx, %edx
+    pxor    %xmm0, %xmm0
+    pxor    %xmm1, %xmm1
+    ret
+    .size objc_msgSend, .-objc_msgSend
+
+    .globl objc_msgSend_fpret
+    .set objc_msgSend_fpret, objc_msgSend
+
+    .p2align 4
+    .globl objc_msgSend_stret
+    .type objc_msgSend_stret, @function
+objc_msgSend_stret:
+    testq   %rsi, %rsi
+    jz      1f
+    pushq   %rbp
+    movq    %rsp, %rbp
+    subq    $192, %rsp
+    movq    %rdi, 0(%rsp)
+    movq    %rsi, 8(%rsp)
+    movq    %rdx, 16(%rsp)
+    movq    %rcx, 24(%rsp)
+    movq    %r8, 32(%rsp)
+    movq    %r9, 40(%rsp)
+    movq    %rax, 48(%rsp)
+    movdqa  %xmm0, 64(%rsp)
+    movdqa  %xmm1, 80(%rsp)
+    movdqa  %xmm2, 96(%rsp)
+    movdqa  %xmm3, 112(%rsp)
+    movdqa  %xmm4, 128(%rsp)
+    movdqa  %xmm5, 144(%rsp)
+    movdqa  %xmm6, 160(%rsp)
+    movdqa  %xmm7, 176(%rsp)
+    movq    %rsi, %rdi
+    movq    %rdx, %rsi
+    call    mock_objc_lookUpImplementation@PLT
+    movq    %rax, %r11
+    movq    0(%rsp), %rdi
+    movq    8(%rsp), %rsi
+    movq    16(%rsp), %rdx
+    movq    24(%rsp), %rcx
+    movq    32(%rsp), %r8
+    movq    40(%rsp), %r9
+    movq    48(%rsp), %rax
+    movdqa  64(%rsp), %xmm0
+    movdqa  80(%rsp), %xmm1
+    movdqa  96(%rsp), %xmm2
+    movdqa  112(%rsp), %xmm3
+    movdqa  128(%rsp), %xmm4
+    movdqa  144(%rsp), %xmm5
+    movdqa  160(%rsp), %xmm6
+    movdqa  176(%rsp), %xmm7
+    leave
+    jmp     *%r11
+1:
+    movq    %rdi, %rax
+    ret
+    .size objc_msgSend_stret, .-objc_msgSend_stret
+    .popsection
+)");
+// clang-format on
+#else
+#error "mock-objc: objc_msgSend is only implemented for x86_64"
+#endif
@@ -0,0 +1,74 @@
+#pragma once
+
+#include <objc/runtime.h>
+
+#include <cstddef>
+#include <cstdint>
+
+// C++ side of the mock Objective-C runtime: helpers for scripting fake
+// classes and counters that let benchmarks see exactly how much work reached
+// the runtime.
+//
+// The runtime registers NSObject (with alloc/init/retain/release/autorelease/
+// dealloc and friends), NSAutoreleasePool and NSString. Everything else is
+// defined by the program through defineClass()/addMethod().
+namespace MockObjC {
+
+struct Statistics {
+  std::uint64_t selectorRegistrations;
+  std::uint64_t classLookups;
+  std::uint64_t messagesSent;
+  std::uint64_t methodLookups;
+  std::uint64_t allocations;
+  std::uint64_t deallocations;
+  std::uint64_t retains;
+  std::uint64_t releases;
+  std::uint64_t autoreleases;
+  std::uint64_t poolPushes;
+  // Most objects a single pool scope released when it was popped, and the
+  // deepest pool nesting seen on any thread.
+  std::uint64_t poolObjectsHighWater;
+  std::uint64_t poolDepthHighWater;
+};
+
+Statistics statistics();
+void resetStatistics();
+
+// Number of distinct selectors interned so far.
+std::size_t selectorCount();
+// Messages dispatched through objc_msgSend for one selector since the last
+// resetStatistics().
+std::uint64_t messageCount(const char *selector);
+// Objects autoreleased into the innermost pool of the calling thread so far.
+std::size_t autoreleasePoolObjectCount();
+
+Class rootClass();
+
+// Defines and registers a class. Instances created by +alloc get
+// instanceExtraBytes of zeroed storage, reachable via
+// object_getIndexedIvars().
+Class defineClass(const char *name, Class superclass = rootClass(),
+                  std::size_t instanceExtraBytes = 0);
+
+template <typename _Ret, typename... _Args>
+void addMethod(Class cls, const char *selector, _Ret (*pFunction)(id, SEL,
+                                                                 _Args...)) {
+  class_addMethod(cls, sel_registerName(selector),
+                  reinterpret_cast<IMP>(pFunction), "");
+}
+
+template <typename _Ret, typename... _Args>
+void addClassMethod(Class cls, const char *selector,
+                    _Ret (*pFunction)(id, SEL, _Args...)) {
+  addMethod(object_getClass(reinterpret_cast<id>(cls)), selector, pFunction);
+}
+
+template <typename _Type>
+_Type *ivars(const void *pObject) {
+  return static_cast<_Type *>(
+      object_getIndexedIvars(static_cast<id>(const_cast<void *>(pObject))));
+}
+
+std::uintptr_t retainCount(const void *pObject);
+
+}  // namespace MockObjC
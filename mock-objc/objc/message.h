@@ -0,0 +1,17 @@
+#pragma once
+
+#include <objc/runtime.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// Like the real runtime these are trampolines: they are declared without a
+// prototype and must be cast to the exact signature of the method called.
+void objc_msgSend(void);
+void objc_msgSend_stret(void);
+void objc_msgSend_fpret(void);
+
+#ifdef __cplusplus
+}
+#endif
@@ -0,0 +1,80 @@
+#pragma once
+
+// Stand-in for the Objective-C runtime headers on platforms without libobjc.
+// Declares the subset of the Apple runtime API that metal-cpp and its
+// extensions use, plus what scripted fakes need to define classes. The
+// implementation lives in MockObjC.cc; MockObjC.hpp adds C++ helpers and
+// counters on top.
+
+#include <stddef.h>
+#ifndef __cplusplus
+#include <stdbool.h>
+#endif
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+typedef struct objc_selector *SEL;
+typedef struct objc_class *Class;
+
+struct objc_object {
+  Class isa;
+};
+typedef struct objc_object *id;
+
+typedef void (*IMP)(void);
+
+typedef bool BOOL;
+#define YES true
+#define NO false
+
+#ifdef __cplusplus
+#define Nil nullptr
+#define nil nullptr
+#else
+#define Nil ((Class)0)
+#define nil ((id)0)
+#endif
+
+typedef enum objc_AssociationPolicy {
+  OBJC_ASSOCIATION_ASSIGN = 0,
+  OBJC_ASSOCIATION_RETAIN_NONATOMIC = 1,
+  OBJC_ASSOCIATION_COPY_NONATOMIC = 3,
+  OBJC_ASSOCIATION_RETAIN = 01401,
+  OBJC_ASSOCIATION_COPY = 01403,
+} objc_AssociationPolicy;
+
+SEL sel_registerName(const char *str);
+const char *sel_getName(SEL sel);
+
+Class objc_lookUpClass(const char *name);
+Class objc_getClass(const char *name);
+Class objc_allocateClassPair(Class superclass, const char *name,
+                             size_t extraBytes);
+void objc_registerClassPair(Class cls);
+
+const char *class_getName(Class cls);
+Class class_getSuperclass(Class cls);
+BOOL class_isMetaClass(Class cls);
+BOOL class_addMethod(Class cls, SEL name, IMP imp, const char *types);
+BOOL class_respondsToSelector(Class cls, SEL sel);
+IMP class_getMethodImplementation(Class cls, SEL name);
+id class_createInstance(Class cls, size_t extraBytes);
+
+Class object_getClass(id obj);
+void *object_getIndexedIvars(id obj);
+id object_dispose(id obj);
+
+void objc_setAssociatedObject(id object, const void *key, id value,
+                              objc_AssociationPolicy policy);
+id objc_getAssociatedObject(id object, const void *key);
+
+// Private on Apple platforms (objc-internal.h), but exported by libobjc and
+// what @autoreleasepool compiles to.
+void *objc_autoreleasePoolPush(void);
+void objc_autoreleasePoolPop(void *context);
+
+#ifdef __cplusplus
+}
+#endif
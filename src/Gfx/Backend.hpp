@@ -0,0 +1,316 @@
+#pragma once
+
+#include <Gfx/Types.hpp>
+
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <string>
+#include <vector>
+
+// Backend interface the Renderer is written against. The shape follows the
+// Metal objects it replaces so that the Metal implementation stays a thin
+// forwarding layer, while the software implementation can run headless.
+namespace Gfx {
+
+// CPU visible buffer, the equivalent of an MTL::Buffer in shared storage.
+class Buffer {
+ public:
+  virtual ~Buffer() = default;
+
+  virtual void *contents() = 0;
+  [[nodiscard]] virtual std::size_t length() const = 0;
+};
+
+// Size and alignment a buffer takes up in a Heap, as MTL::SizeAndAlign.
+struct SizeAndAlign {
+  std::size_t size;
+  std::size_t align;
+};
+
+// Memory buffers are placed into at offsets the caller picks, the equivalent
+// of an MTL::Heap of placement type in shared storage. Buffers from a heap
+// must not outlive it.
+class Heap {
+ public:
+  virtual ~Heap() = default;
+
+  [[nodiscard]] virtual std::size_t size() const = 0;
+  // offset has to be a multiple of the alignment heapBufferSizeAndAlign()
+  // reports for length, and the buffer has to fit from there.
+  virtual std::unique_ptr<Buffer> newBuffer(std::size_t length,
+                                            std::size_t offset) = 0;
+};
+
+// Monotonic value shared between the CPU and command buffers, the
+// equivalent of an MTL::SharedEvent. Command buffers signal it as they
+// execute, and can wait for it before executing.
+class SharedEvent {
+ public:
+  using NotificationFunction = std::function<void(std::uint64_t value)>;
+
+  virtual ~SharedEvent() = default;
+
+  [[nodiscard]] virtual std::uint64_t signaledValue() const = 0;
+  // Runs function once the event has reached value, possibly right away and
+  // possibly on a backend owned thread.
+  virtual void notify(std::uint64_t value, NotificationFunction function) = 0;
+};
+
+class Texture {
+ public:
+  virtual ~Texture() = default;
+
+  [[nodiscard]] virtual std::uint32_t width() const = 0;
+  [[nodiscard]] virtual std::uint32_t height() const = 0;
+  [[nodiscard]] virtual PixelFormat pixelFormat() const = 0;
+};
+
+struct RenderPassColorAttachmentDescriptor {
+  Texture *pTexture = nullptr;
+  LoadAction loadAction = LoadAction::Clear;
+  StoreAction storeAction = StoreAction::Store;
+  ClearColor clearColor = ClearColor::Make(0.0, 0.0, 0.0, 1.0);
+};
+
+struct RenderPassDescriptor {
+  RenderPassColorAttachmentDescriptor colorAttachment;
+};
+
+struct VertexAttributeDescriptor {
+  VertexFormat format = VertexFormat::Invalid;
+  std::uint32_t offset = 0;
+  std::uint32_t bufferIndex = 0;
+};
+
+struct VertexBufferLayoutDescriptor {
+  std::uint32_t stride = 0;
+  VertexStepFunction stepFunction = VertexStepFunction::PerVertex;
+  std::uint32_t stepRate = 1;
+};
+
+// Attributes by location and layouts by buffer index; attributes with an
+// Invalid format are unused. Empty for shaders that fetch their own
+// vertices.
+struct VertexDescriptor {
+  std::vector<VertexAttributeDescriptor> attributes;
+  std::vector<VertexBufferLayoutDescriptor> layouts;
+};
+
+struct RenderPipelineColorAttachmentDescriptor {
+  PixelFormat pixelFormat = PixelFormat::Invalid;
+  bool blendingEnabled = false;
+  BlendFactor sourceRGBBlendFactor = BlendFactor::One;
+  BlendFactor destinationRGBBlendFactor = BlendFactor::Zero;
+  BlendOperation rgbBlendOperation = BlendOperation::Add;
+  BlendFactor sourceAlphaBlendFactor = BlendFactor::One;
+  BlendFactor destinationAlphaBlendFactor = BlendFactor::Zero;
+  BlendOperation alphaBlendOperation = BlendOperation::Add;
+  std::uint8_t writeMask = ColorWriteMaskAll;
+};
+
+// Everything a render pipeline is compiled from, as in an
+// MTL::RenderPipelineDescriptor. Functions are named in the device's shader
+// library.
+struct RenderPipelineDescriptor {
+  std::string vertexFunction;
+  std::string fragmentFunction;
+  VertexDescriptor vertexDescriptor;
+  RenderPipelineColorAttachmentDescriptor colorAttachment;
+  PixelFormat depthAttachmentPixelFormat = PixelFormat::Invalid;
+  std::uint32_t sampleCount = 1;
+};
+
+// A compiled render pipeline, the equivalent of an MTL::RenderPipelineState.
+class RenderPipelineState {
+ public:
+  virtual ~RenderPipelineState() = default;
+};
+
+class Drawable {
+ public:
+  virtual ~Drawable() = default;
+
+  virtual Texture *texture() = 0;
+};
+
+// A range of commands of an IndirectCommandBuffer, with the layout of
+// MTL::IndirectCommandBufferExecutionRange.
+struct IndirectCommandBufferExecutionRange {
+  std::uint32_t location;
+  std::uint32_t length;
+};
+
+struct IndirectCommandBufferDescriptor {
+  // Commands bind their own vertex buffers at indices below this instead of
+  // inheriting the encoder's. The pipeline state is always inherited.
+  std::size_t maxVertexBufferBindCount = 1;
+};
+
+// Draw commands recorded ahead of time, which render passes then execute
+// any number of times, the equivalent of an MTL::IndirectCommandBuffer of
+// draw commands. Commands are encoded by index, and different commands may
+// be encoded from different threads at once. A command must not be encoded
+// while a committed command buffer that executes it has yet to complete.
+class IndirectCommandBuffer {
+ public:
+  virtual ~IndirectCommandBuffer() = default;
+
+  [[nodiscard]] virtual std::size_t size() const = 0;
+  virtual void setVertexBuffer(std::size_t command, Buffer *pBuffer,
+                               std::size_t offset, std::size_t index) = 0;
+  virtual void drawPrimitives(std::size_t command,
+                              PrimitiveType primitiveType,
+                              std::size_t vertexStart,
+                              std::size_t vertexCount,
+                              std::size_t instanceCount,
+                              std::size_t baseInstance) = 0;
+  // Clears the commands of range, which then draw nothing.
+  virtual void reset(const IndirectCommandBufferExecutionRange &range) = 0;
+};
+
+// Bound state starts out undefined with every encoder, including each
+// sub-encoder of a parallel pass.
+class RenderCommandEncoder {
+ public:
+  // Same limits as Metal's buffer and texture argument tables.
+  static constexpr std::size_t kMaxVertexBuffers = 31;
+  static constexpr std::size_t kMaxFragmentTextures = 31;
+
+  virtual ~RenderCommandEncoder() = default;
+
+  virtual void setRenderPipelineState(RenderPipelineState *pState) = 0;
+  virtual void setVertexBuffer(Buffer *pBuffer, std::size_t offset,
+                               std::size_t index) = 0;
+  // Moves the buffer bound at index to offset.
+  virtual void setVertexBufferOffset(std::size_t offset,
+                                     std::size_t index) = 0;
+  virtual void setFragmentTexture(Texture *pTexture, std::size_t index) = 0;
+  virtual void setViewport(const Viewport &viewport) = 0;
+  virtual void setScissorRect(const ScissorRect &rect) = 0;
+  virtual void setCullMode(CullMode cullMode) = 0;
+  virtual void setFrontFacingWinding(Winding winding) = 0;
+  virtual void drawPrimitives(PrimitiveType primitiveType,
+                              std::size_t vertexStart,
+                              std::size_t vertexCount) = 0;
+  // Buffers that executed indirect commands bind have to be declared with
+  // useResource() in every pass that executes them.
+  virtual void useResource(Buffer *pBuffer) = 0;
+  virtual void executeCommandsInBuffer(
+      IndirectCommandBuffer *pCommands,
+      const IndirectCommandBufferExecutionRange &range) = 0;
+  virtual void endEncoding() = 0;
+};
+
+// Copies between resources in command buffer order, the equivalent of an
+// MTL::BlitCommandEncoder.
+class BlitCommandEncoder {
+ public:
+  virtual ~BlitCommandEncoder() = default;
+
+  // Copies all of pTexture into pBuffer, row by row starting at
+  // destinationOffset, with rows destinationBytesPerRow apart.
+  virtual void copyFromTexture(Texture *pTexture, Buffer *pBuffer,
+                               std::size_t destinationOffset,
+                               std::size_t destinationBytesPerRow) = 0;
+  // Metal on macOS wants both offsets and size to be multiples of 4.
+  virtual void copyFromBuffer(Buffer *pSource, std::size_t sourceOffset,
+                              Buffer *pDestination,
+                              std::size_t destinationOffset,
+                              std::size_t size) = 0;
+  virtual void endEncoding() = 0;
+};
+
+// Splits one render pass across several render command encoders that can be
+// used from different threads at the same time. The sub-encoders execute in
+// the order renderCommandEncoder() created them, regardless of which thread
+// finished encoding first. Create them on the thread that owns the parallel
+// encoder; end all of them before ending it.
+class ParallelRenderCommandEncoder {
+ public:
+  virtual ~ParallelRenderCommandEncoder() = default;
+
+  virtual RenderCommandEncoder *renderCommandEncoder() = 0;
+  virtual void endEncoding() = 0;
+};
+
+struct CommandBufferDescriptor {
+  // A command buffer with retained references keeps every resource it
+  // references alive until it completes, at the price of a retain/release
+  // pair per reference. Without them the caller has to keep resources alive
+  // itself, see FrameSubmitter.
+  bool retainedReferences = true;
+};
+
+// Command buffers are owned by their queue. Callers must not hold on to one
+// past the frame that requested it.
+class CommandBuffer {
+ public:
+  using HandlerFunction = std::function<void()>;
+
+  virtual ~CommandBuffer() = default;
+
+  // Runs once the backend has finished executing the buffer. Handlers may be
+  // invoked on a backend owned thread.
+  virtual void addCompletedHandler(const HandlerFunction &function) = 0;
+
+  virtual RenderCommandEncoder *renderCommandEncoder(
+      const RenderPassDescriptor &descriptor) = 0;
+  virtual ParallelRenderCommandEncoder *parallelRenderCommandEncoder(
+      const RenderPassDescriptor &descriptor) = 0;
+  virtual BlitCommandEncoder *blitCommandEncoder() = 0;
+  // Between passes: commands encoded after a wait don't execute before
+  // pEvent reaches value, and pEvent is set to value once everything encoded
+  // before a signal has executed.
+  virtual void encodeWait(SharedEvent *pEvent, std::uint64_t value) = 0;
+  virtual void encodeSignalEvent(SharedEvent *pEvent,
+                                 std::uint64_t value) = 0;
+  virtual void presentDrawable(Drawable *pDrawable) = 0;
+  virtual void commit() = 0;
+  virtual void waitUntilCompleted() = 0;
+};
+
+class CommandQueue {
+ public:
+  virtual ~CommandQueue() = default;
+
+  virtual CommandBuffer *commandBuffer(
+      const CommandBufferDescriptor &descriptor) = 0;
+  CommandBuffer *commandBuffer() {
+    return commandBuffer(CommandBufferDescriptor{});
+  }
+};
+
+class View {
+ public:
+  virtual ~View() = default;
+
+  virtual RenderPassDescriptor currentRenderPassDescriptor() = 0;
+  virtual Drawable *currentDrawable() = 0;
+};
+
+class Device {
+ public:
+  virtual ~Device() = default;
+
+  virtual std::unique_ptr<CommandQueue> newCommandQueue() = 0;
+  virtual std::unique_ptr<Buffer> newBuffer(std::size_t length) = 0;
+  virtual SizeAndAlign heapBufferSizeAndAlign(std::size_t length) = 0;
+  virtual std::unique_ptr<Heap> newHeap(std::size_t size) = 0;
+  virtual std::unique_ptr<SharedEvent> newSharedEvent() = 0;
+  virtual std::unique_ptr<IndirectCommandBuffer> newIndirectCommandBuffer(
+      const IndirectCommandBufferDescriptor &descriptor,
+      std::size_t maxCommandCount) = 0;
+  // Compiles a pipeline, which can take long enough to drop frames, see
+  // PipelineCache. Returns nullptr if it doesn't compile. Thread safe.
+  virtual std::unique_ptr<RenderPipelineState> newRenderPipelineState(
+      const RenderPipelineDescriptor &descriptor) = 0;
+  // A render target in GPU memory, like the textures behind drawables. The
+  // CPU reads it back by blitting it into a buffer.
+  virtual std::unique_ptr<Texture> newTexture(std::uint32_t width,
+                                              std::uint32_t height,
+                                              PixelFormat pixelFormat) = 0;
+};
+
+}  // namespace Gfx
@@ -0,0 +1,180 @@
+#include <Gfx/BufferHeap.hpp>
+
+#include <algorithm>
+#include <cassert>
+#include <utility>
+
+namespace Gfx {
+
+HeapBuffer::HeapBuffer(HeapBuffer &&other) noexcept
+    : _pHeap(other._pHeap),
+      _pBuffer(std::move(other._pBuffer)),
+      _heapIndex(other._heapIndex),
+      _allocation(other._allocation) {}
+
+HeapBuffer &HeapBuffer::operator=(HeapBuffer &&other) noexcept {
+  if (this != &other) {
+    reset();
+    _pHeap = other._pHeap;
+    _pBuffer = std::move(other._pBuffer);
+    _heapIndex = other._heapIndex;
+    _allocation = other._allocation;
+  }
+  return *this;
+}
+
+void HeapBuffer::reset() {
+  if (_pBuffer == nullptr) {
+    return;
+  }
+  const std::size_t length = _pBuffer->length();
+  // The buffer goes before its range can be handed out again.
+  _pBuffer.reset();
+  _pHeap->release(*this, length);
+}
+
+BufferHeap::BufferHeap(Device *pDevice, const BufferHeapDescriptor &descriptor)
+    : _pDevice(pDevice), _descriptor(descriptor) {}
+
+HeapBuffer BufferHeap::newBuffer(std::size_t length) {
+  const SizeAndAlign sizeAndAlign = _pDevice->heapBufferSizeAndAlign(length);
+  HeapBuffer buffer;
+  buffer._pHeap = this;
+  if (sizeAndAlign.size > _descriptor.heapSize) {
+    buffer._pBuffer = _pDevice->newBuffer(length);
+    std::lock_guard<std::mutex> lock(_mutex);
+    ++_allocationCount;
+    ++_dedicatedBufferCount;
+    _dedicatedBytes += length;
+    return buffer;
+  }
+
+  Heap *pHeap = nullptr;
+  {
+    std::lock_guard<std::mutex> lock(_mutex);
+    ++_allocationCount;
+    // The lowest heap that fits, so later heaps drain and can be trimmed.
+    for (std::size_t i = 0; i < _heaps.size() && pHeap == nullptr; ++i) {
+      if (_heaps[i] == nullptr) {
+        continue;
+      }
+      buffer._allocation =
+          _heaps[i]->allocator.allocate(sizeAndAlign.size, sizeAndAlign.align);
+      if (buffer._allocation) {
+        buffer._heapIndex = i;
+        pHeap = _heaps[i]->pHeap.get();
+      }
+    }
+    if (pHeap == nullptr) {
+      const auto liveHeapCount = static_cast<std::size_t>(std::count_if(
+          _heaps.begin(), _heaps.end(),
+          [](const std::unique_ptr<HeapRange> &pRange) {
+            return pRange != nullptr;
+          }));
+      if (_descriptor.maxHeapCount != 0 &&
+          liveHeapCount >= _descriptor.maxHeapCount) {
+        ++_failedAllocationCount;
+        return {};
+      }
+      // Placement granularity is what the smallest buffer takes up.
+      const std::size_t granularity =
+          _pDevice->heapBufferSizeAndAlign(1).align;
+      auto pRange = std::make_unique<HeapRange>(HeapRange{
+          _pDevice->newHeap(_descriptor.heapSize),
+          TlsfAllocator(_descriptor.heapSize, granularity)});
+      buffer._allocation =
+          pRange->allocator.allocate(sizeAndAlign.size, sizeAndAlign.align);
+      assert(buffer._allocation);
+      pHeap = pRange->pHeap.get();
+      const auto slot = std::find(_heaps.begin(), _heaps.end(), nullptr);
+      buffer._heapIndex = static_cast<std::size_t>(slot - _heaps.begin());
+      if (slot == _heaps.end()) {
+        _heaps.push_back(std::move(pRange));
+      } else {
+        *slot = std::move(pRange);
+      }
+    }
+    _requestedBytes += length;
+  }
+  // The range is taken, so its heap can't be trimmed meanwhile.
+  buffer._pBuffer = pHeap->newBuffer(length, buffer._allocation.offset);
+  return buffer;
+}
+
+std::uint64_t BufferHeap::trim() {
+  std::vector<std::unique_ptr<HeapRange>> released;
+  std::uint64_t releasedBytes = 0;
+  {
+    std::lock_guard<std::mutex> lock(_mutex);
+    for (std::unique_ptr<HeapRange> &pRange : _heaps) {
+      if (pRange != nullptr && pRange->allocator.empty()) {
+        releasedBytes += pRange->allocator.size();
+        released.push_back(std::move(pRange));
+      }
+    }
+    while (!_heaps.empty() && _heaps.back() == nullptr) {
+      _heaps.pop_back();
+    }
+  }
+  return releasedBytes;
+}
+
+BufferHeapStatistics BufferHeap::statistics() {
+  std::lock_guard<std::mutex> lock(_mutex);
+  BufferHeapStatistics statistics{};
+  std::uint64_t freeBytes = 0;
+  for (const std::unique_ptr<HeapRange> &pRange : _heaps) {
+    if (pRange == nullptr) {
+      continue;
+    }
+    const TlsfAllocator::Statistics heap = pRange->allocator.statistics();
+    ++statistics.heapCount;
+    statistics.heapBytes += heap.size;
+    statistics.usedBytes += heap.usedBytes;
+    statistics.largestFreeBlock =
+        std::max(statistics.largestFreeBlock, heap.largestFreeBlock);
+    statistics.bufferCount += heap.allocationCount;
+    statistics.freeBlockCount += heap.freeBlockCount;
+    freeBytes += heap.freeBytes;
+  }
+  statistics.requestedBytes = _requestedBytes;
+  statistics.dedicatedBufferCount = _dedicatedBufferCount;
+  statistics.dedicatedBytes = _dedicatedBytes;
+  statistics.fragmentation =
+      freeBytes == 0 ? 0.0
+                     : 1.0 - static_cast<double>(statistics.largestFreeBlock) /
+                                 static_cast<double>(freeBytes);
+  statistics.allocationCount = _allocationCount;
+  statistics.failedAllocationCount = _failedAllocationCount;
+  return statistics;
+}
+
+std::vector<BufferHeapDefragmentationHint> BufferHeap::defragmentationHints(
+    std::size_t maxCount) {
+  std::lock_guard<std::mutex> lock(_mutex);
+  std::vector<BufferHeapDefragmentationHint> hints;
+  for (std::size_t i = _heaps.size(); i-- > 0 && hints.size() < maxCount;) {
+    if (_heaps[i] == nullptr) {
+      continue;
+    }
+    for (const TlsfAllocator::Allocation &allocation :
+         _heaps[i]->allocator.defragmentationCandidates(maxCount -
+                                                        hints.size())) {
+      hints.push_back({i, allocation.offset, allocation.size});
+    }
+  }
+  return hints;
+}
+
+void BufferHeap::release(HeapBuffer &buffer, std::size_t length) {
+  std::lock_guard<std::mutex> lock(_mutex);
+  if (buffer._heapIndex == HeapBuffer::kDedicated) {
+    --_dedicatedBufferCount;
+    _dedicatedBytes -= length;
+    return;
+  }
+  _requestedBytes -= length;
+  _heaps[buffer._heapIndex]->allocator.free(buffer._allocation);
+}
+
+}  // namespace Gfx
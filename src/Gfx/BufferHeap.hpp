@@ -0,0 +1,133 @@
+#pragma once
+
+#include <Gfx/Backend.hpp>
+#include <Gfx/TlsfAllocator.hpp>
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <vector>
+
+// Sub-allocates buffers out of a few large device heaps instead of making
+// every buffer its own driver allocation. Each heap's range is managed by a
+// TlsfAllocator at the sizes and alignments heapBufferSizeAndAlign()
+// reports, and placing a buffer costs one Heap::newBuffer.
+namespace Gfx {
+
+class BufferHeap;
+
+struct BufferHeapDescriptor {
+  // Size of each heap. Buffers that don't fit in one get a dedicated
+  // allocation from the device.
+  std::size_t heapSize = std::size_t{64} << 20;
+  // Heaps are added as they fill up, up to this many; 0 for no limit.
+  std::size_t maxHeapCount = 0;
+};
+
+struct BufferHeapStatistics {
+  std::size_t heapCount;
+  std::uint64_t heapBytes;
+  // Bytes taken by placed buffers, padded to their heap size and alignment.
+  std::uint64_t usedBytes;
+  // Lengths of placed buffers as they were asked for.
+  std::uint64_t requestedBytes;
+  std::uint64_t largestFreeBlock;
+  std::size_t bufferCount;
+  std::size_t freeBlockCount;
+  std::size_t dedicatedBufferCount;
+  std::uint64_t dedicatedBytes;
+  // Free space outside the largest free block of any heap.
+  double fragmentation;
+  std::uint64_t allocationCount;
+  std::uint64_t failedAllocationCount;
+};
+
+// A placed buffer worth moving: replacing it with a new buffer from the
+// heap, then releasing it, compacts its heap. Compare heapIndex() and
+// offset() of the HeapBuffers to find it.
+struct BufferHeapDefragmentationHint {
+  std::size_t heapIndex;
+  std::uint64_t offset;
+  std::uint64_t size;
+};
+
+// A buffer from a BufferHeap, which gets its range back when this is
+// destroyed or reset. Like the buffer itself, it has to outlive the frames
+// that use it, and the BufferHeap has to outlive it.
+class HeapBuffer {
+ public:
+  static constexpr std::size_t kDedicated = ~std::size_t{0};
+
+  HeapBuffer() = default;
+  ~HeapBuffer() { reset(); }
+
+  HeapBuffer(HeapBuffer &&other) noexcept;
+  HeapBuffer &operator=(HeapBuffer &&other) noexcept;
+
+  explicit operator bool() const { return _pBuffer != nullptr; }
+  [[nodiscard]] Buffer *buffer() const { return _pBuffer.get(); }
+  // kDedicated for a buffer too large for the heaps.
+  [[nodiscard]] std::size_t heapIndex() const { return _heapIndex; }
+  [[nodiscard]] std::uint64_t offset() const { return _allocation.offset; }
+
+  void reset();
+
+ private:
+  friend class BufferHeap;
+
+  BufferHeap *_pHeap = nullptr;
+  std::unique_ptr<Buffer> _pBuffer;
+  std::size_t _heapIndex = kDedicated;
+  TlsfAllocator::Allocation _allocation;
+};
+
+// Thread safe. Heaps are created on demand and kept when they empty out
+// until trim() is called.
+class BufferHeap {
+ public:
+  explicit BufferHeap(Device *pDevice, const BufferHeapDescriptor &descriptor =
+                                           BufferHeapDescriptor());
+
+  BufferHeap(const BufferHeap &) = delete;
+  BufferHeap &operator=(const BufferHeap &) = delete;
+
+  // An empty HeapBuffer once maxHeapCount heaps are full.
+  [[nodiscard]] HeapBuffer newBuffer(std::size_t length);
+  // Destroys empty heaps and returns how many bytes that released.
+  std::uint64_t trim();
+
+  [[nodiscard]] BufferHeapStatistics statistics();
+  // Up to maxCount hints, starting at the end of the last heap, so moves
+  // drain the heaps trim() can release soonest.
+  [[nodiscard]] std::vector<BufferHeapDefragmentationHint>
+  defragmentationHints(std::size_t maxCount);
+
+  [[nodiscard]] const BufferHeapDescriptor &descriptor() const {
+    return _descriptor;
+  }
+
+ private:
+  friend class HeapBuffer;
+
+  struct HeapRange {
+    std::unique_ptr<Heap> pHeap;
+    TlsfAllocator allocator;
+  };
+
+  void release(HeapBuffer &buffer, std::size_t length);
+
+  Device *_pDevice;
+  BufferHeapDescriptor _descriptor;
+
+  std::mutex _mutex;
+  // Trimmed heaps leave a null slot behind, so indices stay put.
+  std::vector<std::unique_ptr<HeapRange>> _heaps;
+  std::uint64_t _requestedBytes = 0;
+  std::size_t _dedicatedBufferCount = 0;
+  std::uint64_t _dedicatedBytes = 0;
+  std::uint64_t _allocationCount = 0;
+  std::uint64_t _failedAllocationCount = 0;
+};
+
+}  // namespace Gfx
@@ -0,0 +1,627 @@
+#include <Gfx/Bvh.hpp>
+
+#include <atomic>
+#include <cassert>
+#include <mutex>
+
+namespace Gfx {
+
+namespace {
+
+constexpr std::uint32_t kMaxBinCount = 32;
+// Nodes with fewer primitives than this build both children on the job that
+// reached them; handing a subtree to another thread costs more.
+constexpr std::size_t kMinJobPrimitives = 4096;
+// Nodes with more primitives than this bin them over parallelFor ranges.
+constexpr std::size_t kMinParallelBinPrimitives = std::size_t{1} << 16;
+constexpr std::size_t kBinGrain = std::size_t{1} << 14;
+// Deeper nodes split at the object median instead of by SAH, which bounds
+// the tree's depth for Detail::kBvhStackSize whatever the input.
+constexpr int kMaxSahDepth = 60;
+// Refits touching fewer nodes than this run on the calling thread.
+constexpr std::size_t kMinParallelRefitNodes = 2048;
+// Subtrees this close to the root are refit as separate jobs: up to 2^6.
+constexpr int kMaxRefitJobDepth = 6;
+
+struct Bounds {
+  Float4 min = Float4::splat(INFINITY);
+  Float4 max = Float4::splat(-INFINITY);
+
+  void grow(Float4 point) {
+    min = Gfx::min(min, point);
+    max = Gfx::max(max, point);
+  }
+  void grow(const Bounds &other) {
+    min = Gfx::min(min, other.min);
+    max = Gfx::max(max, other.max);
+  }
+  // Half the surface area; only ratios of areas matter.
+  [[nodiscard]] float halfArea() const {
+    const Float4 extent = max - min;
+    const float x = extent.x();
+    const float y = extent.y();
+    const float z = extent.z();
+    return x * y + y * z + z * x;
+  }
+};
+
+// A primitive's bounds with its index in the input, moved around by the
+// partitioning instead of indexing into the input.
+struct alignas(16) Reference {
+  Float4 min;
+  Float4 max;
+  std::uint32_t index;
+
+  [[nodiscard]] Float4 centroid() const { return (min + max) * 0.5F; }
+};
+
+Bounds toBounds(const AxisAlignedBoundingBox &box) {
+  return {Float4::fromPacked(box.min, 0.0F),
+          Float4::fromPacked(box.max, 0.0F)};
+}
+
+Bounds toBounds(const BvhNode &node) {
+  return {Float4::fromPacked(node.min, 0.0F),
+          Float4::fromPacked(node.max, 0.0F)};
+}
+
+void setBounds(BvhNode &node, const Bounds &bounds) {
+  node.min = bounds.min.toPacked();
+  node.max = bounds.max.toPacked();
+}
+
+// Bins of all three axes. Only the counts are cleared up front: a bin's
+// bounds are written by the first primitive that lands in it and read only
+// while its count is nonzero, so the many small nodes near the leaves don't
+// pay for clearing every bin.
+struct Bins {
+  void add(int axis, std::uint32_t bin, const Bounds &bounds,
+           std::uint32_t count) {
+    float(&box)[2][4] = boxes[axis][bin];
+    if (counts[axis][bin] == 0) {
+      bounds.min.store(box[0]);
+      bounds.max.store(box[1]);
+    } else {
+      min(Float4::load(box[0]), bounds.min).store(box[0]);
+      max(Float4::load(box[1]), bounds.max).store(box[1]);
+    }
+    counts[axis][bin] += count;
+  }
+
+  void merge(const Bins &other, std::uint32_t binCount) {
+    for (int axis = 0; axis < 3; ++axis) {
+      for (std::uint32_t bin = 0; bin < binCount; ++bin) {
+        if (other.counts[axis][bin] != 0) {
+          add(axis, bin, other.bounds(axis, bin), other.counts[axis][bin]);
+        }
+      }
+    }
+  }
+
+  [[nodiscard]] Bounds bounds(int axis, std::uint32_t bin) const {
+    return {Float4::load(boxes[axis][bin][0]),
+            Float4::load(boxes[axis][bin][1])};
+  }
+
+  std::uint32_t counts[3][kMaxBinCount] = {};
+  alignas(16) float boxes[3][kMaxBinCount][2][4];
+};
+
+// Maps centroids to bins, evenly over the node's centroid bounds. Binning
+// and partitioning use the same mapping, so they agree on every primitive.
+struct BinMapping {
+  BinMapping(const Bounds &centroids, std::uint32_t binCount)
+      : origin(centroids.min), binCount(binCount) {
+    const Float4 extent = centroids.max - centroids.min;
+    alignas(16) float scales[4];
+    extent.store(scales);
+    for (float &value : scales) {
+      // Flat axes map everything to bin 0 and never split.
+      value = value > 0.0F ? static_cast<float>(binCount) * 0.9999F / value
+                           : 0.0F;
+    }
+    scale = Float4::load(scales);
+  }
+
+  void map(Float4 centroid, std::uint32_t (&bins)[3]) const {
+    alignas(16) float values[4];
+    ((centroid - origin) * scale).store(values);
+    for (int axis = 0; axis < 3; ++axis) {
+      bins[axis] = std::min(static_cast<std::uint32_t>(values[axis]),
+                            binCount - 1);
+    }
+  }
+
+  Float4 origin;
+  Float4 scale;
+  std::uint32_t binCount;
+};
+
+struct Split {
+  int axis = -1;
+  std::uint32_t bin = 0;
+  float cost = INFINITY;
+  Bounds leftBounds;
+  Bounds leftCentroids;
+  Bounds rightBounds;
+  Bounds rightCentroids;
+  std::uint32_t leftCount = 0;
+};
+
+class Builder {
+ public:
+  Builder(std::vector<Reference> &references, BvhNodeArray &nodes,
+          JobSystem *pJobSystem, const BvhBuildOptions &options)
+      : _references(references),
+        _nodes(nodes),
+        _pJobSystem(pJobSystem),
+        _options(options) {
+    _options.binCount = std::clamp(_options.binCount, 2U, kMaxBinCount);
+    _options.maxLeafSize = std::max(_options.maxLeafSize, 1U);
+  }
+
+  // Builds the subtree of nodeIndex, whose bounds are already set, over
+  // references [begin, end).
+  void buildNode(std::uint32_t nodeIndex, std::size_t begin, std::size_t end,
+                 const Bounds &centroids, int depth) {
+    const std::size_t count = end - begin;
+    BvhNode &node = _nodes[nodeIndex];
+
+    Split split;
+    if (count > 1 && depth < kMaxSahDepth) {
+      split = findSplit(begin, end, centroids, node);
+    }
+    const float leafCost =
+        _options.intersectionCost * static_cast<float>(count);
+    if (count <= _options.maxLeafSize && !(split.cost < leafCost)) {
+      node.leftFirst = static_cast<std::uint32_t>(begin);
+      node.count = static_cast<std::uint32_t>(count);
+      return;
+    }
+
+    std::size_t middle = 0;
+    if (split.axis >= 0) {
+      middle = partition(begin, end, centroids, split);
+    } else {
+      // All centroids in one spot, or too deep for SAH.
+      middle = splitAtMedian(begin, end, centroids, split);
+    }
+
+    const auto children =
+        _nodeCount.fetch_add(2, std::memory_order_relaxed);
+    node.leftFirst = children;
+    node.count = 0;
+    setBounds(_nodes[children], split.leftBounds);
+    setBounds(_nodes[children + 1], split.rightBounds);
+
+    if (_pJobSystem != nullptr && middle - begin >= kMinJobPrimitives &&
+        end - middle >= kMinJobPrimitives) {
+      JobCounter counter;
+      _pJobSystem->run(
+          [this, children, begin, middle, &split, depth] {
+            buildNode(children, begin, middle, split.leftCentroids,
+                      depth + 1);
+          },
+          &counter);
+      buildNode(children + 1, middle, end, split.rightCentroids, depth + 1);
+      _pJobSystem->wait(counter);
+    } else {
+      buildNode(children, begin, middle, split.leftCentroids, depth + 1);
+      buildNode(children + 1, middle, end, split.rightCentroids, depth + 1);
+    }
+  }
+
+  [[nodiscard]] std::uint32_t nodeCount() const {
+    return _nodeCount.load(std::memory_order_relaxed);
+  }
+
+ private:
+  Split findSplit(std::size_t begin, std::size_t end, const Bounds &centroids,
+                  const BvhNode &node) const {
+    const BinMapping mapping(centroids, _options.binCount);
+    Bins bins;
+    if (_pJobSystem != nullptr && end - begin >= kMinParallelBinPrimitives) {
+      std::mutex mutex;
+      _pJobSystem->parallelFor(
+          end - begin, kBinGrain,
+          [&, begin](std::size_t rangeBegin, std::size_t rangeEnd) {
+            Bins rangeBins;
+            fillBins(begin + rangeBegin, begin + rangeEnd, mapping,
+                     rangeBins);
+            const std::lock_guard lock(mutex);
+            bins.merge(rangeBins, _options.binCount);
+          });
+    } else {
+      fillBins(begin, end, mapping, bins);
+    }
+
+    // Sweep each axis from the right to collect the right-hand sides of the
+    // planes between bins, then from the left to evaluate them.
+    const std::uint32_t binCount = _options.binCount;
+    const float parentArea = toBounds(node).halfArea();
+    Split best;
+    for (int axis = 0; axis < 3; ++axis) {
+      const std::uint32_t *pCounts = bins.counts[axis];
+      float rightCost[kMaxBinCount];
+      Bounds right;
+      std::uint32_t rightCount = 0;
+      float cost = 0.0F;
+      for (std::uint32_t plane = binCount - 1; plane > 0; --plane) {
+        if (pCounts[plane] != 0) {
+          right.grow(bins.bounds(axis, plane));
+          rightCount += pCounts[plane];
+          cost = right.halfArea() * static_cast<float>(rightCount);
+        }
+        rightCost[plane] = cost;
+      }
+      Bounds left;
+      std::uint32_t leftCount = 0;
+      for (std::uint32_t plane = 1; plane < binCount; ++plane) {
+        // Past an empty bin a plane splits like the one before it.
+        if (pCounts[plane - 1] == 0) {
+          continue;
+        }
+        left.grow(bins.bounds(axis, plane - 1));
+        leftCount += pCounts[plane - 1];
+        if (leftCount == end - begin) {
+          break;
+        }
+        const float splitCost =
+            _options.traversalCost +
+            _options.intersectionCost *
+                (left.halfArea() * static_cast<float>(leftCount) +
+                 rightCost[plane]) /
+                parentArea;
+        if (splitCost < best.cost) {
+          best.axis = axis;
+          best.bin = plane;
+          best.cost = splitCost;
+        }
+      }
+    }
+
+    if (best.axis >= 0) {
+      for (std::uint32_t bin = 0; bin < binCount; ++bin) {
+        const std::uint32_t count = bins.counts[best.axis][bin];
+        if (count == 0) {
+          continue;
+        }
+        if (bin < best.bin) {
+          best.leftBounds.grow(bins.bounds(best.axis, bin));
+          best.leftCount += count;
+        } else {
+          best.rightBounds.grow(bins.bounds(best.axis, bin));
+        }
+      }
+    }
+    return best;
+  }
+
+  void fillBins(std::size_t begin, std::size_t end, const BinMapping &mapping,
+                Bins &bins) const {
+    for (std::size_t i = begin; i < end; ++i) {
+      const Reference &reference = _references[i];
+      const Float4 centroid = reference.centroid();
+      std::uint32_t index[3];
+      mapping.map(centroid, index);
+      for (int axis = 0; axis < 3; ++axis) {
+        bins.add(axis, index[axis], Bounds{reference.min, reference.max}, 1);
+      }
+    }
+  }
+  // Moves the references left of the split plane to the front of
+  // [begin, end), collecting the children's centroid bounds on the way, and
+  // returns where the right child starts.
+  std::size_t partition(std::size_t begin, std::size_t end,
+                        const Bounds &centroids, Split &split) const {
+    const BinMapping mapping(centroids, _options.binCount);
+    const auto isLeft = [&mapping, &split](Float4 centroid) {
+      std::uint32_t index[3];
+      mapping.map(centroid, index);
+      return index[split.axis] < split.bin;
+    };
+    std::size_t left = begin;
+    std::size_t right = end;
+    while (true) {
+      while (left < right) {
+        const Float4 centroid = _references[left].centroid();
+        if (!isLeft(centroid)) {
+          break;
+        }
+        split.leftCentroids.grow(centroid);
+        ++left;
+      }
+      while (left < right) {
+        const Float4 centroid = _references[right - 1].centroid();
+        if (isLeft(centroid)) {
+          break;
+        }
+        split.rightCentroids.grow(centroid);
+        --right;
+      }
+      if (left == right) {
+        break;
+      }
+      std::swap(_references[left], _references[right - 1]);
+    }
+    assert(left - begin == split.leftCount);
+    return left;
+  }
+
+  std::size_t splitAtMedian(std::size_t begin, std::size_t end,
+                            const Bounds &centroids, Split &split) const {
+    const Float4 extent = centroids.max - centroids.min;
+    int axis = 0;
+    if (extent.y() > extent[axis]) {
+      axis = 1;
+    }
+    if (extent.z() > extent[axis]) {
+      axis = 2;
+    }
+    const auto first =
+        _references.begin() + static_cast<std::ptrdiff_t>(begin);
+    const auto middle = first + static_cast<std::ptrdiff_t>(end - begin) / 2;
+    std::nth_element(first, middle,
+                     _references.begin() + static_cast<std::ptrdiff_t>(end),
+                     [axis](const Reference &a, const Reference &b) {
+                       return a.centroid()[axis] < b.centroid()[axis];
+                     });
+    for (auto it = first; it != middle; ++it) {
+      split.leftBounds.grow(Bounds{it->min, it->max});
+      split.leftCentroids.grow(it->centroid());
+    }
+    for (auto it = middle;
+         it != _references.begin() + static_cast<std::ptrdiff_t>(end);
+         ++it) {
+      split.rightBounds.grow(Bounds{it->min, it->max});
+      split.rightCentroids.grow(it->centroid());
+    }
+    return static_cast<std::size_t>(middle - _references.begin());
+  }
+
+  std::vector<Reference> &_references;
+  BvhNodeArray &_nodes;
+  JobSystem *_pJobSystem;
+  BvhBuildOptions _options;
+  // The root is node 0 and node 1 is padding; children are allocated in
+  // pairs from there.
+  std::atomic<std::uint32_t> _nodeCount = 2;
+};
+
+// Fills references from boundsOf(i) for every primitive i and returns the
+// bounds of all of them and of their centroids.
+template <typename BoundsOf>
+std::pair<Bounds, Bounds> makeReferences(std::vector<Reference> &references,
+                                         std::size_t count,
+                                         JobSystem *pJobSystem,
+                                         const BoundsOf &boundsOf) {
+  references.resize(count);
+  Bounds bounds;
+  Bounds centroids;
+  std::mutex mutex;
+  const auto fill = [&](std::size_t begin, std::size_t end) {
+    Bounds rangeBounds;
+    Bounds rangeCentroids;
+    for (std::size_t i = begin; i < end; ++i) {
+      Reference &reference = references[i];
+      const Bounds primitive = boundsOf(i);
+      reference.min = primitive.min;
+      reference.max = primitive.max;
+      reference.index = static_cast<std::uint32_t>(i);
+      rangeBounds.grow(primitive);
+      rangeCentroids.grow(reference.centroid());
+    }
+    const std::lock_guard lock(mutex);
+    bounds.grow(rangeBounds);
+    centroids.grow(rangeCentroids);
+  };
+  if (pJobSystem != nullptr) {
+    pJobSystem->parallelFor(count, kBinGrain, fill);
+  } else {
+    fill(0, count);
+  }
+  return {bounds, centroids};
+}
+
+// Recomputes bounds bottom-up over the nodes isDirty() selects, which
+// always include the ancestors of every selected node.
+class Refitter {
+ public:
+  // With pStamps null every node is dirty; otherwise those stamped epoch.
+  Refitter(BvhNodeArray &nodes,
+           const std::vector<std::uint32_t> &primitiveIndices,
+           const AxisAlignedBoundingBox *pBounds,
+           const std::uint32_t *pStamps, std::uint32_t epoch,
+           JobSystem *pJobSystem)
+      : _nodes(nodes),
+        _primitiveIndices(primitiveIndices),
+        _pBounds(pBounds),
+        _pStamps(pStamps),
+        _epoch(epoch),
+        _pJobSystem(pJobSystem) {}
+
+  void refitNode(std::uint32_t nodeIndex, int depth) {
+    BvhNode &node = _nodes[nodeIndex];
+    Bounds bounds;
+    if (node.isLeaf()) {
+      for (std::uint32_t i = 0; i < node.count; ++i) {
+        bounds.grow(toBounds(_pBounds[_primitiveIndices[node.leftFirst + i]]));
+      }
+    } else {
+      const std::uint32_t left = node.leftFirst;
+      const std::uint32_t right = left + 1;
+      const bool refitLeft = isDirty(left);
+      const bool refitRight = isDirty(right);
+      if (refitLeft && refitRight && _pJobSystem != nullptr &&
+          depth < kMaxRefitJobDepth) {
+        // The two subtrees share no nodes, so they can be refit in parallel.
+        JobCounter counter;
+        _pJobSystem->run([this, left, depth] { refitNode(left, depth + 1); },
+                         &counter);
+        refitNode(right, depth + 1);
+        _pJobSystem->wait(counter);
+      } else {
+        if (refitLeft) {
+          refitNode(left, depth + 1);
+        }
+        if (refitRight) {
+          refitNode(right, depth + 1);
+        }
+      }
+      bounds = toBounds(_nodes[left]);
+      bounds.grow(toBounds(_nodes[right]));
+    }
+    setBounds(node, bounds);
+  }
+
+ private:
+  [[nodiscard]] bool isDirty(std::uint32_t nodeIndex) const {
+    return _pStamps == nullptr || _pStamps[nodeIndex] == _epoch;
+  }
+
+  BvhNodeArray &_nodes;
+  const std::vector<std::uint32_t> &_primitiveIndices;
+  const AxisAlignedBoundingBox *_pBounds;
+  const std::uint32_t *_pStamps;
+  std::uint32_t _epoch;
+  JobSystem *_pJobSystem;
+};
+
+template <typename BoundsOf>
+void buildTree(BvhNodeArray &nodes,
+               std::vector<std::uint32_t> &primitiveIndices,
+               std::size_t count, JobSystem *pJobSystem,
+               const BvhBuildOptions &options, const BoundsOf &boundsOf) {
+  nodes.clear();
+  primitiveIndices.clear();
+  if (count == 0) {
+    return;
+  }
+
+  std::vector<Reference> references;
+  const auto [bounds, centroids] =
+      makeReferences(references, count, pJobSystem, boundsOf);
+
+  // A binary tree with at least one primitive per leaf, plus the padding.
+  nodes.resize(2 * count);
+  Builder builder(references, nodes, pJobSystem, options);
+  setBounds(nodes[0], bounds);
+  builder.buildNode(0, 0, count, centroids, 0);
+  nodes.resize(builder.nodeCount());
+
+  primitiveIndices.resize(count);
+  for (std::size_t i = 0; i < count; ++i) {
+    primitiveIndices[i] = references[i].index;
+  }
+}
+
+}  // namespace
+
+void Bvh::build(const AxisAlignedBoundingBox *pBounds, std::size_t count,
+                JobSystem *pJobSystem, const BvhBuildOptions &options) {
+  buildTree(_nodes, _primitiveIndices, count, pJobSystem, options,
+            [pBounds](std::size_t i) { return toBounds(pBounds[i]); });
+  _options = options;
+  linkNodes();
+}
+
+void Bvh::buildFromTriangles(const PackedFloat3 *pVertices,
+                             const std::uint32_t *pIndices,
+                             std::size_t triangleCount, JobSystem *pJobSystem,
+                             const BvhBuildOptions &options) {
+  buildTree(_nodes, _primitiveIndices, triangleCount, pJobSystem, options,
+            [pVertices, pIndices](std::size_t i) {
+              Bounds bounds;
+              for (std::size_t corner = 0; corner < 3; ++corner) {
+                bounds.grow(Float4::fromPacked(
+                    pVertices[pIndices[i * 3 + corner]], 0.0F));
+              }
+              return bounds;
+            });
+  _options = options;
+  linkNodes();
+}
+
+void Bvh::refit(const AxisAlignedBoundingBox *pBounds,
+                JobSystem *pJobSystem) {
+  if (empty()) {
+    return;
+  }
+  Refitter(_nodes, _primitiveIndices, pBounds, nullptr, 0, pJobSystem)
+      .refitNode(0, 0);
+}
+
+void Bvh::refit(const AxisAlignedBoundingBox *pBounds,
+                const std::uint32_t *pPrimitives, std::size_t count,
+                JobSystem *pJobSystem) {
+  if (empty() || count == 0) {
+    return;
+  }
+  if (++_refitEpoch == 0) {
+    std::fill(_refitStamps.begin(), _refitStamps.end(), 0);
+    _refitEpoch = 1;
+  }
+
+  // Stamp each moved primitive's leaf and its ancestors. A walk stops at the
+  // first node already stamped, whose ancestors are stamped too, so every
+  // node is visited once however many of its primitives moved.
+  std::size_t touched = 0;
+  for (std::size_t i = 0; i < count; ++i) {
+    std::uint32_t nodeIndex = _primitiveLeaves[pPrimitives[i]];
+    while (_refitStamps[nodeIndex] != _refitEpoch) {
+      _refitStamps[nodeIndex] = _refitEpoch;
+      ++touched;
+      if (nodeIndex == 0) {
+        break;
+      }
+      nodeIndex = _pairParents[nodeIndex / 2];
+    }
+  }
+
+  Refitter(_nodes, _primitiveIndices, pBounds, _refitStamps.data(),
+           _refitEpoch,
+           touched >= kMinParallelRefitNodes ? pJobSystem : nullptr)
+      .refitNode(0, 0);
+}
+
+float Bvh::sahCost() const {
+  if (empty()) {
+    return 0.0F;
+  }
+  const auto costOf = [this](const BvhNode &node) {
+    return node.isLeaf()
+               ? _options.intersectionCost * static_cast<float>(node.count)
+               : _options.traversalCost;
+  };
+  const float rootArea = toBounds(_nodes[0]).halfArea();
+  const float scale = rootArea > 0.0F ? 1.0F / rootArea : 1.0F;
+  double cost = costOf(_nodes[0]);
+  for (std::size_t i = 2; i < _nodes.size(); ++i) {
+    cost += static_cast<double>(toBounds(_nodes[i]).halfArea() * scale *
+                                costOf(_nodes[i]));
+  }
+  return static_cast<float>(cost);
+}
+
+void Bvh::linkNodes() {
+  _pairParents.assign(_nodes.size() / 2, 0);
+  _primitiveLeaves.resize(_primitiveIndices.size());
+  _refitStamps.assign(_nodes.size(), 0);
+  _refitEpoch = 0;
+  for (std::size_t i = 0; i < _nodes.size(); ++i) {
+    if (i == 1) {
+      continue;
+    }
+    const BvhNode &node = _nodes[i];
+    const auto nodeIndex = static_cast<std::uint32_t>(i);
+    if (node.isLeaf()) {
+      for (std::uint32_t j = 0; j < node.count; ++j) {
+        _primitiveLeaves[_primitiveIndices[node.leftFirst + j]] = nodeIndex;
+      }
+    } else {
+      _pairParents[node.leftFirst / 2] = nodeIndex;
+    }
+  }
+}
+
+}  // namespace Gfx
@@ -0,0 +1,312 @@
+#pragma once
+
+#include <Gfx/JobSystem.hpp>
+#include <Gfx/Math.hpp>
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <new>
+#include <utility>
+#include <vector>
+
+namespace Gfx {
+
+// One node of a flattened Bvh. The two children of an interior node are
+// stored next to each other, at leftFirst and leftFirst + 1, and always after
+// their parent. Left children have even indices and the array starts on a
+// cache line, so a traversal step reads both children from one line.
+struct BvhNode {
+  PackedFloat3 min;
+  // Interior: index of the left child. Leaf: first entry of the leaf's
+  // primitives in Bvh::primitiveIndices().
+  std::uint32_t leftFirst = 0;
+  PackedFloat3 max;
+  // Primitives in the leaf; 0 for interior nodes.
+  std::uint32_t count = 0;
+
+  [[nodiscard]] bool isLeaf() const { return count != 0; }
+  [[nodiscard]] AxisAlignedBoundingBox bounds() const { return {min, max}; }
+};
+
+static_assert(sizeof(BvhNode) == 32);
+
+namespace Detail {
+
+template <typename T>
+struct CacheLineAllocator {
+  using value_type = T;
+  static constexpr std::size_t kAlignment = 64;
+
+  CacheLineAllocator() = default;
+  template <typename U>
+  explicit CacheLineAllocator(const CacheLineAllocator<U> & /*other*/) {}
+
+  T *allocate(std::size_t count) {
+    return static_cast<T *>(
+        ::operator new(count * sizeof(T), std::align_val_t{kAlignment}));
+  }
+  void deallocate(T *pValues, std::size_t /*count*/) {
+    ::operator delete(pValues, std::align_val_t{kAlignment});
+  }
+
+  friend bool operator==(const CacheLineAllocator & /*lhs*/,
+                         const CacheLineAllocator & /*rhs*/) {
+    return true;
+  }
+};
+
+}  // namespace Detail
+
+using BvhNodeArray = std::vector<BvhNode, Detail::CacheLineAllocator<BvhNode>>;
+
+struct BvhBuildOptions {
+  // Split candidates per axis and node.
+  std::uint32_t binCount = 16;
+  // Leaves larger than this are split even when the SAH prefers a leaf.
+  std::uint32_t maxLeafSize = 8;
+  // Relative costs of visiting a node and of testing one primitive.
+  float traversalCost = 1.0F;
+  float intersectionCost = 1.0F;
+};
+
+// Bounding volume hierarchy over primitives given by their bounding boxes,
+// built top-down with the binned surface area heuristic (Wald, "On fast
+// Construction of SAH-based Bounding Volume Hierarchies", 2007).
+//
+// With a JobSystem, sibling subtrees are built as separate jobs and the
+// binning of large nodes is spread over parallelFor ranges, so the top of
+// the tree doesn't run on one thread. The resulting tree doesn't depend on
+// the thread count; only the order of the node array does.
+//
+// When primitives move without changing much relative to each other, refit()
+// updates the bounds in place instead of rebuilding. The tree's topology
+// stays, so its quality drifts with the motion; sahCost() tells when a
+// rebuild is due.
+class Bvh {
+ public:
+  Bvh() = default;
+
+  // Replaces the tree with one over pBounds[0, count). pJobSystem may be
+  // null to build on the calling thread.
+  void build(const AxisAlignedBoundingBox *pBounds, std::size_t count,
+             JobSystem *pJobSystem = nullptr,
+             const BvhBuildOptions &options = {});
+  // Builds over triangles: pIndices holds three vertex indices per triangle.
+  void buildFromTriangles(const PackedFloat3 *pVertices,
+                          const std::uint32_t *pIndices,
+                          std::size_t triangleCount,
+                          JobSystem *pJobSystem = nullptr,
+                          const BvhBuildOptions &options = {});
+
+  // Recomputes every node's bounds bottom-up from pBounds, which holds the
+  // current bounds of the primitives the tree was built over, in the same
+  // order.
+  void refit(const AxisAlignedBoundingBox *pBounds,
+             JobSystem *pJobSystem = nullptr);
+  // Recomputes only the leaves holding pPrimitives[0, count) and their
+  // ancestors, so the cost follows the number of moved primitives rather
+  // than the size of the tree. Large refits spread disjoint subtrees over
+  // pJobSystem.
+  void refit(const AxisAlignedBoundingBox *pBounds,
+             const std::uint32_t *pPrimitives, std::size_t count,
+             JobSystem *pJobSystem = nullptr);
+
+  [[nodiscard]] bool empty() const { return _nodes.empty(); }
+  // The root is nodes()[0]; nodes()[1] is padding that keeps sibling pairs
+  // on cache lines.
+  [[nodiscard]] const BvhNodeArray &nodes() const { return _nodes; }
+  // Primitive indices in leaf order.
+  [[nodiscard]] const std::vector<std::uint32_t> &primitiveIndices() const {
+    return _primitiveIndices;
+  }
+  [[nodiscard]] AxisAlignedBoundingBox bounds() const {
+    return empty() ? AxisAlignedBoundingBox{} : _nodes[0].bounds();
+  }
+  // Expected cost of a random ray query, in units of the build options'
+  // costs: the sum over nodes of their surface area relative to the root's,
+  // times the cost of visiting them. Walks the whole tree.
+  [[nodiscard]] float sahCost() const;
+
+  // Calls function(primitiveIndex) for every primitive whose leaf bounds
+  // overlap box.
+  template <typename Function>
+  void forEachOverlap(const AxisAlignedBoundingBox &box,
+                      Function &&function) const;
+
+  // Visits the leaves a ray passes through, nearest first, and calls
+  // intersect(primitiveIndex, tMax) for their primitives. intersect returns
+  // true on a hit closer than tMax after lowering tMax to it. Returns whether
+  // anything was hit; tMax is then the distance to the closest hit.
+  template <typename Intersect>
+  bool raycast(Float4 origin, Float4 direction, float &tMax,
+               Intersect &&intersect) const;
+
+ private:
+  void linkNodes();
+
+  BvhNodeArray _nodes;
+  std::vector<std::uint32_t> _primitiveIndices;
+  BvhBuildOptions _options;
+  // Parent of each sibling pair, at the left child's index / 2.
+  std::vector<std::uint32_t> _pairParents;
+  // Leaf holding each primitive.
+  std::vector<std::uint32_t> _primitiveLeaves;
+  // A partial refit stamps the nodes it has to recompute with a new epoch.
+  std::vector<std::uint32_t> _refitStamps;
+  std::uint32_t _refitEpoch = 0;
+};
+
+// Möller-Trumbore ray-triangle test. Returns true, setting t, on a hit
+// in (0, tMax).
+inline bool intersectTriangle(Float4 origin, Float4 direction,
+                              const PackedFloat3 &a, const PackedFloat3 &b,
+                              const PackedFloat3 &c, float tMax, float &t) {
+  const Float4 vertex = Float4::fromPacked(a, 0.0F);
+  const Float4 edge1 = Float4::fromPacked(b, 0.0F) - vertex;
+  const Float4 edge2 = Float4::fromPacked(c, 0.0F) - vertex;
+  const Float4 p = cross3(direction, edge2);
+  const float determinant = dot3(edge1, p);
+  if (std::abs(determinant) < 1e-12F) {
+    return false;
+  }
+  const float inverse = 1.0F / determinant;
+  const Float4 s = origin - vertex;
+  const float u = dot3(s, p) * inverse;
+  if (u < 0.0F || u > 1.0F) {
+    return false;
+  }
+  const Float4 q = cross3(s, edge1);
+  const float v = dot3(direction, q) * inverse;
+  if (v < 0.0F || u + v > 1.0F) {
+    return false;
+  }
+  const float distance = dot3(edge2, q) * inverse;
+  if (distance <= 0.0F || distance >= tMax) {
+    return false;
+  }
+  t = distance;
+  return true;
+}
+
+namespace Detail {
+
+inline bool overlaps(const BvhNode &node, const AxisAlignedBoundingBox &box) {
+  return node.min.x <= box.max.x && node.max.x >= box.min.x &&
+         node.min.y <= box.max.y && node.max.y >= box.min.y &&
+         node.min.z <= box.max.z && node.max.z >= box.min.z;
+}
+
+// Slab test. Returns the distance at which the ray enters node, or infinity
+// if it misses or enters beyond tMax.
+inline float rayEntry(const BvhNode &node, const float (&origin)[3],
+                      const float (&inverseDirection)[3], float tMax) {
+  const float *pMin = &node.min.x;
+  const float *pMax = &node.max.x;
+  float entry = 0.0F;
+  float exit = tMax;
+  for (int axis = 0; axis < 3; ++axis) {
+    float near = (pMin[axis] - origin[axis]) * inverseDirection[axis];
+    float far = (pMax[axis] - origin[axis]) * inverseDirection[axis];
+    if (near > far) {
+      std::swap(near, far);
+    }
+    // Written so NaNs, from 0 * infinity on a slab boundary, are ignored.
+    entry = near > entry ? near : entry;
+    exit = far < exit ? far : exit;
+  }
+  return entry <= exit ? entry : INFINITY;
+}
+
+// Holds one deferred node per level of the deepest tree the builder makes.
+constexpr int kBvhStackSize = 96;
+
+}  // namespace Detail
+
+template <typename Function>
+void Bvh::forEachOverlap(const AxisAlignedBoundingBox &box,
+                         Function &&function) const {
+  if (empty()) {
+    return;
+  }
+  std::uint32_t stack[Detail::kBvhStackSize];
+  int stackSize = 0;
+  std::uint32_t nodeIndex = 0;
+  while (true) {
+    const BvhNode &node = _nodes[nodeIndex];
+    if (Detail::overlaps(node, box)) {
+      if (node.isLeaf()) {
+        for (std::uint32_t i = 0; i < node.count; ++i) {
+          function(_primitiveIndices[node.leftFirst + i]);
+        }
+      } else {
+        stack[stackSize++] = node.leftFirst + 1;
+        nodeIndex = node.leftFirst;
+        continue;
+      }
+    }
+    if (stackSize == 0) {
+      return;
+    }
+    nodeIndex = stack[--stackSize];
+  }
+}
+
+template <typename Intersect>
+bool Bvh::raycast(Float4 origin, Float4 direction, float &tMax,
+                  Intersect &&intersect) const {
+  if (empty()) {
+    return false;
+  }
+  const float rayOrigin[3] = {origin.x(), origin.y(), origin.z()};
+  const float inverseDirection[3] = {
+      1.0F / direction.x(), 1.0F / direction.y(), 1.0F / direction.z()};
+  if (Detail::rayEntry(_nodes[0], rayOrigin, inverseDirection, tMax) ==
+      INFINITY) {
+    return false;
+  }
+
+  bool hit = false;
+  std::uint32_t stack[Detail::kBvhStackSize];
+  int stackSize = 0;
+  std::uint32_t nodeIndex = 0;
+  while (true) {
+    const BvhNode &node = _nodes[nodeIndex];
+    if (node.isLeaf()) {
+      for (std::uint32_t i = 0; i < node.count; ++i) {
+        hit |= intersect(_primitiveIndices[node.leftFirst + i], tMax);
+      }
+    } else {
+      std::uint32_t nearIndex = node.leftFirst;
+      std::uint32_t farIndex = node.leftFirst + 1;
+      float nearEntry = Detail::rayEntry(_nodes[nearIndex], rayOrigin,
+                                         inverseDirection, tMax);
+      float farEntry = Detail::rayEntry(_nodes[farIndex], rayOrigin,
+                                        inverseDirection, tMax);
+      if (farEntry < nearEntry) {
+        std::swap(nearIndex, farIndex);
+        std::swap(nearEntry, farEntry);
+      }
+      if (nearEntry != INFINITY) {
+        if (farEntry != INFINITY) {
+          stack[stackSize++] = farIndex;
+        }
+        nodeIndex = nearIndex;
+        continue;
+      }
+    }
+    // Pop, skipping nodes that a closer hit has put out of reach.
+    while (true) {
+      if (stackSize == 0) {
+        return hit;
+      }
+      nodeIndex = stack[--stackSize];
+      if (Detail::rayEntry(_nodes[nodeIndex], rayOrigin, inverseDirection,
+                           tMax) != INFINITY) {
+        break;
+      }
+    }
+  }
+}
+
+}  // namespace Gfx
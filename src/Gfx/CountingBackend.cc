@@ -0,0 +1,306 @@
+#include <Gfx/CountingBackend.hpp>
+
+namespace Gfx {
+
+namespace {
+
+void count(std::atomic<std::uint64_t> &counter, std::uint64_t value = 1) {
+  counter.fetch_add(value, std::memory_order_relaxed);
+}
+
+}  // namespace
+
+void CountingRenderCommandEncoder::setRenderPipelineState(
+    RenderPipelineState *pState) {
+  count(_pCommandBuffer->_pCounters->messages);
+  _pEncoder->setRenderPipelineState(pState);
+}
+
+void CountingRenderCommandEncoder::setVertexBuffer(Buffer *pBuffer,
+                                                   std::size_t offset,
+                                                   std::size_t index) {
+  Detail::CountingCounters &counters = *_pCommandBuffer->_pCounters;
+  count(counters.messages);
+  if (pBuffer != nullptr && _pCommandBuffer->_retainedReferences) {
+    count(counters.retains);
+    count(_pCommandBuffer->_references);
+  }
+  _pEncoder->setVertexBuffer(pBuffer, offset, index);
+}
+
+void CountingRenderCommandEncoder::setVertexBufferOffset(std::size_t offset,
+                                                         std::size_t index) {
+  count(_pCommandBuffer->_pCounters->messages);
+  _pEncoder->setVertexBufferOffset(offset, index);
+}
+
+void CountingRenderCommandEncoder::setFragmentTexture(Texture *pTexture,
+                                                      std::size_t index) {
+  Detail::CountingCounters &counters = *_pCommandBuffer->_pCounters;
+  count(counters.messages);
+  if (pTexture != nullptr && _pCommandBuffer->_retainedReferences) {
+    count(counters.retains);
+    count(_pCommandBuffer->_references);
+  }
+  _pEncoder->setFragmentTexture(pTexture, index);
+}
+
+void CountingRenderCommandEncoder::setViewport(const Viewport &viewport) {
+  count(_pCommandBuffer->_pCounters->messages);
+  _pEncoder->setViewport(viewport);
+}
+
+void CountingRenderCommandEncoder::setScissorRect(const ScissorRect &rect) {
+  count(_pCommandBuffer->_pCounters->messages);
+  _pEncoder->setScissorRect(rect);
+}
+
+void CountingRenderCommandEncoder::setCullMode(CullMode cullMode) {
+  count(_pCommandBuffer->_pCounters->messages);
+  _pEncoder->setCullMode(cullMode);
+}
+
+void CountingRenderCommandEncoder::setFrontFacingWinding(Winding winding) {
+  count(_pCommandBuffer->_pCounters->messages);
+  _pEncoder->setFrontFacingWinding(winding);
+}
+
+void CountingRenderCommandEncoder::drawPrimitives(PrimitiveType primitiveType,
+                                                  std::size_t vertexStart,
+                                                  std::size_t vertexCount) {
+  Detail::CountingCounters &counters = *_pCommandBuffer->_pCounters;
+  count(counters.messages);
+  count(counters.drawCalls);
+  _pEncoder->drawPrimitives(primitiveType, vertexStart, vertexCount);
+}
+
+void CountingRenderCommandEncoder::useResource(Buffer *pBuffer) {
+  Detail::CountingCounters &counters = *_pCommandBuffer->_pCounters;
+  count(counters.messages);
+  if (_pCommandBuffer->_retainedReferences) {
+    count(counters.retains);
+    count(_pCommandBuffer->_references);
+  }
+  _pEncoder->useResource(pBuffer);
+}
+
+void CountingRenderCommandEncoder::executeCommandsInBuffer(
+    IndirectCommandBuffer *pCommands,
+    const IndirectCommandBufferExecutionRange &range) {
+  Detail::CountingCounters &counters = *_pCommandBuffer->_pCounters;
+  count(counters.messages);
+  if (_pCommandBuffer->_retainedReferences) {
+    count(counters.retains);
+    count(_pCommandBuffer->_references);
+  }
+  _pEncoder->executeCommandsInBuffer(pCommands, range);
+}
+
+void CountingRenderCommandEncoder::endEncoding() {
+  count(_pCommandBuffer->_pCounters->messages);
+  _pEncoder->endEncoding();
+}
+
+RenderCommandEncoder *
+CountingParallelRenderCommandEncoder::renderCommandEncoder() {
+  count(_pCommandBuffer->_pCounters->messages);
+  return _pCommandBuffer->wrap(_pEncoder->renderCommandEncoder());
+}
+
+void CountingParallelRenderCommandEncoder::endEncoding() {
+  count(_pCommandBuffer->_pCounters->messages);
+  _pEncoder->endEncoding();
+}
+
+void CountingBlitCommandEncoder::copyFromTexture(
+    Texture *pTexture, Buffer *pBuffer, std::size_t destinationOffset,
+    std::size_t destinationBytesPerRow) {
+  Detail::CountingCounters &counters = *_pCommandBuffer->_pCounters;
+  count(counters.messages);
+  if (_pCommandBuffer->_retainedReferences) {
+    count(counters.retains, 2);
+    count(_pCommandBuffer->_references, 2);
+  }
+  _pEncoder->copyFromTexture(pTexture, pBuffer, destinationOffset,
+                             destinationBytesPerRow);
+}
+
+void CountingBlitCommandEncoder::copyFromBuffer(
+    Buffer *pSource, std::size_t sourceOffset, Buffer *pDestination,
+    std::size_t destinationOffset, std::size_t size) {
+  Detail::CountingCounters &counters = *_pCommandBuffer->_pCounters;
+  count(counters.messages);
+  if (_pCommandBuffer->_retainedReferences) {
+    count(counters.retains, 2);
+    count(_pCommandBuffer->_references, 2);
+  }
+  _pEncoder->copyFromBuffer(pSource, sourceOffset, pDestination,
+                            destinationOffset, size);
+}
+
+void CountingBlitCommandEncoder::endEncoding() {
+  count(_pCommandBuffer->_pCounters->messages);
+  _pEncoder->endEncoding();
+}
+
+void CountingCommandBuffer::addCompletedHandler(
+    const HandlerFunction &function) {
+  count(_pCounters->messages);
+  _pCommandBuffer->addCompletedHandler(function);
+}
+
+RenderCommandEncoder *CountingCommandBuffer::renderCommandEncoder(
+    const RenderPassDescriptor &descriptor) {
+  count(_pCounters->messages);
+  return wrap(_pCommandBuffer->renderCommandEncoder(descriptor));
+}
+
+ParallelRenderCommandEncoder *
+CountingCommandBuffer::parallelRenderCommandEncoder(
+    const RenderPassDescriptor &descriptor) {
+  count(_pCounters->messages);
+  _parallelEncoder._pCommandBuffer = this;
+  _parallelEncoder._pEncoder =
+      _pCommandBuffer->parallelRenderCommandEncoder(descriptor);
+  return &_parallelEncoder;
+}
+
+BlitCommandEncoder *CountingCommandBuffer::blitCommandEncoder() {
+  count(_pCounters->messages);
+  _blitEncoder._pCommandBuffer = this;
+  _blitEncoder._pEncoder = _pCommandBuffer->blitCommandEncoder();
+  return &_blitEncoder;
+}
+
+void CountingCommandBuffer::encodeWait(SharedEvent *pEvent,
+                                       std::uint64_t value) {
+  count(_pCounters->messages);
+  _pCommandBuffer->encodeWait(pEvent, value);
+}
+
+void CountingCommandBuffer::encodeSignalEvent(SharedEvent *pEvent,
+                                              std::uint64_t value) {
+  count(_pCounters->messages);
+  _pCommandBuffer->encodeSignalEvent(pEvent, value);
+}
+
+void CountingCommandBuffer::presentDrawable(Drawable *pDrawable) {
+  count(_pCounters->messages);
+  _pCommandBuffer->presentDrawable(pDrawable);
+}
+
+void CountingCommandBuffer::commit() {
+  count(_pCounters->messages);
+  const std::uint64_t references = _references.load();
+  if (references > 0) {
+    // Not counted as a message: this stands in for the releases Metal
+    // performs internally once the buffer completes.
+    _pCommandBuffer->addCompletedHandler(
+        [pCounters = _pCounters, references] {
+          count(pCounters->releases, references);
+        });
+  }
+  _pCommandBuffer->commit();
+}
+
+void CountingCommandBuffer::waitUntilCompleted() {
+  count(_pCounters->messages);
+  _pCommandBuffer->waitUntilCompleted();
+}
+
+CountingRenderCommandEncoder *CountingCommandBuffer::wrap(
+    RenderCommandEncoder *pEncoder) {
+  if (_encoderCount == _encoders.size()) {
+    _encoders.push_back(std::make_unique<CountingRenderCommandEncoder>());
+  }
+  CountingRenderCommandEncoder *pWrapper = _encoders[_encoderCount++].get();
+  pWrapper->_pCommandBuffer = this;
+  pWrapper->_pEncoder = pEncoder;
+  return pWrapper;
+}
+
+CommandBuffer *CountingCommandQueue::commandBuffer(
+    const CommandBufferDescriptor &descriptor) {
+  count(_pCounters->messages);
+  count(_pCounters->commandBuffers);
+  _commandBuffer._pCounters = _pCounters;
+  _commandBuffer._pCommandBuffer = _pCommandQueue->commandBuffer(descriptor);
+  _commandBuffer._retainedReferences = descriptor.retainedReferences;
+  _commandBuffer._references = 0;
+  _commandBuffer._encoderCount = 0;
+  return &_commandBuffer;
+}
+
+std::unique_ptr<CommandQueue> CountingDevice::newCommandQueue() {
+  count(_counters.messages);
+  return std::make_unique<CountingCommandQueue>(_pDevice->newCommandQueue(),
+                                                &_counters);
+}
+
+std::unique_ptr<Buffer> CountingDevice::newBuffer(std::size_t length) {
+  count(_counters.messages);
+  count(_counters.bufferAllocations);
+  return _pDevice->newBuffer(length);
+}
+
+SizeAndAlign CountingDevice::heapBufferSizeAndAlign(std::size_t length) {
+  count(_counters.messages);
+  return _pDevice->heapBufferSizeAndAlign(length);
+}
+
+std::unique_ptr<Heap> CountingDevice::newHeap(std::size_t size) {
+  count(_counters.messages);
+  count(_counters.bufferAllocations);
+  return _pDevice->newHeap(size);
+}
+
+std::unique_ptr<SharedEvent> CountingDevice::newSharedEvent() {
+  count(_counters.messages);
+  return _pDevice->newSharedEvent();
+}
+
+std::unique_ptr<IndirectCommandBuffer>
+CountingDevice::newIndirectCommandBuffer(
+    const IndirectCommandBufferDescriptor &descriptor,
+    std::size_t maxCommandCount) {
+  count(_counters.messages);
+  count(_counters.bufferAllocations);
+  return _pDevice->newIndirectCommandBuffer(descriptor, maxCommandCount);
+}
+
+std::unique_ptr<RenderPipelineState> CountingDevice::newRenderPipelineState(
+    const RenderPipelineDescriptor &descriptor) {
+  count(_counters.messages);
+  count(_counters.pipelineCompilations);
+  return _pDevice->newRenderPipelineState(descriptor);
+}
+
+std::unique_ptr<Texture> CountingDevice::newTexture(std::uint32_t width,
+                                                    std::uint32_t height,
+                                                    PixelFormat pixelFormat) {
+  count(_counters.messages);
+  return _pDevice->newTexture(width, height, pixelFormat);
+}
+
+CountingStatistics CountingDevice::statistics() const {
+  return {
+      _counters.messages.load(std::memory_order_relaxed),
+      _counters.commandBuffers.load(std::memory_order_relaxed),
+      _counters.drawCalls.load(std::memory_order_relaxed),
+      _counters.bufferAllocations.load(std::memory_order_relaxed),
+      _counters.pipelineCompilations.load(std::memory_order_relaxed),
+      _counters.retains.load(std::memory_order_relaxed),
+      _counters.releases.load(std::memory_order_relaxed),
+  };
+}
+
+void CountingDevice::resetStatistics() {
+  for (auto *pCounter :
+       {&_counters.messages, &_counters.commandBuffers, &_counters.drawCalls,
+        &_counters.bufferAllocations, &_counters.pipelineCompilations,
+        &_counters.retains, &_counters.releases}) {
+    pCounter->store(0, std::memory_order_relaxed);
+  }
+}
+
+}  // namespace Gfx
@@ -0,0 +1,186 @@
+#pragma once
+
+#include <Gfx/Backend.hpp>
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <utility>
+#include <vector>
+
+// Backend decorator that forwards every call to another backend and counts
+// it. Each of these calls costs the Metal backend at least one Objective-C
+// message, so the message count is a lower bound for what a frame sends on
+// Metal. Like Metal, a command buffer with retained references is counted as
+// retaining every buffer it binds and releasing them when it completes.
+namespace Gfx {
+
+struct CountingStatistics {
+  std::uint64_t messages;
+  std::uint64_t commandBuffers;
+  std::uint64_t drawCalls;
+  std::uint64_t bufferAllocations;
+  std::uint64_t pipelineCompilations;
+  std::uint64_t retains;
+  std::uint64_t releases;
+};
+
+namespace Detail {
+
+struct CountingCounters {
+  std::atomic<std::uint64_t> messages{0};
+  std::atomic<std::uint64_t> commandBuffers{0};
+  std::atomic<std::uint64_t> drawCalls{0};
+  std::atomic<std::uint64_t> bufferAllocations{0};
+  std::atomic<std::uint64_t> pipelineCompilations{0};
+  std::atomic<std::uint64_t> retains{0};
+  std::atomic<std::uint64_t> releases{0};
+};
+
+}  // namespace Detail
+
+class CountingCommandBuffer;
+
+class CountingRenderCommandEncoder final : public RenderCommandEncoder {
+ public:
+  void setRenderPipelineState(RenderPipelineState *pState) override;
+  void setVertexBuffer(Buffer *pBuffer, std::size_t offset,
+                       std::size_t index) override;
+  void setVertexBufferOffset(std::size_t offset, std::size_t index) override;
+  void setFragmentTexture(Texture *pTexture, std::size_t index) override;
+  void setViewport(const Viewport &viewport) override;
+  void setScissorRect(const ScissorRect &rect) override;
+  void setCullMode(CullMode cullMode) override;
+  void setFrontFacingWinding(Winding winding) override;
+  void drawPrimitives(PrimitiveType primitiveType, std::size_t vertexStart,
+                      std::size_t vertexCount) override;
+  void useResource(Buffer *pBuffer) override;
+  void executeCommandsInBuffer(
+      IndirectCommandBuffer *pCommands,
+      const IndirectCommandBufferExecutionRange &range) override;
+  void endEncoding() override;
+
+ private:
+  friend class CountingCommandBuffer;
+
+  CountingCommandBuffer *_pCommandBuffer = nullptr;
+  RenderCommandEncoder *_pEncoder = nullptr;
+};
+
+class CountingParallelRenderCommandEncoder final
+    : public ParallelRenderCommandEncoder {
+ public:
+  RenderCommandEncoder *renderCommandEncoder() override;
+  void endEncoding() override;
+
+ private:
+  friend class CountingCommandBuffer;
+
+  CountingCommandBuffer *_pCommandBuffer = nullptr;
+  ParallelRenderCommandEncoder *_pEncoder = nullptr;
+};
+
+class CountingBlitCommandEncoder final : public BlitCommandEncoder {
+ public:
+  void copyFromTexture(Texture *pTexture, Buffer *pBuffer,
+                       std::size_t destinationOffset,
+                       std::size_t destinationBytesPerRow) override;
+  void copyFromBuffer(Buffer *pSource, std::size_t sourceOffset,
+                      Buffer *pDestination, std::size_t destinationOffset,
+                      std::size_t size) override;
+  void endEncoding() override;
+
+ private:
+  friend class CountingCommandBuffer;
+
+  CountingCommandBuffer *_pCommandBuffer = nullptr;
+  BlitCommandEncoder *_pEncoder = nullptr;
+};
+
+class CountingCommandBuffer final : public CommandBuffer {
+ public:
+  void addCompletedHandler(const HandlerFunction &function) override;
+  RenderCommandEncoder *renderCommandEncoder(
+      const RenderPassDescriptor &descriptor) override;
+  ParallelRenderCommandEncoder *parallelRenderCommandEncoder(
+      const RenderPassDescriptor &descriptor) override;
+  BlitCommandEncoder *blitCommandEncoder() override;
+  void encodeWait(SharedEvent *pEvent, std::uint64_t value) override;
+  void encodeSignalEvent(SharedEvent *pEvent, std::uint64_t value) override;
+  void presentDrawable(Drawable *pDrawable) override;
+  void commit() override;
+  void waitUntilCompleted() override;
+
+  // The wrapped backend's command buffer.
+  [[nodiscard]] CommandBuffer *commandBuffer() const {
+    return _pCommandBuffer;
+  }
+
+ private:
+  friend class CountingCommandQueue;
+  friend class CountingRenderCommandEncoder;
+  friend class CountingParallelRenderCommandEncoder;
+  friend class CountingBlitCommandEncoder;
+
+  CountingRenderCommandEncoder *wrap(RenderCommandEncoder *pEncoder);
+
+  Detail::CountingCounters *_pCounters = nullptr;
+  CommandBuffer *_pCommandBuffer = nullptr;
+  bool _retainedReferences = true;
+  // Sub-encoders of a parallel pass bind from several threads.
+  std::atomic<std::uint64_t> _references = 0;
+  std::vector<std::unique_ptr<CountingRenderCommandEncoder>> _encoders;
+  std::size_t _encoderCount = 0;
+  CountingParallelRenderCommandEncoder _parallelEncoder;
+  CountingBlitCommandEncoder _blitEncoder;
+};
+
+class CountingCommandQueue final : public CommandQueue {
+ public:
+  CountingCommandQueue(std::unique_ptr<CommandQueue> pCommandQueue,
+                       Detail::CountingCounters *pCounters)
+      : _pCommandQueue(std::move(pCommandQueue)), _pCounters(pCounters) {}
+
+  using CommandQueue::commandBuffer;
+  CommandBuffer *commandBuffer(
+      const CommandBufferDescriptor &descriptor) override;
+
+ private:
+  std::unique_ptr<CommandQueue> _pCommandQueue;
+  Detail::CountingCounters *_pCounters;
+  CountingCommandBuffer _commandBuffer;
+};
+
+// Buffers, heaps, events, indirect command buffers, pipelines and textures
+// are not wrapped: the device returns the wrapped device's objects, so they
+// can be passed to both backends. A heap counts as one buffer allocation;
+// placing buffers in it is not counted, and neither is encoding indirect
+// commands.
+class CountingDevice final : public Device {
+ public:
+  explicit CountingDevice(Device *pDevice) : _pDevice(pDevice) {}
+
+  std::unique_ptr<CommandQueue> newCommandQueue() override;
+  std::unique_ptr<Buffer> newBuffer(std::size_t length) override;
+  SizeAndAlign heapBufferSizeAndAlign(std::size_t length) override;
+  std::unique_ptr<Heap> newHeap(std::size_t size) override;
+  std::unique_ptr<SharedEvent> newSharedEvent() override;
+  std::unique_ptr<IndirectCommandBuffer> newIndirectCommandBuffer(
+      const IndirectCommandBufferDescriptor &descriptor,
+      std::size_t maxCommandCount) override;
+  std::unique_ptr<RenderPipelineState> newRenderPipelineState(
+      const RenderPipelineDescriptor &descriptor) override;
+  std::unique_ptr<Texture> newTexture(std::uint32_t width,
+                                      std::uint32_t height,
+                                      PixelFormat pixelFormat) override;
+
+  [[nodiscard]] CountingStatistics statistics() const;
+  void resetStatistics();
+
+ private:
+  Device *_pDevice;
+  Detail::CountingCounters _counters;
+};
+
+}  // namespace Gfx
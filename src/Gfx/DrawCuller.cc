@@ -0,0 +1,377 @@
+#include <Gfx/DrawCuller.hpp>
+
+#include <algorithm>
+#include <bit>
+#include <cassert>
+#include <cmath>
+#include <cstring>
+
+#if GFX_MATH_SSE && (defined(__GNUC__) || defined(__clang__))
+#define GFX_CULL_AVX2 1
+#include <immintrin.h>
+#endif
+
+namespace Gfx {
+
+namespace {
+
+// Objects per parallelFor chunk. A multiple of 8, so that chunks start on a
+// byte of the visibility mask.
+constexpr std::size_t kChunkSize = 16384;
+// Fewer objects than this are culled on the calling thread.
+constexpr std::size_t kMinParallelCount = 65536;
+
+// A frustum prepared for boxes in center/extent form. With c = min + max and
+// e = max - min, a box is inside a plane when
+//   dot(n, c) + dot(|n|, e) + 2d >= 0,
+// which tests the box corner furthest along n without picking it.
+struct Planes {
+  float n[6][3];
+  float absN[6][3];
+  float twoD[6];
+};
+
+struct Bounds {
+  const float *pMinX;
+  const float *pMinY;
+  const float *pMinZ;
+  const float *pMaxX;
+  const float *pMaxY;
+  const float *pMaxZ;
+};
+
+// Sets bit i % 8 of pVisible[i / 8] for every visible object i in
+// [begin, end) and returns how many there are. begin is a multiple of 8.
+using CullFunction = std::uint32_t (*)(const Planes &planes,
+                                       const Bounds &bounds,
+                                       std::size_t begin, std::size_t end,
+                                       std::uint8_t *pVisible);
+
+Planes preparePlanes(const Frustum &frustum) {
+  Planes planes;
+  for (int p = 0; p < 6; ++p) {
+    const Float4 &plane = frustum.planes[p];
+    for (int axis = 0; axis < 3; ++axis) {
+      planes.n[p][axis] = plane[axis];
+      planes.absN[p][axis] = std::fabs(plane[axis]);
+    }
+    planes.twoD[p] = 2.0F * plane.w();
+  }
+  return planes;
+}
+
+namespace Scalar {
+
+bool inside(const Planes &planes, const Bounds &bounds, std::size_t i) {
+  const float cx = bounds.pMinX[i] + bounds.pMaxX[i];
+  const float cy = bounds.pMinY[i] + bounds.pMaxY[i];
+  const float cz = bounds.pMinZ[i] + bounds.pMaxZ[i];
+  const float ex = bounds.pMaxX[i] - bounds.pMinX[i];
+  const float ey = bounds.pMaxY[i] - bounds.pMinY[i];
+  const float ez = bounds.pMaxZ[i] - bounds.pMinZ[i];
+  for (int p = 0; p < 6; ++p) {
+    const float distance =
+        planes.n[p][0] * cx + planes.n[p][1] * cy + planes.n[p][2] * cz +
+        planes.absN[p][0] * ex + planes.absN[p][1] * ey +
+        planes.absN[p][2] * ez + planes.twoD[p];
+    // Written so that NaN fails.
+    if (!(distance >= 0.0F)) {
+      return false;
+    }
+  }
+  return true;
+}
+
+std::uint8_t insideBits(const Planes &planes, const Bounds &bounds,
+                        std::size_t begin, std::size_t end) {
+  std::uint8_t bits = 0;
+  for (std::size_t i = begin; i < end; ++i) {
+    bits |= inside(planes, bounds, i) ? 1 << (i - begin) : 0;
+  }
+  return bits;
+}
+
+std::uint32_t cull(const Planes &planes, const Bounds &bounds,
+                   std::size_t begin, std::size_t end,
+                   std::uint8_t *pVisible) {
+  std::uint32_t count = 0;
+  for (std::size_t i = begin; i < end; i += 8) {
+    const std::uint8_t bits =
+        insideBits(planes, bounds, i, std::min(i + 8, end));
+    pVisible[i / 8] = bits;
+    count += std::popcount(bits);
+  }
+  return count;
+}
+
+}  // namespace Scalar
+
+// Four objects per Float4: SSE on x86-64, NEON on arm64.
+namespace Vector {
+
+std::uint32_t cull(const Planes &planes, const Bounds &bounds,
+                   std::size_t begin, std::size_t end,
+                   std::uint8_t *pVisible) {
+  Float4 n[6][3];
+  Float4 absN[6][3];
+  Float4 twoD[6];
+  for (int p = 0; p < 6; ++p) {
+    for (int axis = 0; axis < 3; ++axis) {
+      n[p][axis] = Float4::splat(planes.n[p][axis]);
+      absN[p][axis] = Float4::splat(planes.absN[p][axis]);
+    }
+    twoD[p] = Float4::splat(planes.twoD[p]);
+  }
+  const Float4 zero;
+  auto insideMask = [&](std::size_t i) {
+    const Float4 minX = Float4::load(bounds.pMinX + i);
+    const Float4 minY = Float4::load(bounds.pMinY + i);
+    const Float4 minZ = Float4::load(bounds.pMinZ + i);
+    const Float4 maxX = Float4::load(bounds.pMaxX + i);
+    const Float4 maxY = Float4::load(bounds.pMaxY + i);
+    const Float4 maxZ = Float4::load(bounds.pMaxZ + i);
+    const Float4 cx = minX + maxX;
+    const Float4 cy = minY + maxY;
+    const Float4 cz = minZ + maxZ;
+    const Float4 ex = maxX - minX;
+    const Float4 ey = maxY - minY;
+    const Float4 ez = maxZ - minZ;
+    int mask = 0xF;
+    for (int p = 0; p < 6; ++p) {
+      const Float4 distance = n[p][0] * cx + n[p][1] * cy + n[p][2] * cz +
+                              absN[p][0] * ex + absN[p][1] * ey +
+                              absN[p][2] * ez + twoD[p];
+      mask &= lessEqualMask(zero, distance);
+    }
+    return mask;
+  };
+
+  std::uint32_t count = 0;
+  std::size_t i = begin;
+  for (; i + 8 <= end; i += 8) {
+    const auto bits =
+        static_cast<std::uint8_t>(insideMask(i) | insideMask(i + 4) << 4);
+    pVisible[i / 8] = bits;
+    count += std::popcount(bits);
+  }
+  if (i < end) {
+    const std::uint8_t bits = Scalar::insideBits(planes, bounds, i, end);
+    pVisible[i / 8] = bits;
+    count += std::popcount(bits);
+  }
+  return count;
+}
+
+}  // namespace Vector
+
+#if GFX_CULL_AVX2
+// Eight objects per register, built with target attributes whatever the
+// build's flags and only called when simdLevel() is AVX2.
+namespace Avx2 {
+
+#define GFX_CULL_AVX2_TARGET __attribute__((target("avx2,fma")))
+
+GFX_CULL_AVX2_TARGET
+std::uint32_t cull(const Planes &planes, const Bounds &bounds,
+                   std::size_t begin, std::size_t end,
+                   std::uint8_t *pVisible) {
+  __m256 n[6][3];
+  __m256 absN[6][3];
+  __m256 twoD[6];
+  for (int p = 0; p < 6; ++p) {
+    for (int axis = 0; axis < 3; ++axis) {
+      n[p][axis] = _mm256_set1_ps(planes.n[p][axis]);
+      absN[p][axis] = _mm256_set1_ps(planes.absN[p][axis]);
+    }
+    twoD[p] = _mm256_set1_ps(planes.twoD[p]);
+  }
+  const __m256 zero = _mm256_setzero_ps();
+
+  std::uint32_t count = 0;
+  std::size_t i = begin;
+  for (; i + 8 <= end; i += 8) {
+    const __m256 minX = _mm256_loadu_ps(bounds.pMinX + i);
+    const __m256 minY = _mm256_loadu_ps(bounds.pMinY + i);
+    const __m256 minZ = _mm256_loadu_ps(bounds.pMinZ + i);
+    const __m256 maxX = _mm256_loadu_ps(bounds.pMaxX + i);
+    const __m256 maxY = _mm256_loadu_ps(bounds.pMaxY + i);
+    const __m256 maxZ = _mm256_loadu_ps(bounds.pMaxZ + i);
+    const __m256 cx = _mm256_add_ps(minX, maxX);
+    const __m256 cy = _mm256_add_ps(minY, maxY);
+    const __m256 cz = _mm256_add_ps(minZ, maxZ);
+    const __m256 ex = _mm256_sub_ps(maxX, minX);
+    const __m256 ey = _mm256_sub_ps(maxY, minY);
+    const __m256 ez = _mm256_sub_ps(maxZ, minZ);
+    __m256 inside = _mm256_castsi256_ps(_mm256_set1_epi32(-1));
+    for (int p = 0; p < 6; ++p) {
+      __m256 distance = _mm256_fmadd_ps(absN[p][2], ez, twoD[p]);
+      distance = _mm256_fmadd_ps(absN[p][1], ey, distance);
+      distance = _mm256_fmadd_ps(absN[p][0], ex, distance);
+      distance = _mm256_fmadd_ps(n[p][2], cz, distance);
+      distance = _mm256_fmadd_ps(n[p][1], cy, distance);
+      distance = _mm256_fmadd_ps(n[p][0], cx, distance);
+      // Ordered, so NaN fails.
+      inside = _mm256_and_ps(inside,
+                             _mm256_cmp_ps(distance, zero, _CMP_GE_OQ));
+    }
+    const auto bits = static_cast<std::uint8_t>(_mm256_movemask_ps(inside));
+    pVisible[i / 8] = bits;
+    count += std::popcount(bits);
+  }
+  if (i < end) {
+    const std::uint8_t bits = Scalar::insideBits(planes, bounds, i, end);
+    pVisible[i / 8] = bits;
+    count += std::popcount(bits);
+  }
+  return count;
+}
+
+#undef GFX_CULL_AVX2_TARGET
+
+}  // namespace Avx2
+#endif
+
+CullFunction pickCull() {
+  switch (simdLevel()) {
+#if GFX_CULL_AVX2
+    case SimdLevel::AVX2:
+      return Avx2::cull;
+#endif
+    case SimdLevel::SSE:
+    case SimdLevel::NEON:
+      return Vector::cull;
+    default:
+      return Scalar::cull;
+  }
+}
+
+// Copies the arguments of the visible objects of [begin, end) to pOut,
+// which needn't be aligned.
+template <typename Arguments>
+void compact(const std::uint8_t *pVisible, const Arguments *pArguments,
+             std::size_t begin, std::size_t end, std::byte *pOut) {
+  for (std::size_t group = begin / 8; group < (end + 7) / 8; ++group) {
+    unsigned bits = pVisible[group];
+    while (bits != 0) {
+      const std::size_t object = group * 8 + std::countr_zero(bits);
+      std::memcpy(pOut, &pArguments[object], sizeof(Arguments));
+      pOut += sizeof(Arguments);
+      bits &= bits - 1;
+    }
+  }
+}
+
+}  // namespace
+
+Frustum Frustum::fromViewProjection(const Float4x4 &viewProjection) {
+  // A clip-space point is inside when -w <= x, y <= w and 0 <= z <= w; each
+  // bound is a plane in terms of the matrix rows (Gribb and Hartmann,
+  // "Fast Extraction of Viewing Frustum Planes", 2001).
+  const Float4x4 rows = viewProjection.transposed();
+  const Float4 &x = rows.columns[0];
+  const Float4 &y = rows.columns[1];
+  const Float4 &z = rows.columns[2];
+  const Float4 &w = rows.columns[3];
+  Frustum frustum{{w + x, w - x, w + y, w - y, z, w - z}};
+  for (Float4 &plane : frustum.planes) {
+    plane = plane * (1.0F / std::sqrt(dot3(plane, plane)));
+  }
+  return frustum;
+}
+
+void DrawCuller::resize(std::size_t count) {
+  _minX.resize(count, INFINITY);
+  _minY.resize(count, INFINITY);
+  _minZ.resize(count, INFINITY);
+  _maxX.resize(count, -INFINITY);
+  _maxY.resize(count, -INFINITY);
+  _maxZ.resize(count, -INFINITY);
+  if (_type == IndirectArgumentsType::Primitives) {
+    _arguments.resize(count);
+  } else {
+    _indexedArguments.resize(count);
+  }
+}
+
+void DrawCuller::setBounds(std::size_t object,
+                           const AxisAlignedBoundingBox &bounds) {
+  _minX[object] = bounds.min.x;
+  _minY[object] = bounds.min.y;
+  _minZ[object] = bounds.min.z;
+  _maxX[object] = bounds.max.x;
+  _maxY[object] = bounds.max.y;
+  _maxZ[object] = bounds.max.z;
+}
+
+std::uint32_t DrawCuller::cull(const Frustum &frustum, void *pArguments,
+                               JobSystem *pJobSystem) {
+  const Planes planes = preparePlanes(frustum);
+  const Bounds bounds{_minX.data(), _minY.data(), _minZ.data(),
+                      _maxX.data(), _maxY.data(), _maxZ.data()};
+  const CullFunction cullRange = pickCull();
+  const std::size_t objectCount = count();
+  const std::size_t stride = indirectArgumentsSize(_type);
+  auto *pOut = static_cast<std::byte *>(pArguments);
+  _visible.resize((objectCount + 7) / 8);
+  auto compactRange = [&](std::size_t begin, std::size_t end,
+                          std::byte *pRangeOut) {
+    if (_type == IndirectArgumentsType::Primitives) {
+      compact(_visible.data(), _arguments.data(), begin, end, pRangeOut);
+    } else {
+      compact(_visible.data(), _indexedArguments.data(), begin, end,
+              pRangeOut);
+    }
+  };
+
+  if (pJobSystem == nullptr || objectCount < kMinParallelCount) {
+    const std::uint32_t visibleCount =
+        cullRange(planes, bounds, 0, objectCount, _visible.data());
+    compactRange(0, objectCount, pOut);
+    return visibleCount;
+  }
+
+  // Chunks are tested in parallel, then compacted in parallel once a prefix
+  // sum of their counts says where each one's arguments go.
+  const std::size_t chunkCount = (objectCount + kChunkSize - 1) / kChunkSize;
+  _chunkCounts.resize(chunkCount);
+  auto chunkEnd = [objectCount](std::size_t chunk) {
+    return std::min(objectCount, (chunk + 1) * kChunkSize);
+  };
+  pJobSystem->parallelFor(
+      chunkCount, 1, [&](std::size_t begin, std::size_t end) {
+        for (std::size_t chunk = begin; chunk < end; ++chunk) {
+          _chunkCounts[chunk] = cullRange(planes, bounds, chunk * kChunkSize,
+                                          chunkEnd(chunk), _visible.data());
+        }
+      });
+  std::uint32_t visibleCount = 0;
+  for (std::uint32_t &chunkVisible : _chunkCounts) {
+    const std::uint32_t first = visibleCount;
+    visibleCount += chunkVisible;
+    chunkVisible = first;
+  }
+  pJobSystem->parallelFor(
+      chunkCount, 1, [&](std::size_t begin, std::size_t end) {
+        for (std::size_t chunk = begin; chunk < end; ++chunk) {
+          compactRange(chunk * kChunkSize, chunkEnd(chunk),
+                       pOut + _chunkCounts[chunk] * stride);
+        }
+      });
+  return visibleCount;
+}
+
+std::uint32_t DrawCuller::cull(const Frustum &frustum, Buffer *pBuffer,
+                               std::size_t argumentsOffset,
+                               std::size_t countOffset,
+                               JobSystem *pJobSystem) {
+  auto *pContents = static_cast<std::byte *>(pBuffer->contents());
+  assert(argumentsOffset + count() * indirectArgumentsSize(_type) <=
+         pBuffer->length());
+  assert(countOffset + sizeof(std::uint32_t) <= pBuffer->length());
+  const std::uint32_t visibleCount =
+      cull(frustum, pContents + argumentsOffset, pJobSystem);
+  std::memcpy(pContents + countOffset, &visibleCount, sizeof(visibleCount));
+  return visibleCount;
+}
+
+}  // namespace Gfx
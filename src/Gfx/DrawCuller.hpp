@@ -0,0 +1,127 @@
+#pragma once
+
+#include <Gfx/Backend.hpp>
+#include <Gfx/JobSystem.hpp>
+#include <Gfx/Math.hpp>
+
+#include <cstddef>
+#include <cstdint>
+#include <type_traits>
+#include <vector>
+
+namespace Gfx {
+
+// The indirect draw arguments of MTLRenderCommandEncoder.hpp, with their
+// exact layouts, so an array of them can be handed to the GPU as is.
+struct DrawPrimitivesIndirectArguments {
+  std::uint32_t vertexCount = 0;
+  std::uint32_t instanceCount = 1;
+  std::uint32_t vertexStart = 0;
+  std::uint32_t baseInstance = 0;
+};
+
+struct DrawIndexedPrimitivesIndirectArguments {
+  std::uint32_t indexCount = 0;
+  std::uint32_t instanceCount = 1;
+  std::uint32_t indexStart = 0;
+  std::int32_t baseVertex = 0;
+  std::uint32_t baseInstance = 0;
+};
+
+static_assert(sizeof(DrawPrimitivesIndirectArguments) == 16 &&
+              std::is_trivially_copyable_v<DrawPrimitivesIndirectArguments>);
+static_assert(sizeof(DrawIndexedPrimitivesIndirectArguments) == 20 &&
+              std::is_trivially_copyable_v<
+                  DrawIndexedPrimitivesIndirectArguments>);
+
+enum class IndirectArgumentsType : std::uint8_t {
+  Primitives,
+  IndexedPrimitives,
+};
+
+[[nodiscard]] constexpr std::size_t indirectArgumentsSize(
+    IndirectArgumentsType type) {
+  return type == IndirectArgumentsType::Primitives
+             ? sizeof(DrawPrimitivesIndirectArguments)
+             : sizeof(DrawIndexedPrimitivesIndirectArguments);
+}
+
+// The six planes of a view frustum, normals pointing inwards.
+struct Frustum {
+  // Left, right, bottom, top, near, far as (n.x, n.y, n.z, d): a point p is
+  // inside a plane when dot(n, p) + d >= 0.
+  Float4 planes[6];
+
+  // The frustum of a column-major view-projection matrix with Metal's clip
+  // space, where z runs from 0 to w.
+  static Frustum fromViewProjection(const Float4x4 &viewProjection);
+};
+
+// CPU culling stage that produces GPU indirect draws. Every object has
+// world-space bounds and the arguments of its draw; cull() tests the bounds
+// against a frustum and writes the arguments of the visible objects, in
+// object order and without gaps, plus their count. Give each object's draw
+// a baseInstance that identifies it if the shaders need per-object data.
+//
+// Bounds are kept as one array per coordinate, so the kernels test eight
+// objects per AVX2 register (four with SSE or NEON) straight from memory;
+// the SIMD level follows simdLevel(). Boxes holding NaN, including empty
+// ones, are culled.
+class DrawCuller {
+ public:
+  explicit DrawCuller(
+      IndirectArgumentsType type = IndirectArgumentsType::IndexedPrimitives)
+      : _type(type) {}
+
+  // New objects get empty bounds and default arguments.
+  void resize(std::size_t count);
+  [[nodiscard]] std::size_t count() const { return _minX.size(); }
+  [[nodiscard]] IndirectArgumentsType type() const { return _type; }
+
+  // Per-coordinate bound arrays of count() entries, valid until the next
+  // resize().
+  float *minX() { return _minX.data(); }
+  float *minY() { return _minY.data(); }
+  float *minZ() { return _minZ.data(); }
+  float *maxX() { return _maxX.data(); }
+  float *maxY() { return _maxY.data(); }
+  float *maxZ() { return _maxZ.data(); }
+  void setBounds(std::size_t object, const AxisAlignedBoundingBox &bounds);
+
+  // The arguments of every object; only the array of type() has count()
+  // entries.
+  DrawPrimitivesIndirectArguments *arguments() { return _arguments.data(); }
+  DrawIndexedPrimitivesIndirectArguments *indexedArguments() {
+    return _indexedArguments.data();
+  }
+
+  // Writes the arguments of the objects inside frustum to pArguments, which
+  // must have room for count() of them, and returns how many it wrote. With
+  // a JobSystem, large object counts are split over parallelFor ranges.
+  std::uint32_t cull(const Frustum &frustum, void *pArguments,
+                     JobSystem *pJobSystem = nullptr);
+  // Writes into pBuffer's contents: the arguments from argumentsOffset and
+  // their count as a uint32_t at countOffset, for the GPU to read the draw
+  // range from.
+  std::uint32_t cull(const Frustum &frustum, Buffer *pBuffer,
+                     std::size_t argumentsOffset, std::size_t countOffset,
+                     JobSystem *pJobSystem = nullptr);
+
+ private:
+  IndirectArgumentsType _type;
+  std::vector<float> _minX;
+  std::vector<float> _minY;
+  std::vector<float> _minZ;
+  std::vector<float> _maxX;
+  std::vector<float> _maxY;
+  std::vector<float> _maxZ;
+  std::vector<DrawPrimitivesIndirectArguments> _arguments;
+  std::vector<DrawIndexedPrimitivesIndirectArguments> _indexedArguments;
+
+  // Scratch of cull(): a visibility bit per object and the number of
+  // visible objects per chunk, then the index of its first argument.
+  std::vector<std::uint8_t> _visible;
+  std::vector<std::uint32_t> _chunkCounts;
+};
+
+}  // namespace Gfx
@@ -0,0 +1,315 @@
+#include <Gfx/FrameCapture.hpp>
+
+#include <Gfx/PixelConversion.hpp>
+
+#include <algorithm>
+#include <cassert>
+#include <cstdio>
+#include <cstring>
+
+namespace Gfx {
+
+namespace {
+
+constexpr std::uint8_t kPngSignature[] = {0x89, 'P',  'N',  'G',
+                                          '\r', '\n', 0x1A, '\n'};
+// The largest stored deflate block.
+constexpr std::size_t kMaxStoredBlock = 65535;
+
+// Slicing-by-8 CRC-32, as PNG chunks use.
+struct Crc32Table {
+  Crc32Table();
+
+  std::uint32_t entries[8][256];
+};
+
+Crc32Table::Crc32Table() {
+  for (std::uint32_t i = 0; i < 256; ++i) {
+    std::uint32_t crc = i;
+    for (int bit = 0; bit < 8; ++bit) {
+      crc = (crc & 1) != 0 ? 0xEDB88320 ^ (crc >> 1) : crc >> 1;
+    }
+    entries[0][i] = crc;
+  }
+  for (int slice = 1; slice < 8; ++slice) {
+    for (std::uint32_t i = 0; i < 256; ++i) {
+      const std::uint32_t previous = entries[slice - 1][i];
+      entries[slice][i] = (previous >> 8) ^ entries[0][previous & 0xFF];
+    }
+  }
+}
+
+std::uint32_t updateCrc32(std::uint32_t crc, const std::uint8_t *pData,
+                          std::size_t size) {
+  static const Crc32Table table;
+  const auto &entries = table.entries;
+  crc = ~crc;
+  for (; size >= 8; size -= 8, pData += 8) {
+    std::uint32_t low;
+    std::uint32_t high;
+    std::memcpy(&low, pData, sizeof(low));
+    std::memcpy(&high, pData + 4, sizeof(high));
+    low ^= crc;
+    crc = entries[7][low & 0xFF] ^ entries[6][low >> 8 & 0xFF] ^
+          entries[5][low >> 16 & 0xFF] ^ entries[4][low >> 24] ^
+          entries[3][high & 0xFF] ^ entries[2][high >> 8 & 0xFF] ^
+          entries[1][high >> 16 & 0xFF] ^ entries[0][high >> 24];
+  }
+  for (; size > 0; --size, ++pData) {
+    crc = entries[0][(crc ^ *pData) & 0xFF] ^ (crc >> 8);
+  }
+  return ~crc;
+}
+
+std::uint32_t adler32(const std::uint8_t *pData, std::size_t size) {
+  // Most bytes that can be summed before the sums could overflow.
+  constexpr std::size_t kMaxRun = 5552;
+  std::uint32_t a = 1;
+  std::uint32_t b = 0;
+  while (size > 0) {
+    const std::size_t run = std::min(size, kMaxRun);
+    for (std::size_t i = 0; i < run; ++i) {
+      a += pData[i];
+      b += a;
+    }
+    a %= 65521;
+    b %= 65521;
+    pData += run;
+    size -= run;
+  }
+  return b << 16 | a;
+}
+
+void appendBigEndian(std::vector<std::uint8_t> &out, std::uint32_t value) {
+  for (int shift = 24; shift >= 0; shift -= 8) {
+    out.push_back(static_cast<std::uint8_t>(value >> shift));
+  }
+}
+
+void appendChunk(std::vector<std::uint8_t> &out, const char *pType,
+                 const std::uint8_t *pData, std::size_t size) {
+  appendBigEndian(out, static_cast<std::uint32_t>(size));
+  const std::size_t start = out.size();
+  out.insert(out.end(), pType, pType + 4);
+  out.insert(out.end(), pData, pData + size);
+  appendBigEndian(out, updateCrc32(0, &out[start], out.size() - start));
+}
+
+// Wraps filtered scanlines in a PNG whose zlib stream uses stored blocks.
+// Captures trade file size for an encoder that runs at memory speed;
+// recompress them offline if size matters.
+void encodePng(const std::vector<std::uint8_t> &scanlines, std::uint32_t width,
+               std::uint32_t height, std::vector<std::uint8_t> &out) {
+  const std::size_t blockCount =
+      std::max<std::size_t>(1, (scanlines.size() + kMaxStoredBlock - 1) /
+                                   kMaxStoredBlock);
+  out.clear();
+  out.reserve(scanlines.size() + blockCount * 5 + 128);
+  out.insert(out.end(), std::begin(kPngSignature), std::end(kPngSignature));
+
+  std::vector<std::uint8_t> header;
+  appendBigEndian(header, width);
+  appendBigEndian(header, height);
+  // 8 bits per channel, RGBA, no interlacing.
+  header.insert(header.end(), {8, 6, 0, 0, 0});
+  appendChunk(out, "IHDR", header.data(), header.size());
+  const std::uint8_t perceptualIntent = 0;
+  appendChunk(out, "sRGB", &perceptualIntent, 1);
+
+  const std::size_t lengthOffset = out.size();
+  appendBigEndian(out, 0);
+  out.insert(out.end(), {'I', 'D', 'A', 'T'});
+  // zlib header: deflate, 32 KiB window, no preset dictionary.
+  out.insert(out.end(), {0x78, 0x01});
+  std::size_t offset = 0;
+  do {
+    const std::size_t size =
+        std::min(kMaxStoredBlock, scanlines.size() - offset);
+    const bool final = offset + size == scanlines.size();
+    const auto length = static_cast<std::uint16_t>(size);
+    const auto complement = static_cast<std::uint16_t>(~length);
+    out.insert(out.end(),
+               {static_cast<std::uint8_t>(final ? 1 : 0),
+                static_cast<std::uint8_t>(length & 0xFF),
+                static_cast<std::uint8_t>(length >> 8),
+                static_cast<std::uint8_t>(complement & 0xFF),
+                static_cast<std::uint8_t>(complement >> 8)});
+    out.insert(out.end(), scanlines.begin() + offset,
+               scanlines.begin() + offset + size);
+    offset += size;
+  } while (offset < scanlines.size());
+  appendBigEndian(out, adler32(scanlines.data(), scanlines.size()));
+
+  const auto dataLength =
+      static_cast<std::uint32_t>(out.size() - lengthOffset - 8);
+  for (int i = 0; i < 4; ++i) {
+    out[lengthOffset + i] =
+        static_cast<std::uint8_t>(dataLength >> (24 - 8 * i));
+  }
+  appendBigEndian(out, updateCrc32(0, &out[lengthOffset + 4],
+                                   out.size() - lengthOffset - 4));
+  appendChunk(out, "IEND", nullptr, 0);
+}
+
+// The 8-bit format PNG pixels are converted to: sRGB formats and float
+// formats, which hold linear values, encode to sRGB; the others keep their
+// stored values.
+PixelFormat pngPixelFormat(PixelFormat pixelFormat) {
+  switch (pixelFormat) {
+    case PixelFormat::RGBA8Unorm_sRGB:
+    case PixelFormat::BGRA8Unorm_sRGB:
+    case PixelFormat::RG11B10Float:
+    case PixelFormat::RGBA16Float:
+    case PixelFormat::RGBA32Float:
+      return PixelFormat::RGBA8Unorm_sRGB;
+    default:
+      return PixelFormat::RGBA8Unorm;
+  }
+}
+
+}  // namespace
+
+FrameCapture::FrameCapture(Device *pDevice,
+                           const FrameCaptureDescriptor &descriptor)
+    : _descriptor(descriptor),
+      _pTexture(pDevice->newTexture(descriptor.width, descriptor.height,
+                                    descriptor.pixelFormat)),
+      _bytesPerRow(bytesPerPixel(descriptor.pixelFormat) * descriptor.width),
+      _slots(descriptor.stagingBufferCount) {
+  assert(!_slots.empty());
+  assert(_bytesPerRow > 0 && descriptor.height > 0);
+  for (Slot &slot : _slots) {
+    slot.pBuffer = pDevice->newBuffer(_bytesPerRow * descriptor.height);
+  }
+  _worker = std::thread(&FrameCapture::run, this);
+}
+
+FrameCapture::~FrameCapture() {
+  finish();
+  {
+    std::lock_guard<std::mutex> lock(_mutex);
+    _stopping = true;
+  }
+  _completed.notify_one();
+  _worker.join();
+}
+
+bool FrameCapture::capture(CommandBuffer *pCommandBuffer,
+                           std::uint64_t frameIndex) {
+  std::size_t index;
+  {
+    std::unique_lock<std::mutex> lock(_mutex);
+    Slot &slot = _slots[_nextSlot];
+    if (slot.busy) {
+      if (_descriptor.dropWhenBusy) {
+        ++_droppedFrameCount;
+        return false;
+      }
+      _freed.wait(lock, [&slot] { return !slot.busy; });
+    }
+    slot.busy = true;
+    slot.frameIndex = frameIndex;
+    ++_busyCount;
+    index = _nextSlot;
+    _nextSlot = (_nextSlot + 1) % _slots.size();
+  }
+
+  BlitCommandEncoder *pBlit = pCommandBuffer->blitCommandEncoder();
+  pBlit->copyFromTexture(_pTexture.get(), _slots[index].pBuffer.get(), 0,
+                         _bytesPerRow);
+  pBlit->endEncoding();
+  pCommandBuffer->addCompletedHandler([this, index] {
+    // Notified under the lock: once the frame is encoded, finish() may
+    // return and this may be destroyed.
+    std::lock_guard<std::mutex> lock(_mutex);
+    _pending.push_back(index);
+    _completed.notify_one();
+  });
+  return true;
+}
+
+void FrameCapture::finish() {
+  std::unique_lock<std::mutex> lock(_mutex);
+  _freed.wait(lock, [this] { return _busyCount == 0; });
+}
+
+std::uint64_t FrameCapture::encodedFrameCount() {
+  std::lock_guard<std::mutex> lock(_mutex);
+  return _encodedFrameCount;
+}
+
+std::uint64_t FrameCapture::droppedFrameCount() {
+  std::lock_guard<std::mutex> lock(_mutex);
+  return _droppedFrameCount;
+}
+
+void FrameCapture::run() {
+  std::vector<std::uint8_t> encoded;
+  for (;;) {
+    std::size_t index;
+    {
+      std::unique_lock<std::mutex> lock(_mutex);
+      _completed.wait(lock, [this] { return _stopping || !_pending.empty(); });
+      if (_pending.empty()) {
+        return;
+      }
+      index = _pending.front();
+      _pending.pop_front();
+    }
+
+    const Slot &slot = _slots[index];
+    encode(slot, encoded);
+    if (!_descriptor.directory.empty()) {
+      write(slot.frameIndex, encoded);
+    }
+    if (_encodedHandler) {
+      _encodedHandler(slot.frameIndex, encoded);
+    }
+
+    {
+      std::lock_guard<std::mutex> lock(_mutex);
+      _slots[index].busy = false;
+      --_busyCount;
+      ++_encodedFrameCount;
+    }
+    _freed.notify_all();
+  }
+}
+
+void FrameCapture::encode(const Slot &slot,
+                          std::vector<std::uint8_t> &encoded) {
+  const auto *pStaging =
+      static_cast<const std::uint8_t *>(slot.pBuffer->contents());
+  if (_descriptor.fileFormat == CaptureFileFormat::Raw) {
+    encoded.assign(pStaging, pStaging + _bytesPerRow * _descriptor.height);
+    return;
+  }
+
+  // Each scanline starts with its filter type, 0 for none.
+  const std::size_t scanlineLength = 1 + 4 * std::size_t{_descriptor.width};
+  _scanlines.resize(scanlineLength * _descriptor.height);
+  for (std::uint32_t row = 0; row < _descriptor.height; ++row) {
+    _scanlines[row * scanlineLength] = 0;
+  }
+  convertPixels(_descriptor.pixelFormat, pStaging, _bytesPerRow,
+                pngPixelFormat(_descriptor.pixelFormat), _scanlines.data() + 1,
+                scanlineLength, _descriptor.width, _descriptor.height);
+  encodePng(_scanlines, _descriptor.width, _descriptor.height, encoded);
+}
+
+void FrameCapture::write(std::uint64_t frameIndex,
+                         const std::vector<std::uint8_t> &encoded) const {
+  char name[32];
+  std::snprintf(name, sizeof(name), "/frame_%06llu.%s",
+                static_cast<unsigned long long>(frameIndex),
+                _descriptor.fileFormat == CaptureFileFormat::Png ? "png"
+                                                                 : "raw");
+  std::FILE *pFile = std::fopen((_descriptor.directory + name).c_str(), "wb");
+  if (pFile == nullptr) {
+    return;
+  }
+  std::fwrite(encoded.data(), 1, encoded.size(), pFile);
+  std::fclose(pFile);
+}
+
+}  // namespace Gfx
@@ -0,0 +1,115 @@
+#pragma once
+
+#include <Gfx/Backend.hpp>
+
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <utility>
+#include <vector>
+
+// Frame readback for automated regression captures. Frames render into an
+// offscreen texture; capture() blits it into the next buffer of a ring of
+// shared staging buffers, in the same command buffer, and once that buffer
+// completes a worker thread encodes the staging copy to a PNG or raw file.
+// The frame loop only waits when every staging buffer is still on its way
+// to the encoder, and not even then with dropWhenBusy.
+namespace Gfx {
+
+enum class CaptureFileFormat : std::uint8_t {
+  // The texture's bytes, rows tightly packed.
+  Raw,
+  // 8-bit RGBA. 8-bit and 10-bit unorm formats keep their values, float
+  // formats are encoded to sRGB, and depth goes to the red channel.
+  Png,
+};
+
+struct FrameCaptureDescriptor {
+  std::uint32_t width = 0;
+  std::uint32_t height = 0;
+  PixelFormat pixelFormat = PixelFormat::BGRA8Unorm_sRGB;
+  std::size_t stagingBufferCount = 3;
+  CaptureFileFormat fileFormat = CaptureFileFormat::Png;
+  // Frames are written as frame_<index>.png or .raw here; nothing is written
+  // if it is empty. Frames that can't be written are skipped.
+  std::string directory;
+  // Skip frames instead of waiting when every staging buffer is busy.
+  bool dropWhenBusy = false;
+};
+
+class FrameCapture {
+ public:
+  // Called on the worker thread with each encoded frame.
+  using EncodedHandler = std::function<void(
+      std::uint64_t frameIndex, const std::vector<std::uint8_t> &encoded)>;
+
+  FrameCapture(Device *pDevice, const FrameCaptureDescriptor &descriptor);
+  // Waits for frames still being captured. Command buffers that render into
+  // texture() without capturing have to complete first.
+  ~FrameCapture();
+
+  FrameCapture(const FrameCapture &) = delete;
+  FrameCapture &operator=(const FrameCapture &) = delete;
+
+  // Set before the first capture.
+  void setEncodedHandler(EncodedHandler handler) {
+    _encodedHandler = std::move(handler);
+  }
+
+  // Render the frame into this.
+  [[nodiscard]] Texture *texture() const { return _pTexture.get(); }
+  [[nodiscard]] const FrameCaptureDescriptor &descriptor() const {
+    return _descriptor;
+  }
+
+  // Encodes the readback of texture() at the end of pCommandBuffer, before
+  // it is committed. Returns false if the frame was dropped. Waiting for a
+  // staging buffer needs the command buffers of earlier captures committed.
+  bool capture(CommandBuffer *pCommandBuffer, std::uint64_t frameIndex);
+  // Waits until every captured frame has been encoded and written; their
+  // command buffers have to be committed.
+  void finish();
+
+  [[nodiscard]] std::uint64_t encodedFrameCount();
+  [[nodiscard]] std::uint64_t droppedFrameCount();
+
+ private:
+  struct Slot {
+    std::unique_ptr<Buffer> pBuffer;
+    std::uint64_t frameIndex = 0;
+    bool busy = false;
+  };
+
+  void run();
+  void encode(const Slot &slot, std::vector<std::uint8_t> &encoded);
+  void write(std::uint64_t frameIndex,
+             const std::vector<std::uint8_t> &encoded) const;
+
+  FrameCaptureDescriptor _descriptor;
+  std::unique_ptr<Texture> _pTexture;
+  std::size_t _bytesPerRow;
+  EncodedHandler _encodedHandler;
+  std::vector<Slot> _slots;
+  std::size_t _nextSlot = 0;
+  // Scratch rows of the PNG encoder; only the worker touches it.
+  std::vector<std::uint8_t> _scanlines;
+
+  std::mutex _mutex;
+  std::condition_variable _completed;
+  std::condition_variable _freed;
+  // Slots whose blit has completed, in completion order.
+  std::deque<std::size_t> _pending;
+  std::size_t _busyCount = 0;
+  std::uint64_t _encodedFrameCount = 0;
+  std::uint64_t _droppedFrameCount = 0;
+  bool _stopping = false;
+  std::thread _worker;
+};
+
+}  // namespace Gfx
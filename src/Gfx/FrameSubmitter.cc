@@ -0,0 +1,82 @@
+#include <Gfx/FrameSubmitter.hpp>
+
+#include <cassert>
+
+namespace Gfx {
+
+FrameSubmitter::FrameSubmitter(CommandQueue *pCommandQueue,
+                               std::size_t maxFramesInFlight,
+                               const CommandBufferDescriptor &descriptor)
+    : _pCommandQueue(pCommandQueue),
+      _maxFramesInFlight(maxFramesInFlight),
+      _descriptor(descriptor) {
+  assert(maxFramesInFlight > 0);
+}
+
+FrameSubmitter::~FrameSubmitter() {
+  // Completion handlers point back at the submitter, and released buffers may
+  // still be read by frames in flight.
+  assert(_pCommandBuffer == nullptr && "frame was begun but not committed");
+  waitForFence(_currentFence);
+  {
+    // The fence may have been read before signal() let go of the mutex.
+    std::lock_guard<std::mutex> lock(_mutex);
+  }
+  _retired.clear();
+}
+
+CommandBuffer *FrameSubmitter::beginFrame() {
+  assert(_pCommandBuffer == nullptr && "previous frame was not committed");
+  const std::uint64_t fence = _currentFence + 1;
+  if (fence > _maxFramesInFlight) {
+    waitForFence(fence - _maxFramesInFlight);
+  }
+  collectRetired();
+
+  _currentFence = fence;
+  _pCommandBuffer = _pCommandQueue->commandBuffer(_descriptor);
+  _pCommandBuffer->addCompletedHandler([this, fence] { signal(fence); });
+  return _pCommandBuffer;
+}
+
+void FrameSubmitter::commitFrame() {
+  assert(_pCommandBuffer != nullptr && "no frame was begun");
+  _pCommandBuffer->commit();
+  _pCommandBuffer = nullptr;
+}
+
+void FrameSubmitter::waitForFence(std::uint64_t fence) {
+  if (completedFence() >= fence) {
+    return;
+  }
+  std::unique_lock<std::mutex> lock(_mutex);
+  _completed.wait(lock, [this, fence] { return completedFence() >= fence; });
+}
+
+void FrameSubmitter::releaseWhenComplete(std::unique_ptr<Buffer> pBuffer) {
+  if (completedFence() >= _currentFence) {
+    return;
+  }
+  _retired.push_back({_currentFence, std::move(pBuffer)});
+}
+
+void FrameSubmitter::signal(std::uint64_t fence) {
+  // Notified under the lock, which the destructor takes before the
+  // condition variable goes away.
+  std::lock_guard<std::mutex> lock(_mutex);
+  // Command buffers on one queue complete in submission order; the check
+  // only keeps a late handler from moving the fence backwards.
+  if (fence > _completedFence.load(std::memory_order_relaxed)) {
+    _completedFence.store(fence, std::memory_order_release);
+  }
+  _completed.notify_all();
+}
+
+void FrameSubmitter::collectRetired() {
+  const std::uint64_t completed = completedFence();
+  while (!_retired.empty() && _retired.front().fence <= completed) {
+    _retired.pop_front();
+  }
+}
+
+}  // namespace Gfx
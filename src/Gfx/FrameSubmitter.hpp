@@ -0,0 +1,78 @@
+#pragma once
+
+#include <Gfx/Backend.hpp>
+
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <memory>
+#include <mutex>
+
+namespace Gfx {
+
+// Hands out one command buffer per frame and keeps at most maxFramesInFlight
+// of them queued on the backend. Every frame signals a fence when its command
+// buffer completes: frame n signals fence value n, starting at 1.
+//
+// Command buffers are created from a fixed descriptor, by default without
+// retained references. The submitter then owns resource lifetimes: anything
+// referenced by a frame still in flight has to be handed to
+// releaseWhenComplete() instead of being destroyed.
+class FrameSubmitter {
+ public:
+  FrameSubmitter(CommandQueue *pCommandQueue, std::size_t maxFramesInFlight,
+                 const CommandBufferDescriptor &descriptor = {
+                     .retainedReferences = false});
+  ~FrameSubmitter();
+
+  FrameSubmitter(const FrameSubmitter &) = delete;
+  FrameSubmitter &operator=(const FrameSubmitter &) = delete;
+
+  // Blocks until fewer than maxFramesInFlight frames are queued, destroys
+  // whatever the completed frames released and returns the command buffer for
+  // the next frame.
+  CommandBuffer *beginFrame();
+  void commitFrame();
+
+  // Fence value of the frame being encoded, or of the last one committed.
+  [[nodiscard]] std::uint64_t currentFence() const { return _currentFence; }
+  [[nodiscard]] std::uint64_t completedFence() const {
+    return _completedFence.load(std::memory_order_acquire);
+  }
+  void waitForFence(std::uint64_t fence);
+
+  // Destroys pBuffer once every frame encoded so far has completed.
+  void releaseWhenComplete(std::unique_ptr<Buffer> pBuffer);
+
+  [[nodiscard]] std::size_t maxFramesInFlight() const {
+    return _maxFramesInFlight;
+  }
+  [[nodiscard]] const CommandBufferDescriptor &descriptor() const {
+    return _descriptor;
+  }
+
+ private:
+  struct RetiredBuffer {
+    std::uint64_t fence;
+    std::unique_ptr<Buffer> pBuffer;
+  };
+
+  void signal(std::uint64_t fence);
+  void collectRetired();
+
+  CommandQueue *_pCommandQueue;
+  std::size_t _maxFramesInFlight;
+  CommandBufferDescriptor _descriptor;
+  CommandBuffer *_pCommandBuffer = nullptr;
+  std::uint64_t _currentFence = 0;
+  // Only touched by the thread encoding frames, ordered by fence.
+  std::deque<RetiredBuffer> _retired;
+
+  std::mutex _mutex;
+  std::condition_variable _completed;
+  std::atomic<std::uint64_t> _completedFence = 0;
+};
+
+}  // namespace Gfx
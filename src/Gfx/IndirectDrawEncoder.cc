@@ -0,0 +1,128 @@
+#include <Gfx/IndirectDrawEncoder.hpp>
+
+#include <algorithm>
+#include <bit>
+#include <cassert>
+#include <utility>
+
+namespace Gfx {
+
+namespace {
+
+constexpr std::size_t kBlocksPerWord = 64;
+
+}  // namespace
+
+IndirectDrawEncoder::IndirectDrawEncoder(
+    Device *pDevice, std::size_t frameCount,
+    const IndirectCommandBufferDescriptor &descriptor)
+    : _pDevice(pDevice), _descriptor(descriptor), _slots(frameCount) {}
+
+void IndirectDrawEncoder::setDrawList(std::size_t drawCount,
+                                      EncodeFunction encodeFunction) {
+  const std::size_t blockCount = (drawCount + kBlockSize - 1) / kBlockSize;
+  for (Slot &slot : _slots) {
+    if (!slot.pCommands || slot.pCommands->size() < drawCount) {
+      slot.pCommands = _pDevice->newIndirectCommandBuffer(
+          _descriptor, std::max<std::size_t>(drawCount, 1));
+    }
+    slot.dirtyBlocks.assign(
+        (blockCount + kBlocksPerWord - 1) / kBlocksPerWord, 0);
+  }
+  _drawCount = drawCount;
+  _encodeFunction = std::move(encodeFunction);
+  markDirty(0, drawCount);
+}
+
+void IndirectDrawEncoder::markDirty(std::size_t begin, std::size_t end) {
+  assert(begin <= end && end <= _drawCount);
+  if (begin == end) {
+    return;
+  }
+  const std::size_t lastBlock = (end - 1) / kBlockSize;
+  for (Slot &slot : _slots) {
+    for (std::size_t block = begin / kBlockSize; block <= lastBlock;
+         ++block) {
+      slot.dirtyBlocks[block / kBlocksPerWord] |=
+          std::uint64_t{1} << (block % kBlocksPerWord);
+    }
+  }
+}
+
+std::size_t IndirectDrawEncoder::update(std::size_t slotIndex,
+                                        JobSystem *pJobSystem) {
+  Slot &slot = _slots[slotIndex];
+  _ranges.clear();
+  collectDirtyRanges(slot, _ranges);
+  if (_ranges.empty()) {
+    return 0;
+  }
+  std::fill(slot.dirtyBlocks.begin(), slot.dirtyBlocks.end(), 0);
+
+  IndirectCommandBuffer *pCommands = slot.pCommands.get();
+  auto encodeRanges = [&](std::size_t first, std::size_t last) {
+    for (std::size_t i = first; i < last; ++i) {
+      const IndirectCommandBufferExecutionRange &range = _ranges[i];
+      pCommands->reset(range);
+      _encodeFunction(pCommands, slotIndex, range.location,
+                      range.location + range.length);
+    }
+  };
+  if (pJobSystem == nullptr || _ranges.size() == 1) {
+    encodeRanges(0, _ranges.size());
+  } else {
+    pJobSystem->parallelFor(_ranges.size(), 1, encodeRanges);
+  }
+
+  std::size_t commandCount = 0;
+  for (const IndirectCommandBufferExecutionRange &range : _ranges) {
+    commandCount += range.length;
+  }
+  return commandCount;
+}
+
+void IndirectDrawEncoder::execute(RenderCommandEncoder *pEncoder,
+                                  std::size_t slot) {
+  if (_drawCount == 0) {
+    return;
+  }
+  for (Buffer *pBuffer : _resources) {
+    pEncoder->useResource(pBuffer);
+  }
+  pEncoder->executeCommandsInBuffer(
+      _slots[slot].pCommands.get(),
+      {0, static_cast<std::uint32_t>(_drawCount)});
+}
+
+std::vector<IndirectCommandBufferExecutionRange>
+IndirectDrawEncoder::dirtyRanges(std::size_t slot) const {
+  std::vector<IndirectCommandBufferExecutionRange> ranges;
+  collectDirtyRanges(_slots[slot], ranges);
+  return ranges;
+}
+
+void IndirectDrawEncoder::collectDirtyRanges(
+    const Slot &slot,
+    std::vector<IndirectCommandBufferExecutionRange> &ranges) const {
+  for (std::size_t word = 0; word < slot.dirtyBlocks.size(); ++word) {
+    std::uint64_t bits = slot.dirtyBlocks[word];
+    while (bits != 0) {
+      const std::size_t block =
+          word * kBlocksPerWord + std::countr_zero(bits);
+      bits &= bits - 1;
+      const auto begin = static_cast<std::uint32_t>(block * kBlockSize);
+      const auto length = static_cast<std::uint32_t>(
+          std::min(kBlockSize, _drawCount - begin));
+      // Adjacent blocks extend the previous range up to its limit.
+      if (!ranges.empty() &&
+          ranges.back().location + ranges.back().length == begin &&
+          ranges.back().length + length <= kMaxCommandsPerRange) {
+        ranges.back().length += length;
+      } else {
+        ranges.push_back({begin, length});
+      }
+    }
+  }
+}
+
+}  // namespace Gfx
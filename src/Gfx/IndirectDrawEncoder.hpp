@@ -0,0 +1,91 @@
+#pragma once
+
+#include <Gfx/Backend.hpp>
+#include <Gfx/JobSystem.hpp>
+
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <vector>
+
+namespace Gfx {
+
+// Submits a mostly static draw list through indirect command buffers. The
+// list is encoded once into an IndirectCommandBuffer per frame in flight and
+// executed with one executeCommandsInBuffer() a frame; after that, a frame
+// only re-encodes the draws marked dirty since its slot's buffer was last
+// updated. Dirty draws are tracked in blocks of kBlockSize commands per
+// slot, so the GPU never reads commands the CPU is rewriting, and the dirty
+// blocks are re-encoded as ranges of up to kMaxCommandsPerRange, spread over
+// a job system if there is one.
+//
+// Not thread safe, except that the encode function is called for several
+// ranges at once.
+class IndirectDrawEncoder {
+ public:
+  // Commands per dirty bit.
+  static constexpr std::size_t kBlockSize = 256;
+  // Longest range handed to one call of the encode function.
+  static constexpr std::size_t kMaxCommandsPerRange = 16 * kBlockSize;
+
+  // Encodes draws [begin, end) into commands [begin, end) of pCommands, the
+  // buffer of slot; the range has been reset.
+  using EncodeFunction =
+      std::function<void(IndirectCommandBuffer *pCommands, std::size_t slot,
+                         std::size_t begin, std::size_t end)>;
+
+  IndirectDrawEncoder(Device *pDevice, std::size_t frameCount,
+                      const IndirectCommandBufferDescriptor &descriptor =
+                          IndirectCommandBufferDescriptor());
+
+  IndirectDrawEncoder(const IndirectDrawEncoder &) = delete;
+  IndirectDrawEncoder &operator=(const IndirectDrawEncoder &) = delete;
+
+  // Replaces the draw list; every draw is dirty afterwards. Grows the
+  // command buffers if needed, so no slot may be in use by the GPU.
+  void setDrawList(std::size_t drawCount, EncodeFunction encodeFunction);
+  // Has draws [begin, end) re-encoded in every slot before it next executes.
+  void markDirty(std::size_t begin, std::size_t end);
+  // A buffer the commands bind, declared with useResource() wherever they
+  // execute.
+  void addResource(Buffer *pBuffer) { _resources.push_back(pBuffer); }
+
+  // Re-encodes the dirty draws of slot, whose previous frame has to have
+  // completed, and returns how many commands that took.
+  std::size_t update(std::size_t slot, JobSystem *pJobSystem = nullptr);
+  // Executes slot's draws in pEncoder, as they were at its last update().
+  void execute(RenderCommandEncoder *pEncoder, std::size_t slot);
+
+  // Ranges the next update() of slot re-encodes, in order.
+  [[nodiscard]] std::vector<IndirectCommandBufferExecutionRange> dirtyRanges(
+      std::size_t slot) const;
+  [[nodiscard]] std::size_t drawCount() const { return _drawCount; }
+  [[nodiscard]] std::size_t frameCount() const { return _slots.size(); }
+  [[nodiscard]] IndirectCommandBuffer *commandBuffer(std::size_t slot) const {
+    return _slots[slot].pCommands.get();
+  }
+
+ private:
+  struct Slot {
+    std::unique_ptr<IndirectCommandBuffer> pCommands;
+    // A bit per block of kBlockSize commands.
+    std::vector<std::uint64_t> dirtyBlocks;
+  };
+
+  // Appends the dirty ranges of slot to ranges.
+  void collectDirtyRanges(
+      const Slot &slot,
+      std::vector<IndirectCommandBufferExecutionRange> &ranges) const;
+
+  Device *_pDevice;
+  IndirectCommandBufferDescriptor _descriptor;
+  std::vector<Slot> _slots;
+  std::vector<Buffer *> _resources;
+  EncodeFunction _encodeFunction;
+  std::size_t _drawCount = 0;
+  // Scratch of update().
+  std::vector<IndirectCommandBufferExecutionRange> _ranges;
+};
+
+}  // namespace Gfx
@@ -0,0 +1,62 @@
+#include <Gfx/InstanceBvh.hpp>
+
+namespace Gfx {
+
+namespace {
+
+AxisAlignedBoundingBox worldBoundsOf(const AxisAlignedBoundingBox &local,
+                                     const PackedFloat4x3 &transform) {
+  return transformBounds(Float4x4::fromPacked(transform), local);
+}
+
+}  // namespace
+
+void InstanceBvh::build(const AxisAlignedBoundingBox *pLocalBounds,
+                        const PackedFloat4x3 *pTransforms,
+                        std::size_t instanceCount, JobSystem *pJobSystem,
+                        const BvhBuildOptions &options) {
+  _options = options;
+  _localBounds.assign(pLocalBounds, pLocalBounds + instanceCount);
+  _transforms.assign(pTransforms, pTransforms + instanceCount);
+  _worldBounds.resize(instanceCount);
+  const auto place = [this](std::size_t begin, std::size_t end) {
+    for (std::size_t i = begin; i < end; ++i) {
+      _worldBounds[i] = worldBoundsOf(_localBounds[i], _transforms[i]);
+    }
+  };
+  if (pJobSystem != nullptr) {
+    pJobSystem->parallelFor(instanceCount, 16384, place);
+  } else {
+    place(0, instanceCount);
+  }
+  _isMoved.assign(instanceCount, false);
+  rebuild(pJobSystem);
+}
+
+void InstanceBvh::rebuild(JobSystem *pJobSystem) {
+  _bvh.build(_worldBounds.data(), _worldBounds.size(), pJobSystem, _options);
+  for (const std::uint32_t instance : _moved) {
+    _isMoved[instance] = false;
+  }
+  _moved.clear();
+}
+
+void InstanceBvh::setTransform(std::uint32_t instance,
+                               const PackedFloat4x3 &transform) {
+  _transforms[instance] = transform;
+  _worldBounds[instance] = worldBoundsOf(_localBounds[instance], transform);
+  if (!_isMoved[instance]) {
+    _isMoved[instance] = true;
+    _moved.push_back(instance);
+  }
+}
+
+void InstanceBvh::refit(JobSystem *pJobSystem) {
+  _bvh.refit(_worldBounds.data(), _moved.data(), _moved.size(), pJobSystem);
+  for (const std::uint32_t instance : _moved) {
+    _isMoved[instance] = false;
+  }
+  _moved.clear();
+}
+
+}  // namespace Gfx
@@ -0,0 +1,60 @@
+#pragma once
+
+#include <Gfx/Bvh.hpp>
+#include <Gfx/JobSystem.hpp>
+#include <Gfx/Math.hpp>
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+namespace Gfx {
+
+// Bvh over instances: object-space bounds placed in the world by the
+// PackedFloat4x3 transforms an instance acceleration structure takes. Moving
+// an instance updates its world bounds right away and marks it; refit() then
+// recomputes only the subtrees of the marked instances, so a frame costs in
+// proportion to what moved.
+class InstanceBvh {
+ public:
+  InstanceBvh() = default;
+
+  void build(const AxisAlignedBoundingBox *pLocalBounds,
+             const PackedFloat4x3 *pTransforms, std::size_t instanceCount,
+             JobSystem *pJobSystem = nullptr,
+             const BvhBuildOptions &options = {});
+  // Rebuilds over the current transforms, for when refits have degraded the
+  // tree too far.
+  void rebuild(JobSystem *pJobSystem = nullptr);
+
+  void setTransform(std::uint32_t instance, const PackedFloat4x3 &transform);
+  // Brings the tree up to date with the transforms set since the last build
+  // or refit.
+  void refit(JobSystem *pJobSystem = nullptr);
+
+  [[nodiscard]] const Bvh &bvh() const { return _bvh; }
+  [[nodiscard]] std::size_t instanceCount() const {
+    return _transforms.size();
+  }
+  [[nodiscard]] const PackedFloat4x3 &transform(std::uint32_t instance) const {
+    return _transforms[instance];
+  }
+  [[nodiscard]] const AxisAlignedBoundingBox &worldBounds(
+      std::uint32_t instance) const {
+    return _worldBounds[instance];
+  }
+  // Instances moved since the last build or refit.
+  [[nodiscard]] std::size_t movedCount() const { return _moved.size(); }
+
+ private:
+  Bvh _bvh;
+  BvhBuildOptions _options;
+  std::vector<AxisAlignedBoundingBox> _localBounds;
+  std::vector<PackedFloat4x3> _transforms;
+  std::vector<AxisAlignedBoundingBox> _worldBounds;
+  std::vector<std::uint32_t> _moved;
+  // Whether an instance is in _moved already.
+  std::vector<bool> _isMoved;
+};
+
+}  // namespace Gfx
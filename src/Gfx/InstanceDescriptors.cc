@@ -0,0 +1,259 @@
+#include <Gfx/InstanceDescriptors.hpp>
+
+#include <algorithm>
+#include <cassert>
+#include <cstring>
+
+namespace Gfx {
+
+namespace {
+
+// Fills larger than this are split over parallelFor ranges. A multiple of
+// kStagedInstances, so every range starts on a 16-byte boundary.
+constexpr std::size_t kParallelGrain = std::size_t{1} << 14;
+// UserID and motion descriptors aren't 16-byte multiples; they are assembled
+// this many at a time in a small buffer that stays in L1, then streamed out
+// in 16-byte pieces. Four of either make a whole number of pieces.
+constexpr std::size_t kStagedInstances = 16;
+// The motion layout's last vector store reaches 4 bytes past the descriptor.
+constexpr std::size_t kStagingSlack = 16;
+
+static_assert(kParallelGrain % kStagedInstances == 0);
+static_assert(kStagedInstances % 4 == 0);
+
+bool isStreamable(const std::byte *pDestination) {
+  return (reinterpret_cast<std::uintptr_t>(pDestination) & 15) == 0;
+}
+
+#if GFX_MATH_SSE
+
+// Loads field values of four consecutive instances and transposes them, so
+// rows[k] holds instance k's four fields in descriptor order.
+template <typename A, typename B, typename C, typename D>
+void loadRows(const A *pA, const B *pB, const C *pC, const D *pD,
+              __m128 (&rows)[4]) {
+  static_assert(sizeof(A) == 4 && sizeof(B) == 4 && sizeof(C) == 4 &&
+                sizeof(D) == 4);
+  rows[0] = _mm_loadu_ps(reinterpret_cast<const float *>(pA));
+  rows[1] = _mm_loadu_ps(reinterpret_cast<const float *>(pB));
+  rows[2] = _mm_loadu_ps(reinterpret_cast<const float *>(pC));
+  rows[3] = _mm_loadu_ps(reinterpret_cast<const float *>(pD));
+  _MM_TRANSPOSE4_PS(rows[0], rows[1], rows[2], rows[3]);
+}
+
+#endif
+
+// Copies size bytes from 16-byte aligned staging to pDestination, bypassing
+// the caches where pDestination allows it.
+void streamCopy(std::byte *pDestination, const std::byte *pSource,
+                std::size_t size) {
+#if GFX_MATH_SSE
+  if (isStreamable(pDestination)) {
+    std::size_t offset = 0;
+    for (; offset + 16 <= size; offset += 16) {
+      _mm_stream_si128(
+          reinterpret_cast<__m128i *>(pDestination + offset),
+          _mm_load_si128(reinterpret_cast<const __m128i *>(pSource + offset)));
+    }
+    std::memcpy(pDestination + offset, pSource + offset, size - offset);
+    return;
+  }
+#endif
+  std::memcpy(pDestination, pSource, size);
+}
+
+}  // namespace
+
+void InstanceDescriptorWriter::resize(std::size_t count) {
+  const AccelerationStructureMotionInstanceDescriptor defaults;
+  _transforms.resize(count, Float4x4::identity().toPacked());
+  _options.resize(count, defaults.options);
+  _masks.resize(count, defaults.mask);
+  _intersectionFunctionTableOffsets.resize(
+      count, defaults.intersectionFunctionTableOffset);
+  _accelerationStructureIndices.resize(count,
+                                       defaults.accelerationStructureIndex);
+  _userIDs.resize(count, defaults.userID);
+  _motionTransformsStartIndices.resize(count,
+                                       defaults.motionTransformsStartIndex);
+  _motionTransformsCounts.resize(count, defaults.motionTransformsCount);
+  _motionStartBorderModes.resize(count, defaults.motionStartBorderMode);
+  _motionEndBorderModes.resize(count, defaults.motionEndBorderMode);
+  _motionStartTimes.resize(count, defaults.motionStartTime);
+  _motionEndTimes.resize(count, defaults.motionEndTime);
+}
+
+void InstanceDescriptorWriter::write(InstanceDescriptorType type,
+                                     void *pDestination,
+                                     JobSystem *pJobSystem) const {
+  auto *pBytes = static_cast<std::byte *>(pDestination);
+  const std::size_t size = instanceDescriptorSize(type);
+  if (pJobSystem != nullptr && count() > kParallelGrain) {
+    pJobSystem->parallelFor(count(), kParallelGrain,
+                            [&](std::size_t begin, std::size_t end) {
+                              writeRange(type, pBytes + begin * size, begin,
+                                         end);
+                            });
+  } else {
+    writeRange(type, pBytes, 0, count());
+  }
+}
+
+void InstanceDescriptorWriter::write(InstanceDescriptorType type,
+                                     Buffer *pBuffer, std::size_t offset,
+                                     JobSystem *pJobSystem) const {
+  assert(offset + count() * instanceDescriptorSize(type) <= pBuffer->length());
+  write(type, static_cast<std::byte *>(pBuffer->contents()) + offset,
+        pJobSystem);
+}
+
+void InstanceDescriptorWriter::writeRange(InstanceDescriptorType type,
+                                          std::byte *pDestination,
+                                          std::size_t begin,
+                                          std::size_t end) const {
+  if (type == InstanceDescriptorType::Default) {
+    writeDefault(pDestination, begin, end);
+  } else {
+    writeStaged(type, pDestination, begin, end);
+  }
+#if GFX_MATH_SSE
+  // Streaming stores aren't ordered with the ones that publish the fill to
+  // other threads; this one has to finish them first.
+  _mm_sfence();
+#endif
+}
+
+// Default descriptors are 64 bytes, a cache line when the destination starts
+// on one, so they go straight from registers to memory.
+void InstanceDescriptorWriter::writeDefault(std::byte *pDestination,
+                                            std::size_t begin,
+                                            std::size_t end) const {
+  constexpr std::size_t kSize = sizeof(AccelerationStructureInstanceDescriptor);
+#if GFX_MATH_SSE
+  if (isStreamable(pDestination)) {
+    std::size_t i = begin;
+    for (; i + 4 <= end; i += 4) {
+      __m128 rows[4];
+      loadRows(&_options[i], &_masks[i], &_intersectionFunctionTableOffsets[i],
+               &_accelerationStructureIndices[i], rows);
+      for (std::size_t k = 0; k < 4; ++k) {
+        const float *pTransform = &_transforms[i + k].columns[0].x;
+        auto *pOut =
+            reinterpret_cast<float *>(pDestination + (i + k - begin) * kSize);
+        _mm_stream_ps(pOut, _mm_loadu_ps(pTransform));
+        _mm_stream_ps(pOut + 4, _mm_loadu_ps(pTransform + 4));
+        _mm_stream_ps(pOut + 8, _mm_loadu_ps(pTransform + 8));
+        _mm_stream_ps(pOut + 12, rows[k]);
+      }
+    }
+    alignas(16) std::byte staging[kSize];
+    for (; i < end; ++i) {
+      assemble(InstanceDescriptorType::Default, i, staging);
+      streamCopy(pDestination + (i - begin) * kSize, staging, kSize);
+    }
+    return;
+  }
+#endif
+  for (std::size_t i = begin; i < end; ++i) {
+    assemble(InstanceDescriptorType::Default, i,
+             pDestination + (i - begin) * kSize);
+  }
+}
+
+void InstanceDescriptorWriter::writeStaged(InstanceDescriptorType type,
+                                           std::byte *pDestination,
+                                           std::size_t begin,
+                                           std::size_t end) const {
+  const std::size_t size = instanceDescriptorSize(type);
+  alignas(16) std::byte staging
+      [kStagedInstances *
+           sizeof(AccelerationStructureUserIDInstanceDescriptor) +
+       kStagingSlack];
+  for (std::size_t block = begin; block < end; block += kStagedInstances) {
+    const std::size_t blockEnd = std::min(block + kStagedInstances, end);
+    std::size_t i = block;
+#if GFX_MATH_SSE
+    for (; i + 4 <= blockEnd; i += 4) {
+      std::byte *pGroup = staging + (i - block) * size;
+      __m128 rows[4];
+      loadRows(&_options[i], &_masks[i], &_intersectionFunctionTableOffsets[i],
+               &_accelerationStructureIndices[i], rows);
+      if (type == InstanceDescriptorType::UserID) {
+        for (std::size_t k = 0; k < 4; ++k) {
+          const float *pTransform = &_transforms[i + k].columns[0].x;
+          auto *pOut = reinterpret_cast<float *>(pGroup + k * size);
+          _mm_storeu_ps(pOut, _mm_loadu_ps(pTransform));
+          _mm_storeu_ps(pOut + 4, _mm_loadu_ps(pTransform + 4));
+          _mm_storeu_ps(pOut + 8, _mm_loadu_ps(pTransform + 8));
+          _mm_storeu_ps(pOut + 12, rows[k]);
+          std::memcpy(pOut + 16, &_userIDs[i + k], sizeof(std::uint32_t));
+        }
+        continue;
+      }
+      __m128 motionRows[4];
+      __m128 timeRows[4];
+      loadRows(&_userIDs[i], &_motionTransformsStartIndices[i],
+               &_motionTransformsCounts[i], &_motionStartBorderModes[i],
+               motionRows);
+      // The fourth field is padding; the next descriptor overwrites it.
+      loadRows(&_motionEndBorderModes[i], &_motionStartTimes[i],
+               &_motionEndTimes[i], &_motionEndTimes[i], timeRows);
+      for (std::size_t k = 0; k < 4; ++k) {
+        auto *pOut = reinterpret_cast<float *>(pGroup + k * size);
+        _mm_storeu_ps(pOut, rows[k]);
+        _mm_storeu_ps(pOut + 4, motionRows[k]);
+        _mm_storeu_ps(pOut + 8, timeRows[k]);
+      }
+    }
+#endif
+    for (; i < blockEnd; ++i) {
+      assemble(type, i, staging + (i - block) * size);
+    }
+    streamCopy(pDestination + (block - begin) * size, staging,
+               (blockEnd - block) * size);
+  }
+}
+
+void InstanceDescriptorWriter::assemble(InstanceDescriptorType type,
+                                        std::size_t instance,
+                                        std::byte *pDescriptor) const {
+  switch (type) {
+    case InstanceDescriptorType::Default: {
+      const AccelerationStructureInstanceDescriptor descriptor{
+          _transforms[instance], _options[instance], _masks[instance],
+          _intersectionFunctionTableOffsets[instance],
+          _accelerationStructureIndices[instance]};
+      std::memcpy(pDescriptor, &descriptor, sizeof(descriptor));
+      break;
+    }
+    case InstanceDescriptorType::UserID: {
+      const AccelerationStructureUserIDInstanceDescriptor descriptor{
+          _transforms[instance],
+          _options[instance],
+          _masks[instance],
+          _intersectionFunctionTableOffsets[instance],
+          _accelerationStructureIndices[instance],
+          _userIDs[instance]};
+      std::memcpy(pDescriptor, &descriptor, sizeof(descriptor));
+      break;
+    }
+    case InstanceDescriptorType::Motion: {
+      const AccelerationStructureMotionInstanceDescriptor descriptor{
+          _options[instance],
+          _masks[instance],
+          _intersectionFunctionTableOffsets[instance],
+          _accelerationStructureIndices[instance],
+          _userIDs[instance],
+          _motionTransformsStartIndices[instance],
+          _motionTransformsCounts[instance],
+          _motionStartBorderModes[instance],
+          _motionEndBorderModes[instance],
+          _motionStartTimes[instance],
+          _motionEndTimes[instance]};
+      std::memcpy(pDescriptor, &descriptor, sizeof(descriptor));
+      break;
+    }
+  }
+}
+
+}  // namespace Gfx
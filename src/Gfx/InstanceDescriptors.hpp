@@ -0,0 +1,177 @@
+#pragma once
+
+#include <Gfx/Backend.hpp>
+#include <Gfx/JobSystem.hpp>
+#include <Gfx/Math.hpp>
+
+#include <cstddef>
+#include <cstdint>
+#include <type_traits>
+#include <vector>
+
+namespace Gfx {
+
+// Bit flags of AccelerationStructureInstanceDescriptor::options; the values
+// are MTL::AccelerationStructureInstanceOptions'.
+enum class InstanceOptions : std::uint32_t {
+  None = 0,
+  DisableTriangleCulling = 1 << 0,
+  TriangleFrontFacingWindingCounterClockwise = 1 << 1,
+  Opaque = 1 << 2,
+  NonOpaque = 1 << 3,
+};
+
+constexpr InstanceOptions operator|(InstanceOptions lhs, InstanceOptions rhs) {
+  return static_cast<InstanceOptions>(static_cast<std::uint32_t>(lhs) |
+                                      static_cast<std::uint32_t>(rhs));
+}
+
+enum class MotionBorderMode : std::uint32_t {
+  Clamp = 0,
+  Vanish = 1,
+};
+
+// Which of the three instance descriptor layouts to write, as
+// MTL::AccelerationStructureInstanceDescriptorType without Indirect.
+enum class InstanceDescriptorType : std::uint8_t {
+  Default,
+  UserID,
+  Motion,
+};
+
+// The instance descriptors of MTLAccelerationStructure.hpp. Every member is
+// four bytes wide, so the natural layout is already the packed one; arrays of
+// them have the exact strides a Metal instance buffer expects.
+struct AccelerationStructureInstanceDescriptor {
+  PackedFloat4x3 transformationMatrix;
+  InstanceOptions options = InstanceOptions::None;
+  std::uint32_t mask = 0xFF;
+  std::uint32_t intersectionFunctionTableOffset = 0;
+  std::uint32_t accelerationStructureIndex = 0;
+};
+
+struct AccelerationStructureUserIDInstanceDescriptor {
+  PackedFloat4x3 transformationMatrix;
+  InstanceOptions options = InstanceOptions::None;
+  std::uint32_t mask = 0xFF;
+  std::uint32_t intersectionFunctionTableOffset = 0;
+  std::uint32_t accelerationStructureIndex = 0;
+  std::uint32_t userID = 0;
+};
+
+struct AccelerationStructureMotionInstanceDescriptor {
+  InstanceOptions options = InstanceOptions::None;
+  std::uint32_t mask = 0xFF;
+  std::uint32_t intersectionFunctionTableOffset = 0;
+  std::uint32_t accelerationStructureIndex = 0;
+  std::uint32_t userID = 0;
+  std::uint32_t motionTransformsStartIndex = 0;
+  std::uint32_t motionTransformsCount = 0;
+  MotionBorderMode motionStartBorderMode = MotionBorderMode::Clamp;
+  MotionBorderMode motionEndBorderMode = MotionBorderMode::Clamp;
+  float motionStartTime = 0.0F;
+  float motionEndTime = 1.0F;
+};
+
+static_assert(sizeof(AccelerationStructureInstanceDescriptor) == 64 &&
+              std::is_trivially_copyable_v<
+                  AccelerationStructureInstanceDescriptor>);
+static_assert(sizeof(AccelerationStructureUserIDInstanceDescriptor) == 68);
+static_assert(sizeof(AccelerationStructureMotionInstanceDescriptor) == 44);
+
+[[nodiscard]] constexpr std::size_t instanceDescriptorSize(
+    InstanceDescriptorType type) {
+  switch (type) {
+    case InstanceDescriptorType::Default:
+      return sizeof(AccelerationStructureInstanceDescriptor);
+    case InstanceDescriptorType::UserID:
+      return sizeof(AccelerationStructureUserIDInstanceDescriptor);
+    case InstanceDescriptorType::Motion:
+      return sizeof(AccelerationStructureMotionInstanceDescriptor);
+  }
+  return 0;
+}
+
+// Keeps the instances of an instance acceleration structure as one array per
+// descriptor field and writes them out in any of the descriptor layouts.
+//
+// The game side touches a few fields of many instances per frame, mostly the
+// transforms, which the separate arrays keep dense. write() then assembles
+// whole descriptors in registers and streams them to the destination with
+// non-temporal stores: the instance buffer is only read by the GPU, so
+// pulling its lines into the CPU caches first would double the memory
+// traffic and evict the arrays being read. On x86-64 this makes a fill of a
+// shared buffer bound by write bandwidth; elsewhere it falls back to plain
+// stores.
+class InstanceDescriptorWriter {
+ public:
+  InstanceDescriptorWriter() = default;
+
+  // New instances get the descriptor defaults: identity transforms and a mask
+  // of 0xFF.
+  void resize(std::size_t count);
+  [[nodiscard]] std::size_t count() const { return _transforms.size(); }
+
+  // Per-field arrays of count() entries, valid until the next resize().
+  // Motion descriptors don't carry a transform; the others ignore the motion
+  // fields.
+  PackedFloat4x3 *transforms() { return _transforms.data(); }
+  InstanceOptions *options() { return _options.data(); }
+  std::uint32_t *masks() { return _masks.data(); }
+  std::uint32_t *intersectionFunctionTableOffsets() {
+    return _intersectionFunctionTableOffsets.data();
+  }
+  std::uint32_t *accelerationStructureIndices() {
+    return _accelerationStructureIndices.data();
+  }
+  std::uint32_t *userIDs() { return _userIDs.data(); }
+  std::uint32_t *motionTransformsStartIndices() {
+    return _motionTransformsStartIndices.data();
+  }
+  std::uint32_t *motionTransformsCounts() {
+    return _motionTransformsCounts.data();
+  }
+  MotionBorderMode *motionStartBorderModes() {
+    return _motionStartBorderModes.data();
+  }
+  MotionBorderMode *motionEndBorderModes() {
+    return _motionEndBorderModes.data();
+  }
+  float *motionStartTimes() { return _motionStartTimes.data(); }
+  float *motionEndTimes() { return _motionEndTimes.data(); }
+
+  // Writes the descriptors of every instance to pDestination, which must hold
+  // count() * instanceDescriptorSize(type) bytes. The non-temporal path needs
+  // pDestination 16-byte aligned, which buffer contents always are. With a
+  // JobSystem, large fills are split into parallelFor ranges.
+  void write(InstanceDescriptorType type, void *pDestination,
+             JobSystem *pJobSystem = nullptr) const;
+  // Writes into pBuffer's contents, starting offset bytes in.
+  void write(InstanceDescriptorType type, Buffer *pBuffer,
+             std::size_t offset = 0, JobSystem *pJobSystem = nullptr) const;
+
+ private:
+  void writeRange(InstanceDescriptorType type, std::byte *pDestination,
+                  std::size_t begin, std::size_t end) const;
+  void writeDefault(std::byte *pDestination, std::size_t begin,
+                    std::size_t end) const;
+  void writeStaged(InstanceDescriptorType type, std::byte *pDestination,
+                   std::size_t begin, std::size_t end) const;
+  void assemble(InstanceDescriptorType type, std::size_t instance,
+                std::byte *pDescriptor) const;
+
+  std::vector<PackedFloat4x3> _transforms;
+  std::vector<InstanceOptions> _options;
+  std::vector<std::uint32_t> _masks;
+  std::vector<std::uint32_t> _intersectionFunctionTableOffsets;
+  std::vector<std::uint32_t> _accelerationStructureIndices;
+  std::vector<std::uint32_t> _userIDs;
+  std::vector<std::uint32_t> _motionTransformsStartIndices;
+  std::vector<std::uint32_t> _motionTransformsCounts;
+  std::vector<MotionBorderMode> _motionStartBorderModes;
+  std::vector<MotionBorderMode> _motionEndBorderModes;
+  std::vector<float> _motionStartTimes;
+  std::vector<float> _motionEndTimes;
+};
+
+}  // namespace Gfx
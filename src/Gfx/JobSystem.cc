@@ -0,0 +1,397 @@
+#include <Gfx/JobSystem.hpp>
+#include <Gfx/WorkStealingDeque.hpp>
+
+#include <algorithm>
+#include <cassert>
+#include <thread>
+
+namespace Gfx {
+
+namespace Detail {
+
+struct Job {
+  JobSystem::JobFunction function;
+  JobCounter *pCounter = nullptr;
+  JobAffinity affinity = JobAffinity::Any;
+  // Carved from a job block rather than allocated on its own.
+  bool pooled = false;
+  // Index of the thread whose pool the job belongs to.
+  std::size_t owner = 0;
+  // Next job in the owner's returnedJobs list.
+  Job *pNextReturned = nullptr;
+};
+
+}  // namespace Detail
+
+namespace {
+
+using Detail::Job;
+
+constexpr std::size_t kJobBlockSize = 256;
+// Rounds of looking for work before an idle thread goes to sleep.
+constexpr int kSpinCount = 64;
+
+thread_local const JobSystem *t_pJobSystem = nullptr;
+thread_local std::size_t t_threadIndex = 0;
+
+}  // namespace
+
+struct alignas(64) JobSystem::Thread {
+  explicit Thread(std::size_t threadIndex)
+      : index(threadIndex),
+        random(static_cast<std::uint32_t>(threadIndex + 1) * 0x9E3779B9U) {}
+
+  std::size_t index;
+  WorkStealingDeque<Job *> jobs;
+  std::vector<Job *> freeJobs;
+  // Jobs from freeJobs that other threads ran and handed back, a lock-free
+  // stack that allocateJob() takes over whole.
+  std::atomic<Job *> returnedJobs = nullptr;
+  // xorshift state for picking whom to steal from.
+  std::uint32_t random;
+  std::thread thread;
+};
+
+JobSystem::JobSystem(std::size_t threadCount) {
+  if (threadCount == 0) {
+    threadCount = std::max(1U, std::thread::hardware_concurrency());
+  }
+  assert(t_pJobSystem == nullptr &&
+         "thread is already the main thread of a JobSystem");
+  t_pJobSystem = this;
+  t_threadIndex = 0;
+
+  // Every deque has to exist before the first worker starts stealing.
+  _threads.reserve(threadCount);
+  for (std::size_t i = 0; i < threadCount; ++i) {
+    _threads.push_back(std::make_unique<Thread>(i));
+  }
+  for (std::size_t i = 1; i < threadCount; ++i) {
+    _threads[i]->thread = std::thread(&JobSystem::workerMain, this, i);
+  }
+}
+
+JobSystem::~JobSystem() {
+  {
+    std::lock_guard<std::mutex> lock(_sleepMutex);
+    _stopping = true;
+  }
+  _wakeUp.notify_all();
+  for (std::size_t i = 1; i < _threads.size(); ++i) {
+    _threads[i]->thread.join();
+  }
+  if (t_pJobSystem == this) {
+    t_pJobSystem = nullptr;
+  }
+}
+
+void JobSystem::run(JobFunction function, JobCounter *pCounter,
+                    JobCounter *pDependency, JobAffinity affinity) {
+  Thread *pThread = currentThread();
+  Job *pJob = allocateJob(pThread);
+  pJob->function = std::move(function);
+  pJob->pCounter = pCounter;
+  pJob->affinity = affinity;
+  if (pCounter != nullptr) {
+    pCounter->_value.fetch_add(1, std::memory_order_relaxed);
+  }
+  if (pDependency != nullptr) {
+    std::lock_guard<std::mutex> lock(pDependency->_mutex);
+    if (!pDependency->done()) {
+      pDependency->_waitingJobs.push_back(pJob);
+      return;
+    }
+  }
+  schedule(pThread, pJob);
+}
+
+void JobSystem::wait(JobCounter &counter) {
+  Thread *pThread = currentThread();
+  int spins = 0;
+  while (!counter.done()) {
+    if (pThread != nullptr) {
+      if (pThread->index == 0 && runMainThreadJob()) {
+        spins = 0;
+        continue;
+      }
+      if (Job *pJob = findJob(pThread)) {
+        execute(pThread, pJob);
+        spins = 0;
+        continue;
+      }
+    }
+    if (++spins < kSpinCount) {
+      std::this_thread::yield();
+      continue;
+    }
+    sleep(pThread, &counter);
+    spins = 0;
+  }
+  // The last job may still be inside finish(); the counter can only be
+  // destroyed once it has let go of the mutex.
+  std::lock_guard<std::mutex> lock(counter._mutex);
+}
+
+void JobSystem::runMainThreadJobs() {
+  assert(currentThreadIndex() == 0 && "not the main thread");
+  while (runMainThreadJob()) {
+  }
+}
+
+void JobSystem::parallelFor(std::size_t count, std::size_t grainSize,
+                            const RangeFunction &function) {
+  if (count == 0) {
+    return;
+  }
+  struct Ranges {
+    const RangeFunction *pFunction;
+    std::size_t count;
+    std::size_t grainSize;
+
+    void operator()(std::size_t range) const {
+      const std::size_t begin = range * grainSize;
+      (*pFunction)(begin, std::min(begin + grainSize, count));
+    }
+  };
+  const Ranges ranges{&function, count, std::max<std::size_t>(grainSize, 1)};
+  const std::size_t rangeCount =
+      (count + ranges.grainSize - 1) / ranges.grainSize;
+
+  // Each job captures two pointers' worth, which std::function stores
+  // without allocating.
+  JobCounter counter;
+  for (std::size_t range = 1; range < rangeCount; ++range) {
+    run([pRanges = &ranges, range] { (*pRanges)(range); }, &counter);
+  }
+  ranges(0);
+  wait(counter);
+}
+
+std::size_t JobSystem::jobBlockCount() {
+  std::lock_guard<std::mutex> lock(_sharedMutex);
+  return _jobBlocks.size();
+}
+
+std::size_t JobSystem::currentThreadIndex() const {
+  return t_pJobSystem == this ? t_threadIndex : _threads.size();
+}
+
+Job *JobSystem::allocateJob(Thread *pThread) {
+  if (pThread == nullptr) {
+    return new Job;
+  }
+  if (pThread->freeJobs.empty()) {
+    for (Job *pJob = pThread->returnedJobs.exchange(
+             nullptr, std::memory_order_acquire);
+         pJob != nullptr; pJob = pJob->pNextReturned) {
+      pThread->freeJobs.push_back(pJob);
+    }
+  }
+  if (pThread->freeJobs.empty()) {
+    auto pBlock = std::make_unique<Job[]>(kJobBlockSize);
+    for (std::size_t i = 0; i < kJobBlockSize; ++i) {
+      pBlock[i].pooled = true;
+      pBlock[i].owner = pThread->index;
+      pThread->freeJobs.push_back(&pBlock[i]);
+    }
+    std::lock_guard<std::mutex> lock(_sharedMutex);
+    _jobBlocks.push_back(std::move(pBlock));
+  }
+  Job *pJob = pThread->freeJobs.back();
+  pThread->freeJobs.pop_back();
+  return pJob;
+}
+
+void JobSystem::freeJob(Thread *pThread, Job *pJob) {
+  if (!pJob->pooled) {
+    delete pJob;
+    return;
+  }
+  // Drop the captures now rather than when the slot is reused.
+  pJob->function = nullptr;
+  if (pJob->owner == pThread->index) {
+    pThread->freeJobs.push_back(pJob);
+    return;
+  }
+  // Back to the thread that allocated it, or submitting threads would keep
+  // carving new blocks while the pools of the threads running their jobs
+  // grew without bound.
+  std::atomic<Job *> &returnedJobs = _threads[pJob->owner]->returnedJobs;
+  pJob->pNextReturned = returnedJobs.load(std::memory_order_relaxed);
+  while (!returnedJobs.compare_exchange_weak(pJob->pNextReturned, pJob,
+                                             std::memory_order_release,
+                                             std::memory_order_relaxed)) {
+  }
+}
+
+void JobSystem::schedule(Thread *pThread, Job *pJob) {
+  if (pJob->affinity == JobAffinity::MainThread) {
+    std::lock_guard<std::mutex> lock(_mainThreadMutex);
+    _mainThreadJobs.push_back(pJob);
+    _hasMainThreadJobs.store(true);
+  } else if (pThread != nullptr) {
+    pThread->jobs.push(pJob);
+  } else {
+    std::lock_guard<std::mutex> lock(_sharedMutex);
+    _sharedJobs.push_back(pJob);
+    _hasSharedJobs.store(true);
+  }
+  wake();
+}
+
+void JobSystem::execute(Thread *pThread, Job *pJob) {
+  pJob->function();
+  JobCounter *pCounter = pJob->pCounter;
+  freeJob(pThread, pJob);
+  if (pCounter != nullptr) {
+    finish(pThread, pCounter);
+  }
+}
+
+void JobSystem::finish(Thread *pThread, JobCounter *pCounter) {
+  std::uint32_t value = pCounter->_value.load(std::memory_order_relaxed);
+  while (value > 1) {
+    if (pCounter->_value.compare_exchange_weak(value, value - 1)) {
+      return;
+    }
+  }
+
+  // Possibly the last job: a waiter may destroy the counter as soon as it
+  // reads zero, so that decrement happens under the mutex wait() takes.
+  std::vector<Job *> readyJobs;
+  {
+    std::lock_guard<std::mutex> lock(pCounter->_mutex);
+    if (pCounter->_value.fetch_sub(1) != 1) {
+      return;
+    }
+    readyJobs.swap(pCounter->_waitingJobs);
+  }
+  for (Job *pJob : readyJobs) {
+    schedule(pThread, pJob);
+  }
+  wake();
+}
+
+Job *JobSystem::findJob(Thread *pThread) {
+  Job *pJob = nullptr;
+  if (pThread->jobs.pop(pJob)) {
+    return pJob;
+  }
+  if (_hasSharedJobs.load(std::memory_order_relaxed)) {
+    std::lock_guard<std::mutex> lock(_sharedMutex);
+    if (!_sharedJobs.empty()) {
+      pJob = _sharedJobs.front();
+      _sharedJobs.pop_front();
+      _hasSharedJobs.store(!_sharedJobs.empty(), std::memory_order_relaxed);
+      return pJob;
+    }
+  }
+
+  // Start at a random victim so thieves spread out.
+  const std::size_t threadCount = _threads.size();
+  std::uint32_t &random = pThread->random;
+  random ^= random << 13;
+  random ^= random >> 17;
+  random ^= random << 5;
+  const std::size_t first = random % threadCount;
+  for (std::size_t i = 0; i < threadCount; ++i) {
+    const std::size_t victim = (first + i) % threadCount;
+    if (victim != pThread->index && _threads[victim]->jobs.steal(pJob)) {
+      return pJob;
+    }
+  }
+  return nullptr;
+}
+
+bool JobSystem::runMainThreadJob() {
+  if (!_hasMainThreadJobs.load(std::memory_order_relaxed)) {
+    return false;
+  }
+  Job *pJob = nullptr;
+  {
+    std::lock_guard<std::mutex> lock(_mainThreadMutex);
+    if (_mainThreadJobs.empty()) {
+      return false;
+    }
+    pJob = _mainThreadJobs.front();
+    _mainThreadJobs.pop_front();
+    _hasMainThreadJobs.store(!_mainThreadJobs.empty(),
+                             std::memory_order_relaxed);
+  }
+  execute(_threads[0].get(), pJob);
+  return true;
+}
+
+void JobSystem::sleep(Thread *pThread, const JobCounter *pCounter) {
+  std::unique_lock<std::mutex> lock(_sleepMutex);
+  // Announced before the checks below; a thread that makes one of them true
+  // afterwards is then guaranteed to see it and wake us.
+  _sleepingThreads.fetch_add(1);
+  std::atomic_thread_fence(std::memory_order_seq_cst);
+  _wakeUp.wait(lock, [&] {
+    if (_stopping || (pCounter != nullptr && pCounter->done())) {
+      return true;
+    }
+    if (pThread == nullptr) {
+      return false;
+    }
+    return hasQueuedJobs() ||
+           (pThread->index == 0 && _hasMainThreadJobs.load());
+  });
+  _sleepingThreads.fetch_sub(1);
+}
+
+void JobSystem::wake() {
+  // Pairs with the increment in sleep(): either the sleeper sees our work or
+  // we see the sleeper.
+  std::atomic_thread_fence(std::memory_order_seq_cst);
+  if (_sleepingThreads.load(std::memory_order_relaxed) == 0) {
+    return;
+  }
+  {
+    std::lock_guard<std::mutex> lock(_sleepMutex);
+  }
+  // All of them: a sleeper waiting on a counter can't take a job for the
+  // thread that could.
+  _wakeUp.notify_all();
+}
+
+bool JobSystem::hasQueuedJobs() const {
+  if (_hasSharedJobs.load()) {
+    return true;
+  }
+  return std::any_of(_threads.begin(), _threads.end(),
+                     [](const std::unique_ptr<Thread> &pThread) {
+                       return pThread->jobs.size() > 0;
+                     });
+}
+
+void JobSystem::workerMain(std::size_t index) {
+  t_pJobSystem = this;
+  t_threadIndex = index;
+  Thread *pThread = _threads[index].get();
+  int spins = 0;
+  for (;;) {
+    if (Job *pJob = findJob(pThread)) {
+      execute(pThread, pJob);
+      spins = 0;
+      continue;
+    }
+    if (++spins < kSpinCount) {
+      std::this_thread::yield();
+      continue;
+    }
+    sleep(pThread, nullptr);
+    std::lock_guard<std::mutex> lock(_sleepMutex);
+    if (_stopping) {
+      return;
+    }
+    spins = 0;
+  }
+}
+
+JobSystem::Thread *JobSystem::currentThread() const {
+  return t_pJobSystem == this ? _threads[t_threadIndex].get() : nullptr;
+}
+
+}  // namespace Gfx
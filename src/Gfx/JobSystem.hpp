@@ -0,0 +1,150 @@
+#pragma once
+
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <utility>
+#include <vector>
+
+namespace Gfx {
+
+class JobSystem;
+
+namespace Detail {
+struct Job;
+}  // namespace Detail
+
+// Counts the unfinished jobs of a group. Every job run with a counter
+// increments it when submitted and decrements it when it returns, so a job
+// group is done once its counter is back at zero. Jobs can be made to wait
+// for a counter instead of running as soon as they are submitted.
+//
+// A counter must outlive the jobs that count into or wait for it.
+class JobCounter {
+ public:
+  JobCounter() = default;
+  JobCounter(const JobCounter &) = delete;
+  JobCounter &operator=(const JobCounter &) = delete;
+
+  [[nodiscard]] bool done() const {
+    return _value.load(std::memory_order_seq_cst) == 0;
+  }
+
+ private:
+  friend class JobSystem;
+
+  std::atomic<std::uint32_t> _value = 0;
+  // Jobs submitted with this counter as their dependency while it was
+  // nonzero; scheduled by whoever brings it to zero.
+  std::mutex _mutex;
+  std::vector<Detail::Job *> _waitingJobs;
+};
+
+enum class JobAffinity : std::uint8_t {
+  // Runs on whichever thread gets to it first.
+  Any,
+  // Runs only on the main thread, inside wait() or runMainThreadJobs(). For
+  // work that has to stay on the thread AppKit calls the app on.
+  MainThread,
+};
+
+// Work-stealing job scheduler. Every thread owns a Chase-Lev deque: it pushes
+// and pops its own jobs at one end while idle threads steal from the other.
+// The thread that creates the JobSystem is its main thread and takes part
+// only while it waits; the others are owned by the system and sleep when
+// there is no work.
+//
+// Jobs may submit more jobs and wait for counters themselves. Waiting never
+// blocks a worker while there is something it can run instead. Threads that
+// don't belong to the system may submit jobs too, through a shared queue.
+//
+// A thread can be the main thread of only one JobSystem at a time. Every job
+// has to have finished before the system is destroyed.
+class JobSystem {
+ public:
+  using JobFunction = std::function<void()>;
+  using RangeFunction =
+      std::function<void(std::size_t begin, std::size_t end)>;
+
+  // threadCount includes the main thread; 0 uses one per hardware thread.
+  explicit JobSystem(std::size_t threadCount = 0);
+  ~JobSystem();
+
+  JobSystem(const JobSystem &) = delete;
+  JobSystem &operator=(const JobSystem &) = delete;
+
+  // Runs function once pDependency (if any) is at zero. pCounter (if any)
+  // counts the job until it has returned.
+  void run(JobFunction function, JobCounter *pCounter = nullptr,
+           JobCounter *pDependency = nullptr,
+           JobAffinity affinity = JobAffinity::Any);
+  void runOnMainThread(JobFunction function, JobCounter *pCounter = nullptr,
+                       JobCounter *pDependency = nullptr) {
+    run(std::move(function), pCounter, pDependency, JobAffinity::MainThread);
+  }
+
+  // Runs jobs until counter is at zero. Only the main thread runs
+  // main-thread jobs; threads outside the system just sleep.
+  void wait(JobCounter &counter);
+
+  // Runs the queued main-thread jobs whose dependencies are met. Main thread
+  // only.
+  void runMainThreadJobs();
+
+  // Calls function on [0, count) split into ranges of about grainSize, in
+  // parallel, and returns once all of them have returned.
+  void parallelFor(std::size_t count, std::size_t grainSize,
+                   const RangeFunction &function);
+
+  [[nodiscard]] std::size_t threadCount() const { return _threads.size(); }
+  // Index of the calling thread in [0, threadCount()): 0 is the main thread.
+  // Returns threadCount() on threads that don't belong to this system.
+  [[nodiscard]] std::size_t currentThreadIndex() const;
+  // Blocks of job records allocated so far. Finished jobs go back to the
+  // pool of the thread that submitted them, so this stops growing once the
+  // pools cover the most jobs ever in flight.
+  [[nodiscard]] std::size_t jobBlockCount();
+
+ private:
+  struct Thread;
+
+  Detail::Job *allocateJob(Thread *pThread);
+  void freeJob(Thread *pThread, Detail::Job *pJob);
+  void schedule(Thread *pThread, Detail::Job *pJob);
+  void execute(Thread *pThread, Detail::Job *pJob);
+  void finish(Thread *pThread, JobCounter *pCounter);
+  Detail::Job *findJob(Thread *pThread);
+  bool runMainThreadJob();
+  void sleep(Thread *pThread, const JobCounter *pCounter);
+  void wake();
+  [[nodiscard]] bool hasQueuedJobs() const;
+  void workerMain(std::size_t index);
+  [[nodiscard]] Thread *currentThread() const;
+
+  std::vector<std::unique_ptr<Thread>> _threads;
+
+  // Jobs submitted from threads outside the system, and the storage every
+  // thread's job pool is carved from.
+  std::mutex _sharedMutex;
+  std::deque<Detail::Job *> _sharedJobs;
+  std::atomic<bool> _hasSharedJobs = false;
+  std::vector<std::unique_ptr<Detail::Job[]>> _jobBlocks;
+
+  std::mutex _mainThreadMutex;
+  std::deque<Detail::Job *> _mainThreadJobs;
+  std::atomic<bool> _hasMainThreadJobs = false;
+
+  // Threads sleep once they find nothing to run; whoever makes work available
+  // (or brings a counter to zero) wakes them if any are asleep.
+  std::mutex _sleepMutex;
+  std::condition_variable _wakeUp;
+  std::atomic<std::size_t> _sleepingThreads = 0;
+  bool _stopping = false;
+};
+
+}  // namespace Gfx
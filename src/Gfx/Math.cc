@@ -0,0 +1,568 @@
+#include <Gfx/Math.hpp>
+
+#if GFX_MATH_SSE && (defined(__GNUC__) || defined(__clang__))
+#define GFX_MATH_AVX2 1
+#include <immintrin.h>
+#endif
+
+namespace Gfx {
+
+Float4x4 Float4x4::rotation(const PackedFloat3 &axis, float angle) {
+  const float c = std::cos(angle);
+  const float s = std::sin(angle);
+  const float t = 1.0F - c;
+  const float x = axis.x;
+  const float y = axis.y;
+  const float z = axis.z;
+  return {{{t * x * x + c, t * x * y + s * z, t * x * z - s * y, 0.0F},
+           {t * x * y - s * z, t * y * y + c, t * y * z + s * x, 0.0F},
+           {t * x * z + s * y, t * y * z - s * x, t * z * z + c, 0.0F},
+           {0.0F, 0.0F, 0.0F, 1.0F}}};
+}
+
+Float4x4 Float4x4::transposed() const {
+  const Float4 t0 = shuffle<0, 1, 0, 1>(columns[0], columns[1]);
+  const Float4 t1 = shuffle<2, 3, 2, 3>(columns[0], columns[1]);
+  const Float4 t2 = shuffle<0, 1, 0, 1>(columns[2], columns[3]);
+  const Float4 t3 = shuffle<2, 3, 2, 3>(columns[2], columns[3]);
+  return {{shuffle<0, 2, 0, 2>(t0, t2), shuffle<1, 3, 1, 3>(t0, t2),
+           shuffle<0, 2, 0, 2>(t1, t3), shuffle<1, 3, 1, 3>(t1, t3)}};
+}
+
+namespace {
+
+// 2x2 matrices held in one Float4 as (m00, m01, m10, m11).
+Float4 mat2Multiply(Float4 lhs, Float4 rhs) {
+  return lhs * swizzle<0, 3, 0, 3>(rhs) +
+         swizzle<1, 0, 3, 2>(lhs) * swizzle<2, 1, 2, 1>(rhs);
+}
+
+// adjugate(lhs) * rhs
+Float4 mat2AdjugateMultiply(Float4 lhs, Float4 rhs) {
+  return swizzle<3, 3, 0, 0>(lhs) * rhs -
+         swizzle<1, 1, 2, 2>(lhs) * swizzle<2, 3, 0, 1>(rhs);
+}
+
+// lhs * adjugate(rhs)
+Float4 mat2MultiplyAdjugate(Float4 lhs, Float4 rhs) {
+  return lhs * swizzle<3, 0, 3, 0>(rhs) -
+         swizzle<1, 0, 3, 2>(lhs) * swizzle<2, 1, 2, 1>(rhs);
+}
+
+}  // namespace
+
+// Block-wise inverse over the four 2x2 sub-matrices,
+//   M = | A B |   inverse(M) = 1/|M| | X# Y# |
+//       | C D |                      | Z# W# |
+// with X = |D|A - B(D#C), W = |A|D - C(A#B), Y = |B|C - D(A#B)#,
+// Z = |C|B - A(D#C)# and |M| = |A||D| + |B||C| - tr((A#B)(D#C)), where #
+// is the adjugate. Written for rows; applied to columns it computes the
+// transposed inverse of the transpose, which is the same thing.
+Float4x4 Float4x4::inverse() const {
+  const Float4 a = shuffle<0, 1, 0, 1>(columns[0], columns[1]);
+  const Float4 b = shuffle<2, 3, 2, 3>(columns[0], columns[1]);
+  const Float4 c = shuffle<0, 1, 0, 1>(columns[2], columns[3]);
+  const Float4 d = shuffle<2, 3, 2, 3>(columns[2], columns[3]);
+
+  // (|A|, |B|, |C|, |D|)
+  const Float4 determinants =
+      shuffle<0, 2, 0, 2>(columns[0], columns[2]) *
+          shuffle<1, 3, 1, 3>(columns[1], columns[3]) -
+      shuffle<1, 3, 1, 3>(columns[0], columns[2]) *
+          shuffle<0, 2, 0, 2>(columns[1], columns[3]);
+  const Float4 detA = swizzle<0, 0, 0, 0>(determinants);
+  const Float4 detB = swizzle<1, 1, 1, 1>(determinants);
+  const Float4 detC = swizzle<2, 2, 2, 2>(determinants);
+  const Float4 detD = swizzle<3, 3, 3, 3>(determinants);
+
+  const Float4 dc = mat2AdjugateMultiply(d, c);
+  const Float4 ab = mat2AdjugateMultiply(a, b);
+  Float4 x = detD * a - mat2Multiply(b, dc);
+  Float4 w = detA * d - mat2Multiply(c, ab);
+  Float4 y = detB * c - mat2MultiplyAdjugate(d, ab);
+  Float4 z = detC * b - mat2MultiplyAdjugate(a, dc);
+
+  Float4 trace = ab * swizzle<0, 2, 1, 3>(dc);
+  trace = trace + swizzle<1, 0, 3, 2>(trace);
+  trace = trace + swizzle<2, 3, 0, 1>(trace);
+  const Float4 determinant = detA * detD + detB * detC - trace;
+  const Float4 reciprocal =
+      Float4(1.0F, -1.0F, -1.0F, 1.0F) / determinant;
+  x = x * reciprocal;
+  y = y * reciprocal;
+  z = z * reciprocal;
+  w = w * reciprocal;
+
+  return {{shuffle<3, 1, 3, 1>(x, y), shuffle<2, 0, 2, 0>(x, y),
+           shuffle<3, 1, 3, 1>(z, w), shuffle<2, 0, 2, 0>(z, w)}};
+}
+
+Float4x4 Float4x4::affineInverse() const {
+  // The rows of the inverse 3x3 part are the cross products of its columns
+  // over the determinant.
+  const Float4 row0 = cross3(columns[1], columns[2]);
+  const Float4 row1 = cross3(columns[2], columns[0]);
+  const Float4 row2 = cross3(columns[0], columns[1]);
+  const Float4 reciprocal = Float4::splat(1.0F / dot3(columns[0], row0));
+  const Float4x4 rows{{row0 * reciprocal, row1 * reciprocal,
+                       row2 * reciprocal, {0.0F, 0.0F, 0.0F, 1.0F}}};
+  Float4x4 result = rows.transposed();
+  result.columns[3] = -result.transformVector(columns[3]) +
+                      Float4(0.0F, 0.0F, 0.0F, 1.0F);
+  return result;
+}
+
+namespace {
+
+struct Kernels {
+  void (*transformPoints)(const Float4x4 &, const PackedFloat3 *,
+                          PackedFloat3 *, std::size_t);
+  void (*multiplyMatrices)(const Float4x4 *, const Float4x4 *, Float4x4 *,
+                           std::size_t);
+  void (*invertMatrices)(const Float4x4 *, Float4x4 *, std::size_t);
+};
+
+// One float at a time, as a baseline for the vector kernels.
+namespace Scalar {
+
+void load(const Float4x4 &matrix, float (&values)[16]) {
+  for (int i = 0; i < 4; ++i) {
+    matrix.columns[i].store(values + i * 4);
+  }
+}
+
+Float4x4 store(const float (&values)[16]) {
+  return {{Float4::load(values), Float4::load(values + 4),
+           Float4::load(values + 8), Float4::load(values + 12)}};
+}
+
+void transformPoints(const Float4x4 &matrix, const PackedFloat3 *pIn,
+                     PackedFloat3 *pOut, std::size_t count) {
+  float m[16];
+  load(matrix, m);
+  for (std::size_t i = 0; i < count; ++i) {
+    const PackedFloat3 p = pIn[i];
+    pOut[i] = {m[0] * p.x + m[4] * p.y + m[8] * p.z + m[12],
+               m[1] * p.x + m[5] * p.y + m[9] * p.z + m[13],
+               m[2] * p.x + m[6] * p.y + m[10] * p.z + m[14]};
+  }
+}
+
+void multiplyMatrices(const Float4x4 *pLhs, const Float4x4 *pRhs,
+                      Float4x4 *pOut, std::size_t count) {
+  for (std::size_t i = 0; i < count; ++i) {
+    float a[16];
+    float b[16];
+    float r[16];
+    load(pLhs[i], a);
+    load(pRhs[i], b);
+    for (int column = 0; column < 4; ++column) {
+      for (int row = 0; row < 4; ++row) {
+        float sum = 0.0F;
+        for (int k = 0; k < 4; ++k) {
+          sum += a[k * 4 + row] * b[column * 4 + k];
+        }
+        r[column * 4 + row] = sum;
+      }
+    }
+    pOut[i] = store(r);
+  }
+}
+
+// Cofactor expansion over 2x2 minors.
+void invertMatrices(const Float4x4 *pIn, Float4x4 *pOut, std::size_t count) {
+  for (std::size_t i = 0; i < count; ++i) {
+    float m[16];
+    load(pIn[i], m);
+    const float s0 = m[0] * m[5] - m[4] * m[1];
+    const float s1 = m[0] * m[6] - m[4] * m[2];
+    const float s2 = m[0] * m[7] - m[4] * m[3];
+    const float s3 = m[1] * m[6] - m[5] * m[2];
+    const float s4 = m[1] * m[7] - m[5] * m[3];
+    const float s5 = m[2] * m[7] - m[6] * m[3];
+    const float c5 = m[10] * m[15] - m[14] * m[11];
+    const float c4 = m[9] * m[15] - m[13] * m[11];
+    const float c3 = m[9] * m[14] - m[13] * m[10];
+    const float c2 = m[8] * m[15] - m[12] * m[11];
+    const float c1 = m[8] * m[14] - m[12] * m[10];
+    const float c0 = m[8] * m[13] - m[12] * m[9];
+    const float inv = 1.0F / (s0 * c5 - s1 * c4 + s2 * c3 + s3 * c2 -
+                              s4 * c1 + s5 * c0);
+    const float r[16] = {
+        (m[5] * c5 - m[6] * c4 + m[7] * c3) * inv,
+        (-m[1] * c5 + m[2] * c4 - m[3] * c3) * inv,
+        (m[13] * s5 - m[14] * s4 + m[15] * s3) * inv,
+        (-m[9] * s5 + m[10] * s4 - m[11] * s3) * inv,
+        (-m[4] * c5 + m[6] * c2 - m[7] * c1) * inv,
+        (m[0] * c5 - m[2] * c2 + m[3] * c1) * inv,
+        (-m[12] * s5 + m[14] * s2 - m[15] * s1) * inv,
+        (m[8] * s5 - m[10] * s2 + m[11] * s1) * inv,
+        (m[4] * c4 - m[5] * c2 + m[7] * c0) * inv,
+        (-m[0] * c4 + m[1] * c2 - m[3] * c0) * inv,
+        (m[12] * s4 - m[13] * s2 + m[15] * s0) * inv,
+        (-m[8] * s4 + m[9] * s2 - m[11] * s0) * inv,
+        (-m[4] * c3 + m[5] * c1 - m[6] * c0) * inv,
+        (m[0] * c3 - m[1] * c1 + m[2] * c0) * inv,
+        (-m[12] * s3 + m[13] * s1 - m[14] * s0) * inv,
+        (m[8] * s3 - m[9] * s1 + m[10] * s0) * inv,
+    };
+    pOut[i] = store(r);
+  }
+}
+
+constexpr Kernels kKernels{transformPoints, multiplyMatrices, invertMatrices};
+
+}  // namespace Scalar
+
+// Float4 kernels: SSE on x86-64, NEON on arm64.
+namespace Vector {
+
+void transformPoint(const Float4x4 &matrix, const PackedFloat3 &in,
+                    PackedFloat3 &out) {
+  out = matrix.transformPoint(Float4::fromPacked(in, 1.0F)).toPacked();
+}
+
+void transformPoints(const Float4x4 &matrix, const PackedFloat3 *pIn,
+                     PackedFloat3 *pOut, std::size_t count) {
+  std::size_t i = 0;
+#if GFX_MATH_SSE
+  const auto broadcast = [&matrix](int column, int row) {
+    return _mm_set1_ps(matrix.columns[column][row]);
+  };
+  const __m128 m[4][3] = {
+      {broadcast(0, 0), broadcast(0, 1), broadcast(0, 2)},
+      {broadcast(1, 0), broadcast(1, 1), broadcast(1, 2)},
+      {broadcast(2, 0), broadcast(2, 1), broadcast(2, 2)},
+      {broadcast(3, 0), broadcast(3, 1), broadcast(3, 2)},
+  };
+  for (; i + 4 <= count; i += 4) {
+    // Four points are three registers: transpose them to x, y and z, and the
+    // results back.
+    const auto *pSource = reinterpret_cast<const float *>(pIn + i);
+    const __m128 a = _mm_loadu_ps(pSource);      // x0 y0 z0 x1
+    const __m128 b = _mm_loadu_ps(pSource + 4);  // y1 z1 x2 y2
+    const __m128 c = _mm_loadu_ps(pSource + 8);  // z2 x3 y3 z3
+    const __m128 x =
+        _mm_shuffle_ps(a, _mm_shuffle_ps(b, c, _MM_SHUFFLE(1, 1, 2, 2)),
+                       _MM_SHUFFLE(2, 0, 3, 0));
+    const __m128 y =
+        _mm_shuffle_ps(_mm_shuffle_ps(a, b, _MM_SHUFFLE(0, 0, 1, 1)),
+                       _mm_shuffle_ps(b, c, _MM_SHUFFLE(2, 2, 3, 3)),
+                       _MM_SHUFFLE(2, 0, 2, 0));
+    const __m128 z =
+        _mm_shuffle_ps(_mm_shuffle_ps(a, b, _MM_SHUFFLE(1, 1, 2, 2)),
+                       _mm_shuffle_ps(c, c, _MM_SHUFFLE(3, 3, 0, 0)),
+                       _MM_SHUFFLE(2, 0, 2, 0));
+
+    __m128 o[3];
+    for (int row = 0; row < 3; ++row) {
+      o[row] = _mm_add_ps(
+          _mm_add_ps(_mm_mul_ps(m[0][row], x), _mm_mul_ps(m[1][row], y)),
+          _mm_add_ps(_mm_mul_ps(m[2][row], z), m[3][row]));
+    }
+
+    auto *pTarget = reinterpret_cast<float *>(pOut + i);
+    _mm_storeu_ps(
+        pTarget,
+        _mm_shuffle_ps(_mm_shuffle_ps(o[0], o[1], _MM_SHUFFLE(0, 0, 0, 0)),
+                       _mm_shuffle_ps(o[2], o[0], _MM_SHUFFLE(1, 1, 0, 0)),
+                       _MM_SHUFFLE(2, 0, 2, 0)));
+    _mm_storeu_ps(
+        pTarget + 4,
+        _mm_shuffle_ps(_mm_shuffle_ps(o[1], o[2], _MM_SHUFFLE(1, 1, 1, 1)),
+                       _mm_shuffle_ps(o[0], o[1], _MM_SHUFFLE(2, 2, 2, 2)),
+                       _MM_SHUFFLE(2, 0, 2, 0)));
+    _mm_storeu_ps(
+        pTarget + 8,
+        _mm_shuffle_ps(_mm_shuffle_ps(o[2], o[0], _MM_SHUFFLE(3, 3, 2, 2)),
+                       _mm_shuffle_ps(o[1], o[2], _MM_SHUFFLE(3, 3, 3, 3)),
+                       _MM_SHUFFLE(2, 0, 2, 0)));
+  }
+#elif GFX_MATH_NEON
+  // vld3q/vst3q transpose four points to x, y and z and back.
+  const float32x4_t c0 = matrix.columns[0].native();
+  const float32x4_t c1 = matrix.columns[1].native();
+  const float32x4_t c2 = matrix.columns[2].native();
+  const float32x4_t c3 = matrix.columns[3].native();
+  for (; i + 4 <= count; i += 4) {
+    const float32x4x3_t p =
+        vld3q_f32(reinterpret_cast<const float *>(pIn + i));
+    float32x4x3_t o;
+    o.val[0] = vdupq_laneq_f32(c3, 0);
+    o.val[0] = vfmaq_laneq_f32(o.val[0], p.val[0], c0, 0);
+    o.val[0] = vfmaq_laneq_f32(o.val[0], p.val[1], c1, 0);
+    o.val[0] = vfmaq_laneq_f32(o.val[0], p.val[2], c2, 0);
+    o.val[1] = vdupq_laneq_f32(c3, 1);
+    o.val[1] = vfmaq_laneq_f32(o.val[1], p.val[0], c0, 1);
+    o.val[1] = vfmaq_laneq_f32(o.val[1], p.val[1], c1, 1);
+    o.val[1] = vfmaq_laneq_f32(o.val[1], p.val[2], c2, 1);
+    o.val[2] = vdupq_laneq_f32(c3, 2);
+    o.val[2] = vfmaq_laneq_f32(o.val[2], p.val[0], c0, 2);
+    o.val[2] = vfmaq_laneq_f32(o.val[2], p.val[1], c1, 2);
+    o.val[2] = vfmaq_laneq_f32(o.val[2], p.val[2], c2, 2);
+    vst3q_f32(reinterpret_cast<float *>(pOut + i), o);
+  }
+#endif
+  for (; i < count; ++i) {
+    transformPoint(matrix, pIn[i], pOut[i]);
+  }
+}
+
+void multiplyMatrices(const Float4x4 *pLhs, const Float4x4 *pRhs,
+                      Float4x4 *pOut, std::size_t count) {
+  for (std::size_t i = 0; i < count; ++i) {
+    pOut[i] = pLhs[i] * pRhs[i];
+  }
+}
+
+void invertMatrices(const Float4x4 *pIn, Float4x4 *pOut, std::size_t count) {
+  for (std::size_t i = 0; i < count; ++i) {
+    pOut[i] = pIn[i].inverse();
+  }
+}
+
+constexpr Kernels kKernels{transformPoints, multiplyMatrices, invertMatrices};
+
+}  // namespace Vector
+
+#if GFX_MATH_AVX2
+// Eight points or two matrix columns per register. Compiled for AVX2 + FMA
+// regardless of the build's target and only called when the CPU has both.
+namespace Avx2 {
+
+#define GFX_MATH_AVX2_TARGET __attribute__((target("avx2,fma")))
+
+// The in-lane transpose of the SSE kernel, on both lanes at once.
+GFX_MATH_AVX2_TARGET
+void deinterleave(__m256 a, __m256 b, __m256 c, __m256 &x, __m256 &y,
+                  __m256 &z) {
+  x = _mm256_shuffle_ps(a, _mm256_shuffle_ps(b, c, _MM_SHUFFLE(1, 1, 2, 2)),
+                        _MM_SHUFFLE(2, 0, 3, 0));
+  y = _mm256_shuffle_ps(_mm256_shuffle_ps(a, b, _MM_SHUFFLE(0, 0, 1, 1)),
+                        _mm256_shuffle_ps(b, c, _MM_SHUFFLE(2, 2, 3, 3)),
+                        _MM_SHUFFLE(2, 0, 2, 0));
+  z = _mm256_shuffle_ps(_mm256_shuffle_ps(a, b, _MM_SHUFFLE(1, 1, 2, 2)),
+                        _mm256_shuffle_ps(c, c, _MM_SHUFFLE(3, 3, 0, 0)),
+                        _MM_SHUFFLE(2, 0, 2, 0));
+}
+
+GFX_MATH_AVX2_TARGET
+void interleave(__m256 x, __m256 y, __m256 z, __m256 &a, __m256 &b,
+                __m256 &c) {
+  a = _mm256_shuffle_ps(_mm256_shuffle_ps(x, y, _MM_SHUFFLE(0, 0, 0, 0)),
+                        _mm256_shuffle_ps(z, x, _MM_SHUFFLE(1, 1, 0, 0)),
+                        _MM_SHUFFLE(2, 0, 2, 0));
+  b = _mm256_shuffle_ps(_mm256_shuffle_ps(y, z, _MM_SHUFFLE(1, 1, 1, 1)),
+                        _mm256_shuffle_ps(x, y, _MM_SHUFFLE(2, 2, 2, 2)),
+                        _MM_SHUFFLE(2, 0, 2, 0));
+  c = _mm256_shuffle_ps(_mm256_shuffle_ps(z, x, _MM_SHUFFLE(3, 3, 2, 2)),
+                        _mm256_shuffle_ps(y, z, _MM_SHUFFLE(3, 3, 3, 3)),
+                        _MM_SHUFFLE(2, 0, 2, 0));
+}
+
+GFX_MATH_AVX2_TARGET
+__m256 loadLanes(const float *pLow, const float *pHigh) {
+  return _mm256_insertf128_ps(_mm256_castps128_ps256(_mm_loadu_ps(pLow)),
+                              _mm_loadu_ps(pHigh), 1);
+}
+
+GFX_MATH_AVX2_TARGET
+void storeLanes(__m256 value, float *pLow, float *pHigh) {
+  _mm_storeu_ps(pLow, _mm256_castps256_ps128(value));
+  _mm_storeu_ps(pHigh, _mm256_extractf128_ps(value, 1));
+}
+
+GFX_MATH_AVX2_TARGET
+void transformPoints(const Float4x4 &matrix, const PackedFloat3 *pIn,
+                     PackedFloat3 *pOut, std::size_t count) {
+  __m256 m[4][3];
+  for (int column = 0; column < 4; ++column) {
+    for (int row = 0; row < 3; ++row) {
+      m[column][row] = _mm256_set1_ps(matrix.columns[column][row]);
+    }
+  }
+
+  std::size_t i = 0;
+  for (; i + 8 <= count; i += 8) {
+    // Points 0-3 go to the low lanes and 4-7 to the high ones.
+    const auto *pSource = reinterpret_cast<const float *>(pIn + i);
+    __m256 x;
+    __m256 y;
+    __m256 z;
+    deinterleave(loadLanes(pSource, pSource + 12),
+                 loadLanes(pSource + 4, pSource + 16),
+                 loadLanes(pSource + 8, pSource + 20), x, y, z);
+
+    __m256 o[3];
+    for (int row = 0; row < 3; ++row) {
+      o[row] = _mm256_fmadd_ps(m[0][row], x, m[3][row]);
+      o[row] = _mm256_fmadd_ps(m[1][row], y, o[row]);
+      o[row] = _mm256_fmadd_ps(m[2][row], z, o[row]);
+    }
+
+    __m256 a;
+    __m256 b;
+    __m256 c;
+    interleave(o[0], o[1], o[2], a, b, c);
+    auto *pTarget = reinterpret_cast<float *>(pOut + i);
+    storeLanes(a, pTarget, pTarget + 12);
+    storeLanes(b, pTarget + 4, pTarget + 16);
+    storeLanes(c, pTarget + 8, pTarget + 20);
+  }
+  Vector::transformPoints(matrix, pIn + i, pOut + i, count - i);
+}
+
+// Two columns of lhs * rhs, given rhs's columns in b and lhs's columns each
+// broadcast to both lanes.
+GFX_MATH_AVX2_TARGET
+__m256 multiplyColumns(const __m256 (&a)[4], __m256 b) {
+  __m256 result = _mm256_mul_ps(a[0], _mm256_permute_ps(b, 0x00));
+  result = _mm256_fmadd_ps(a[1], _mm256_permute_ps(b, 0x55), result);
+  result = _mm256_fmadd_ps(a[2], _mm256_permute_ps(b, 0xAA), result);
+  return _mm256_fmadd_ps(a[3], _mm256_permute_ps(b, 0xFF), result);
+}
+
+GFX_MATH_AVX2_TARGET
+void multiplyMatrices(const Float4x4 *pLhs, const Float4x4 *pRhs,
+                      Float4x4 *pOut, std::size_t count) {
+  for (std::size_t i = 0; i < count; ++i) {
+    const auto *pA = reinterpret_cast<const __m128 *>(&pLhs[i]);
+    const __m256 a[4] = {_mm256_broadcast_ps(pA), _mm256_broadcast_ps(pA + 1),
+                         _mm256_broadcast_ps(pA + 2),
+                         _mm256_broadcast_ps(pA + 3)};
+    // Read both column pairs before writing; pOut may alias.
+    const auto *pB = reinterpret_cast<const float *>(&pRhs[i]);
+    const __m256 b01 = _mm256_loadu_ps(pB);
+    const __m256 b23 = _mm256_loadu_ps(pB + 8);
+    auto *pResult = reinterpret_cast<float *>(&pOut[i]);
+    _mm256_storeu_ps(pResult, multiplyColumns(a, b01));
+    _mm256_storeu_ps(pResult + 8, multiplyColumns(a, b23));
+  }
+}
+
+GFX_MATH_AVX2_TARGET
+void invertMatrices(const Float4x4 *pIn, Float4x4 *pOut, std::size_t count) {
+  // The Float4 code, re-encoded with VEX instructions.
+  for (std::size_t i = 0; i < count; ++i) {
+    pOut[i] = pIn[i].inverse();
+  }
+}
+
+#undef GFX_MATH_AVX2_TARGET
+
+constexpr Kernels kKernels{transformPoints, multiplyMatrices, invertMatrices};
+
+}  // namespace Avx2
+#endif
+
+bool cpuHasAvx2() {
+#if GFX_MATH_AVX2
+  static const bool hasAvx2 =
+      __builtin_cpu_supports("avx2") && __builtin_cpu_supports("fma");
+  return hasAvx2;
+#else
+  return false;
+#endif
+}
+
+const Kernels &kernels(SimdLevel level) {
+  switch (level) {
+#if GFX_MATH_AVX2
+    case SimdLevel::AVX2:
+      return Avx2::kKernels;
+#endif
+    case SimdLevel::SSE:
+    case SimdLevel::NEON:
+      return Vector::kKernels;
+    default:
+      return Scalar::kKernels;
+  }
+}
+
+SimdLevel bestSimdLevel() {
+#if GFX_MATH_SSE
+  return cpuHasAvx2() ? SimdLevel::AVX2 : SimdLevel::SSE;
+#elif GFX_MATH_NEON
+  return SimdLevel::NEON;
+#else
+  return SimdLevel::Scalar;
+#endif
+}
+
+SimdLevel g_simdLevel = bestSimdLevel();
+const Kernels *g_pKernels = &kernels(g_simdLevel);
+
+}  // namespace
+
+SimdLevel simdLevel() { return g_simdLevel; }
+
+bool isSimdLevelSupported(SimdLevel level) {
+  switch (level) {
+    case SimdLevel::Scalar:
+      return true;
+#if GFX_MATH_SSE
+    case SimdLevel::SSE:
+      return true;
+#elif GFX_MATH_NEON
+    case SimdLevel::NEON:
+      return true;
+#endif
+    case SimdLevel::AVX2:
+      return cpuHasAvx2();
+    default:
+      return false;
+  }
+}
+
+bool setSimdLevel(SimdLevel level) {
+  if (!isSimdLevelSupported(level)) {
+    return false;
+  }
+  g_simdLevel = level;
+  g_pKernels = &kernels(level);
+  return true;
+}
+
+const char *simdLevelName(SimdLevel level) {
+  switch (level) {
+    case SimdLevel::Scalar:
+      return "scalar";
+    case SimdLevel::SSE:
+      return "sse";
+    case SimdLevel::AVX2:
+      return "avx2";
+    case SimdLevel::NEON:
+      return "neon";
+  }
+  return "unknown";
+}
+
+void transformPoints(const Float4x4 &matrix, const PackedFloat3 *pIn,
+                     PackedFloat3 *pOut, std::size_t count) {
+  g_pKernels->transformPoints(matrix, pIn, pOut, count);
+}
+
+void multiplyMatrices(const Float4x4 *pLhs, const Float4x4 *pRhs,
+                      Float4x4 *pOut, std::size_t count) {
+  g_pKernels->multiplyMatrices(pLhs, pRhs, pOut, count);
+}
+
+void invertMatrices(const Float4x4 *pIn, Float4x4 *pOut, std::size_t count) {
+  g_pKernels->invertMatrices(pIn, pOut, count);
+}
+
+void packMatrices(const Float4x4 *pIn, PackedFloat4x3 *pOut,
+                  std::size_t count) {
+  for (std::size_t i = 0; i < count; ++i) {
+    pOut[i] = pIn[i].toPacked();
+  }
+}
+
+void unpackMatrices(const PackedFloat4x3 *pIn, Float4x4 *pOut,
+                    std::size_t count) {
+  for (std::size_t i = 0; i < count; ++i) {
+    pOut[i] = Float4x4::fromPacked(pIn[i]);
+  }
+}
+
+}  // namespace Gfx
@@ -0,0 +1,379 @@
+#pragma once
+
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <type_traits>
+
+#if defined(__SSE2__) || defined(_M_X64)
+#define GFX_MATH_SSE 1
+#include <emmintrin.h>
+#elif defined(__ARM_NEON)
+#define GFX_MATH_NEON 1
+#include <arm_neon.h>
+#endif
+
+// Vector math for CPU-side scene work. Float4 and Float4x4 live in SIMD
+// registers (SSE on x86-64, NEON on arm64, plain floats elsewhere); the bulk
+// kernels at the bottom pick the widest instruction set the CPU has at run
+// time, up to AVX2 + FMA.
+//
+// Matrices are column-major and transform column vectors, like Metal's. The
+// packed types have the exact layout of their MTL:: namesakes from
+// MTLAccelerationStructureTypes.hpp, so arrays of them can be copied straight
+// into Metal buffers; MetalBackend.hpp converts between the two.
+namespace Gfx {
+
+struct PackedFloat3 {
+  float x = 0.0F;
+  float y = 0.0F;
+  float z = 0.0F;
+};
+
+struct PackedFloat4x3 {
+  PackedFloat3 columns[4];
+};
+
+struct AxisAlignedBoundingBox {
+  // Empty: grows to fit the first point added.
+  PackedFloat3 min{INFINITY, INFINITY, INFINITY};
+  PackedFloat3 max{-INFINITY, -INFINITY, -INFINITY};
+};
+
+static_assert(sizeof(PackedFloat3) == 12 &&
+              std::is_trivially_copyable_v<PackedFloat3>);
+static_assert(sizeof(PackedFloat4x3) == 48);
+static_assert(sizeof(AxisAlignedBoundingBox) == 24);
+
+class alignas(16) Float4 {
+ public:
+#if GFX_MATH_SSE
+  using Native = __m128;
+#elif GFX_MATH_NEON
+  using Native = float32x4_t;
+#else
+  struct Native {
+    float v[4];
+  };
+#endif
+
+  Float4() : Float4(0.0F, 0.0F, 0.0F, 0.0F) {}
+  explicit Float4(Native v) : _v(v) {}
+  Float4(float x, float y, float z, float w) {
+#if GFX_MATH_SSE
+    _v = _mm_setr_ps(x, y, z, w);
+#elif GFX_MATH_NEON
+    const float values[4] = {x, y, z, w};
+    _v = vld1q_f32(values);
+#else
+    _v = {{x, y, z, w}};
+#endif
+  }
+
+  static Float4 splat(float value) {
+#if GFX_MATH_SSE
+    return Float4(_mm_set1_ps(value));
+#elif GFX_MATH_NEON
+    return Float4(vdupq_n_f32(value));
+#else
+    return {value, value, value, value};
+#endif
+  }
+  // Reads four floats from unaligned memory.
+  static Float4 load(const float *pValues) {
+#if GFX_MATH_SSE
+    return Float4(_mm_loadu_ps(pValues));
+#elif GFX_MATH_NEON
+    return Float4(vld1q_f32(pValues));
+#else
+    return {pValues[0], pValues[1], pValues[2], pValues[3]};
+#endif
+  }
+  void store(float *pValues) const {
+#if GFX_MATH_SSE
+    _mm_storeu_ps(pValues, _v);
+#elif GFX_MATH_NEON
+    vst1q_f32(pValues, _v);
+#else
+    std::memcpy(pValues, _v.v, sizeof(_v.v));
+#endif
+  }
+
+  static Float4 fromPacked(const PackedFloat3 &value, float w) {
+    return {value.x, value.y, value.z, w};
+  }
+  [[nodiscard]] PackedFloat3 toPacked() const {
+    alignas(16) float values[4];
+    store(values);
+    return {values[0], values[1], values[2]};
+  }
+
+  [[nodiscard]] float operator[](int index) const {
+    alignas(16) float values[4];
+    store(values);
+    return values[index];
+  }
+  [[nodiscard]] float x() const {
+#if GFX_MATH_SSE
+    return _mm_cvtss_f32(_v);
+#elif GFX_MATH_NEON
+    return vgetq_lane_f32(_v, 0);
+#else
+    return _v.v[0];
+#endif
+  }
+  [[nodiscard]] float y() const { return (*this)[1]; }
+  [[nodiscard]] float z() const { return (*this)[2]; }
+  [[nodiscard]] float w() const { return (*this)[3]; }
+
+  [[nodiscard]] Native native() const { return _v; }
+
+ private:
+  Native _v;
+};
+
+#if GFX_MATH_SSE
+#define GFX_MATH_FLOAT4_OP(op, sse, neon)                \
+  inline Float4 operator op(Float4 lhs, Float4 rhs) {    \
+    return Float4(sse(lhs.native(), rhs.native()));      \
+  }
+#elif GFX_MATH_NEON
+#define GFX_MATH_FLOAT4_OP(op, sse, neon)                \
+  inline Float4 operator op(Float4 lhs, Float4 rhs) {    \
+    return Float4(neon(lhs.native(), rhs.native()));     \
+  }
+#else
+#define GFX_MATH_FLOAT4_OP(op, sse, neon)                \
+  inline Float4 operator op(Float4 lhs, Float4 rhs) {    \
+    return {lhs.x() op rhs.x(), lhs.y() op rhs.y(),      \
+            lhs.z() op rhs.z(), lhs.w() op rhs.w()};     \
+  }
+#endif
+
+GFX_MATH_FLOAT4_OP(+, _mm_add_ps, vaddq_f32)
+GFX_MATH_FLOAT4_OP(-, _mm_sub_ps, vsubq_f32)
+GFX_MATH_FLOAT4_OP(*, _mm_mul_ps, vmulq_f32)
+GFX_MATH_FLOAT4_OP(/, _mm_div_ps, vdivq_f32)
+
+#undef GFX_MATH_FLOAT4_OP
+
+inline Float4 operator*(Float4 lhs, float rhs) {
+  return lhs * Float4::splat(rhs);
+}
+inline Float4 operator-(Float4 value) { return Float4() - value; }
+
+inline Float4 min(Float4 lhs, Float4 rhs) {
+#if GFX_MATH_SSE
+  return Float4(_mm_min_ps(lhs.native(), rhs.native()));
+#elif GFX_MATH_NEON
+  return Float4(vminq_f32(lhs.native(), rhs.native()));
+#else
+  return {std::fmin(lhs.x(), rhs.x()), std::fmin(lhs.y(), rhs.y()),
+          std::fmin(lhs.z(), rhs.z()), std::fmin(lhs.w(), rhs.w())};
+#endif
+}
+
+inline Float4 max(Float4 lhs, Float4 rhs) {
+#if GFX_MATH_SSE
+  return Float4(_mm_max_ps(lhs.native(), rhs.native()));
+#elif GFX_MATH_NEON
+  return Float4(vmaxq_f32(lhs.native(), rhs.native()));
+#else
+  return {std::fmax(lhs.x(), rhs.x()), std::fmax(lhs.y(), rhs.y()),
+          std::fmax(lhs.z(), rhs.z()), std::fmax(lhs.w(), rhs.w())};
+#endif
+}
+
+#if GFX_MATH_NEON
+namespace Detail {
+inline int laneMask(uint32x4_t lanes) {
+  const std::uint32_t bits[4] = {1, 2, 4, 8};
+  return static_cast<int>(vaddvq_u32(vandq_u32(lanes, vld1q_u32(bits))));
+}
+}  // namespace Detail
+#endif
+
+// Lane-wise comparisons as bit masks: bit i is set where lane i compares
+// true. Lanes holding NaN compare false.
+inline int lessMask(Float4 lhs, Float4 rhs) {
+#if GFX_MATH_SSE
+  return _mm_movemask_ps(_mm_cmplt_ps(lhs.native(), rhs.native()));
+#elif GFX_MATH_NEON
+  return Detail::laneMask(vcltq_f32(lhs.native(), rhs.native()));
+#else
+  int mask = 0;
+  for (int i = 0; i < 4; ++i) {
+    mask |= lhs[i] < rhs[i] ? 1 << i : 0;
+  }
+  return mask;
+#endif
+}
+
+inline int lessEqualMask(Float4 lhs, Float4 rhs) {
+#if GFX_MATH_SSE
+  return _mm_movemask_ps(_mm_cmple_ps(lhs.native(), rhs.native()));
+#elif GFX_MATH_NEON
+  return Detail::laneMask(vcleq_f32(lhs.native(), rhs.native()));
+#else
+  int mask = 0;
+  for (int i = 0; i < 4; ++i) {
+    mask |= lhs[i] <= rhs[i] ? 1 << i : 0;
+  }
+  return mask;
+#endif
+}
+
+// {a[X], a[Y], b[Z], b[W]}, the semantics of _mm_shuffle_ps.
+template <int X, int Y, int Z, int W>
+inline Float4 shuffle(Float4 a, Float4 b) {
+#if GFX_MATH_SSE
+  return Float4(
+      _mm_shuffle_ps(a.native(), b.native(), _MM_SHUFFLE(W, Z, Y, X)));
+#elif GFX_MATH_NEON && defined(__clang__)
+  return Float4(__builtin_shufflevector(a.native(), b.native(), X, Y, Z + 4,
+                                        W + 4));
+#else
+  return {a[X], a[Y], b[Z], b[W]};
+#endif
+}
+
+template <int X, int Y, int Z, int W>
+inline Float4 swizzle(Float4 value) {
+  return shuffle<X, Y, Z, W>(value, value);
+}
+
+inline float dot3(Float4 lhs, Float4 rhs) {
+  const Float4 product = lhs * rhs;
+  return product.x() + product.y() + product.z();
+}
+
+// Cross product of the xyz parts; w is 0 for finite inputs.
+inline Float4 cross3(Float4 lhs, Float4 rhs) {
+  const Float4 result = lhs * swizzle<1, 2, 0, 3>(rhs) -
+                        swizzle<1, 2, 0, 3>(lhs) * rhs;
+  return swizzle<1, 2, 0, 3>(result);
+}
+
+struct Float4x4 {
+  static Float4x4 identity() {
+    return {{{1.0F, 0.0F, 0.0F, 0.0F},
+             {0.0F, 1.0F, 0.0F, 0.0F},
+             {0.0F, 0.0F, 1.0F, 0.0F},
+             {0.0F, 0.0F, 0.0F, 1.0F}}};
+  }
+  static Float4x4 translation(float x, float y, float z) {
+    Float4x4 result = identity();
+    result.columns[3] = {x, y, z, 1.0F};
+    return result;
+  }
+  static Float4x4 scale(float x, float y, float z) {
+    return {{{x, 0.0F, 0.0F, 0.0F},
+             {0.0F, y, 0.0F, 0.0F},
+             {0.0F, 0.0F, z, 0.0F},
+             {0.0F, 0.0F, 0.0F, 1.0F}}};
+  }
+  // Right-handed rotation by angle radians about a unit axis.
+  static Float4x4 rotation(const PackedFloat3 &axis, float angle);
+
+  // The last row of a packed matrix is implicitly (0, 0, 0, 1).
+  static Float4x4 fromPacked(const PackedFloat4x3 &matrix) {
+    return {{Float4::fromPacked(matrix.columns[0], 0.0F),
+             Float4::fromPacked(matrix.columns[1], 0.0F),
+             Float4::fromPacked(matrix.columns[2], 0.0F),
+             Float4::fromPacked(matrix.columns[3], 1.0F)}};
+  }
+  // Drops the last row, so the round trip is exact for affine matrices.
+  [[nodiscard]] PackedFloat4x3 toPacked() const {
+    return {{columns[0].toPacked(), columns[1].toPacked(),
+             columns[2].toPacked(), columns[3].toPacked()}};
+  }
+
+  [[nodiscard]] Float4 transformPoint(Float4 point) const {
+    return columns[0] * swizzle<0, 0, 0, 0>(point) +
+           columns[1] * swizzle<1, 1, 1, 1>(point) +
+           columns[2] * swizzle<2, 2, 2, 2>(point) + columns[3];
+  }
+  [[nodiscard]] Float4 transformVector(Float4 vector) const {
+    return columns[0] * swizzle<0, 0, 0, 0>(vector) +
+           columns[1] * swizzle<1, 1, 1, 1>(vector) +
+           columns[2] * swizzle<2, 2, 2, 2>(vector);
+  }
+
+  [[nodiscard]] Float4x4 transposed() const;
+  // General inverse. Singular matrices give infinities and NaNs.
+  [[nodiscard]] Float4x4 inverse() const;
+  // Inverse of a matrix whose last row is (0, 0, 0, 1); cheaper than
+  // inverse().
+  [[nodiscard]] Float4x4 affineInverse() const;
+
+  Float4 columns[4];
+};
+
+inline Float4 operator*(const Float4x4 &matrix, Float4 vector) {
+  return matrix.columns[0] * swizzle<0, 0, 0, 0>(vector) +
+         matrix.columns[1] * swizzle<1, 1, 1, 1>(vector) +
+         matrix.columns[2] * swizzle<2, 2, 2, 2>(vector) +
+         matrix.columns[3] * swizzle<3, 3, 3, 3>(vector);
+}
+
+inline Float4x4 operator*(const Float4x4 &lhs, const Float4x4 &rhs) {
+  return {{lhs * rhs.columns[0], lhs * rhs.columns[1], lhs * rhs.columns[2],
+           lhs * rhs.columns[3]}};
+}
+
+// Bounds of the transformed corners of box, without transforming all eight
+// (Arvo, "Transforming Axis-Aligned Bounding Boxes", Graphics Gems 1990).
+inline AxisAlignedBoundingBox transformBounds(
+    const Float4x4 &matrix, const AxisAlignedBoundingBox &box) {
+  Float4 lower = matrix.columns[3];
+  Float4 upper = matrix.columns[3];
+  const Float4 boxMin = Float4::fromPacked(box.min, 0.0F);
+  const Float4 boxMax = Float4::fromPacked(box.max, 0.0F);
+  const Float4 axes[3] = {swizzle<0, 0, 0, 0>(boxMin),
+                          swizzle<1, 1, 1, 1>(boxMin),
+                          swizzle<2, 2, 2, 2>(boxMin)};
+  const Float4 axesMax[3] = {swizzle<0, 0, 0, 0>(boxMax),
+                             swizzle<1, 1, 1, 1>(boxMax),
+                             swizzle<2, 2, 2, 2>(boxMax)};
+  for (int i = 0; i < 3; ++i) {
+    const Float4 a = matrix.columns[i] * axes[i];
+    const Float4 b = matrix.columns[i] * axesMax[i];
+    lower = lower + min(a, b);
+    upper = upper + max(a, b);
+  }
+  return {lower.toPacked(), upper.toPacked()};
+}
+
+// Instruction sets the bulk kernels below can run with.
+enum class SimdLevel : std::uint8_t {
+  Scalar,
+  SSE,
+  AVX2,
+  NEON,
+};
+
+// The level the kernels currently use; the best the CPU supports unless
+// setSimdLevel() chose another.
+[[nodiscard]] SimdLevel simdLevel();
+[[nodiscard]] bool isSimdLevelSupported(SimdLevel level);
+// For benchmarks and testing. Returns false, changing nothing, if the CPU or
+// build doesn't support level. Not thread-safe with running kernels.
+bool setSimdLevel(SimdLevel level);
+[[nodiscard]] const char *simdLevelName(SimdLevel level);
+
+// pOut[i] = matrix * (pIn[i], 1), dropping w. matrix has to be affine.
+// pIn and pOut may be the same array.
+void transformPoints(const Float4x4 &matrix, const PackedFloat3 *pIn,
+                     PackedFloat3 *pOut, std::size_t count);
+// pOut[i] = pLhs[i] * pRhs[i]. pOut may alias either input.
+void multiplyMatrices(const Float4x4 *pLhs, const Float4x4 *pRhs,
+                      Float4x4 *pOut, std::size_t count);
+// pOut[i] = pIn[i].inverse(). pOut may alias pIn.
+void invertMatrices(const Float4x4 *pIn, Float4x4 *pOut, std::size_t count);
+void packMatrices(const Float4x4 *pIn, PackedFloat4x3 *pOut,
+                  std::size_t count);
+void unpackMatrices(const PackedFloat4x3 *pIn, Float4x4 *pOut,
+                    std::size_t count);
+
+}  // namespace Gfx
@@ -0,0 +1,42 @@
+#include <Gfx/ParallelPassEncoder.hpp>
+
+#include <algorithm>
+
+namespace Gfx {
+
+void ParallelPassEncoder::encode(CommandBuffer *pCommandBuffer,
+                                 const RenderPassDescriptor &descriptor,
+                                 std::size_t drawCount,
+                                 const EncodeFunction &encodeFunction) {
+  const std::size_t rangeCount = std::min(
+      threadCount(),
+      std::max<std::size_t>(1, drawCount / kMinDrawsPerRange));
+  if (rangeCount == 1) {
+    RenderCommandEncoder *pEncoder =
+        pCommandBuffer->renderCommandEncoder(descriptor);
+    encodeFunction(pEncoder, 0, drawCount);
+    pEncoder->endEncoding();
+    return;
+  }
+
+  ParallelRenderCommandEncoder *pParallelEncoder =
+      pCommandBuffer->parallelRenderCommandEncoder(descriptor);
+  _encoders.clear();
+  for (std::size_t i = 0; i < rangeCount; ++i) {
+    _encoders.push_back(pParallelEncoder->renderCommandEncoder());
+  }
+
+  _pJobSystem->parallelFor(
+      rangeCount, 1, [&](std::size_t firstRange, std::size_t lastRange) {
+        for (std::size_t range = firstRange; range < lastRange; ++range) {
+          const std::size_t begin = drawCount * range / rangeCount;
+          const std::size_t end = drawCount * (range + 1) / rangeCount;
+          RenderCommandEncoder *pEncoder = _encoders[range];
+          encodeFunction(pEncoder, begin, end);
+          pEncoder->endEncoding();
+        }
+      });
+  pParallelEncoder->endEncoding();
+}
+
+}  // namespace Gfx
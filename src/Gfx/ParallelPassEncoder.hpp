@@ -0,0 +1,49 @@
+#pragma once
+
+#include <Gfx/Backend.hpp>
+#include <Gfx/JobSystem.hpp>
+
+#include <cstddef>
+#include <functional>
+#include <vector>
+
+namespace Gfx {
+
+// Encodes one render pass from several threads. The draw list
+// [0, drawCount) is cut into contiguous ranges, one per sub-encoder of a
+// ParallelRenderCommandEncoder, and the ranges are encoded as jobs. Sub-
+// encoders are created in range order, so the pass executes the draws in list
+// order exactly as a serial encode would, whichever thread finishes first.
+//
+// encode() has to be called on a thread that may create encoders for the
+// command buffer; it encodes ranges itself while it waits for the rest.
+class ParallelPassEncoder {
+ public:
+  // Below this many draws per range the cost of handing a range to another
+  // thread outweighs the encoding it takes over.
+  static constexpr std::size_t kMinDrawsPerRange = 512;
+
+  using EncodeFunction = std::function<void(
+      RenderCommandEncoder *pEncoder, std::size_t begin, std::size_t end)>;
+
+  explicit ParallelPassEncoder(JobSystem *pJobSystem)
+      : _pJobSystem(pJobSystem) {}
+
+  // Records the whole pass, calling encodeFunction once per range. Small
+  // passes are encoded on the calling thread with a plain render command
+  // encoder. Returns once every range has been encoded and ended.
+  void encode(CommandBuffer *pCommandBuffer,
+              const RenderPassDescriptor &descriptor, std::size_t drawCount,
+              const EncodeFunction &encodeFunction);
+
+  [[nodiscard]] std::size_t threadCount() const {
+    return _pJobSystem->threadCount();
+  }
+
+ private:
+  JobSystem *_pJobSystem;
+  // Sub-encoders of the pass being encoded, in range order.
+  std::vector<RenderCommandEncoder *> _encoders;
+};
+
+}  // namespace Gfx
@@ -0,0 +1,181 @@
+#include <Gfx/PipelineCache.hpp>
+
+#include <algorithm>
+#include <bit>
+#include <cassert>
+#include <string>
+
+namespace Gfx {
+
+namespace {
+
+// Folds 64-bit words into the hash one at a time with the splitmix64
+// finalizer.
+class DescriptorHasher {
+ public:
+  void add(std::uint64_t value) {
+    std::uint64_t x = _hash ^ value;
+    x += 0x9e3779b97f4a7c15ULL;
+    x = (x ^ (x >> 30)) * 0xbf58476d1ce4e5b9ULL;
+    x = (x ^ (x >> 27)) * 0x94d049bb133111ebULL;
+    _hash = x ^ (x >> 31);
+  }
+  // Length first, then the bytes eight at a time in little-endian order.
+  void add(const std::string &string) {
+    add(string.size());
+    for (std::size_t i = 0; i < string.size(); i += 8) {
+      std::uint64_t word = 0;
+      for (std::size_t j = i; j < i + 8 && j < string.size(); ++j) {
+        word |= std::uint64_t{static_cast<unsigned char>(string[j])}
+                << (8 * (j - i));
+      }
+      add(word);
+    }
+  }
+  // Narrower integers and enums.
+  template <typename _Value>
+  void add(_Value value) {
+    add(static_cast<std::uint64_t>(value));
+  }
+
+  [[nodiscard]] std::uint64_t hash() const { return _hash; }
+
+ private:
+  std::uint64_t _hash = 0;
+};
+
+}  // namespace
+
+std::uint64_t hashRenderPipelineDescriptor(
+    const RenderPipelineDescriptor &descriptor) {
+  DescriptorHasher hasher;
+  hasher.add(descriptor.vertexFunction);
+  hasher.add(descriptor.fragmentFunction);
+  const VertexDescriptor &vertexDescriptor = descriptor.vertexDescriptor;
+  hasher.add(vertexDescriptor.attributes.size());
+  for (const VertexAttributeDescriptor &attribute :
+       vertexDescriptor.attributes) {
+    hasher.add(attribute.format);
+    hasher.add(attribute.offset);
+    hasher.add(attribute.bufferIndex);
+  }
+  hasher.add(vertexDescriptor.layouts.size());
+  for (const VertexBufferLayoutDescriptor &layout : vertexDescriptor.layouts) {
+    hasher.add(layout.stride);
+    hasher.add(layout.stepFunction);
+    hasher.add(layout.stepRate);
+  }
+  const RenderPipelineColorAttachmentDescriptor &color =
+      descriptor.colorAttachment;
+  hasher.add(color.pixelFormat);
+  hasher.add(color.blendingEnabled ? 1 : 0);
+  hasher.add(color.sourceRGBBlendFactor);
+  hasher.add(color.destinationRGBBlendFactor);
+  hasher.add(color.rgbBlendOperation);
+  hasher.add(color.sourceAlphaBlendFactor);
+  hasher.add(color.destinationAlphaBlendFactor);
+  hasher.add(color.alphaBlendOperation);
+  hasher.add(color.writeMask);
+  hasher.add(descriptor.depthAttachmentPixelFormat);
+  hasher.add(descriptor.sampleCount);
+  // 0 marks free entries.
+  return hasher.hash() != 0 ? hasher.hash() : 1;
+}
+
+PipelineCache::PipelineCache(Device *pDevice, JobSystem *pJobSystem,
+                             std::size_t capacity)
+    : _pDevice(pDevice),
+      _pJobSystem(pJobSystem),
+      _mask(std::bit_ceil(std::max<std::size_t>(capacity, 2)) - 1),
+      _entries(std::make_unique<Entry[]>(_mask + 1)) {}
+
+PipelineCache::~PipelineCache() { wait(); }
+
+RenderPipelineState *PipelineCache::pipeline(
+    std::uint64_t key, const RenderPipelineDescriptor &descriptor,
+    RenderPipelineState *pFallback) {
+  assert(key == hashRenderPipelineDescriptor(descriptor));
+  for (std::size_t index = key & _mask;; index = (index + 1) & _mask) {
+    Entry &entry = _entries[index];
+    std::uint64_t entryKey = entry.key.load(std::memory_order_acquire);
+    if (entryKey == 0) {
+      if (_size.load(std::memory_order_relaxed) > _mask / 2) {
+        assert(false && "PipelineCache is full");
+        return pFallback;
+      }
+      if (entry.key.compare_exchange_strong(entryKey, key,
+                                            std::memory_order_acq_rel)) {
+        _size.fetch_add(1, std::memory_order_relaxed);
+        if (_pJobSystem == nullptr) {
+          compile(entry, descriptor);
+          return entry.pState ? entry.pState.get() : pFallback;
+        }
+        _pJobSystem->run(
+            [this, &entry, descriptor] { compile(entry, descriptor); },
+            &_compiles);
+        return pFallback;
+      }
+      // Another thread claimed the entry first, maybe for key.
+    }
+    if (entryKey == key) {
+      return entry.status.load(std::memory_order_acquire) == Status::Ready
+                 ? entry.pState.get()
+                 : pFallback;
+    }
+  }
+}
+
+RenderPipelineState *PipelineCache::find(
+    std::uint64_t key, RenderPipelineState *pFallback) const {
+  const Entry *pEntry = findEntry(key);
+  return pEntry != nullptr &&
+                 pEntry->status.load(std::memory_order_acquire) ==
+                     Status::Ready
+             ? pEntry->pState.get()
+             : pFallback;
+}
+
+std::uint64_t PipelineCache::prepare(
+    const RenderPipelineDescriptor &descriptor) {
+  const std::uint64_t key = hashRenderPipelineDescriptor(descriptor);
+  static_cast<void>(pipeline(key, descriptor));
+  return key;
+}
+
+PipelineCache::Status PipelineCache::status(std::uint64_t key) const {
+  const Entry *pEntry = findEntry(key);
+  if (pEntry == nullptr) {
+    return Status::Missing;
+  }
+  // A claimed entry is Missing until its compile is done.
+  const Status value = pEntry->status.load(std::memory_order_acquire);
+  return value == Status::Missing ? Status::Compiling : value;
+}
+
+void PipelineCache::wait() {
+  if (_pJobSystem != nullptr) {
+    _pJobSystem->wait(_compiles);
+  }
+}
+
+const PipelineCache::Entry *PipelineCache::findEntry(std::uint64_t key) const {
+  for (std::size_t index = key & _mask;; index = (index + 1) & _mask) {
+    const Entry &entry = _entries[index];
+    const std::uint64_t entryKey = entry.key.load(std::memory_order_acquire);
+    if (entryKey == key) {
+      return &entry;
+    }
+    if (entryKey == 0) {
+      return nullptr;
+    }
+  }
+}
+
+void PipelineCache::compile(Entry &entry,
+                            const RenderPipelineDescriptor &descriptor) {
+  entry.pState = _pDevice->newRenderPipelineState(descriptor);
+  entry.status.store(entry.pState ? Status::Ready : Status::Failed,
+                     std::memory_order_release);
+}
+
+}  // namespace Gfx
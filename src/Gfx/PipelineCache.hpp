@@ -0,0 +1,100 @@
+#pragma once
+
+#include <Gfx/Backend.hpp>
+#include <Gfx/JobSystem.hpp>
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+
+namespace Gfx {
+
+// 64-bit hash of everything a pipeline is compiled from, fed field by field
+// as fixed-width values, so it is the same in every run and on every
+// platform. Never 0.
+[[nodiscard]] std::uint64_t hashRenderPipelineDescriptor(
+    const RenderPipelineDescriptor &descriptor);
+
+// Render pipelines by descriptor hash, compiled in the background. The first
+// request for a descriptor starts compiling it as a job and gets the
+// caller's fallback, and so does every request until the pipeline is ready;
+// a frame never waits for the compiler.
+//
+// The table is open addressed with a fixed capacity and never moves or
+// removes entries, so lookups are a few atomic loads and take no lock. A new
+// descriptor claims its entry with a compare-and-swap on the key. Two
+// descriptors with the same hash share an entry.
+//
+// Thread safe. Without a job system, pipelines compile on the requesting
+// thread instead.
+class PipelineCache {
+ public:
+  static constexpr std::size_t kDefaultCapacity = 4096;
+
+  enum class Status : std::uint8_t {
+    Missing,
+    Compiling,
+    Ready,
+    // The device returned no pipeline; requests get the fallback for good.
+    Failed,
+  };
+
+  // capacity is rounded up to a power of two; the table stays at most half
+  // full.
+  PipelineCache(Device *pDevice, JobSystem *pJobSystem,
+                std::size_t capacity = kDefaultCapacity);
+  // Waits for the compiles in flight.
+  ~PipelineCache();
+
+  PipelineCache(const PipelineCache &) = delete;
+  PipelineCache &operator=(const PipelineCache &) = delete;
+
+  // The pipeline for descriptor once it is ready, pFallback until then.
+  RenderPipelineState *pipeline(const RenderPipelineDescriptor &descriptor,
+                                RenderPipelineState *pFallback = nullptr) {
+    return pipeline(hashRenderPipelineDescriptor(descriptor), descriptor,
+                    pFallback);
+  }
+  // Same, with key already hashed from descriptor, as materials keep it.
+  RenderPipelineState *pipeline(std::uint64_t key,
+                                const RenderPipelineDescriptor &descriptor,
+                                RenderPipelineState *pFallback = nullptr);
+  // Only looks key up; never starts a compile.
+  [[nodiscard]] RenderPipelineState *find(
+      std::uint64_t key, RenderPipelineState *pFallback = nullptr) const;
+  // Starts compiling descriptor unless it is known already, for warming the
+  // cache at load time. Returns its key.
+  std::uint64_t prepare(const RenderPipelineDescriptor &descriptor);
+
+  [[nodiscard]] Status status(std::uint64_t key) const;
+  // Descriptors requested so far.
+  [[nodiscard]] std::size_t size() const {
+    return _size.load(std::memory_order_relaxed);
+  }
+  // Waits for every compile started so far. Only on the job system's main
+  // thread or threads outside it.
+  void wait();
+
+ private:
+  struct Entry {
+    // 0 while free.
+    std::atomic<std::uint64_t> key = 0;
+    std::atomic<Status> status = Status::Missing;
+    // Written once, before status turns Ready.
+    std::unique_ptr<RenderPipelineState> pState;
+  };
+
+  // The entry of key, or nullptr.
+  [[nodiscard]] const Entry *findEntry(std::uint64_t key) const;
+  void compile(Entry &entry, const RenderPipelineDescriptor &descriptor);
+
+  Device *_pDevice;
+  JobSystem *_pJobSystem;
+  std::size_t _mask;
+  std::unique_ptr<Entry[]> _entries;
+  std::atomic<std::size_t> _size = 0;
+  JobCounter _compiles;
+};
+
+}  // namespace Gfx
@@ -0,0 +1,1291 @@
+#include <Gfx/PixelConversion.hpp>
+
+#include <Gfx/Math.hpp>
+
+#include <algorithm>
+#include <cassert>
+#include <cmath>
+#include <cstdint>
+#include <cstring>
+
+#if GFX_MATH_SSE && (defined(__GNUC__) || defined(__clang__))
+#define GFX_PIXEL_AVX2 1
+#include <immintrin.h>
+#endif
+
+namespace Gfx {
+
+namespace {
+
+using DecodeFunction = void (*)(const std::byte *pSource, float *pRgba,
+                                std::size_t count);
+using EncodeFunction = void (*)(const float *pRgba, std::byte *pDestination,
+                                std::size_t count);
+using ConvertFunction = void (*)(const std::byte *pSource,
+                                 std::byte *pDestination, std::size_t count);
+
+// Kernel variants per format or pair. A missing variant falls back to the
+// one below it.
+enum KernelLevel : std::uint8_t { kScalar, kSse, kAvx2, kKernelLevels };
+
+// Pixels decoded at a time on the way through RGBA32Float: 4 KiB of floats.
+constexpr std::size_t kBlockPixels = 256;
+// Regions smaller than this convert on the calling thread.
+constexpr std::size_t kMinParallelBytes = std::size_t{1} << 18;
+
+constexpr float kInverse3 = 1.0F / 3.0F;
+constexpr float kInverse255 = 1.0F / 255.0F;
+constexpr float kInverse1023 = 1.0F / 1023.0F;
+constexpr float kInverse65535 = 1.0F / 65535.0F;
+
+// Below this linear value every sRGB encode is 0 (2^-13).
+constexpr std::uint32_t kSrgbMinimumBits = 0x39000000;
+constexpr int kSrgbBucketShift = 16;
+constexpr std::size_t kSrgbBucketCount =
+    ((0x3F800000 - kSrgbMinimumBits) >> kSrgbBucketShift) + 1;
+
+// Half and the unsigned small floats of RG11B10Float share a 5-bit exponent:
+// values below 2^-14 are denormal, and rebiasing to float adds 112.
+constexpr std::uint32_t kSmallFloatMinNormalBits = 0x38800000;
+constexpr std::uint32_t kSmallFloatRebias = 112;
+// Floats from 65520 up round to a half infinity.
+constexpr std::uint32_t kHalfOverflowBits = 0x477FF000;
+
+std::uint32_t floatBits(float value) {
+  std::uint32_t bits;
+  std::memcpy(&bits, &value, sizeof(bits));
+  return bits;
+}
+
+float bitsFloat(std::uint32_t bits) {
+  float value;
+  std::memcpy(&value, &bits, sizeof(value));
+  return value;
+}
+
+// NaN clamps to 0, as the vector min/max order below does.
+float clamp01(float value) {
+  return value > 0.0F ? (value < 1.0F ? value : 1.0F) : 0.0F;
+}
+
+// Rounds to nearest even, like cvtps2dq.
+std::int32_t roundToInt(float value) {
+#if GFX_MATH_SSE
+  return _mm_cvtss_si32(_mm_set_ss(value));
+#else
+  return static_cast<std::int32_t>(std::lrint(value));
+#endif
+}
+
+std::uint8_t encodeUnorm8(float value) {
+  return static_cast<std::uint8_t>(roundToInt(clamp01(value) * 255.0F));
+}
+
+double srgbToLinear(double value) {
+  return value <= 0.04045 ? value / 12.92
+                          : std::pow((value + 0.055) / 1.055, 2.4);
+}
+
+// Decoding sRGB is a lookup. Encoding finds the largest code whose threshold
+// (the linear value halfway to the code below) is at most the input: a
+// bucket table indexed by the float's top bits gives the code at the
+// bucket's start, and buckets are narrow enough to hold at most one
+// threshold, so one compare finishes. Both work the same in vector code with
+// gathers.
+struct SrgbTables {
+  SrgbTables();
+
+  // [0, 256): sRGB byte to linear. [256, 512): unorm byte to float, for
+  // alpha lanes.
+  float decode[512];
+  // thresholds[k] is the smallest float that encodes to k or more;
+  // thresholds[256] is infinity.
+  float thresholds[257];
+  std::int32_t buckets[kSrgbBucketCount];
+  // Direct 8-bit conversions.
+  std::uint8_t srgbToLinear8[256];
+  std::uint8_t linearToSrgb8[256];
+};
+
+std::uint8_t encodeSrgb(float value, const SrgbTables &tables);
+
+SrgbTables::SrgbTables() {
+  for (int i = 0; i < 256; ++i) {
+    decode[i] = static_cast<float>(srgbToLinear(i / 255.0));
+    decode[256 + i] = static_cast<float>(i) * kInverse255;
+  }
+  thresholds[0] = 0.0F;
+  for (int code = 1; code < 256; ++code) {
+    const double threshold = srgbToLinear((code - 0.5) / 255.0);
+    float rounded = static_cast<float>(threshold);
+    if (static_cast<double>(rounded) < threshold) {
+      rounded = std::nextafter(rounded, INFINITY);
+    }
+    thresholds[code] = rounded;
+  }
+  thresholds[256] = INFINITY;
+
+  std::int32_t code = 0;
+  for (std::size_t bucket = 0; bucket < kSrgbBucketCount; ++bucket) {
+    const auto first = static_cast<std::uint32_t>(
+        kSrgbMinimumBits + (bucket << kSrgbBucketShift));
+    while (code < 255 && thresholds[code + 1] <= bitsFloat(first)) {
+      ++code;
+    }
+    buckets[bucket] = code;
+    assert(code >= 254 ||
+           thresholds[code + 2] >
+               bitsFloat(first + (1U << kSrgbBucketShift) - 1));
+  }
+
+  for (int i = 0; i < 256; ++i) {
+    srgbToLinear8[i] = encodeUnorm8(decode[i]);
+    linearToSrgb8[i] = encodeSrgb(decode[256 + i], *this);
+  }
+}
+
+const SrgbTables &srgbTables() {
+  static const SrgbTables tables;
+  return tables;
+}
+
+std::uint8_t encodeSrgb(float value, const SrgbTables &tables) {
+  const float x = std::max(clamp01(value), bitsFloat(kSrgbMinimumBits));
+  const std::int32_t code =
+      tables.buckets[(floatBits(x) - kSrgbMinimumBits) >> kSrgbBucketShift];
+  return static_cast<std::uint8_t>(
+      code + (x >= tables.thresholds[code + 1] ? 1 : 0));
+}
+
+// Float bits of an unsigned 5-bit-exponent float with kMantissa bits, given
+// its exponent and mantissa fields.
+template <int kMantissa>
+std::uint32_t decodeSmallFloat(std::uint32_t exponentMantissa) {
+  constexpr std::uint32_t kMantissaMask = (1U << kMantissa) - 1;
+  if (exponentMantissa <= kMantissaMask) {
+    return floatBits(static_cast<float>(exponentMantissa) *
+                     std::ldexp(1.0F, -14 - kMantissa));
+  }
+  std::uint32_t bits = (exponentMantissa << (23 - kMantissa)) +
+                       (kSmallFloatRebias << 23);
+  if (exponentMantissa >= 31U << kMantissa) {
+    bits += kSmallFloatRebias << 23;
+    bits |= (exponentMantissa & kMantissaMask) != 0 ? 0x400000 : 0;
+  }
+  return bits;
+}
+
+// Unsigned small float: negatives and -0 give 0, finite overflow clamps to
+// the largest finite value, NaN stays NaN.
+template <int kMantissa>
+std::uint32_t encodeSmallFloat(float value) {
+  constexpr float kMaxFinite =
+      (2.0F - 1.0F / (1 << kMantissa)) * 32768.0F;
+  if (std::isnan(value)) {
+    return (31U << kMantissa) | (1U << (kMantissa - 1));
+  }
+  if (!(value > 0.0F)) {
+    return 0;
+  }
+  if (value == INFINITY) {
+    return 31U << kMantissa;
+  }
+  const float x = std::min(value, kMaxFinite);
+  const std::uint32_t bits = floatBits(x);
+  if (bits < kSmallFloatMinNormalBits) {
+    return static_cast<std::uint32_t>(
+        roundToInt(x * std::ldexp(1.0F, 14 + kMantissa)));
+  }
+  constexpr int kShift = 23 - kMantissa;
+  return ((bits + ((1U << (kShift - 1)) - 1) + ((bits >> kShift) & 1)) >>
+          kShift) -
+         (kSmallFloatRebias << kMantissa);
+}
+
+float decodeHalf(std::uint16_t half) {
+  const std::uint32_t sign = static_cast<std::uint32_t>(half & 0x8000) << 16;
+  return bitsFloat(sign | decodeSmallFloat<10>(half & 0x7FFFU));
+}
+
+// IEEE round to nearest even, as F16C does it.
+std::uint16_t encodeHalf(float value) {
+  const std::uint32_t bits = floatBits(value);
+  const std::uint32_t sign = (bits >> 16) & 0x8000;
+  const std::uint32_t magnitude = bits & 0x7FFFFFFF;
+  std::uint32_t half;
+  if (magnitude > 0x7F800000) {
+    half = 0x7E00 | ((magnitude >> 13) & 0x3FF);
+  } else if (magnitude >= kHalfOverflowBits) {
+    half = 0x7C00;
+  } else if (magnitude < kSmallFloatMinNormalBits) {
+    half = static_cast<std::uint32_t>(
+        roundToInt(bitsFloat(magnitude) * 16777216.0F));
+  } else {
+    half = ((magnitude + 0xFFF + ((magnitude >> 13) & 1)) >> 13) -
+           (kSmallFloatRebias << 10);
+  }
+  return static_cast<std::uint16_t>(sign | half);
+}
+
+std::uint32_t load32(const std::byte *pSource) {
+  std::uint32_t value;
+  std::memcpy(&value, pSource, sizeof(value));
+  return value;
+}
+
+void store32(std::byte *pDestination, std::uint32_t value) {
+  std::memcpy(pDestination, &value, sizeof(value));
+}
+
+// One pixel at a time; the reference every vector kernel has to match.
+namespace Scalar {
+
+template <bool kBgr, bool kSrgb>
+void decodeRgba8(const std::byte *pSource, float *pRgba, std::size_t count) {
+  const SrgbTables &tables = srgbTables();
+  const float *pColor = kSrgb ? tables.decode : tables.decode + 256;
+  const float *pAlpha = tables.decode + 256;
+  const auto *pBytes = reinterpret_cast<const std::uint8_t *>(pSource);
+  for (std::size_t i = 0; i < count; ++i) {
+    const std::uint8_t *pPixel = pBytes + 4 * i;
+    float *pOut = pRgba + 4 * i;
+    pOut[0] = pColor[pPixel[kBgr ? 2 : 0]];
+    pOut[1] = pColor[pPixel[1]];
+    pOut[2] = pColor[pPixel[kBgr ? 0 : 2]];
+    pOut[3] = pAlpha[pPixel[3]];
+  }
+}
+
+template <bool kBgr, bool kSrgb>
+void encodeRgba8(const float *pRgba, std::byte *pDestination,
+                 std::size_t count) {
+  const SrgbTables &tables = srgbTables();
+  auto *pBytes = reinterpret_cast<std::uint8_t *>(pDestination);
+  for (std::size_t i = 0; i < count; ++i) {
+    const float *pIn = pRgba + 4 * i;
+    std::uint8_t *pPixel = pBytes + 4 * i;
+    for (int channel = 0; channel < 3; ++channel) {
+      pPixel[kBgr ? 2 - channel : channel] =
+          kSrgb ? encodeSrgb(pIn[channel], tables)
+                : encodeUnorm8(pIn[channel]);
+    }
+    pPixel[3] = encodeUnorm8(pIn[3]);
+  }
+}
+
+template <bool kBgr>
+void decodeRgb10A2(const std::byte *pSource, float *pRgba,
+                   std::size_t count) {
+  for (std::size_t i = 0; i < count; ++i) {
+    const std::uint32_t pixel = load32(pSource + 4 * i);
+    float *pOut = pRgba + 4 * i;
+    pOut[kBgr ? 2 : 0] = static_cast<float>(pixel & 1023) * kInverse1023;
+    pOut[1] = static_cast<float>(pixel >> 10 & 1023) * kInverse1023;
+    pOut[kBgr ? 0 : 2] = static_cast<float>(pixel >> 20 & 1023) * kInverse1023;
+    pOut[3] = static_cast<float>(pixel >> 30) * kInverse3;
+  }
+}
+
+template <bool kBgr>
+void encodeRgb10A2(const float *pRgba, std::byte *pDestination,
+                   std::size_t count) {
+  for (std::size_t i = 0; i < count; ++i) {
+    const float *pIn = pRgba + 4 * i;
+    const auto field = [](float value, float scale) {
+      return static_cast<std::uint32_t>(roundToInt(clamp01(value) * scale));
+    };
+    store32(pDestination + 4 * i,
+            field(pIn[kBgr ? 2 : 0], 1023.0F) |
+                field(pIn[1], 1023.0F) << 10 |
+                field(pIn[kBgr ? 0 : 2], 1023.0F) << 20 |
+                field(pIn[3], 3.0F) << 30);
+  }
+}
+
+void decodeRg11B10(const std::byte *pSource, float *pRgba,
+                   std::size_t count) {
+  for (std::size_t i = 0; i < count; ++i) {
+    const std::uint32_t pixel = load32(pSource + 4 * i);
+    float *pOut = pRgba + 4 * i;
+    pOut[0] = bitsFloat(decodeSmallFloat<6>(pixel & 0x7FF));
+    pOut[1] = bitsFloat(decodeSmallFloat<6>(pixel >> 11 & 0x7FF));
+    pOut[2] = bitsFloat(decodeSmallFloat<5>(pixel >> 22));
+    pOut[3] = 1.0F;
+  }
+}
+
+void encodeRg11B10(const float *pRgba, std::byte *pDestination,
+                   std::size_t count) {
+  for (std::size_t i = 0; i < count; ++i) {
+    const float *pIn = pRgba + 4 * i;
+    store32(pDestination + 4 * i, encodeSmallFloat<6>(pIn[0]) |
+                                      encodeSmallFloat<6>(pIn[1]) << 11 |
+                                      encodeSmallFloat<5>(pIn[2]) << 22);
+  }
+}
+
+void decodeRgba16Float(const std::byte *pSource, float *pRgba,
+                       std::size_t count) {
+  for (std::size_t i = 0; i < 4 * count; ++i) {
+    std::uint16_t half;
+    std::memcpy(&half, pSource + 2 * i, sizeof(half));
+    pRgba[i] = decodeHalf(half);
+  }
+}
+
+void encodeRgba16Float(const float *pRgba, std::byte *pDestination,
+                       std::size_t count) {
+  for (std::size_t i = 0; i < 4 * count; ++i) {
+    const std::uint16_t half = encodeHalf(pRgba[i]);
+    std::memcpy(pDestination + 2 * i, &half, sizeof(half));
+  }
+}
+
+void decodeRgba32Float(const std::byte *pSource, float *pRgba,
+                       std::size_t count) {
+  std::memcpy(pRgba, pSource, 16 * count);
+}
+
+void encodeRgba32Float(const float *pRgba, std::byte *pDestination,
+                       std::size_t count) {
+  std::memcpy(pDestination, pRgba, 16 * count);
+}
+
+void decodeDepth16(const std::byte *pSource, float *pRgba, std::size_t count) {
+  for (std::size_t i = 0; i < count; ++i) {
+    std::uint16_t depth;
+    std::memcpy(&depth, pSource + 2 * i, sizeof(depth));
+    float *pOut = pRgba + 4 * i;
+    pOut[0] = static_cast<float>(depth) * kInverse65535;
+    pOut[1] = 0.0F;
+    pOut[2] = 0.0F;
+    pOut[3] = 1.0F;
+  }
+}
+
+void encodeDepth16(const float *pRgba, std::byte *pDestination,
+                   std::size_t count) {
+  for (std::size_t i = 0; i < count; ++i) {
+    const auto depth = static_cast<std::uint16_t>(
+        roundToInt(clamp01(pRgba[4 * i]) * 65535.0F));
+    std::memcpy(pDestination + 2 * i, &depth, sizeof(depth));
+  }
+}
+
+void decodeDepth32Float(const std::byte *pSource, float *pRgba,
+                        std::size_t count) {
+  for (std::size_t i = 0; i < count; ++i) {
+    float *pOut = pRgba + 4 * i;
+    std::memcpy(pOut, pSource + 4 * i, sizeof(float));
+    pOut[1] = 0.0F;
+    pOut[2] = 0.0F;
+    pOut[3] = 1.0F;
+  }
+}
+
+void encodeDepth32Float(const float *pRgba, std::byte *pDestination,
+                        std::size_t count) {
+  for (std::size_t i = 0; i < count; ++i) {
+    std::memcpy(pDestination + 4 * i, pRgba + 4 * i, sizeof(float));
+  }
+}
+
+// RGBA8 <-> BGRA8 with the same encoding.
+void swapRedBlue8(const std::byte *pSource, std::byte *pDestination,
+                  std::size_t count) {
+  for (std::size_t i = 0; i < count; ++i) {
+    const std::uint32_t pixel = load32(pSource + 4 * i);
+    store32(pDestination + 4 * i, (pixel & 0xFF00FF00) |
+                                      (pixel >> 16 & 0xFF) |
+                                      (pixel & 0xFF) << 16);
+  }
+}
+
+// 8-bit sRGB <-> linear through a byte table, optionally swizzling.
+template <bool kSwap, bool kToLinear>
+void convertSrgb8(const std::byte *pSource, std::byte *pDestination,
+                  std::size_t count) {
+  const SrgbTables &tables = srgbTables();
+  const std::uint8_t *pTable =
+      kToLinear ? tables.srgbToLinear8 : tables.linearToSrgb8;
+  const auto *pIn = reinterpret_cast<const std::uint8_t *>(pSource);
+  auto *pOut = reinterpret_cast<std::uint8_t *>(pDestination);
+  for (std::size_t i = 0; i < count; ++i) {
+    const std::uint8_t *pPixel = pIn + 4 * i;
+    std::uint8_t *pResult = pOut + 4 * i;
+    pResult[kSwap ? 2 : 0] = pTable[pPixel[0]];
+    pResult[1] = pTable[pPixel[1]];
+    pResult[kSwap ? 0 : 2] = pTable[pPixel[2]];
+    pResult[3] = pPixel[3];
+  }
+}
+
+// RGB10A2 <-> BGR10A2.
+void swapRedBlue10(const std::byte *pSource, std::byte *pDestination,
+                   std::size_t count) {
+  for (std::size_t i = 0; i < count; ++i) {
+    const std::uint32_t pixel = load32(pSource + 4 * i);
+    store32(pDestination + 4 * i, (pixel & 0xC00FFC00) |
+                                      (pixel >> 20 & 1023) |
+                                      (pixel & 1023) << 20);
+  }
+}
+
+}  // namespace Scalar
+
+#if GFX_MATH_SSE
+
+// SSE2, four pixels or channels per instruction. sRGB stays scalar here:
+// without gathers the table lookups dominate either way.
+namespace Sse {
+
+__m128i select(__m128i mask, __m128i lhs, __m128i rhs) {
+  return _mm_or_si128(_mm_and_si128(mask, lhs), _mm_andnot_si128(mask, rhs));
+}
+
+__m128 clamp01(__m128 value) {
+  return _mm_min_ps(_mm_max_ps(value, _mm_setzero_ps()), _mm_set1_ps(1.0F));
+}
+
+template <bool kBgr>
+__m128 swizzle(__m128 pixel) {
+  return kBgr ? _mm_shuffle_ps(pixel, pixel, _MM_SHUFFLE(3, 0, 1, 2)) : pixel;
+}
+
+// Packs 32-bit lanes holding 0..65535 into 16-bit lanes.
+__m128i packUnsigned16(__m128i lo, __m128i hi) {
+  return _mm_packs_epi32(_mm_srai_epi32(_mm_slli_epi32(lo, 16), 16),
+                         _mm_srai_epi32(_mm_slli_epi32(hi, 16), 16));
+}
+
+template <bool kBgr>
+void decodeRgba8(const std::byte *pSource, float *pRgba, std::size_t count) {
+  const __m128i zero = _mm_setzero_si128();
+  const __m128 scale = _mm_set1_ps(kInverse255);
+  std::size_t i = 0;
+  for (; i + 4 <= count; i += 4) {
+    const __m128i bytes = _mm_loadu_si128(
+        reinterpret_cast<const __m128i *>(pSource + 4 * i));
+    const __m128i lo = _mm_unpacklo_epi8(bytes, zero);
+    const __m128i hi = _mm_unpackhi_epi8(bytes, zero);
+    const __m128i pixels[4] = {
+        _mm_unpacklo_epi16(lo, zero), _mm_unpackhi_epi16(lo, zero),
+        _mm_unpacklo_epi16(hi, zero), _mm_unpackhi_epi16(hi, zero)};
+    for (int k = 0; k < 4; ++k) {
+      _mm_storeu_ps(pRgba + 4 * (i + k),
+                    swizzle<kBgr>(_mm_mul_ps(_mm_cvtepi32_ps(pixels[k]),
+                                             scale)));
+    }
+  }
+  Scalar::decodeRgba8<kBgr, false>(pSource + 4 * i, pRgba + 4 * i,
+                                   count - i);
+}
+
+template <bool kBgr>
+void encodeRgba8(const float *pRgba, std::byte *pDestination,
+                 std::size_t count) {
+  const __m128 scale = _mm_set1_ps(255.0F);
+  std::size_t i = 0;
+  for (; i + 4 <= count; i += 4) {
+    __m128i pixels[4];
+    for (int k = 0; k < 4; ++k) {
+      const __m128 pixel =
+          clamp01(swizzle<kBgr>(_mm_loadu_ps(pRgba + 4 * (i + k))));
+      pixels[k] = _mm_cvtps_epi32(_mm_mul_ps(pixel, scale));
+    }
+    _mm_storeu_si128(
+        reinterpret_cast<__m128i *>(pDestination + 4 * i),
+        _mm_packus_epi16(_mm_packs_epi32(pixels[0], pixels[1]),
+                         _mm_packs_epi32(pixels[2], pixels[3])));
+  }
+  Scalar::encodeRgba8<kBgr, false>(pRgba + 4 * i, pDestination + 4 * i,
+                                   count - i);
+}
+
+template <bool kBgr>
+void decodeRgb10A2(const std::byte *pSource, float *pRgba,
+                   std::size_t count) {
+  const __m128i mask = _mm_set1_epi32(1023);
+  const __m128 scale = _mm_set1_ps(kInverse1023);
+  std::size_t i = 0;
+  for (; i + 4 <= count; i += 4) {
+    const __m128i pixels = _mm_loadu_si128(
+        reinterpret_cast<const __m128i *>(pSource + 4 * i));
+    __m128 first = _mm_mul_ps(
+        _mm_cvtepi32_ps(_mm_and_si128(pixels, mask)), scale);
+    __m128 green = _mm_mul_ps(
+        _mm_cvtepi32_ps(_mm_and_si128(_mm_srli_epi32(pixels, 10), mask)),
+        scale);
+    __m128 third = _mm_mul_ps(
+        _mm_cvtepi32_ps(_mm_and_si128(_mm_srli_epi32(pixels, 20), mask)),
+        scale);
+    __m128 alpha = _mm_mul_ps(_mm_cvtepi32_ps(_mm_srli_epi32(pixels, 30)),
+                              _mm_set1_ps(kInverse3));
+    if (kBgr) {
+      std::swap(first, third);
+    }
+    _MM_TRANSPOSE4_PS(first, green, third, alpha);
+    _mm_storeu_ps(pRgba + 4 * i, first);
+    _mm_storeu_ps(pRgba + 4 * i + 4, green);
+    _mm_storeu_ps(pRgba + 4 * i + 8, third);
+    _mm_storeu_ps(pRgba + 4 * i + 12, alpha);
+  }
+  Scalar::decodeRgb10A2<kBgr>(pSource + 4 * i, pRgba + 4 * i, count - i);
+}
+
+template <bool kBgr>
+void encodeRgb10A2(const float *pRgba, std::byte *pDestination,
+                   std::size_t count) {
+  const __m128 scale = _mm_set1_ps(1023.0F);
+  std::size_t i = 0;
+  for (; i + 4 <= count; i += 4) {
+    __m128 red = _mm_loadu_ps(pRgba + 4 * i);
+    __m128 green = _mm_loadu_ps(pRgba + 4 * i + 4);
+    __m128 blue = _mm_loadu_ps(pRgba + 4 * i + 8);
+    __m128 alpha = _mm_loadu_ps(pRgba + 4 * i + 12);
+    _MM_TRANSPOSE4_PS(red, green, blue, alpha);
+    if (kBgr) {
+      std::swap(red, blue);
+    }
+    const __m128i pixels = _mm_or_si128(
+        _mm_or_si128(_mm_cvtps_epi32(_mm_mul_ps(clamp01(red), scale)),
+                     _mm_slli_epi32(
+                         _mm_cvtps_epi32(_mm_mul_ps(clamp01(green), scale)),
+                         10)),
+        _mm_or_si128(
+            _mm_slli_epi32(_mm_cvtps_epi32(_mm_mul_ps(clamp01(blue), scale)),
+                           20),
+            _mm_slli_epi32(_mm_cvtps_epi32(_mm_mul_ps(clamp01(alpha),
+                                                      _mm_set1_ps(3.0F))),
+                           30)));
+    _mm_storeu_si128(reinterpret_cast<__m128i *>(pDestination + 4 * i),
+                     pixels);
+  }
+  Scalar::encodeRgb10A2<kBgr>(pRgba + 4 * i, pDestination + 4 * i,
+                              count - i);
+}
+
+// decodeSmallFloat on four lanes.
+template <int kMantissa>
+__m128i decodeSmallFloat(__m128i exponentMantissa) {
+  const __m128i rebias = _mm_set1_epi32(kSmallFloatRebias << 23);
+  const __m128i normal =
+      _mm_add_epi32(_mm_slli_epi32(exponentMantissa, 23 - kMantissa), rebias);
+  const __m128i denormal = _mm_castps_si128(
+      _mm_mul_ps(_mm_cvtepi32_ps(exponentMantissa),
+                 _mm_set1_ps(std::ldexp(1.0F, -14 - kMantissa))));
+  const __m128i hasMantissa = _mm_cmpgt_epi32(
+      _mm_and_si128(exponentMantissa, _mm_set1_epi32((1 << kMantissa) - 1)),
+      _mm_setzero_si128());
+  const __m128i infinityOrNan =
+      _mm_or_si128(_mm_add_epi32(normal, rebias),
+                   _mm_and_si128(hasMantissa, _mm_set1_epi32(0x400000)));
+  const __m128i isDenormal =
+      _mm_cmplt_epi32(exponentMantissa, _mm_set1_epi32(1 << kMantissa));
+  const __m128i isInfinityOrNan = _mm_cmpgt_epi32(
+      exponentMantissa, _mm_set1_epi32((31 << kMantissa) - 1));
+  return select(isDenormal, denormal,
+                select(isInfinityOrNan, infinityOrNan, normal));
+}
+
+template <int kMantissa>
+__m128i encodeSmallFloat(__m128 value) {
+  constexpr float kMaxFinite =
+      (2.0F - 1.0F / (1 << kMantissa)) * 32768.0F;
+  constexpr int kShift = 23 - kMantissa;
+  const __m128 clamped = _mm_min_ps(value, _mm_set1_ps(kMaxFinite));
+  const __m128i bits = _mm_castps_si128(clamped);
+  const __m128i denormal = _mm_cvtps_epi32(
+      _mm_mul_ps(clamped, _mm_set1_ps(std::ldexp(1.0F, 14 + kMantissa))));
+  const __m128i normal = _mm_sub_epi32(
+      _mm_srli_epi32(
+          _mm_add_epi32(
+              _mm_add_epi32(bits, _mm_set1_epi32((1 << (kShift - 1)) - 1)),
+              _mm_and_si128(_mm_srli_epi32(bits, kShift), _mm_set1_epi32(1))),
+          kShift),
+      _mm_set1_epi32(kSmallFloatRebias << kMantissa));
+  __m128i result = select(
+      _mm_cmplt_epi32(bits, _mm_set1_epi32(kSmallFloatMinNormalBits)),
+      denormal, normal);
+  result = select(
+      _mm_castps_si128(_mm_cmpeq_ps(value, _mm_set1_ps(INFINITY))),
+      _mm_set1_epi32(31 << kMantissa), result);
+  result = _mm_andnot_si128(
+      _mm_castps_si128(_mm_cmple_ps(value, _mm_setzero_ps())), result);
+  return select(_mm_castps_si128(_mm_cmpunord_ps(value, value)),
+                _mm_set1_epi32((31 << kMantissa) | (1 << (kMantissa - 1))),
+                result);
+}
+
+void decodeRg11B10(const std::byte *pSource, float *pRgba,
+                   std::size_t count) {
+  const __m128i mask = _mm_set1_epi32(0x7FF);
+  std::size_t i = 0;
+  for (; i + 4 <= count; i += 4) {
+    const __m128i pixels = _mm_loadu_si128(
+        reinterpret_cast<const __m128i *>(pSource + 4 * i));
+    __m128 red = _mm_castsi128_ps(
+        decodeSmallFloat<6>(_mm_and_si128(pixels, mask)));
+    __m128 green = _mm_castsi128_ps(
+        decodeSmallFloat<6>(_mm_and_si128(_mm_srli_epi32(pixels, 11), mask)));
+    __m128 blue =
+        _mm_castsi128_ps(decodeSmallFloat<5>(_mm_srli_epi32(pixels, 22)));
+    __m128 alpha = _mm_set1_ps(1.0F);
+    _MM_TRANSPOSE4_PS(red, green, blue, alpha);
+    _mm_storeu_ps(pRgba + 4 * i, red);
+    _mm_storeu_ps(pRgba + 4 * i + 4, green);
+    _mm_storeu_ps(pRgba + 4 * i + 8, blue);
+    _mm_storeu_ps(pRgba + 4 * i + 12, alpha);
+  }
+  Scalar::decodeRg11B10(pSource + 4 * i, pRgba + 4 * i, count - i);
+}
+
+void encodeRg11B10(const float *pRgba, std::byte *pDestination,
+                   std::size_t count) {
+  std::size_t i = 0;
+  for (; i + 4 <= count; i += 4) {
+    __m128 red = _mm_loadu_ps(pRgba + 4 * i);
+    __m128 green = _mm_loadu_ps(pRgba + 4 * i + 4);
+    __m128 blue = _mm_loadu_ps(pRgba + 4 * i + 8);
+    __m128 alpha = _mm_loadu_ps(pRgba + 4 * i + 12);
+    _MM_TRANSPOSE4_PS(red, green, blue, alpha);
+    const __m128i pixels = _mm_or_si128(
+        _mm_or_si128(encodeSmallFloat<6>(red),
+                     _mm_slli_epi32(encodeSmallFloat<6>(green), 11)),
+        _mm_slli_epi32(encodeSmallFloat<5>(blue), 22));
+    _mm_storeu_si128(reinterpret_cast<__m128i *>(pDestination + 4 * i),
+                     pixels);
+  }
+  Scalar::encodeRg11B10(pRgba + 4 * i, pDestination + 4 * i, count - i);
+}
+
+__m128 decodeHalves(__m128i halves) {
+  const __m128i sign =
+      _mm_slli_epi32(_mm_and_si128(halves, _mm_set1_epi32(0x8000)), 16);
+  return _mm_castsi128_ps(_mm_or_si128(
+      sign,
+      decodeSmallFloat<10>(_mm_and_si128(halves, _mm_set1_epi32(0x7FFF)))));
+}
+
+__m128i encodeHalves(__m128 value) {
+  const __m128i bits = _mm_castps_si128(value);
+  const __m128i sign =
+      _mm_and_si128(_mm_srli_epi32(bits, 16), _mm_set1_epi32(0x8000));
+  const __m128i magnitude =
+      _mm_and_si128(bits, _mm_set1_epi32(0x7FFFFFFF));
+  const __m128i denormal = _mm_cvtps_epi32(_mm_mul_ps(
+      _mm_castsi128_ps(magnitude), _mm_set1_ps(16777216.0F)));
+  const __m128i normal = _mm_sub_epi32(
+      _mm_srli_epi32(
+          _mm_add_epi32(_mm_add_epi32(magnitude, _mm_set1_epi32(0xFFF)),
+                        _mm_and_si128(_mm_srli_epi32(magnitude, 13),
+                                      _mm_set1_epi32(1))),
+          13),
+      _mm_set1_epi32(kSmallFloatRebias << 10));
+  __m128i result = select(
+      _mm_cmplt_epi32(magnitude, _mm_set1_epi32(kSmallFloatMinNormalBits)),
+      denormal, normal);
+  result = select(
+      _mm_cmpgt_epi32(magnitude, _mm_set1_epi32(kHalfOverflowBits - 1)),
+      _mm_set1_epi32(0x7C00), result);
+  result = select(
+      _mm_cmpgt_epi32(magnitude, _mm_set1_epi32(0x7F800000)),
+      _mm_or_si128(_mm_set1_epi32(0x7E00),
+                   _mm_and_si128(_mm_srli_epi32(magnitude, 13),
+                                 _mm_set1_epi32(0x3FF))),
+      result);
+  return _mm_or_si128(result, sign);
+}
+
+void decodeRgba16Float(const std::byte *pSource, float *pRgba,
+                       std::size_t count) {
+  const __m128i zero = _mm_setzero_si128();
+  std::size_t i = 0;
+  for (; i + 2 <= count; i += 2) {
+    const __m128i halves = _mm_loadu_si128(
+        reinterpret_cast<const __m128i *>(pSource + 8 * i));
+    _mm_storeu_ps(pRgba + 4 * i,
+                  decodeHalves(_mm_unpacklo_epi16(halves, zero)));
+    _mm_storeu_ps(pRgba + 4 * i + 4,
+                  decodeHalves(_mm_unpackhi_epi16(halves, zero)));
+  }
+  Scalar::decodeRgba16Float(pSource + 8 * i, pRgba + 4 * i, count - i);
+}
+
+void encodeRgba16Float(const float *pRgba, std::byte *pDestination,
+                       std::size_t count) {
+  std::size_t i = 0;
+  for (; i + 2 <= count; i += 2) {
+    _mm_storeu_si128(
+        reinterpret_cast<__m128i *>(pDestination + 8 * i),
+        packUnsigned16(encodeHalves(_mm_loadu_ps(pRgba + 4 * i)),
+                       encodeHalves(_mm_loadu_ps(pRgba + 4 * i + 4))));
+  }
+  Scalar::encodeRgba16Float(pRgba + 4 * i, pDestination + 8 * i, count - i);
+}
+
+// Writes four (depth, 0, 0, 1) pixels.
+void storeDepths(__m128 depths, float *pRgba) {
+  const __m128 base = _mm_setr_ps(0.0F, 0.0F, 0.0F, 1.0F);
+  _mm_storeu_ps(pRgba, _mm_move_ss(base, depths));
+  _mm_storeu_ps(pRgba + 4,
+                _mm_move_ss(base, _mm_shuffle_ps(depths, depths, 1)));
+  _mm_storeu_ps(pRgba + 8,
+                _mm_move_ss(base, _mm_shuffle_ps(depths, depths, 2)));
+  _mm_storeu_ps(pRgba + 12,
+                _mm_move_ss(base, _mm_shuffle_ps(depths, depths, 3)));
+}
+
+// The red channels of four pixels.
+__m128 loadReds(const float *pRgba) {
+  const __m128 first = _mm_unpacklo_ps(_mm_loadu_ps(pRgba),
+                                       _mm_loadu_ps(pRgba + 4));
+  const __m128 second = _mm_unpacklo_ps(_mm_loadu_ps(pRgba + 8),
+                                        _mm_loadu_ps(pRgba + 12));
+  return _mm_movelh_ps(first, second);
+}
+
+void decodeDepth16(const std::byte *pSource, float *pRgba, std::size_t count) {
+  std::size_t i = 0;
+  for (; i + 4 <= count; i += 4) {
+    const __m128i depths = _mm_unpacklo_epi16(
+        _mm_loadl_epi64(reinterpret_cast<const __m128i *>(pSource + 2 * i)),
+        _mm_setzero_si128());
+    storeDepths(
+        _mm_mul_ps(_mm_cvtepi32_ps(depths), _mm_set1_ps(kInverse65535)),
+        pRgba + 4 * i);
+  }
+  Scalar::decodeDepth16(pSource + 2 * i, pRgba + 4 * i, count - i);
+}
+
+void encodeDepth16(const float *pRgba, std::byte *pDestination,
+                   std::size_t count) {
+  std::size_t i = 0;
+  for (; i + 4 <= count; i += 4) {
+    const __m128i depths = _mm_cvtps_epi32(
+        _mm_mul_ps(clamp01(loadReds(pRgba + 4 * i)), _mm_set1_ps(65535.0F)));
+    _mm_storel_epi64(reinterpret_cast<__m128i *>(pDestination + 2 * i),
+                     packUnsigned16(depths, depths));
+  }
+  Scalar::encodeDepth16(pRgba + 4 * i, pDestination + 2 * i, count - i);
+}
+
+void decodeDepth32Float(const std::byte *pSource, float *pRgba,
+                        std::size_t count) {
+  std::size_t i = 0;
+  for (; i + 4 <= count; i += 4) {
+    storeDepths(_mm_loadu_ps(reinterpret_cast<const float *>(pSource + 4 * i)),
+                pRgba + 4 * i);
+  }
+  Scalar::decodeDepth32Float(pSource + 4 * i, pRgba + 4 * i, count - i);
+}
+
+void encodeDepth32Float(const float *pRgba, std::byte *pDestination,
+                        std::size_t count) {
+  std::size_t i = 0;
+  for (; i + 4 <= count; i += 4) {
+    _mm_storeu_ps(reinterpret_cast<float *>(pDestination + 4 * i),
+                  loadReds(pRgba + 4 * i));
+  }
+  Scalar::encodeDepth32Float(pRgba + 4 * i, pDestination + 4 * i, count - i);
+}
+
+void swapRedBlue8(const std::byte *pSource, std::byte *pDestination,
+                  std::size_t count) {
+  const __m128i keep = _mm_set1_epi32(static_cast<int>(0xFF00FF00));
+  const __m128i low = _mm_set1_epi32(0xFF);
+  std::size_t i = 0;
+  for (; i + 4 <= count; i += 4) {
+    const __m128i pixels = _mm_loadu_si128(
+        reinterpret_cast<const __m128i *>(pSource + 4 * i));
+    const __m128i swapped = _mm_or_si128(
+        _mm_and_si128(pixels, keep),
+        _mm_or_si128(_mm_and_si128(_mm_srli_epi32(pixels, 16), low),
+                     _mm_slli_epi32(_mm_and_si128(pixels, low), 16)));
+    _mm_storeu_si128(reinterpret_cast<__m128i *>(pDestination + 4 * i),
+                     swapped);
+  }
+  Scalar::swapRedBlue8(pSource + 4 * i, pDestination + 4 * i, count - i);
+}
+
+void swapRedBlue10(const std::byte *pSource, std::byte *pDestination,
+                   std::size_t count) {
+  const __m128i keep = _mm_set1_epi32(static_cast<int>(0xC00FFC00));
+  const __m128i field = _mm_set1_epi32(1023);
+  std::size_t i = 0;
+  for (; i + 4 <= count; i += 4) {
+    const __m128i pixels = _mm_loadu_si128(
+        reinterpret_cast<const __m128i *>(pSource + 4 * i));
+    const __m128i swapped = _mm_or_si128(
+        _mm_and_si128(pixels, keep),
+        _mm_or_si128(_mm_and_si128(_mm_srli_epi32(pixels, 20), field),
+                     _mm_slli_epi32(_mm_and_si128(pixels, field), 20)));
+    _mm_storeu_si128(reinterpret_cast<__m128i *>(pDestination + 4 * i),
+                     swapped);
+  }
+  Scalar::swapRedBlue10(pSource + 4 * i, pDestination + 4 * i, count - i);
+}
+
+}  // namespace Sse
+
+#endif
+
+#if GFX_PIXEL_AVX2
+
+// AVX2, built with target attributes whatever the build's flags and only
+// called when simdLevel() is AVX2. Two pixels per register; sRGB uses
+// gathers into the tables, halves use F16C where the CPU has it.
+namespace Avx2 {
+
+#define GFX_PIXEL_AVX2_TARGET __attribute__((target("avx2,fma")))
+#define GFX_PIXEL_F16C_TARGET __attribute__((target("avx2,fma,f16c")))
+
+bool cpuHasF16c() {
+  static const bool hasF16c = __builtin_cpu_supports("f16c");
+  return hasF16c;
+}
+
+template <bool kBgr>
+GFX_PIXEL_AVX2_TARGET __m256 swizzle(__m256 pixels) {
+  return kBgr ? _mm256_shuffle_ps(pixels, pixels, _MM_SHUFFLE(3, 0, 1, 2))
+              : pixels;
+}
+
+template <bool kBgr, bool kSrgb>
+GFX_PIXEL_AVX2_TARGET void decodeRgba8(const std::byte *pSource,
+                                       float *pRgba, std::size_t count) {
+  const SrgbTables &tables = srgbTables();
+  // Alpha lanes look up the unorm half of the table.
+  const __m256i alphaOffset = _mm256_setr_epi32(0, 0, 0, 256, 0, 0, 0, 256);
+  std::size_t i = 0;
+  for (; i + 2 <= count; i += 2) {
+    const __m256i bytes = _mm256_cvtepu8_epi32(
+        _mm_loadl_epi64(reinterpret_cast<const __m128i *>(pSource + 4 * i)));
+    __m256 pixels;
+    if (kSrgb) {
+      pixels = _mm256_i32gather_ps(
+          tables.decode, _mm256_add_epi32(bytes, alphaOffset), 4);
+    } else {
+      pixels = _mm256_mul_ps(_mm256_cvtepi32_ps(bytes),
+                             _mm256_set1_ps(kInverse255));
+    }
+    _mm256_storeu_ps(pRgba + 4 * i, swizzle<kBgr>(pixels));
+  }
+  Scalar::decodeRgba8<kBgr, kSrgb>(pSource + 4 * i, pRgba + 4 * i,
+                                   count - i);
+}
+
+// Codes of two pixels as eight 32-bit lanes.
+template <bool kBgr, bool kSrgb>
+GFX_PIXEL_AVX2_TARGET __m256i encodePixels(const float *pRgba,
+                                           const SrgbTables &tables) {
+  const __m256 pixels = _mm256_min_ps(
+      _mm256_max_ps(swizzle<kBgr>(_mm256_loadu_ps(pRgba)),
+                    _mm256_setzero_ps()),
+      _mm256_set1_ps(1.0F));
+  const __m256i linear =
+      _mm256_cvtps_epi32(_mm256_mul_ps(pixels, _mm256_set1_ps(255.0F)));
+  if (!kSrgb) {
+    return linear;
+  }
+  const __m256 x =
+      _mm256_max_ps(pixels, _mm256_set1_ps(bitsFloat(kSrgbMinimumBits)));
+  const __m256i bucket = _mm256_srli_epi32(
+      _mm256_sub_epi32(_mm256_castps_si256(x),
+                       _mm256_set1_epi32(kSrgbMinimumBits)),
+      kSrgbBucketShift);
+  const __m256i code = _mm256_i32gather_epi32(tables.buckets, bucket, 4);
+  const __m256 threshold = _mm256_i32gather_ps(
+      tables.thresholds, _mm256_add_epi32(code, _mm256_set1_epi32(1)), 4);
+  const __m256i srgb = _mm256_sub_epi32(
+      code,
+      _mm256_castps_si256(_mm256_cmp_ps(x, threshold, _CMP_GE_OQ)));
+  return _mm256_blend_epi32(srgb, linear, 0x88);
+}
+
+template <bool kBgr, bool kSrgb>
+GFX_PIXEL_AVX2_TARGET void encodeRgba8(const float *pRgba,
+                                       std::byte *pDestination,
+                                       std::size_t count) {
+  const SrgbTables &tables = srgbTables();
+  std::size_t i = 0;
+  for (; i + 4 <= count; i += 4) {
+    const __m256i first = encodePixels<kBgr, kSrgb>(pRgba + 4 * i, tables);
+    const __m256i second =
+        encodePixels<kBgr, kSrgb>(pRgba + 4 * i + 8, tables);
+    // packs works per 128-bit lane; put the pixels back in order.
+    const __m256i words = _mm256_permute4x64_epi64(
+        _mm256_packs_epi32(first, second), _MM_SHUFFLE(3, 1, 2, 0));
+    _mm_storeu_si128(reinterpret_cast<__m128i *>(pDestination + 4 * i),
+                     _mm_packus_epi16(_mm256_castsi256_si128(words),
+                                      _mm256_extracti128_si256(words, 1)));
+  }
+  Scalar::encodeRgba8<kBgr, kSrgb>(pRgba + 4 * i, pDestination + 4 * i,
+                                   count - i);
+}
+
+GFX_PIXEL_F16C_TARGET void decodeRgba16FloatF16c(const std::byte *pSource,
+                                                 float *pRgba,
+                                                 std::size_t count) {
+  std::size_t i = 0;
+  for (; i + 2 <= count; i += 2) {
+    _mm256_storeu_ps(pRgba + 4 * i,
+                     _mm256_cvtph_ps(_mm_loadu_si128(
+                         reinterpret_cast<const __m128i *>(pSource + 8 * i))));
+  }
+  Scalar::decodeRgba16Float(pSource + 8 * i, pRgba + 4 * i, count - i);
+}
+
+GFX_PIXEL_F16C_TARGET void encodeRgba16FloatF16c(const float *pRgba,
+                                                 std::byte *pDestination,
+                                                 std::size_t count) {
+  std::size_t i = 0;
+  for (; i + 2 <= count; i += 2) {
+    _mm_storeu_si128(
+        reinterpret_cast<__m128i *>(pDestination + 8 * i),
+        _mm256_cvtps_ph(_mm256_loadu_ps(pRgba + 4 * i),
+                        _MM_FROUND_TO_NEAREST_INT | _MM_FROUND_NO_EXC));
+  }
+  Scalar::encodeRgba16Float(pRgba + 4 * i, pDestination + 8 * i, count - i);
+}
+
+void decodeRgba16Float(const std::byte *pSource, float *pRgba,
+                       std::size_t count) {
+  if (cpuHasF16c()) {
+    decodeRgba16FloatF16c(pSource, pRgba, count);
+  } else {
+    Sse::decodeRgba16Float(pSource, pRgba, count);
+  }
+}
+
+void encodeRgba16Float(const float *pRgba, std::byte *pDestination,
+                       std::size_t count) {
+  if (cpuHasF16c()) {
+    encodeRgba16FloatF16c(pRgba, pDestination, count);
+  } else {
+    Sse::encodeRgba16Float(pRgba, pDestination, count);
+  }
+}
+
+GFX_PIXEL_AVX2_TARGET void swapRedBlue8(const std::byte *pSource,
+                                        std::byte *pDestination,
+                                        std::size_t count) {
+  const __m256i shuffle = _mm256_setr_epi8(
+      2, 1, 0, 3, 6, 5, 4, 7, 10, 9, 8, 11, 14, 13, 12, 15, 2, 1, 0, 3, 6, 5,
+      4, 7, 10, 9, 8, 11, 14, 13, 12, 15);
+  std::size_t i = 0;
+  for (; i + 8 <= count; i += 8) {
+    const __m256i pixels = _mm256_loadu_si256(
+        reinterpret_cast<const __m256i *>(pSource + 4 * i));
+    _mm256_storeu_si256(reinterpret_cast<__m256i *>(pDestination + 4 * i),
+                        _mm256_shuffle_epi8(pixels, shuffle));
+  }
+  Scalar::swapRedBlue8(pSource + 4 * i, pDestination + 4 * i, count - i);
+}
+
+#undef GFX_PIXEL_F16C_TARGET
+#undef GFX_PIXEL_AVX2_TARGET
+
+}  // namespace Avx2
+
+#endif
+
+#if GFX_MATH_SSE
+#define GFX_PIXEL_SSE(...) &Sse::__VA_ARGS__
+#else
+#define GFX_PIXEL_SSE(...) nullptr
+#endif
+#if GFX_PIXEL_AVX2
+#define GFX_PIXEL_AVX2_KERNEL(...) &Avx2::__VA_ARGS__
+#else
+#define GFX_PIXEL_AVX2_KERNEL(...) nullptr
+#endif
+
+struct FormatEntry {
+  PixelFormat format;
+  const char *pName;
+  std::uint8_t bytesPerPixel;
+  DecodeFunction decode[kKernelLevels];
+  EncodeFunction encode[kKernelLevels];
+};
+
+const FormatEntry kFormats[] = {
+    {PixelFormat::RGBA8Unorm,
+     "RGBA8Unorm",
+     4,
+     {&Scalar::decodeRgba8<false, false>, GFX_PIXEL_SSE(decodeRgba8<false>),
+      GFX_PIXEL_AVX2_KERNEL(decodeRgba8<false, false>)},
+     {&Scalar::encodeRgba8<false, false>, GFX_PIXEL_SSE(encodeRgba8<false>),
+      GFX_PIXEL_AVX2_KERNEL(encodeRgba8<false, false>)}},
+    {PixelFormat::RGBA8Unorm_sRGB,
+     "RGBA8Unorm_sRGB",
+     4,
+     {&Scalar::decodeRgba8<false, true>, nullptr,
+      GFX_PIXEL_AVX2_KERNEL(decodeRgba8<false, true>)},
+     {&Scalar::encodeRgba8<false, true>, nullptr,
+      GFX_PIXEL_AVX2_KERNEL(encodeRgba8<false, true>)}},
+    {PixelFormat::RGB10A2Unorm,
+     "RGB10A2Unorm",
+     4,
+     {&Scalar::decodeRgb10A2<false>, GFX_PIXEL_SSE(decodeRgb10A2<false>),
+      nullptr},
+     {&Scalar::encodeRgb10A2<false>, GFX_PIXEL_SSE(encodeRgb10A2<false>),
+      nullptr}},
+    {PixelFormat::RG11B10Float,
+     "RG11B10Float",
+     4,
+     {&Scalar::decodeRg11B10, GFX_PIXEL_SSE(decodeRg11B10), nullptr},
+     {&Scalar::encodeRg11B10, GFX_PIXEL_SSE(encodeRg11B10), nullptr}},
+    {PixelFormat::BGRA8Unorm,
+     "BGRA8Unorm",
+     4,
+     {&Scalar::decodeRgba8<true, false>, GFX_PIXEL_SSE(decodeRgba8<true>),
+      GFX_PIXEL_AVX2_KERNEL(decodeRgba8<true, false>)},
+     {&Scalar::encodeRgba8<true, false>, GFX_PIXEL_SSE(encodeRgba8<true>),
+      GFX_PIXEL_AVX2_KERNEL(encodeRgba8<true, false>)}},
+    {PixelFormat::BGRA8Unorm_sRGB,
+     "BGRA8Unorm_sRGB",
+     4,
+     {&Scalar::decodeRgba8<true, true>, nullptr,
+      GFX_PIXEL_AVX2_KERNEL(decodeRgba8<true, true>)},
+     {&Scalar::encodeRgba8<true, true>, nullptr,
+      GFX_PIXEL_AVX2_KERNEL(encodeRgba8<true, true>)}},
+    {PixelFormat::BGR10A2Unorm,
+     "BGR10A2Unorm",
+     4,
+     {&Scalar::decodeRgb10A2<true>, GFX_PIXEL_SSE(decodeRgb10A2<true>),
+      nullptr},
+     {&Scalar::encodeRgb10A2<true>, GFX_PIXEL_SSE(encodeRgb10A2<true>),
+      nullptr}},
+    {PixelFormat::RGBA16Float,
+     "RGBA16Float",
+     8,
+     {&Scalar::decodeRgba16Float, GFX_PIXEL_SSE(decodeRgba16Float),
+      GFX_PIXEL_AVX2_KERNEL(decodeRgba16Float)},
+     {&Scalar::encodeRgba16Float, GFX_PIXEL_SSE(encodeRgba16Float),
+      GFX_PIXEL_AVX2_KERNEL(encodeRgba16Float)}},
+    {PixelFormat::RGBA32Float,
+     "RGBA32Float",
+     16,
+     {&Scalar::decodeRgba32Float, nullptr, nullptr},
+     {&Scalar::encodeRgba32Float, nullptr, nullptr}},
+    {PixelFormat::Depth16Unorm,
+     "Depth16Unorm",
+     2,
+     {&Scalar::decodeDepth16, GFX_PIXEL_SSE(decodeDepth16), nullptr},
+     {&Scalar::encodeDepth16, GFX_PIXEL_SSE(encodeDepth16), nullptr}},
+    {PixelFormat::Depth32Float,
+     "Depth32Float",
+     4,
+     {&Scalar::decodeDepth32Float, GFX_PIXEL_SSE(decodeDepth32Float),
+      nullptr},
+     {&Scalar::encodeDepth32Float, GFX_PIXEL_SSE(encodeDepth32Float),
+      nullptr}},
+};
+
+// Pairs with a kernel of their own, bypassing RGBA32Float. Each gives the
+// same bytes as decoding and encoding would.
+struct DirectEntry {
+  PixelFormat source;
+  PixelFormat destination;
+  ConvertFunction convert[kKernelLevels];
+};
+
+const DirectEntry kDirectConversions[] = {
+    {PixelFormat::RGBA8Unorm,
+     PixelFormat::BGRA8Unorm,
+     {&Scalar::swapRedBlue8, GFX_PIXEL_SSE(swapRedBlue8),
+      GFX_PIXEL_AVX2_KERNEL(swapRedBlue8)}},
+    {PixelFormat::BGRA8Unorm,
+     PixelFormat::RGBA8Unorm,
+     {&Scalar::swapRedBlue8, GFX_PIXEL_SSE(swapRedBlue8),
+      GFX_PIXEL_AVX2_KERNEL(swapRedBlue8)}},
+    {PixelFormat::RGBA8Unorm_sRGB,
+     PixelFormat::BGRA8Unorm_sRGB,
+     {&Scalar::swapRedBlue8, GFX_PIXEL_SSE(swapRedBlue8),
+      GFX_PIXEL_AVX2_KERNEL(swapRedBlue8)}},
+    {PixelFormat::BGRA8Unorm_sRGB,
+     PixelFormat::RGBA8Unorm_sRGB,
+     {&Scalar::swapRedBlue8, GFX_PIXEL_SSE(swapRedBlue8),
+      GFX_PIXEL_AVX2_KERNEL(swapRedBlue8)}},
+    {PixelFormat::RGB10A2Unorm,
+     PixelFormat::BGR10A2Unorm,
+     {&Scalar::swapRedBlue10, GFX_PIXEL_SSE(swapRedBlue10), nullptr}},
+    {PixelFormat::BGR10A2Unorm,
+     PixelFormat::RGB10A2Unorm,
+     {&Scalar::swapRedBlue10, GFX_PIXEL_SSE(swapRedBlue10), nullptr}},
+    {PixelFormat::RGBA8Unorm_sRGB,
+     PixelFormat::RGBA8Unorm,
+     {&Scalar::convertSrgb8<false, true>, nullptr, nullptr}},
+    {PixelFormat::BGRA8Unorm_sRGB,
+     PixelFormat::BGRA8Unorm,
+     {&Scalar::convertSrgb8<false, true>, nullptr, nullptr}},
+    {PixelFormat::RGBA8Unorm_sRGB,
+     PixelFormat::BGRA8Unorm,
+     {&Scalar::convertSrgb8<true, true>, nullptr, nullptr}},
+    {PixelFormat::BGRA8Unorm_sRGB,
+     PixelFormat::RGBA8Unorm,
+     {&Scalar::convertSrgb8<true, true>, nullptr, nullptr}},
+    {PixelFormat::RGBA8Unorm,
+     PixelFormat::RGBA8Unorm_sRGB,
+     {&Scalar::convertSrgb8<false, false>, nullptr, nullptr}},
+    {PixelFormat::BGRA8Unorm,
+     PixelFormat::BGRA8Unorm_sRGB,
+     {&Scalar::convertSrgb8<false, false>, nullptr, nullptr}},
+    {PixelFormat::RGBA8Unorm,
+     PixelFormat::BGRA8Unorm_sRGB,
+     {&Scalar::convertSrgb8<true, false>, nullptr, nullptr}},
+    {PixelFormat::BGRA8Unorm,
+     PixelFormat::RGBA8Unorm_sRGB,
+     {&Scalar::convertSrgb8<true, false>, nullptr, nullptr}},
+};
+
+#undef GFX_PIXEL_AVX2_KERNEL
+#undef GFX_PIXEL_SSE
+
+const FormatEntry *findFormat(PixelFormat pixelFormat) {
+  for (const FormatEntry &entry : kFormats) {
+    if (entry.format == pixelFormat) {
+      return &entry;
+    }
+  }
+  return nullptr;
+}
+
+// The best variant at the current SIMD level.
+template <typename Function>
+Function pickKernel(const Function (&kernels)[kKernelLevels]) {
+  int level = kScalar;
+  switch (simdLevel()) {
+    case SimdLevel::AVX2:
+      level = kAvx2;
+      break;
+    case SimdLevel::SSE:
+      level = kSse;
+      break;
+    default:
+      break;
+  }
+  while (kernels[level] == nullptr) {
+    --level;
+  }
+  return kernels[level];
+}
+
+struct Conversion {
+  std::size_t sourceBytesPerPixel = 0;
+  std::size_t destinationBytesPerPixel = 0;
+  bool copy = false;
+  ConvertFunction convert = nullptr;
+  DecodeFunction decode = nullptr;
+  EncodeFunction encode = nullptr;
+};
+
+bool findConversion(PixelFormat sourceFormat, PixelFormat destinationFormat,
+                    Conversion &conversion) {
+  const FormatEntry *pSource = findFormat(sourceFormat);
+  const FormatEntry *pDestination = findFormat(destinationFormat);
+  if (pSource == nullptr || pDestination == nullptr) {
+    return false;
+  }
+  conversion.sourceBytesPerPixel = pSource->bytesPerPixel;
+  conversion.destinationBytesPerPixel = pDestination->bytesPerPixel;
+  if (sourceFormat == destinationFormat) {
+    conversion.copy = true;
+    return true;
+  }
+  for (const DirectEntry &entry : kDirectConversions) {
+    if (entry.source == sourceFormat &&
+        entry.destination == destinationFormat) {
+      conversion.convert = pickKernel(entry.convert);
+      return true;
+    }
+  }
+  conversion.decode = pickKernel(pSource->decode);
+  conversion.encode = pickKernel(pDestination->encode);
+  return true;
+}
+
+void convertRow(const Conversion &conversion, const std::byte *pSource,
+                std::byte *pDestination, std::size_t count) {
+  if (conversion.copy) {
+    std::memmove(pDestination, pSource,
+                 count * conversion.sourceBytesPerPixel);
+    return;
+  }
+  if (conversion.convert != nullptr) {
+    conversion.convert(pSource, pDestination, count);
+    return;
+  }
+  alignas(32) float rgba[kBlockPixels * 4];
+  for (std::size_t begin = 0; begin < count; begin += kBlockPixels) {
+    const std::size_t blockCount = std::min(kBlockPixels, count - begin);
+    conversion.decode(pSource + begin * conversion.sourceBytesPerPixel, rgba,
+                      blockCount);
+    conversion.encode(
+        rgba, pDestination + begin * conversion.destinationBytesPerPixel,
+        blockCount);
+  }
+}
+
+}  // namespace
+
+std::size_t bytesPerPixel(PixelFormat pixelFormat) {
+  const FormatEntry *pEntry = findFormat(pixelFormat);
+  return pEntry != nullptr ? pEntry->bytesPerPixel : 0;
+}
+
+const char *pixelFormatName(PixelFormat pixelFormat) {
+  const FormatEntry *pEntry = findFormat(pixelFormat);
+  return pEntry != nullptr ? pEntry->pName : "Invalid";
+}
+
+bool canConvertPixels(PixelFormat sourceFormat,
+                      PixelFormat destinationFormat) {
+  Conversion conversion;
+  return findConversion(sourceFormat, destinationFormat, conversion);
+}
+
+bool convertPixels(PixelFormat sourceFormat, const void *pSource,
+                   PixelFormat destinationFormat, void *pDestination,
+                   std::size_t pixelCount) {
+  Conversion conversion;
+  if (!findConversion(sourceFormat, destinationFormat, conversion)) {
+    return false;
+  }
+  convertRow(conversion, static_cast<const std::byte *>(pSource),
+             static_cast<std::byte *>(pDestination), pixelCount);
+  return true;
+}
+
+bool convertPixels(PixelFormat sourceFormat, const void *pSource,
+                   std::size_t sourceBytesPerRow,
+                   PixelFormat destinationFormat, void *pDestination,
+                   std::size_t destinationBytesPerRow, std::size_t width,
+                   std::size_t height, JobSystem *pJobSystem) {
+  Conversion conversion;
+  if (!findConversion(sourceFormat, destinationFormat, conversion)) {
+    return false;
+  }
+  const auto *pSourceBytes = static_cast<const std::byte *>(pSource);
+  auto *pDestinationBytes = static_cast<std::byte *>(pDestination);
+  const auto convertRows = [&](std::size_t begin, std::size_t end) {
+    for (std::size_t row = begin; row < end; ++row) {
+      convertRow(conversion, pSourceBytes + row * sourceBytesPerRow,
+                 pDestinationBytes + row * destinationBytesPerRow, width);
+    }
+  };
+  const std::size_t rowBytes =
+      width * std::max(conversion.sourceBytesPerPixel,
+                       conversion.destinationBytesPerPixel);
+  if (pJobSystem != nullptr && rowBytes * height >= kMinParallelBytes) {
+    pJobSystem->parallelFor(
+        height, std::max<std::size_t>(1, kMinParallelBytes / 4 / rowBytes),
+        convertRows);
+  } else {
+    convertRows(0, height);
+  }
+  return true;
+}
+
+}  // namespace Gfx
@@ -0,0 +1,46 @@
+#pragma once
+
+#include <Gfx/JobSystem.hpp>
+#include <Gfx/Types.hpp>
+
+#include <cstddef>
+
+// Conversions between the pixel formats of Types.hpp, for texture uploads and
+// readbacks.
+//
+// Every format decodes to and encodes from linear RGBA32Float; a conversion
+// runs the two back to back over small blocks that stay in L1. Hot pairs,
+// such as the RGBA8 <-> BGRA8 swizzles and the 8-bit sRGB <-> linear tables,
+// have direct kernels instead. Decoders and encoders exist per SimdLevel,
+// with scalar versions as the fallback; conversions use the level simdLevel()
+// returns, and every level gives the same bits.
+//
+// Rounding follows Metal's format conversion rules: normalized formats round
+// to nearest, sRGB encodes round to the nearest sRGB value, and float formats
+// round to nearest even. Finite values too large for RG11B10Float clamp to its
+// largest finite value; RGBA16Float follows IEEE and overflows to infinity.
+// Depth formats decode to (depth, 0, 0, 1) and encode red.
+namespace Gfx {
+
+// 0 for Invalid.
+[[nodiscard]] std::size_t bytesPerPixel(PixelFormat pixelFormat);
+[[nodiscard]] const char *pixelFormatName(PixelFormat pixelFormat);
+
+[[nodiscard]] bool canConvertPixels(PixelFormat sourceFormat,
+                                    PixelFormat destinationFormat);
+
+// Converts pixelCount tightly packed pixels. Returns false, writing nothing,
+// if the pair can't be converted. The buffers must not overlap unless the
+// formats are the same.
+bool convertPixels(PixelFormat sourceFormat, const void *pSource,
+                   PixelFormat destinationFormat, void *pDestination,
+                   std::size_t pixelCount);
+// Converts a width x height region whose rows start bytesPerRow apart. With
+// a JobSystem, rows are spread over parallelFor ranges.
+bool convertPixels(PixelFormat sourceFormat, const void *pSource,
+                   std::size_t sourceBytesPerRow,
+                   PixelFormat destinationFormat, void *pDestination,
+                   std::size_t destinationBytesPerRow, std::size_t width,
+                   std::size_t height, JobSystem *pJobSystem = nullptr);
+
+}  // namespace Gfx
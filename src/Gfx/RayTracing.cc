@@ -0,0 +1,470 @@
+#include <Gfx/RayTracing.hpp>
+
+#include <algorithm>
+#include <cstring>
+
+namespace Gfx {
+
+namespace Detail {
+
+// Four rays in structure-of-arrays form, one per lane. Lanes outside
+// activeMask repeat another ray and are never reported.
+struct RayPacket {
+  Float4 origin[3];
+  Float4 direction[3];
+  Float4 inverseDirection[3];
+  Float4 minDistance;
+  alignas(16) float maxDistance[4];
+  int activeMask;
+};
+
+}  // namespace Detail
+
+namespace {
+
+using Detail::RayPacket;
+using Triangle = PrimitiveAccelerationStructure::Triangle;
+
+// Packets per parallelFor range.
+constexpr std::size_t kPacketGrain = 64;
+// Triangles whose determinant squares to less are taken as parallel to the
+// ray.
+constexpr float kMinSquaredDeterminant = 1e-24F;
+
+float closest(Float4 distances, int lanes) {
+  alignas(16) float values[4];
+  distances.store(values);
+  float result = INFINITY;
+  for (int lane = 0; lane < 4; ++lane) {
+    if ((lanes & (1 << lane)) != 0) {
+      result = std::min(result, values[lane]);
+    }
+  }
+  return result;
+}
+
+// Slab test of every active lane against a box. Returns the lanes that enter
+// it before their maxDistance and sets entry to the entry distances.
+int enterMask(const PackedFloat3 &boxMin, const PackedFloat3 &boxMax,
+              const RayPacket &packet, Float4 &entry) {
+  const float *pMin = &boxMin.x;
+  const float *pMax = &boxMax.x;
+  Float4 lower = packet.minDistance;
+  Float4 upper = Float4::load(packet.maxDistance);
+  for (int axis = 0; axis < 3; ++axis) {
+    const Float4 near = (Float4::splat(pMin[axis]) - packet.origin[axis]) *
+                        packet.inverseDirection[axis];
+    const Float4 far = (Float4::splat(pMax[axis]) - packet.origin[axis]) *
+                       packet.inverseDirection[axis];
+    // min and max return their second operand when either is NaN, so the
+    // NaNs of 0 * infinity on a slab boundary are ignored.
+    lower = max(min(near, far), lower);
+    upper = min(max(near, far), upper);
+  }
+  entry = lower;
+  return lessEqualMask(lower, upper) & packet.activeMask;
+}
+
+// Möller-Trumbore for four rays against one triangle. Returns the lanes of
+// lanes that hit it within their distance range.
+int intersectTriangle(const Triangle &triangle, const RayPacket &packet,
+                      int lanes, Float4 &t, Float4 &u, Float4 &v) {
+  const Float4 e1x = Float4::splat(triangle.edge1.x);
+  const Float4 e1y = Float4::splat(triangle.edge1.y);
+  const Float4 e1z = Float4::splat(triangle.edge1.z);
+  const Float4 e2x = Float4::splat(triangle.edge2.x);
+  const Float4 e2y = Float4::splat(triangle.edge2.y);
+  const Float4 e2z = Float4::splat(triangle.edge2.z);
+  const Float4 &dx = packet.direction[0];
+  const Float4 &dy = packet.direction[1];
+  const Float4 &dz = packet.direction[2];
+
+  const Float4 px = dy * e2z - dz * e2y;
+  const Float4 py = dz * e2x - dx * e2z;
+  const Float4 pz = dx * e2y - dy * e2x;
+  const Float4 determinant = e1x * px + e1y * py + e1z * pz;
+  const Float4 inverse = Float4::splat(1.0F) / determinant;
+  const Float4 sx = packet.origin[0] - Float4::splat(triangle.vertex.x);
+  const Float4 sy = packet.origin[1] - Float4::splat(triangle.vertex.y);
+  const Float4 sz = packet.origin[2] - Float4::splat(triangle.vertex.z);
+  u = (sx * px + sy * py + sz * pz) * inverse;
+  const Float4 qx = sy * e1z - sz * e1y;
+  const Float4 qy = sz * e1x - sx * e1z;
+  const Float4 qz = sx * e1y - sy * e1x;
+  v = (dx * qx + dy * qy + dz * qz) * inverse;
+  t = (e2x * qx + e2y * qy + e2z * qz) * inverse;
+
+  const Float4 zero;
+  return lanes &
+         lessMask(Float4::splat(kMinSquaredDeterminant),
+                  determinant * determinant) &
+         lessEqualMask(zero, u) & lessEqualMask(zero, v) &
+         lessEqualMask(u + v, Float4::splat(1.0F)) &
+         lessMask(packet.minDistance, t) &
+         lessMask(t, Float4::load(packet.maxDistance));
+}
+
+// The same test for one ray, operation for operation, so both paths agree
+// to the bit.
+bool intersectTriangle(const Triangle &triangle, const float (&origin)[3],
+                       const float (&direction)[3], float minDistance,
+                       float maxDistance, float &t, float &u, float &v) {
+  const PackedFloat3 &e1 = triangle.edge1;
+  const PackedFloat3 &e2 = triangle.edge2;
+  const float dx = direction[0];
+  const float dy = direction[1];
+  const float dz = direction[2];
+
+  const float px = dy * e2.z - dz * e2.y;
+  const float py = dz * e2.x - dx * e2.z;
+  const float pz = dx * e2.y - dy * e2.x;
+  const float determinant = e1.x * px + e1.y * py + e1.z * pz;
+  const float inverse = 1.0F / determinant;
+  const float sx = origin[0] - triangle.vertex.x;
+  const float sy = origin[1] - triangle.vertex.y;
+  const float sz = origin[2] - triangle.vertex.z;
+  u = (sx * px + sy * py + sz * pz) * inverse;
+  const float qx = sy * e1.z - sz * e1.y;
+  const float qy = sz * e1.x - sx * e1.z;
+  const float qz = sx * e1.y - sy * e1.x;
+  v = (dx * qx + dy * qy + dz * qz) * inverse;
+  t = (e2.x * qx + e2.y * qy + e2.z * qz) * inverse;
+
+  return kMinSquaredDeterminant < determinant * determinant && 0.0F <= u &&
+         0.0F <= v && u + v <= 1.0F && minDistance < t && t < maxDistance;
+}
+
+// Walks bvh with the whole packet, nearest child first by the closest lane,
+// and calls visit(primitiveIndex, lanes) for the primitives of every leaf
+// that lanes reach. visit may lower the packet's maxDistance, which prunes
+// the rest of the walk.
+template <typename Visit>
+void traverse(const Bvh &bvh, const RayPacket &packet, Visit &&visit) {
+  if (bvh.empty()) {
+    return;
+  }
+  const BvhNodeArray &nodes = bvh.nodes();
+  const std::vector<std::uint32_t> &primitives = bvh.primitiveIndices();
+  Float4 entry;
+  int lanes = enterMask(nodes[0].min, nodes[0].max, packet, entry);
+  if (lanes == 0) {
+    return;
+  }
+
+  std::uint32_t stack[Detail::kBvhStackSize];
+  int stackSize = 0;
+  std::uint32_t nodeIndex = 0;
+  while (true) {
+    const BvhNode &node = nodes[nodeIndex];
+    if (node.isLeaf()) {
+      for (std::uint32_t i = 0; i < node.count; ++i) {
+        visit(primitives[node.leftFirst + i], lanes);
+      }
+    } else {
+      std::uint32_t nearIndex = node.leftFirst;
+      std::uint32_t farIndex = node.leftFirst + 1;
+      Float4 nearEntry;
+      Float4 farEntry;
+      int nearLanes =
+          enterMask(nodes[nearIndex].min, nodes[nearIndex].max, packet,
+                    nearEntry);
+      int farLanes = enterMask(nodes[farIndex].min, nodes[farIndex].max,
+                               packet, farEntry);
+      if (nearLanes != 0 && farLanes != 0) {
+        if (closest(farEntry, farLanes) < closest(nearEntry, nearLanes)) {
+          std::swap(nearIndex, farIndex);
+          std::swap(nearLanes, farLanes);
+        }
+        stack[stackSize++] = farIndex;
+        nodeIndex = nearIndex;
+        lanes = nearLanes;
+        continue;
+      }
+      if (nearLanes != 0 || farLanes != 0) {
+        nodeIndex = nearLanes != 0 ? nearIndex : farIndex;
+        lanes = nearLanes | farLanes;
+        continue;
+      }
+    }
+    // Pop, retesting against the distances closer hits have lowered since.
+    while (true) {
+      if (stackSize == 0) {
+        return;
+      }
+      nodeIndex = stack[--stackSize];
+      lanes = enterMask(nodes[nodeIndex].min, nodes[nodeIndex].max, packet,
+                        entry);
+      if (lanes != 0) {
+        break;
+      }
+    }
+  }
+}
+
+PackedFloat3 loadVertex(const TriangleGeometryDescriptor &descriptor,
+                        std::size_t index) {
+  PackedFloat3 vertex;
+  std::memcpy(&vertex,
+              static_cast<const std::byte *>(descriptor.pVertices) +
+                  index * descriptor.vertexStride,
+              sizeof(vertex));
+  return vertex;
+}
+
+PackedFloat3 operator-(const PackedFloat3 &lhs, const PackedFloat3 &rhs) {
+  return {lhs.x - rhs.x, lhs.y - rhs.y, lhs.z - rhs.z};
+}
+
+}  // namespace
+
+void PrimitiveAccelerationStructure::build(
+    const TriangleGeometryDescriptor &descriptor, JobSystem *pJobSystem,
+    const BvhBuildOptions &options) {
+  const std::size_t count = descriptor.triangleCount;
+  _boxes.clear();
+  _triangles.resize(count);
+  std::vector<AxisAlignedBoundingBox> bounds(count);
+  for (std::size_t i = 0; i < count; ++i) {
+    std::size_t indices[3] = {3 * i, 3 * i + 1, 3 * i + 2};
+    if (descriptor.pIndices != nullptr) {
+      for (std::size_t &index : indices) {
+        index = descriptor.pIndices[index];
+      }
+    }
+    const PackedFloat3 a = loadVertex(descriptor, indices[0]);
+    const PackedFloat3 b = loadVertex(descriptor, indices[1]);
+    const PackedFloat3 c = loadVertex(descriptor, indices[2]);
+    _triangles[i] = {a, b - a, c - a};
+    bounds[i] = {{std::min({a.x, b.x, c.x}), std::min({a.y, b.y, c.y}),
+                  std::min({a.z, b.z, c.z})},
+                 {std::max({a.x, b.x, c.x}), std::max({a.y, b.y, c.y}),
+                  std::max({a.z, b.z, c.z})}};
+  }
+  _bvh.build(bounds.data(), count, pJobSystem, options);
+}
+
+void PrimitiveAccelerationStructure::build(
+    const BoundingBoxGeometryDescriptor &descriptor, JobSystem *pJobSystem,
+    const BvhBuildOptions &options) {
+  _triangles.clear();
+  _boxes.assign(descriptor.pBoundingBoxes,
+                descriptor.pBoundingBoxes + descriptor.boundingBoxCount);
+  _bvh.build(_boxes.data(), _boxes.size(), pJobSystem, options);
+}
+
+void InstanceAccelerationStructure::build(
+    const AccelerationStructureInstanceDescriptor *pInstances,
+    std::size_t instanceCount,
+    const PrimitiveAccelerationStructure *const *ppStructures,
+    JobSystem *pJobSystem) {
+  _instances.resize(instanceCount);
+  std::vector<AxisAlignedBoundingBox> localBounds(instanceCount);
+  std::vector<PackedFloat4x3> transforms(instanceCount);
+  for (std::size_t i = 0; i < instanceCount; ++i) {
+    const AccelerationStructureInstanceDescriptor &descriptor = pInstances[i];
+    const PrimitiveAccelerationStructure *pStructure =
+        ppStructures[descriptor.accelerationStructureIndex];
+    localBounds[i] = pStructure->bvh().bounds();
+    transforms[i] = descriptor.transformationMatrix;
+    _instances[i] = {
+        Float4x4::fromPacked(descriptor.transformationMatrix)
+            .affineInverse()
+            .toPacked(),
+        pStructure, descriptor.mask};
+  }
+  _bvh.build(localBounds.data(), transforms.data(), instanceCount,
+             pJobSystem);
+}
+
+void InstanceAccelerationStructure::intersect(const Ray *pRays,
+                                              Intersection *pIntersections,
+                                              std::size_t count,
+                                              std::uint32_t mask,
+                                              JobSystem *pJobSystem) const {
+  const auto trace = [&](std::size_t begin, std::size_t end) {
+    for (std::size_t packetIndex = begin; packetIndex < end; ++packetIndex) {
+      const std::size_t first = packetIndex * 4;
+      const std::size_t lanes = std::min<std::size_t>(4, count - first);
+      alignas(16) float values[8][4];
+      for (std::size_t lane = 0; lane < 4; ++lane) {
+        const Ray &ray = pRays[first + std::min(lane, lanes - 1)];
+        values[0][lane] = ray.origin.x;
+        values[1][lane] = ray.origin.y;
+        values[2][lane] = ray.origin.z;
+        values[3][lane] = ray.direction.x;
+        values[4][lane] = ray.direction.y;
+        values[5][lane] = ray.direction.z;
+        values[6][lane] = ray.minDistance;
+        values[7][lane] = ray.maxDistance;
+      }
+      RayPacket packet;
+      for (int axis = 0; axis < 3; ++axis) {
+        packet.origin[axis] = Float4::load(values[axis]);
+        packet.direction[axis] = Float4::load(values[3 + axis]);
+        packet.inverseDirection[axis] =
+            Float4::splat(1.0F) / packet.direction[axis];
+      }
+      packet.minDistance = Float4::load(values[6]);
+      std::memcpy(packet.maxDistance, values[7], sizeof(packet.maxDistance));
+      packet.activeMask = (1 << lanes) - 1;
+
+      Intersection hits[4];
+      intersectPacket(packet, mask, hits);
+      std::copy_n(hits, lanes, pIntersections + first);
+    }
+  };
+
+  const std::size_t packetCount = (count + 3) / 4;
+  if (pJobSystem != nullptr && packetCount > kPacketGrain) {
+    pJobSystem->parallelFor(packetCount, kPacketGrain, trace);
+  } else {
+    trace(0, packetCount);
+  }
+}
+
+void InstanceAccelerationStructure::intersectPacket(
+    RayPacket &packet, std::uint32_t mask, Intersection *pHits) const {
+  traverse(_bvh.bvh(), packet, [&](std::uint32_t instanceIndex, int lanes) {
+    const Instance &instance = _instances[instanceIndex];
+    if ((instance.mask & mask) == 0) {
+      return;
+    }
+    // The packet in object space. Directions keep their length, so distances
+    // carry over between the spaces.
+    const PackedFloat3 *pColumns = instance.inverseTransform.columns;
+    RayPacket local;
+    for (int row = 0; row < 3; ++row) {
+      const Float4 c0 = Float4::splat((&pColumns[0].x)[row]);
+      const Float4 c1 = Float4::splat((&pColumns[1].x)[row]);
+      const Float4 c2 = Float4::splat((&pColumns[2].x)[row]);
+      const Float4 c3 = Float4::splat((&pColumns[3].x)[row]);
+      local.origin[row] = c0 * packet.origin[0] + c1 * packet.origin[1] +
+                          c2 * packet.origin[2] + c3;
+      local.direction[row] = c0 * packet.direction[0] +
+                             c1 * packet.direction[1] +
+                             c2 * packet.direction[2];
+      local.inverseDirection[row] = Float4::splat(1.0F) / local.direction[row];
+    }
+    local.minDistance = packet.minDistance;
+    std::memcpy(local.maxDistance, packet.maxDistance,
+                sizeof(local.maxDistance));
+    local.activeMask = lanes;
+
+    const PrimitiveAccelerationStructure &structure = *instance.pStructure;
+    const auto record = [&](int hitLanes, std::uint32_t primitive, Float4 t,
+                            Float4 u, Float4 v) {
+      for (int lane = 0; lane < 4; ++lane) {
+        if ((hitLanes & (1 << lane)) != 0) {
+          local.maxDistance[lane] = t[lane];
+          pHits[lane] = {t[lane], primitive, instanceIndex, u[lane], v[lane]};
+        }
+      }
+    };
+    if (!structure.triangles().empty()) {
+      traverse(structure.bvh(), local,
+               [&](std::uint32_t primitive, int primitiveLanes) {
+                 Float4 t;
+                 Float4 u;
+                 Float4 v;
+                 const int hitLanes =
+                     intersectTriangle(structure.triangles()[primitive],
+                                       local, primitiveLanes, t, u, v);
+                 if (hitLanes != 0) {
+                   record(hitLanes, primitive, t, u, v);
+                 }
+               });
+    } else {
+      traverse(structure.bvh(), local,
+               [&](std::uint32_t primitive, int primitiveLanes) {
+                 const AxisAlignedBoundingBox &box =
+                     structure.boxes()[primitive];
+                 Float4 entry;
+                 const int hitLanes =
+                     enterMask(box.min, box.max, local, entry) &
+                     primitiveLanes &
+                     lessMask(entry, Float4::load(local.maxDistance));
+                 if (hitLanes != 0) {
+                   record(hitLanes, primitive, entry, Float4(), Float4());
+                 }
+               });
+    }
+    std::memcpy(packet.maxDistance, local.maxDistance,
+                sizeof(packet.maxDistance));
+  });
+}
+
+Intersection InstanceAccelerationStructure::intersect(
+    const Ray &ray, std::uint32_t mask) const {
+  Intersection result;
+  float maxDistance = ray.maxDistance;
+  _bvh.bvh().raycast(
+      Float4::fromPacked(ray.origin, 1.0F),
+      Float4::fromPacked(ray.direction, 0.0F), maxDistance,
+      [&](std::uint32_t instanceIndex, float &instanceMaxDistance) {
+        const Instance &instance = _instances[instanceIndex];
+        if ((instance.mask & mask) == 0) {
+          return false;
+        }
+        const PackedFloat3 *pColumns = instance.inverseTransform.columns;
+        const float *pOrigin = &ray.origin.x;
+        const float *pDirection = &ray.direction.x;
+        float origin[3];
+        float direction[3];
+        for (int row = 0; row < 3; ++row) {
+          const float c0 = (&pColumns[0].x)[row];
+          const float c1 = (&pColumns[1].x)[row];
+          const float c2 = (&pColumns[2].x)[row];
+          const float c3 = (&pColumns[3].x)[row];
+          origin[row] =
+              c0 * pOrigin[0] + c1 * pOrigin[1] + c2 * pOrigin[2] + c3;
+          direction[row] =
+              c0 * pDirection[0] + c1 * pDirection[1] + c2 * pDirection[2];
+        }
+
+        const PrimitiveAccelerationStructure &structure =
+            *instance.pStructure;
+        return structure.bvh().raycast(
+            Float4(origin[0], origin[1], origin[2], 1.0F),
+            Float4(direction[0], direction[1], direction[2], 0.0F),
+            instanceMaxDistance,
+            [&](std::uint32_t primitive, float &primitiveMaxDistance) {
+              float t = 0.0F;
+              float u = 0.0F;
+              float v = 0.0F;
+              if (!structure.triangles().empty()) {
+                if (!intersectTriangle(structure.triangles()[primitive],
+                                       origin, direction, ray.minDistance,
+                                       primitiveMaxDistance, t, u, v)) {
+                  return false;
+                }
+              } else {
+                const AxisAlignedBoundingBox &box =
+                    structure.boxes()[primitive];
+                const float *pMin = &box.min.x;
+                const float *pMax = &box.max.x;
+                float lower = ray.minDistance;
+                float upper = primitiveMaxDistance;
+                for (int axis = 0; axis < 3; ++axis) {
+                  const float inverse = 1.0F / direction[axis];
+                  float near = (pMin[axis] - origin[axis]) * inverse;
+                  float far = (pMax[axis] - origin[axis]) * inverse;
+                  if (near > far) {
+                    std::swap(near, far);
+                  }
+                  lower = near > lower ? near : lower;
+                  upper = far < upper ? far : upper;
+                }
+                if (!(lower <= upper && lower < primitiveMaxDistance)) {
+                  return false;
+                }
+                t = lower;
+              }
+              primitiveMaxDistance = t;
+              result = {t, primitive, instanceIndex, u, v};
+              return true;
+            });
+      });
+  return result;
+}
+
+}  // namespace Gfx
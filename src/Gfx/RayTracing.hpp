@@ -0,0 +1,142 @@
+#pragma once
+
+#include <Gfx/Bvh.hpp>
+#include <Gfx/InstanceBvh.hpp>
+#include <Gfx/InstanceDescriptors.hpp>
+#include <Gfx/JobSystem.hpp>
+#include <Gfx/Math.hpp>
+
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+#include <limits>
+#include <vector>
+
+// CPU reference for Metal ray tracing. The structures take the geometry the
+// Metal acceleration structure descriptors point at and the instance
+// descriptors InstanceDescriptorWriter produces, so a scene can be traced on
+// machines without a GPU and the results compared with the GPU's.
+namespace Gfx {
+
+namespace Detail {
+struct RayPacket;
+}  // namespace Detail
+
+// Metal's ray: hits count in (minDistance, maxDistance), in units of the
+// direction's length.
+struct Ray {
+  PackedFloat3 origin;
+  float minDistance = 0.0F;
+  PackedFloat3 direction;
+  float maxDistance = INFINITY;
+};
+
+struct Intersection {
+  static constexpr std::uint32_t kNone =
+      std::numeric_limits<std::uint32_t>::max();
+
+  [[nodiscard]] bool hit() const { return primitiveIndex != kNone; }
+
+  float distance = INFINITY;
+  std::uint32_t primitiveIndex = kNone;
+  std::uint32_t instanceIndex = kNone;
+  // Barycentric coordinates of the hit on the triangle's second and third
+  // vertex; 0 for bounding boxes.
+  float u = 0.0F;
+  float v = 0.0F;
+};
+
+// What an MTL::AccelerationStructureTriangleGeometryDescriptor describes, with
+// pointers in place of buffers.
+struct TriangleGeometryDescriptor {
+  const void *pVertices = nullptr;
+  // Bytes between vertices, each of which starts with a PackedFloat3.
+  std::size_t vertexStride = sizeof(PackedFloat3);
+  // Three per triangle; null for unindexed triangles.
+  const std::uint32_t *pIndices = nullptr;
+  std::size_t triangleCount = 0;
+};
+
+// As MTL::AccelerationStructureBoundingBoxGeometryDescriptor. There are no
+// intersection functions on the CPU: a ray hits a box where it enters it.
+struct BoundingBoxGeometryDescriptor {
+  const AxisAlignedBoundingBox *pBoundingBoxes = nullptr;
+  std::size_t boundingBoxCount = 0;
+};
+
+// Bottom level: a Bvh over one geometry, which it copies.
+class PrimitiveAccelerationStructure {
+ public:
+  // First vertex and the two edges leaving it.
+  struct Triangle {
+    PackedFloat3 vertex;
+    PackedFloat3 edge1;
+    PackedFloat3 edge2;
+  };
+
+  void build(const TriangleGeometryDescriptor &descriptor,
+             JobSystem *pJobSystem = nullptr,
+             const BvhBuildOptions &options = {});
+  void build(const BoundingBoxGeometryDescriptor &descriptor,
+             JobSystem *pJobSystem = nullptr,
+             const BvhBuildOptions &options = {});
+
+  [[nodiscard]] const Bvh &bvh() const { return _bvh; }
+  // One of the two is empty.
+  [[nodiscard]] const std::vector<Triangle> &triangles() const {
+    return _triangles;
+  }
+  [[nodiscard]] const std::vector<AxisAlignedBoundingBox> &boxes() const {
+    return _boxes;
+  }
+
+ private:
+  Bvh _bvh;
+  std::vector<Triangle> _triangles;
+  std::vector<AxisAlignedBoundingBox> _boxes;
+};
+
+// Top level: instances of primitive structures, given as Metal instance
+// descriptors. intersect() traces rays in packets of four that walk both
+// levels together, testing boxes and triangles against all four rays at
+// once, so coherent rays (neighbouring pixels of a camera) share the node
+// fetches. The single-ray intersect() runs the same tests one ray at a time.
+class InstanceAccelerationStructure {
+ public:
+  // Keeps pointers to the structures, which have to outlive this one.
+  // pInstances[i].accelerationStructureIndex indexes ppStructures.
+  void build(const AccelerationStructureInstanceDescriptor *pInstances,
+             std::size_t instanceCount,
+             const PrimitiveAccelerationStructure *const *ppStructures,
+             JobSystem *pJobSystem = nullptr);
+
+  // Finds the closest hit of every ray in instances whose mask shares a bit
+  // with mask. Rays are grouped into packets of four consecutive ones; with
+  // a JobSystem, packets are spread over parallelFor ranges.
+  void intersect(const Ray *pRays, Intersection *pIntersections,
+                 std::size_t count, std::uint32_t mask = 0xFF,
+                 JobSystem *pJobSystem = nullptr) const;
+  [[nodiscard]] Intersection intersect(const Ray &ray,
+                                       std::uint32_t mask = 0xFF) const;
+
+  [[nodiscard]] std::size_t instanceCount() const { return _instances.size(); }
+  [[nodiscard]] AxisAlignedBoundingBox bounds() const {
+    return _bvh.bvh().bounds();
+  }
+
+ private:
+  struct Instance {
+    // World to object space.
+    PackedFloat4x3 inverseTransform;
+    const PrimitiveAccelerationStructure *pStructure;
+    std::uint32_t mask;
+  };
+
+  void intersectPacket(Detail::RayPacket &packet, std::uint32_t mask,
+                       Intersection *pHits) const;
+
+  InstanceBvh _bvh;
+  std::vector<Instance> _instances;
+};
+
+}  // namespace Gfx
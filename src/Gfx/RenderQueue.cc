@@ -0,0 +1,133 @@
+#include <Gfx/RenderQueue.hpp>
+
+#include <algorithm>
+#include <cassert>
+#include <cstdint>
+#include <utility>
+
+namespace Gfx {
+
+namespace {
+
+// Fewer keys per block than this aren't worth a job of their own.
+constexpr std::size_t kMinKeysPerBlock = 16384;
+
+}  // namespace
+
+void RenderQueue::sort(JobSystem *pJobSystem, unsigned digitBits) {
+  assert(digitBits >= 1 && digitBits <= 16);
+  const std::size_t count = size();
+  assert(count <= UINT32_MAX);
+  _passCount = 0;
+  if (count < 2) {
+    return;
+  }
+  const std::size_t blockCount =
+      pJobSystem == nullptr
+          ? 1
+          : std::clamp<std::size_t>(count / kMinKeysPerBlock, 1,
+                                    pJobSystem->threadCount());
+  auto forEachBlock = [&](auto &&function) {
+    auto blocks = [&](std::size_t first, std::size_t last) {
+      for (std::size_t block = first; block < last; ++block) {
+        function(block, count * block / blockCount,
+                 count * (block + 1) / blockCount);
+      }
+    };
+    if (blockCount == 1) {
+      blocks(0, 1);
+    } else {
+      pJobSystem->parallelFor(blockCount, 1, blocks);
+    }
+  };
+
+  // One sweep counts the digits of every pass in every block. Those counts
+  // are final for the first pass, and with a single block for all of them;
+  // summed, they show which passes have the same digit in every key.
+  const std::size_t digitCount = std::size_t{1} << digitBits;
+  const std::uint64_t digitMask = digitCount - 1;
+  const unsigned passLimit = (64 + digitBits - 1) / digitBits;
+  const std::size_t blockStride = passLimit * digitCount;
+  _counts.assign(blockCount * blockStride, 0);
+  forEachBlock([&](std::size_t block, std::size_t begin, std::size_t end) {
+    std::uint32_t *pCounts = _counts.data() + block * blockStride;
+    for (std::size_t i = begin; i < end; ++i) {
+      const std::uint64_t key = _keys[i];
+      for (unsigned pass = 0; pass < passLimit; ++pass) {
+        ++pCounts[pass * digitCount + (key >> (pass * digitBits) & digitMask)];
+      }
+    }
+  });
+
+  _scratchKeys.resize(count);
+  _scratchDraws.resize(count);
+  for (unsigned pass = 0; pass < passLimit; ++pass) {
+    const unsigned shift = pass * digitBits;
+    const std::size_t passOffset = pass * digitCount;
+    const std::size_t firstDigit = _keys[0] >> shift & digitMask;
+    std::size_t firstDigitKeys = 0;
+    for (std::size_t block = 0; block < blockCount; ++block) {
+      firstDigitKeys +=
+          _counts[block * blockStride + passOffset + firstDigit];
+    }
+    if (firstDigitKeys == count) {
+      continue;
+    }
+    const std::uint64_t *pKeys = _keys.data();
+    const std::uint32_t *pDraws = _draws.data();
+    std::uint64_t *pOutKeys = _scratchKeys.data();
+    std::uint32_t *pOutDraws = _scratchDraws.data();
+
+    // Earlier passes moved keys between blocks.
+    if (blockCount > 1 && _passCount > 0) {
+      forEachBlock(
+          [&](std::size_t block, std::size_t begin, std::size_t end) {
+            std::uint32_t *pCounts =
+                _counts.data() + block * blockStride + passOffset;
+            std::fill_n(pCounts, digitCount, 0);
+            for (std::size_t i = begin; i < end; ++i) {
+              ++pCounts[pKeys[i] >> shift & digitMask];
+            }
+          });
+    }
+    // Digit by digit, each block's keys go after those of earlier blocks.
+    std::uint32_t offset = 0;
+    for (std::size_t digit = 0; digit < digitCount; ++digit) {
+      for (std::size_t block = 0; block < blockCount; ++block) {
+        std::uint32_t &counted =
+            _counts[block * blockStride + passOffset + digit];
+        const std::uint32_t digitKeys = counted;
+        counted = offset;
+        offset += digitKeys;
+      }
+    }
+    forEachBlock([&](std::size_t block, std::size_t begin, std::size_t end) {
+      std::uint32_t *pOffsets =
+          _counts.data() + block * blockStride + passOffset;
+      for (std::size_t i = begin; i < end; ++i) {
+        const std::uint32_t position =
+            pOffsets[pKeys[i] >> shift & digitMask]++;
+        pOutKeys[position] = pKeys[i];
+        pOutDraws[position] = pDraws[i];
+      }
+    });
+    std::swap(_keys, _scratchKeys);
+    std::swap(_draws, _scratchDraws);
+    ++_passCount;
+  }
+}
+
+std::size_t countStateChanges(const std::uint64_t *pKeys, std::size_t count) {
+  std::size_t changes = 0;
+  for (std::size_t i = 1; i < count; ++i) {
+    changes += DrawSortKey::pipeline(pKeys[i]) !=
+                       DrawSortKey::pipeline(pKeys[i - 1]) ||
+                   DrawSortKey::material(pKeys[i]) !=
+                       DrawSortKey::material(pKeys[i - 1])
+               ? 1
+               : 0;
+  }
+  return changes;
+}
+
+}  // namespace Gfx
@@ -0,0 +1,127 @@
+#pragma once
+
+#include <Gfx/JobSystem.hpp>
+
+#include <bit>
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+namespace Gfx {
+
+// 64-bit draw sort keys; sorting them ascending gives an order with few
+// state changes. From the most significant bit:
+//
+//   layer        7 bits   layers draw in order, e.g. world before UI
+//   translucent  1 bit    opaque draws first
+//   opaque:      pipeline 12, material 20, depth 24 (front to back)
+//   translucent: depth 24 (back to front), pipeline 12, material 20
+//
+// Opaque draws are grouped by pipeline, then material, the two most
+// expensive changes; translucent ones have to blend in depth order, so
+// their state only breaks ties. Depth is the view-space distance, kept to
+// its 24 most significant bits.
+struct DrawSortKey {
+  static constexpr unsigned kLayerBits = 7;
+  static constexpr unsigned kPipelineBits = 12;
+  static constexpr unsigned kMaterialBits = 20;
+  static constexpr unsigned kDepthBits = 24;
+
+  [[nodiscard]] static std::uint64_t opaque(std::uint32_t layer,
+                                            std::uint32_t pipeline,
+                                            std::uint32_t material,
+                                            float depth) {
+    return field(layer, kLayerBits, 57) | field(pipeline, kPipelineBits, 44) |
+           field(material, kMaterialBits, 24) |
+           field(depthBits(depth), kDepthBits, 0);
+  }
+  [[nodiscard]] static std::uint64_t translucent(std::uint32_t layer,
+                                                 std::uint32_t pipeline,
+                                                 std::uint32_t material,
+                                                 float depth) {
+    return field(layer, kLayerBits, 57) | std::uint64_t{1} << 56 |
+           field(~depthBits(depth), kDepthBits, 32) |
+           field(pipeline, kPipelineBits, 20) |
+           field(material, kMaterialBits, 0);
+  }
+
+  [[nodiscard]] static bool isTranslucent(std::uint64_t key) {
+    return (key >> 56 & 1) != 0;
+  }
+  [[nodiscard]] static std::uint32_t pipeline(std::uint64_t key) {
+    return static_cast<std::uint32_t>(key >> (isTranslucent(key) ? 20 : 44)) &
+           ((1U << kPipelineBits) - 1);
+  }
+  [[nodiscard]] static std::uint32_t material(std::uint64_t key) {
+    return static_cast<std::uint32_t>(key >> (isTranslucent(key) ? 0 : 24)) &
+           ((1U << kMaterialBits) - 1);
+  }
+
+ private:
+  static std::uint64_t field(std::uint32_t value, unsigned bits,
+                             unsigned shift) {
+    return (std::uint64_t{value} & ((std::uint64_t{1} << bits) - 1)) << shift;
+  }
+  // Positive floats order like their bit patterns; negative depths and NaN
+  // count as 0.
+  static std::uint32_t depthBits(float depth) {
+    return depth > 0.0F ? std::bit_cast<std::uint32_t>(depth) >> 7 : 0;
+  }
+};
+
+// Draws collected during scene traversal as (sort key, draw index) pairs,
+// sorted before encoding. Draw range handlers then walk draws() in order.
+//
+// sort() is an LSD radix sort over digits of 8 or 11 bits. Every pass
+// counts digits per block of keys, turns the counts into a stable output
+// offset per block and digit, and scatters each block to its offsets;
+// with a JobSystem, blocks are counted and scattered in parallel. Passes
+// whose digit is the same for every key, like unused layers, are skipped.
+class RenderQueue {
+ public:
+  static constexpr unsigned kDefaultDigitBits = 11;
+
+  void clear() {
+    _keys.clear();
+    _draws.clear();
+  }
+  void push(std::uint64_t key, std::uint32_t draw) {
+    _keys.push_back(key);
+    _draws.push_back(draw);
+  }
+  // For traversals that fill the arrays from several threads.
+  void resize(std::size_t count) {
+    _keys.resize(count);
+    _draws.resize(count);
+  }
+
+  // Sorts by key, keeping the push order of equal keys. digitBits is from 1
+  // to 16.
+  void sort(JobSystem *pJobSystem = nullptr,
+            unsigned digitBits = kDefaultDigitBits);
+
+  [[nodiscard]] std::size_t size() const { return _keys.size(); }
+  std::uint64_t *keys() { return _keys.data(); }
+  std::uint32_t *draws() { return _draws.data(); }
+  [[nodiscard]] const std::uint64_t *keys() const { return _keys.data(); }
+  [[nodiscard]] const std::uint32_t *draws() const { return _draws.data(); }
+  // Digit passes the last sort() made.
+  [[nodiscard]] unsigned passCount() const { return _passCount; }
+
+ private:
+  std::vector<std::uint64_t> _keys;
+  std::vector<std::uint32_t> _draws;
+  unsigned _passCount = 0;
+
+  // Scratch of sort(): the other half of each pass, and a count per block
+  // and digit.
+  std::vector<std::uint64_t> _scratchKeys;
+  std::vector<std::uint32_t> _scratchDraws;
+  std::vector<std::uint32_t> _counts;
+};
+
+// Times the pipeline or the material differs between neighbours in keys.
+[[nodiscard]] std::size_t countStateChanges(const std::uint64_t *pKeys,
+                                            std::size_t count);
+
+}  // namespace Gfx
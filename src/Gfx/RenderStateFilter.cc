@@ -0,0 +1,112 @@
+#include <Gfx/RenderStateFilter.hpp>
+
+#include <cassert>
+
+namespace Gfx {
+
+void RenderStateFilter::setRenderPipelineState(RenderPipelineState *pState) {
+  if ((_knownState & kPipelineState) != 0 && _pPipelineState == pState) {
+    ++_statistics.pipelineStates;
+    return;
+  }
+  _knownState |= kPipelineState;
+  _pPipelineState = pState;
+  _pEncoder->setRenderPipelineState(pState);
+}
+
+void RenderStateFilter::setVertexBuffer(Buffer *pBuffer, std::size_t offset,
+                                        std::size_t index) {
+  assert(index < kMaxVertexBuffers);
+  const std::uint32_t bit = std::uint32_t{1} << index;
+  VertexBufferBinding &binding = _vertexBuffers[index];
+  if ((_knownVertexBuffers & bit) != 0 && binding.pBuffer == pBuffer) {
+    if (pBuffer == nullptr || binding.offset == offset) {
+      ++_statistics.vertexBuffers;
+      return;
+    }
+    ++_statistics.vertexBufferOffsets;
+    binding.offset = offset;
+    _pEncoder->setVertexBufferOffset(offset, index);
+    return;
+  }
+  _knownVertexBuffers |= bit;
+  binding = {pBuffer, offset};
+  _pEncoder->setVertexBuffer(pBuffer, offset, index);
+}
+
+void RenderStateFilter::setVertexBufferOffset(std::size_t offset,
+                                              std::size_t index) {
+  assert(index < kMaxVertexBuffers);
+  VertexBufferBinding &binding = _vertexBuffers[index];
+  if ((_knownVertexBuffers & std::uint32_t{1} << index) != 0 &&
+      binding.offset == offset) {
+    ++_statistics.vertexBuffers;
+    return;
+  }
+  // The buffer is bound even if the filter doesn't know which one it is.
+  binding.offset = offset;
+  _pEncoder->setVertexBufferOffset(offset, index);
+}
+
+void RenderStateFilter::setFragmentTexture(Texture *pTexture,
+                                           std::size_t index) {
+  assert(index < kMaxFragmentTextures);
+  const std::uint32_t bit = std::uint32_t{1} << index;
+  if ((_knownFragmentTextures & bit) != 0 &&
+      _fragmentTextures[index] == pTexture) {
+    ++_statistics.fragmentTextures;
+    return;
+  }
+  _knownFragmentTextures |= bit;
+  _fragmentTextures[index] = pTexture;
+  _pEncoder->setFragmentTexture(pTexture, index);
+}
+
+void RenderStateFilter::setViewport(const Viewport &viewport) {
+  if ((_knownState & kViewport) != 0 && _viewport == viewport) {
+    ++_statistics.viewports;
+    return;
+  }
+  _knownState |= kViewport;
+  _viewport = viewport;
+  _pEncoder->setViewport(viewport);
+}
+
+void RenderStateFilter::setScissorRect(const ScissorRect &rect) {
+  if ((_knownState & kScissorRect) != 0 && _scissorRect == rect) {
+    ++_statistics.scissorRects;
+    return;
+  }
+  _knownState |= kScissorRect;
+  _scissorRect = rect;
+  _pEncoder->setScissorRect(rect);
+}
+
+void RenderStateFilter::setCullMode(CullMode cullMode) {
+  if ((_knownState & kCullMode) != 0 && _cullMode == cullMode) {
+    ++_statistics.cullModes;
+    return;
+  }
+  _knownState |= kCullMode;
+  _cullMode = cullMode;
+  _pEncoder->setCullMode(cullMode);
+}
+
+void RenderStateFilter::setFrontFacingWinding(Winding winding) {
+  if ((_knownState & kWinding) != 0 && _winding == winding) {
+    ++_statistics.windings;
+    return;
+  }
+  _knownState |= kWinding;
+  _winding = winding;
+  _pEncoder->setFrontFacingWinding(winding);
+}
+
+void RenderStateFilter::executeCommandsInBuffer(
+    IndirectCommandBuffer *pCommands,
+    const IndirectCommandBufferExecutionRange &range) {
+  _knownVertexBuffers = 0;
+  _pEncoder->executeCommandsInBuffer(pCommands, range);
+}
+
+}  // namespace Gfx
@@ -0,0 +1,133 @@
+#pragma once
+
+#include <Gfx/Backend.hpp>
+
+#include <cstddef>
+#include <cstdint>
+
+namespace Gfx {
+
+// Calls a RenderStateFilter didn't pass on, or passed on as a cheaper call.
+struct RenderStateFilterStatistics {
+  std::uint64_t pipelineStates = 0;
+  std::uint64_t vertexBuffers = 0;
+  // setVertexBuffer() calls that only moved the offset and went out as
+  // setVertexBufferOffset(), which on Metal doesn't retain the buffer again.
+  std::uint64_t vertexBufferOffsets = 0;
+  std::uint64_t fragmentTextures = 0;
+  std::uint64_t viewports = 0;
+  std::uint64_t scissorRects = 0;
+  std::uint64_t cullModes = 0;
+  std::uint64_t windings = 0;
+
+  // Calls dropped altogether.
+  [[nodiscard]] std::uint64_t eliminated() const {
+    return pipelineStates + vertexBuffers + fragmentTextures + viewports +
+           scissorRects + cullModes + windings;
+  }
+
+  RenderStateFilterStatistics &operator+=(
+      const RenderStateFilterStatistics &other) {
+    pipelineStates += other.pipelineStates;
+    vertexBuffers += other.vertexBuffers;
+    vertexBufferOffsets += other.vertexBufferOffsets;
+    fragmentTextures += other.fragmentTextures;
+    viewports += other.viewports;
+    scissorRects += other.scissorRects;
+    cullModes += other.cullModes;
+    windings += other.windings;
+    return *this;
+  }
+};
+
+// Encoder decorator that shadows the state set on another encoder and
+// drops calls that would set it to what it already is, so draw loops can set
+// everything they need per draw and only pay for what changes. Rebinding the
+// bound buffer at another offset becomes setVertexBufferOffset().
+//
+// Bound state is undefined at the start of an encoder, so the shadow starts
+// out unknown and the first call for each piece of state always goes
+// through. Executing indirect commands forgets the vertex buffers; they
+// bind their own. Anything else that changes the encoder behind the filter's
+// back has to be followed by invalidate().
+//
+// One filter per encoder; like the encoder, it is used by one thread at a
+// time. Filters can be reused across encoders with reset().
+class RenderStateFilter final : public RenderCommandEncoder {
+ public:
+  explicit RenderStateFilter(RenderCommandEncoder *pEncoder = nullptr)
+      : _pEncoder(pEncoder) {}
+
+  // Filters pEncoder, a new encoder, from here on. Statistics keep adding
+  // up.
+  void reset(RenderCommandEncoder *pEncoder) {
+    _pEncoder = pEncoder;
+    invalidate();
+  }
+  // Forgets all bound state.
+  void invalidate() {
+    _knownVertexBuffers = 0;
+    _knownFragmentTextures = 0;
+    _knownState = 0;
+  }
+
+  [[nodiscard]] RenderCommandEncoder *encoder() const { return _pEncoder; }
+  [[nodiscard]] const RenderStateFilterStatistics &statistics() const {
+    return _statistics;
+  }
+  void resetStatistics() { _statistics = {}; }
+
+  void setRenderPipelineState(RenderPipelineState *pState) override;
+  void setVertexBuffer(Buffer *pBuffer, std::size_t offset,
+                       std::size_t index) override;
+  void setVertexBufferOffset(std::size_t offset, std::size_t index) override;
+  void setFragmentTexture(Texture *pTexture, std::size_t index) override;
+  void setViewport(const Viewport &viewport) override;
+  void setScissorRect(const ScissorRect &rect) override;
+  void setCullMode(CullMode cullMode) override;
+  void setFrontFacingWinding(Winding winding) override;
+  void drawPrimitives(PrimitiveType primitiveType, std::size_t vertexStart,
+                      std::size_t vertexCount) override {
+    _pEncoder->drawPrimitives(primitiveType, vertexStart, vertexCount);
+  }
+  void useResource(Buffer *pBuffer) override {
+    _pEncoder->useResource(pBuffer);
+  }
+  void executeCommandsInBuffer(
+      IndirectCommandBuffer *pCommands,
+      const IndirectCommandBufferExecutionRange &range) override;
+  void endEncoding() override { _pEncoder->endEncoding(); }
+
+ private:
+  // Bits of _knownState.
+  enum : std::uint8_t {
+    kViewport = 1 << 0,
+    kScissorRect = 1 << 1,
+    kCullMode = 1 << 2,
+    kWinding = 1 << 3,
+    kPipelineState = 1 << 4,
+  };
+
+  struct VertexBufferBinding {
+    Buffer *pBuffer;
+    std::size_t offset;
+  };
+
+  static_assert(kMaxVertexBuffers <= 32 && kMaxFragmentTextures <= 32);
+
+  RenderCommandEncoder *_pEncoder;
+  // A bit per slot whose shadow below is valid.
+  std::uint32_t _knownVertexBuffers = 0;
+  std::uint32_t _knownFragmentTextures = 0;
+  std::uint8_t _knownState = 0;
+  RenderPipelineState *_pPipelineState = nullptr;
+  VertexBufferBinding _vertexBuffers[kMaxVertexBuffers];
+  Texture *_fragmentTextures[kMaxFragmentTextures];
+  Viewport _viewport{};
+  ScissorRect _scissorRect{};
+  CullMode _cullMode = CullMode::None;
+  Winding _winding = Winding::Clockwise;
+  RenderStateFilterStatistics _statistics;
+};
+
+}  // namespace Gfx
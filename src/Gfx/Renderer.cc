@@ -0,0 +1,150 @@
+#include <Gfx/Renderer.hpp>
+
+#include <cmath>
+#include <cstring>
+
+namespace Gfx {
+
+namespace {
+
+constexpr std::size_t kVertexCount = 3;
+constexpr std::size_t kVertexBufferLength = kVertexCount * 4 * sizeof(float);
+
+}  // namespace
+
+Renderer::Renderer(Device *pDevice, std::size_t maxFramesInFlight,
+                   bool retainedReferences)
+    : _pDevice(pDevice),
+      _pCommandQueue(_pDevice->newCommandQueue()),
+      _frameSubmitter(_pCommandQueue.get(), maxFramesInFlight,
+                      {.retainedReferences = retainedReferences}),
+      _startTime(std::chrono::steady_clock::now()) {
+  _frames.resize(maxFramesInFlight);
+  for (Frame &frame : _frames) {
+    frame.pUniformBuffer = _pDevice->newBuffer(sizeof(FrameUniforms));
+    frame.pVertexBuffer = _pDevice->newBuffer(kVertexBufferLength);
+  }
+}
+
+void Renderer::setDrawList(std::size_t drawCount, DrawRangeHandler handler,
+                           std::size_t threadCount) {
+  useJobSystem(threadCount);
+  _drawCount = drawCount;
+  _drawRangeHandler = std::move(handler);
+}
+
+void Renderer::setIndirectDrawList(
+    std::size_t drawCount, IndirectDrawHandler handler,
+    const IndirectCommandBufferDescriptor &descriptor,
+    std::size_t threadCount) {
+  useJobSystem(threadCount);
+  // Frames in flight may still execute the old commands.
+  if (_pIndirectDraws) {
+    _frameSubmitter.waitForFence(_frameSubmitter.currentFence());
+  }
+  _pIndirectDraws = std::make_unique<IndirectDrawEncoder>(
+      _pDevice, _frames.size(), descriptor);
+  _pIndirectDraws->setDrawList(drawCount, std::move(handler));
+}
+
+void Renderer::setDrawUniformCapacity(std::size_t bytesPerFrame) {
+  // Frames in flight may still read the old buffer.
+  if (_pDrawUniforms) {
+    _frameSubmitter.waitForFence(_frameSubmitter.currentFence());
+  }
+  _pDrawUniforms = std::make_unique<UniformAllocator>(_pDevice, bytesPerFrame,
+                                                      _frames.size());
+}
+
+void Renderer::draw(View *pView) {
+  // Waits for the frame that last used this slot.
+  CommandBuffer *pCmd = _frameSubmitter.beginFrame();
+  encodeFrame(pCmd, pView->currentRenderPassDescriptor());
+  pCmd->presentDrawable(pView->currentDrawable());
+  _frameSubmitter.commitFrame();
+}
+
+void Renderer::drawOffscreen(FrameCapture *pCapture,
+                             const ClearColor &clearColor) {
+  CommandBuffer *pCmd = _frameSubmitter.beginFrame();
+  RenderPassDescriptor rpd;
+  rpd.colorAttachment.pTexture = pCapture->texture();
+  rpd.colorAttachment.clearColor = clearColor;
+  const std::uint64_t frameNumber = _frameNumber;
+  encodeFrame(pCmd, rpd);
+  pCapture->capture(pCmd, frameNumber);
+  _frameSubmitter.commitFrame();
+}
+
+void Renderer::useJobSystem(std::size_t threadCount) {
+  if (!_pJobSystem ||
+      (threadCount != 0 && threadCount != _pJobSystem->threadCount())) {
+    // Only one job system per main thread at a time.
+    _pParallelEncoder.reset();
+    _pJobSystem.reset();
+    _pJobSystem = std::make_unique<JobSystem>(threadCount);
+    _pParallelEncoder =
+        std::make_unique<ParallelPassEncoder>(_pJobSystem.get());
+  }
+}
+
+void Renderer::encodeFrame(CommandBuffer *pCmd,
+                           const RenderPassDescriptor &rpd) {
+  Frame &frame = _frames[_frameIndex];
+  const FrameResources resources{_frameIndex, frame.pUniformBuffer.get(),
+                                 frame.pVertexBuffer.get(),
+                                 _pDrawUniforms.get()};
+  updateFrame(frame);
+  if (_pDrawUniforms) {
+    _pDrawUniforms->beginFrame(_frameIndex);
+  }
+  if (_frameUpdateHandler) {
+    _frameUpdateHandler(resources);
+  }
+  _frameIndex = (_frameIndex + 1) % _frames.size();
+  if (_pIndirectDraws) {
+    _pIndirectDraws->update(resources.slot, _pJobSystem.get());
+  }
+
+  if (_drawRangeHandler) {
+    _pParallelEncoder->encode(
+        pCmd, rpd, _drawCount,
+        [this, &resources](RenderCommandEncoder *pEnc, std::size_t begin,
+                           std::size_t end) {
+          if (begin == 0 && _pIndirectDraws) {
+            _pIndirectDraws->execute(pEnc, resources.slot);
+          }
+          _drawRangeHandler(pEnc, resources, begin, end);
+        });
+  } else {
+    RenderCommandEncoder *pEnc = pCmd->renderCommandEncoder(rpd);
+    if (_pIndirectDraws) {
+      _pIndirectDraws->execute(pEnc, resources.slot);
+    }
+    if (_encodeHandler) {
+      _encodeHandler(pEnc, resources);
+    }
+    pEnc->endEncoding();
+  }
+}
+
+void Renderer::updateFrame(Frame &frame) {
+  const float time = std::chrono::duration<float>(
+                         std::chrono::steady_clock::now() - _startTime)
+                         .count();
+
+  const FrameUniforms uniforms{_frameNumber++, time};
+  std::memcpy(frame.pUniformBuffer->contents(), &uniforms, sizeof(uniforms));
+
+  auto *pVertices = static_cast<float *>(frame.pVertexBuffer->contents());
+  for (std::size_t i = 0; i < kVertexCount; ++i) {
+    const float angle =
+        time + static_cast<float>(i) * (2.0F * 3.14159265F / kVertexCount);
+    pVertices[i * 4 + 0] = 0.5F * std::cos(angle);
+    pVertices[i * 4 + 1] = 0.5F * std::sin(angle);
+    pVertices[i * 4 + 2] = 0.0F;
+    pVertices[i * 4 + 3] = 1.0F;
+  }
+}
+
+}  // namespace Gfx
@@ -0,0 +1,136 @@
+#pragma once
+
+#include <Gfx/Backend.hpp>
+#include <Gfx/FrameCapture.hpp>
+#include <Gfx/FrameSubmitter.hpp>
+#include <Gfx/IndirectDrawEncoder.hpp>
+#include <Gfx/JobSystem.hpp>
+#include <Gfx/ParallelPassEncoder.hpp>
+#include <Gfx/UniformAllocator.hpp>
+
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <utility>
+#include <vector>
+
+namespace Gfx {
+
+struct FrameUniforms {
+  std::uint64_t frameNumber;
+  float time;
+};
+
+// Dynamic buffers owned by one slot of the frame ring.
+struct FrameResources {
+  std::size_t slot;
+  Buffer *pUniformBuffer;
+  Buffer *pVertexBuffer;
+  // Per-draw constants, already started on this slot; nullptr unless
+  // setDrawUniformCapacity() was called.
+  UniformAllocator *pDrawUniforms;
+};
+
+// Renderer keeps up to maxFramesInFlight frames queued on the backend. Each
+// frame slot owns its own dynamic buffers, and the CPU only writes a slot
+// after the command buffer that last read it has completed.
+//
+// Command buffers don't retain what they reference unless retainedReferences
+// is set: the renderer's buffers outlive every frame, and anything the encode
+// handler replaces goes through frameSubmitter().releaseWhenComplete().
+class Renderer {
+ public:
+  static constexpr std::size_t kDefaultMaxFramesInFlight = 3;
+
+  using FrameUpdateHandler = std::function<void(const FrameResources &)>;
+  using EncodeHandler =
+      std::function<void(RenderCommandEncoder *, const FrameResources &)>;
+  using DrawRangeHandler =
+      std::function<void(RenderCommandEncoder *, const FrameResources &,
+                         std::size_t begin, std::size_t end)>;
+  using IndirectDrawHandler = IndirectDrawEncoder::EncodeFunction;
+
+  explicit Renderer(Device *pDevice,
+                    std::size_t maxFramesInFlight = kDefaultMaxFramesInFlight,
+                    bool retainedReferences = false);
+
+  Renderer(const Renderer &) = delete;
+  Renderer &operator=(const Renderer &) = delete;
+
+  // Called from draw() once the frame's slot is safe to write, after the
+  // renderer has filled in its own uniforms.
+  void setFrameUpdateHandler(FrameUpdateHandler handler) {
+    _frameUpdateHandler = std::move(handler);
+  }
+  // Called with the frame's render pass encoder to record its draws.
+  void setEncodeHandler(EncodeHandler handler) {
+    _encodeHandler = std::move(handler);
+  }
+  // Encodes drawCount draws per frame in place of the encode handler. The
+  // list is split into ranges that are encoded concurrently by a job system
+  // of threadCount threads (0: one per hardware thread), so the handler must
+  // be safe to call from several threads at once. Draws still execute in list
+  // order. The renderer's thread becomes the job system's main thread.
+  void setDrawList(std::size_t drawCount, DrawRangeHandler handler,
+                   std::size_t threadCount = 0);
+  // Submits drawCount mostly static draws through indirect command buffers:
+  // handler encodes them once per frame slot, then again only where they are
+  // marked dirty through indirectDraws(), on the same job system as
+  // setDrawList(). They execute first in the frame's pass. Waits for the
+  // frames in flight if there was a list already.
+  void setIndirectDrawList(std::size_t drawCount, IndirectDrawHandler handler,
+                           const IndirectCommandBufferDescriptor &descriptor =
+                               IndirectCommandBufferDescriptor(),
+                           std::size_t threadCount = 0);
+  // Gives every frame bytesPerFrame of per-draw constants, which any
+  // encoding thread can allocate from; draw range handlers are best off
+  // going through a UniformBlockAllocator of their own.
+  void setDrawUniformCapacity(std::size_t bytesPerFrame);
+
+  void draw(View *pView);
+  // Renders the frame into pCapture's texture instead of a drawable and
+  // captures it, for headless runs and regression captures.
+  void drawOffscreen(FrameCapture *pCapture, const ClearColor &clearColor);
+
+  [[nodiscard]] std::size_t maxFramesInFlight() const {
+    return _frames.size();
+  }
+  [[nodiscard]] FrameSubmitter &frameSubmitter() { return _frameSubmitter; }
+  // nullptr without an indirect draw list.
+  [[nodiscard]] IndirectDrawEncoder *indirectDraws() const {
+    return _pIndirectDraws.get();
+  }
+
+ private:
+  struct Frame {
+    std::unique_ptr<Buffer> pUniformBuffer;
+    std::unique_ptr<Buffer> pVertexBuffer;
+  };
+
+  // Keeps the job system if threadCount is 0 or matches it.
+  void useJobSystem(std::size_t threadCount);
+  void encodeFrame(CommandBuffer *pCmd, const RenderPassDescriptor &rpd);
+  void updateFrame(Frame &frame);
+
+  Device *_pDevice;
+  std::unique_ptr<CommandQueue> _pCommandQueue;
+  // Frame resources are declared before _frameSubmitter, whose destructor
+  // waits for the frames in flight that still read them.
+  std::vector<Frame> _frames;
+  std::unique_ptr<UniformAllocator> _pDrawUniforms;
+  std::unique_ptr<IndirectDrawEncoder> _pIndirectDraws;
+  FrameSubmitter _frameSubmitter;
+  FrameUpdateHandler _frameUpdateHandler;
+  EncodeHandler _encodeHandler;
+  std::unique_ptr<JobSystem> _pJobSystem;
+  std::unique_ptr<ParallelPassEncoder> _pParallelEncoder;
+  DrawRangeHandler _drawRangeHandler;
+  std::size_t _drawCount = 0;
+  std::size_t _frameIndex = 0;
+  std::uint64_t _frameNumber = 0;
+  std::chrono::steady_clock::time_point _startTime;
+};
+
+}  // namespace Gfx
@@ -0,0 +1,894 @@
+#include <Gfx/SoftwareBackend.hpp>
+
+#include <Gfx/PixelConversion.hpp>
+
+#include <algorithm>
+#include <cassert>
+#include <cmath>
+#include <cstring>
+#include <iterator>
+#include <new>
+#include <utility>
+
+namespace Gfx {
+
+namespace {
+
+std::uint8_t unormToByte(double value) {
+  return static_cast<std::uint8_t>(
+      std::lround(std::clamp(value, 0.0, 1.0) * 255.0));
+}
+
+double linearToSrgb(double value) {
+  value = std::clamp(value, 0.0, 1.0);
+  return value <= 0.0031308 ? value * 12.92
+                            : 1.055 * std::pow(value, 1.0 / 2.4) - 0.055;
+}
+
+// FNV-1a, fed field by field so padding never reaches the hash.
+constexpr std::uint64_t kDigestBasis = 0xcbf29ce484222325ULL;
+
+template <typename _Value>
+void hashValue(std::uint64_t &digest, const _Value &value) {
+  unsigned char bytes[sizeof(value)];
+  std::memcpy(bytes, &value, sizeof(value));
+  for (unsigned char byte : bytes) {
+    digest = (digest ^ byte) * 0x100000001b3ULL;
+  }
+}
+
+struct VertexBufferBinding {
+  Buffer *pBuffer = nullptr;
+  std::size_t offset = 0;
+};
+
+// What an encoder has bound while its commands execute. Slots from count up
+// were never set.
+struct RenderState {
+  RenderPipelineState *pPipelineState = nullptr;
+  VertexBufferBinding vertexBuffers[RenderCommandEncoder::kMaxVertexBuffers];
+  std::size_t vertexBufferCount = 0;
+  Texture *fragmentTextures[RenderCommandEncoder::kMaxFragmentTextures];
+  std::size_t fragmentTextureCount = 0;
+  Viewport viewport{};
+  ScissorRect scissorRect{};
+  CullMode cullMode = CullMode::None;
+  Winding winding = Winding::Clockwise;
+};
+
+void bindVertexBuffer(VertexBufferBinding *pBindings, std::size_t &count,
+                      std::size_t index, Buffer *pBuffer,
+                      std::size_t offset) {
+  for (; count <= index; ++count) {
+    pBindings[count] = {};
+  }
+  pBindings[index] = {pBuffer, offset};
+}
+
+// A draw with the vertex buffers in pBindings and the rest of state.
+void hashDraw(std::uint64_t &digest, const SoftwareCommand &draw,
+              const VertexBufferBinding *pBindings, std::size_t bindingCount,
+              const RenderState &state) {
+  hashValue(digest, state.pPipelineState);
+  hashValue(digest, draw.primitiveType);
+  hashValue(digest, draw.start);
+  hashValue(digest, draw.vertexCount);
+  hashValue(digest, draw.instanceCount);
+  hashValue(digest, draw.baseInstance);
+  for (std::size_t index = 0; index < bindingCount; ++index) {
+    if (pBindings[index].pBuffer != nullptr) {
+      hashValue(digest, index);
+      hashValue(digest, pBindings[index].pBuffer);
+      hashValue(digest, pBindings[index].offset);
+    }
+  }
+  for (std::size_t index = 0; index < state.fragmentTextureCount; ++index) {
+    if (state.fragmentTextures[index] != nullptr) {
+      hashValue(digest, index);
+      hashValue(digest, state.fragmentTextures[index]);
+    }
+  }
+  hashValue(digest, state.viewport);
+  hashValue(digest, state.scissorRect);
+  hashValue(digest, state.cullMode);
+  hashValue(digest, state.winding);
+}
+
+}  // namespace
+
+void SoftwareSharedEvent::notify(std::uint64_t value,
+                                 NotificationFunction function) {
+  {
+    std::lock_guard<std::mutex> lock(_mutex);
+    if (_value.load(std::memory_order_relaxed) < value) {
+      _listeners.push_back({value, std::move(function)});
+      return;
+    }
+  }
+  function(value);
+}
+
+void SoftwareSharedEvent::signal(std::uint64_t value) {
+  std::vector<Listener> ready;
+  {
+    std::lock_guard<std::mutex> lock(_mutex);
+    if (value <= _value.load(std::memory_order_relaxed)) {
+      return;
+    }
+    _value.store(value, std::memory_order_release);
+    const auto firstReady = std::stable_partition(
+        _listeners.begin(), _listeners.end(),
+        [value](const Listener &listener) { return listener.value > value; });
+    std::move(firstReady, _listeners.end(), std::back_inserter(ready));
+    _listeners.erase(firstReady, _listeners.end());
+    // Under the lock: a waiter may destroy the event as soon as it sees the
+    // value.
+    _signaled.notify_all();
+  }
+  // The listeners are this function's own now; the event is not touched.
+  for (const Listener &listener : ready) {
+    listener.function(value);
+  }
+}
+
+void SoftwareSharedEvent::wait(std::uint64_t value) {
+  std::unique_lock<std::mutex> lock(_mutex);
+  _signaled.wait(lock, [this, value] {
+    return _value.load(std::memory_order_relaxed) >= value;
+  });
+}
+
+SoftwareTexture::SoftwareTexture(std::uint32_t width, std::uint32_t height,
+                                 PixelFormat pixelFormat)
+    : _width(width),
+      _height(height),
+      _pixelFormat(pixelFormat),
+      _storage(bytesPerPixel(pixelFormat) * width * height) {}
+
+std::size_t SoftwareTexture::bytesPerRow() const {
+  return bytesPerPixel(_pixelFormat) * _width;
+}
+
+void SoftwareTexture::clear(const ClearColor &color) {
+  std::uint8_t pixel[4];
+  switch (_pixelFormat) {
+    case PixelFormat::RGBA8Unorm:
+      pixel[0] = unormToByte(color.red);
+      pixel[1] = unormToByte(color.green);
+      pixel[2] = unormToByte(color.blue);
+      pixel[3] = unormToByte(color.alpha);
+      break;
+    case PixelFormat::BGRA8Unorm:
+      pixel[0] = unormToByte(color.blue);
+      pixel[1] = unormToByte(color.green);
+      pixel[2] = unormToByte(color.red);
+      pixel[3] = unormToByte(color.alpha);
+      break;
+    case PixelFormat::BGRA8Unorm_sRGB:
+      pixel[0] = unormToByte(linearToSrgb(color.blue));
+      pixel[1] = unormToByte(linearToSrgb(color.green));
+      pixel[2] = unormToByte(linearToSrgb(color.red));
+      pixel[3] = unormToByte(color.alpha);
+      break;
+    case PixelFormat::Invalid:
+      return;
+    default:
+      fillConverted(color);
+      return;
+  }
+
+  std::uint32_t packed;
+  std::memcpy(&packed, pixel, sizeof(packed));
+  auto *pTexels = reinterpret_cast<std::uint32_t *>(_storage.data());
+  std::fill_n(pTexels, std::size_t{_width} * _height, packed);
+}
+
+void SoftwareTexture::fillConverted(const ClearColor &color) {
+  const float rgba[4] = {
+      static_cast<float>(color.red), static_cast<float>(color.green),
+      static_cast<float>(color.blue), static_cast<float>(color.alpha)};
+  const std::size_t pixelSize = bytesPerPixel(_pixelFormat);
+  std::byte pixel[16];
+  if (!convertPixels(PixelFormat::RGBA32Float, rgba, _pixelFormat, pixel, 1)) {
+    return;
+  }
+  for (std::size_t offset = 0; offset < _storage.size(); offset += pixelSize) {
+    std::memcpy(_storage.data() + offset, pixel, pixelSize);
+  }
+}
+
+SoftwareBuffer::SoftwareBuffer(std::size_t length)
+    : _pContents(::operator new(length, std::align_val_t{kAlignment})),
+      _length(length) {
+  std::memset(_pContents, 0, _length);
+}
+
+SoftwareBuffer::~SoftwareBuffer() {
+  if (_owned) {
+    ::operator delete(_pContents, std::align_val_t{kAlignment});
+  }
+}
+
+SoftwareHeap::SoftwareHeap(std::size_t size)
+    : _pContents(static_cast<std::uint8_t *>(
+          ::operator new(size, std::align_val_t{SoftwareBuffer::kAlignment}))),
+      _size(size) {}
+
+SoftwareHeap::~SoftwareHeap() {
+  ::operator delete(_pContents, std::align_val_t{SoftwareBuffer::kAlignment});
+}
+
+std::unique_ptr<Buffer> SoftwareHeap::newBuffer(std::size_t length,
+                                                std::size_t offset) {
+  assert(offset % SoftwareBuffer::kAlignment == 0);
+  assert(offset <= _size && length <= _size - offset);
+  return std::make_unique<SoftwareBuffer>(_pContents + offset, length);
+}
+
+SoftwareDrawable::SoftwareDrawable(SoftwareView *pView, std::uint32_t width,
+                                   std::uint32_t height,
+                                   PixelFormat pixelFormat)
+    : _pView(pView), _texture(width, height, pixelFormat) {}
+
+SoftwareIndirectCommandBuffer::SoftwareIndirectCommandBuffer(
+    const IndirectCommandBufferDescriptor &descriptor,
+    std::size_t maxCommandCount)
+    : _maxVertexBufferBindCount(descriptor.maxVertexBufferBindCount),
+      _bindings(maxCommandCount * descriptor.maxVertexBufferBindCount),
+      _draws(maxCommandCount, {SoftwareCommand::Type::DrawPrimitives,
+                               PrimitiveType::Point, 0, nullptr, 0, 0}) {
+  assert(_maxVertexBufferBindCount <=
+         RenderCommandEncoder::kMaxVertexBuffers);
+}
+
+void SoftwareIndirectCommandBuffer::setVertexBuffer(std::size_t command,
+                                                    Buffer *pBuffer,
+                                                    std::size_t offset,
+                                                    std::size_t index) {
+  assert(command < size());
+  assert(index < _maxVertexBufferBindCount);
+  assert(pBuffer == nullptr || offset < pBuffer->length());
+  _bindings[command * _maxVertexBufferBindCount + index] = {pBuffer, offset};
+}
+
+void SoftwareIndirectCommandBuffer::drawPrimitives(
+    std::size_t command, PrimitiveType primitiveType, std::size_t vertexStart,
+    std::size_t vertexCount, std::size_t instanceCount,
+    std::size_t baseInstance) {
+  assert(command < size());
+  SoftwareCommand &draw = _draws[command];
+  draw.primitiveType = primitiveType;
+  draw.start = vertexStart;
+  draw.vertexCount = instanceCount != 0 ? vertexCount : 0;
+  draw.instanceCount = static_cast<std::uint32_t>(instanceCount);
+  draw.baseInstance = static_cast<std::uint32_t>(baseInstance);
+}
+
+void SoftwareIndirectCommandBuffer::reset(
+    const IndirectCommandBufferExecutionRange &range) {
+  assert(range.location + range.length <= size());
+  std::fill_n(_bindings.begin() + range.location * _maxVertexBufferBindCount,
+              range.length * _maxVertexBufferBindCount, Binding{});
+  for (std::size_t i = 0; i < range.length; ++i) {
+    _draws[range.location + i].vertexCount = 0;
+  }
+}
+
+void SoftwareIndirectCommandBuffer::replay(
+    std::size_t command, std::vector<SoftwareCommand> &commands) const {
+  const SoftwareCommand &draw = _draws[command];
+  if (draw.vertexCount == 0) {
+    return;
+  }
+  const Binding *pBindings =
+      _bindings.data() + command * _maxVertexBufferBindCount;
+  for (std::size_t index = 0; index < _maxVertexBufferBindCount; ++index) {
+    if (pBindings[index].pBuffer != nullptr) {
+      commands.push_back({SoftwareCommand::Type::SetVertexBuffer,
+                          PrimitiveType::Point,
+                          static_cast<std::uint32_t>(index),
+                          pBindings[index].pBuffer, pBindings[index].offset,
+                          0});
+    }
+  }
+  commands.push_back(draw);
+}
+
+void SoftwareRenderCommandEncoder::setRenderPipelineState(
+    RenderPipelineState *pState) {
+  assert(_encoding);
+  SoftwareCommand &command = _commands.emplace_back(
+      SoftwareCommand{SoftwareCommand::Type::SetRenderPipelineState,
+                      PrimitiveType::Point, 0, nullptr, 0, 0});
+  command.pPipelineState = pState;
+}
+
+void SoftwareRenderCommandEncoder::setVertexBuffer(Buffer *pBuffer,
+                                                   std::size_t offset,
+                                                   std::size_t index) {
+  assert(_encoding);
+  assert(index < kMaxVertexBuffers);
+  assert(pBuffer == nullptr || offset < pBuffer->length());
+  _commands.push_back({SoftwareCommand::Type::SetVertexBuffer,
+                       PrimitiveType::Point, static_cast<std::uint32_t>(index),
+                       pBuffer, offset, 0});
+  if (pBuffer != nullptr && _retainedReferences) {
+    _referencedResources.push_back(pBuffer);
+  }
+}
+
+void SoftwareRenderCommandEncoder::setVertexBufferOffset(std::size_t offset,
+                                                         std::size_t index) {
+  assert(_encoding);
+  assert(index < kMaxVertexBuffers);
+  _commands.push_back({SoftwareCommand::Type::SetVertexBufferOffset,
+                       PrimitiveType::Point, static_cast<std::uint32_t>(index),
+                       nullptr, offset, 0});
+}
+
+void SoftwareRenderCommandEncoder::setFragmentTexture(Texture *pTexture,
+                                                      std::size_t index) {
+  assert(_encoding);
+  assert(index < kMaxFragmentTextures);
+  SoftwareCommand &command = _commands.emplace_back(SoftwareCommand{
+      SoftwareCommand::Type::SetFragmentTexture, PrimitiveType::Point,
+      static_cast<std::uint32_t>(index), nullptr, 0, 0});
+  command.pTexture = pTexture;
+  if (pTexture != nullptr && _retainedReferences) {
+    _referencedResources.push_back(pTexture);
+  }
+}
+
+void SoftwareRenderCommandEncoder::setViewport(const Viewport &viewport) {
+  assert(_encoding);
+  _commands.push_back({SoftwareCommand::Type::SetViewport,
+                       PrimitiveType::Point,
+                       static_cast<std::uint32_t>(_viewports.size()), nullptr,
+                       0, 0});
+  _viewports.push_back(viewport);
+}
+
+void SoftwareRenderCommandEncoder::setScissorRect(const ScissorRect &rect) {
+  assert(_encoding);
+  _commands.push_back({SoftwareCommand::Type::SetScissorRect,
+                       PrimitiveType::Point,
+                       static_cast<std::uint32_t>(_scissorRects.size()),
+                       nullptr, 0, 0});
+  _scissorRects.push_back(rect);
+}
+
+void SoftwareRenderCommandEncoder::setCullMode(CullMode cullMode) {
+  assert(_encoding);
+  _commands.push_back({SoftwareCommand::Type::SetCullMode,
+                       PrimitiveType::Point, 0, nullptr,
+                       static_cast<std::size_t>(cullMode), 0});
+}
+
+void SoftwareRenderCommandEncoder::setFrontFacingWinding(Winding winding) {
+  assert(_encoding);
+  _commands.push_back({SoftwareCommand::Type::SetFrontFacingWinding,
+                       PrimitiveType::Point, 0, nullptr,
+                       static_cast<std::size_t>(winding), 0});
+}
+
+void SoftwareRenderCommandEncoder::drawPrimitives(PrimitiveType primitiveType,
+                                                  std::size_t vertexStart,
+                                                  std::size_t vertexCount) {
+  assert(_encoding);
+  if (vertexCount == 0) {
+    return;
+  }
+  _commands.push_back({SoftwareCommand::Type::DrawPrimitives, primitiveType,
+                       0, nullptr, vertexStart, vertexCount});
+  ++_drawCount;
+}
+
+void SoftwareRenderCommandEncoder::useResource(Buffer *pBuffer) {
+  assert(_encoding);
+  if (_retainedReferences) {
+    _referencedResources.push_back(pBuffer);
+  }
+}
+
+void SoftwareRenderCommandEncoder::executeCommandsInBuffer(
+    IndirectCommandBuffer *pCommands,
+    const IndirectCommandBufferExecutionRange &range) {
+  assert(_encoding);
+  assert(range.location + range.length <= pCommands->size());
+  SoftwareCommand &command = _commands.emplace_back(
+      SoftwareCommand{SoftwareCommand::Type::ExecuteCommandsInBuffer,
+                      PrimitiveType::Point, 0, nullptr, range.location,
+                      range.length});
+  command.pCommands = static_cast<SoftwareIndirectCommandBuffer *>(pCommands);
+}
+
+void SoftwareRenderCommandEncoder::begin(bool retainedReferences) {
+  _retainedReferences = retainedReferences;
+  _encoding = true;
+}
+
+void SoftwareRenderCommandEncoder::reset() {
+  _commands.clear();
+  _viewports.clear();
+  _scissorRects.clear();
+  _referencedResources.clear();
+  _drawCount = 0;
+}
+
+SoftwareRenderCommandEncoder *
+SoftwareParallelRenderCommandEncoder::renderCommandEncoder() {
+  assert(_encoding);
+  SoftwareRenderCommandEncoder *pEncoder = _pCommandBuffer->acquireEncoder();
+  ++_pCommandBuffer->_passes.back().encoderCount;
+  return pEncoder;
+}
+
+void SoftwareParallelRenderCommandEncoder::endEncoding() {
+  assert(_encoding);
+  const SoftwareCommandBuffer::Pass &pass = _pCommandBuffer->_passes.back();
+  for (std::size_t i = 0; i < pass.encoderCount; ++i) {
+    assert(!_pCommandBuffer->_encoders[pass.firstEncoder + i]->_encoding &&
+           "sub-encoder was not ended before its parallel encoder");
+  }
+  _encoding = false;
+}
+
+void SoftwareBlitCommandEncoder::copyFromTexture(
+    Texture *pTexture, Buffer *pBuffer, std::size_t destinationOffset,
+    std::size_t destinationBytesPerRow) {
+  assert(_encoding);
+  auto *pSource = static_cast<SoftwareTexture *>(pTexture);
+  assert(destinationBytesPerRow >= pSource->bytesPerRow());
+  assert(destinationOffset +
+             destinationBytesPerRow * (pSource->height() - 1) +
+             pSource->bytesPerRow() <=
+         pBuffer->length());
+  _pCommandBuffer->_copies.push_back({pSource, nullptr, 0, pBuffer,
+                                      destinationOffset,
+                                      destinationBytesPerRow});
+  ++_pCommandBuffer->_passes.back().copyCount;
+}
+
+void SoftwareBlitCommandEncoder::copyFromBuffer(Buffer *pSource,
+                                                std::size_t sourceOffset,
+                                                Buffer *pDestination,
+                                                std::size_t destinationOffset,
+                                                std::size_t size) {
+  assert(_encoding);
+  assert(sourceOffset + size <= pSource->length());
+  assert(destinationOffset + size <= pDestination->length());
+  _pCommandBuffer->_copies.push_back(
+      {nullptr, pSource, sourceOffset, pDestination, destinationOffset, size});
+  ++_pCommandBuffer->_passes.back().copyCount;
+}
+
+void SoftwareCommandBuffer::addCompletedHandler(
+    const HandlerFunction &function) {
+  assert(status() == Status::NotEnqueued);
+  _completedHandlers.push_back(function);
+}
+
+SoftwareRenderCommandEncoder *SoftwareCommandBuffer::renderCommandEncoder(
+    const RenderPassDescriptor &descriptor) {
+  assert(status() == Status::NotEnqueued);
+  assert(!isEncoding() && "previous encoder was not ended");
+  _passes.push_back({descriptor, _encoderCount, 1});
+  return acquireEncoder();
+}
+
+SoftwareParallelRenderCommandEncoder *
+SoftwareCommandBuffer::parallelRenderCommandEncoder(
+    const RenderPassDescriptor &descriptor) {
+  assert(status() == Status::NotEnqueued);
+  assert(!isEncoding() && "previous encoder was not ended");
+  _passes.push_back({descriptor, _encoderCount, 0});
+  _parallelEncoder._encoding = true;
+  return &_parallelEncoder;
+}
+
+SoftwareBlitCommandEncoder *SoftwareCommandBuffer::blitCommandEncoder() {
+  assert(status() == Status::NotEnqueued);
+  assert(!isEncoding() && "previous encoder was not ended");
+  _passes.push_back({{}, _encoderCount, 0, _copies.size(), 0});
+  _blitEncoder._encoding = true;
+  return &_blitEncoder;
+}
+
+void SoftwareCommandBuffer::encodeWait(SharedEvent *pEvent,
+                                       std::uint64_t value) {
+  assert(status() == Status::NotEnqueued);
+  assert(!isEncoding() && "previous encoder was not ended");
+  Pass &pass = _passes.emplace_back(Pass{{}, _encoderCount, 0});
+  pass.pWaitEvent = static_cast<SoftwareSharedEvent *>(pEvent);
+  pass.eventValue = value;
+}
+
+void SoftwareCommandBuffer::encodeSignalEvent(SharedEvent *pEvent,
+                                              std::uint64_t value) {
+  assert(status() == Status::NotEnqueued);
+  assert(!isEncoding() && "previous encoder was not ended");
+  Pass &pass = _passes.emplace_back(Pass{{}, _encoderCount, 0});
+  pass.pSignalEvent = static_cast<SoftwareSharedEvent *>(pEvent);
+  pass.eventValue = value;
+}
+
+std::size_t SoftwareCommandBuffer::drawCount() const {
+  std::size_t drawCount = 0;
+  for (std::size_t i = 0; i < _encoderCount; ++i) {
+    drawCount += _encoders[i]->_drawCount;
+  }
+  return drawCount;
+}
+
+std::size_t SoftwareCommandBuffer::referencedResourceCount() const {
+  std::size_t count = 0;
+  for (std::size_t i = 0; i < _encoderCount; ++i) {
+    count += _encoders[i]->_referencedResources.size();
+  }
+  return count;
+}
+
+SoftwareRenderCommandEncoder *SoftwareCommandBuffer::acquireEncoder() {
+  if (_encoderCount == _encoders.size()) {
+    _encoders.push_back(std::make_unique<SoftwareRenderCommandEncoder>());
+  }
+  SoftwareRenderCommandEncoder *pEncoder = _encoders[_encoderCount++].get();
+  pEncoder->begin(_retainedReferences);
+  return pEncoder;
+}
+
+bool SoftwareCommandBuffer::isEncoding() const {
+  if (_parallelEncoder._encoding || _blitEncoder._encoding) {
+    return true;
+  }
+  for (std::size_t i = 0; i < _encoderCount; ++i) {
+    if (_encoders[i]->_encoding) {
+      return true;
+    }
+  }
+  return false;
+}
+
+void SoftwareCommandBuffer::presentDrawable(Drawable *pDrawable) {
+  assert(status() == Status::NotEnqueued);
+  _drawables.push_back(static_cast<SoftwareDrawable *>(pDrawable));
+}
+
+void SoftwareCommandBuffer::commit() {
+  assert(status() == Status::NotEnqueued);
+  assert(!isEncoding() && "encoder was not ended before commit");
+  _status.store(Status::Committed, std::memory_order_release);
+  for (SoftwareDrawable *pDrawable : _drawables) {
+    pDrawable->view()->schedulePresent(pDrawable);
+  }
+  _pQueue->enqueue(this);
+}
+
+void SoftwareCommandBuffer::waitUntilCompleted() {
+  assert(status() != Status::NotEnqueued);
+  _pQueue->waitUntilCompleted(this);
+}
+
+void SoftwareCommandBuffer::reset(const CommandBufferDescriptor &descriptor) {
+  _status.store(Status::NotEnqueued, std::memory_order_relaxed);
+  _passes.clear();
+  for (std::size_t i = 0; i < _encoderCount; ++i) {
+    _encoders[i]->reset();
+  }
+  _encoderCount = 0;
+  _copies.clear();
+  _drawables.clear();
+  _completedHandlers.clear();
+  _retainedReferences = descriptor.retainedReferences;
+  _executionDigest = kDigestBasis;
+}
+
+void SoftwareCommandBuffer::execute() {
+  for (const Pass &pass : _passes) {
+    if (pass.pWaitEvent != nullptr) {
+      pass.pWaitEvent->wait(pass.eventValue);
+    }
+    if (pass.pSignalEvent != nullptr) {
+      pass.pSignalEvent->signal(pass.eventValue);
+    }
+    const RenderPassColorAttachmentDescriptor &color =
+        pass.descriptor.colorAttachment;
+    for (std::size_t i = 0; i < pass.copyCount; ++i) {
+      const Copy &copy = _copies[pass.firstCopy + i];
+      if (copy.pTexture == nullptr) {
+        std::memcpy(
+            static_cast<std::uint8_t *>(copy.pBuffer->contents()) +
+                copy.offset,
+            static_cast<const std::uint8_t *>(copy.pSource->contents()) +
+                copy.sourceOffset,
+            copy.bytesPerRow);
+        continue;
+      }
+      const std::size_t rowLength = copy.pTexture->bytesPerRow();
+      auto *pDestination =
+          static_cast<std::uint8_t *>(copy.pBuffer->contents()) + copy.offset;
+      for (std::uint32_t row = 0; row < copy.pTexture->height(); ++row) {
+        std::memcpy(pDestination + row * copy.bytesPerRow,
+                    copy.pTexture->contents() + row * rowLength, rowLength);
+      }
+    }
+    auto *pTexture = static_cast<SoftwareTexture *>(color.pTexture);
+    // Rendering happens in place, so Load and DontCare both keep the current
+    // contents and only Clear touches memory. StoreAction::DontCare is
+    // honoured the same way: the contents are simply left undefined.
+    if (pTexture != nullptr && color.loadAction == LoadAction::Clear) {
+      pTexture->clear(color.clearColor);
+    }
+
+    for (std::size_t i = 0; i < pass.encoderCount; ++i) {
+      executeEncoder(*_encoders[pass.firstEncoder + i]);
+    }
+  }
+  for (SoftwareDrawable *pDrawable : _drawables) {
+    pDrawable->view()->present(pDrawable);
+  }
+}
+
+void SoftwareCommandBuffer::executeEncoder(
+    const SoftwareRenderCommandEncoder &encoder) {
+  RenderState state;
+  for (const SoftwareCommand &command : encoder._commands) {
+    switch (command.type) {
+      case SoftwareCommand::Type::SetRenderPipelineState:
+        state.pPipelineState = command.pPipelineState;
+        break;
+      case SoftwareCommand::Type::SetVertexBuffer:
+        bindVertexBuffer(state.vertexBuffers, state.vertexBufferCount,
+                         command.index, command.pBuffer, command.start);
+        break;
+      case SoftwareCommand::Type::SetVertexBufferOffset:
+        assert(command.index < state.vertexBufferCount &&
+               state.vertexBuffers[command.index].pBuffer != nullptr &&
+               "offset set without a buffer bound");
+        state.vertexBuffers[command.index].offset = command.start;
+        break;
+      case SoftwareCommand::Type::SetFragmentTexture:
+        for (; state.fragmentTextureCount <= command.index;
+             ++state.fragmentTextureCount) {
+          state.fragmentTextures[state.fragmentTextureCount] = nullptr;
+        }
+        state.fragmentTextures[command.index] = command.pTexture;
+        break;
+      case SoftwareCommand::Type::SetViewport:
+        state.viewport = encoder._viewports[command.index];
+        break;
+      case SoftwareCommand::Type::SetScissorRect:
+        state.scissorRect = encoder._scissorRects[command.index];
+        break;
+      case SoftwareCommand::Type::SetCullMode:
+        state.cullMode = static_cast<CullMode>(command.start);
+        break;
+      case SoftwareCommand::Type::SetFrontFacingWinding:
+        state.winding = static_cast<Winding>(command.start);
+        break;
+      case SoftwareCommand::Type::DrawPrimitives:
+        hashDraw(_executionDigest, command, state.vertexBuffers,
+                 state.vertexBufferCount, state);
+        break;
+      case SoftwareCommand::Type::ExecuteCommandsInBuffer:
+        // Indirect commands don't inherit vertex buffers; everything else
+        // comes from the encoder.
+        for (std::size_t j = 0; j < command.vertexCount; ++j) {
+          _replayedCommands.clear();
+          command.pCommands->replay(command.start + j, _replayedCommands);
+          VertexBufferBinding
+              bindings[RenderCommandEncoder::kMaxVertexBuffers];
+          std::size_t bindingCount = 0;
+          for (const SoftwareCommand &replayed : _replayedCommands) {
+            if (replayed.type == SoftwareCommand::Type::SetVertexBuffer) {
+              bindVertexBuffer(bindings, bindingCount, replayed.index,
+                               replayed.pBuffer, replayed.start);
+            } else {
+              hashDraw(_executionDigest, replayed, bindings, bindingCount,
+                       state);
+            }
+          }
+        }
+        break;
+    }
+  }
+}
+
+void SoftwareCommandBuffer::complete() {
+  for (const HandlerFunction &handler : _completedHandlers) {
+    handler();
+  }
+  for (std::size_t i = 0; i < _encoderCount; ++i) {
+    _encoders[i]->_referencedResources.clear();
+  }
+  {
+    std::lock_guard<std::mutex> lock(_pQueue->_mutex);
+    _status.store(Status::Completed, std::memory_order_release);
+  }
+  _pQueue->_completed.notify_all();
+}
+
+SoftwareCommandQueue::SoftwareCommandQueue(
+    std::chrono::microseconds completionLatency)
+    : _completionLatency(completionLatency) {
+  if (_completionLatency.count() > 0) {
+    _worker = std::thread(&SoftwareCommandQueue::run, this);
+  }
+}
+
+SoftwareCommandQueue::~SoftwareCommandQueue() {
+  if (_worker.joinable()) {
+    {
+      std::lock_guard<std::mutex> lock(_mutex);
+      _stopping = true;
+    }
+    _submitted.notify_one();
+    _worker.join();
+  }
+}
+
+SoftwareCommandBuffer *SoftwareCommandQueue::commandBuffer(
+    const CommandBufferDescriptor &descriptor) {
+  for (const auto &pCommandBuffer : _commandBuffers) {
+    if (pCommandBuffer->status() == SoftwareCommandBuffer::Status::Completed) {
+      pCommandBuffer->reset(descriptor);
+      return pCommandBuffer.get();
+    }
+  }
+  SoftwareCommandBuffer *pCommandBuffer =
+      _commandBuffers
+          .emplace_back(std::make_unique<SoftwareCommandBuffer>(this))
+          .get();
+  pCommandBuffer->reset(descriptor);
+  return pCommandBuffer;
+}
+
+void SoftwareCommandQueue::enqueue(SoftwareCommandBuffer *pCommandBuffer) {
+  if (!_worker.joinable()) {
+    pCommandBuffer->execute();
+    pCommandBuffer->complete();
+    return;
+  }
+  {
+    std::lock_guard<std::mutex> lock(_mutex);
+    _pending.push_back(pCommandBuffer);
+  }
+  _submitted.notify_one();
+}
+
+void SoftwareCommandQueue::waitUntilCompleted(
+    const SoftwareCommandBuffer *pCommandBuffer) {
+  std::unique_lock<std::mutex> lock(_mutex);
+  _completed.wait(lock, [pCommandBuffer] {
+    return pCommandBuffer->status() == SoftwareCommandBuffer::Status::Completed;
+  });
+}
+
+void SoftwareCommandQueue::run() {
+  for (;;) {
+    SoftwareCommandBuffer *pCommandBuffer = nullptr;
+    {
+      std::unique_lock<std::mutex> lock(_mutex);
+      _submitted.wait(lock, [this] { return _stopping || !_pending.empty(); });
+      if (_pending.empty()) {
+        return;
+      }
+      pCommandBuffer = _pending.front();
+      _pending.pop_front();
+    }
+
+    const auto start = std::chrono::steady_clock::now();
+    pCommandBuffer->execute();
+    std::this_thread::sleep_until(start + _completionLatency);
+    pCommandBuffer->complete();
+  }
+}
+
+std::unique_ptr<CommandQueue> SoftwareDevice::newCommandQueue() {
+  return std::make_unique<SoftwareCommandQueue>(_completionLatency);
+}
+
+std::unique_ptr<Buffer> SoftwareDevice::newBuffer(std::size_t length) {
+  return std::make_unique<SoftwareBuffer>(length);
+}
+
+SizeAndAlign SoftwareDevice::heapBufferSizeAndAlign(std::size_t length) {
+  constexpr std::size_t kAlignment = SoftwareBuffer::kAlignment;
+  return {(std::max<std::size_t>(length, 1) + kAlignment - 1) / kAlignment *
+              kAlignment,
+          kAlignment};
+}
+
+std::unique_ptr<Heap> SoftwareDevice::newHeap(std::size_t size) {
+  return std::make_unique<SoftwareHeap>(size);
+}
+
+std::unique_ptr<SharedEvent> SoftwareDevice::newSharedEvent() {
+  return std::make_unique<SoftwareSharedEvent>();
+}
+
+std::unique_ptr<IndirectCommandBuffer>
+SoftwareDevice::newIndirectCommandBuffer(
+    const IndirectCommandBufferDescriptor &descriptor,
+    std::size_t maxCommandCount) {
+  return std::make_unique<SoftwareIndirectCommandBuffer>(descriptor,
+                                                         maxCommandCount);
+}
+
+std::unique_ptr<RenderPipelineState> SoftwareDevice::newRenderPipelineState(
+    const RenderPipelineDescriptor &descriptor) {
+  if (_pipelineCompileTime.count() > 0) {
+    std::this_thread::sleep_for(_pipelineCompileTime);
+  }
+  if (descriptor.vertexFunction.empty()) {
+    return nullptr;
+  }
+  return std::make_unique<SoftwareRenderPipelineState>(descriptor);
+}
+
+std::unique_ptr<Texture> SoftwareDevice::newTexture(std::uint32_t width,
+                                                    std::uint32_t height,
+                                                    PixelFormat pixelFormat) {
+  return std::make_unique<SoftwareTexture>(width, height, pixelFormat);
+}
+
+SoftwareView::SoftwareView(std::uint32_t width, std::uint32_t height,
+                           PixelFormat colorPixelFormat,
+                           std::size_t drawableCount) {
+  assert(drawableCount > 0);
+  _drawables.reserve(drawableCount);
+  for (std::size_t i = 0; i < drawableCount; ++i) {
+    _drawables.push_back(std::make_unique<SoftwareDrawable>(
+        this, width, height, colorPixelFormat));
+  }
+}
+
+RenderPassDescriptor SoftwareView::currentRenderPassDescriptor() {
+  RenderPassDescriptor descriptor;
+  descriptor.colorAttachment.pTexture = currentDrawable()->texture();
+  descriptor.colorAttachment.loadAction = LoadAction::Clear;
+  descriptor.colorAttachment.storeAction = StoreAction::Store;
+  descriptor.colorAttachment.clearColor = _clearColor;
+  return descriptor;
+}
+
+SoftwareDrawable *SoftwareView::currentDrawable() {
+  std::unique_lock<std::mutex> lock(_mutex);
+  if (_pCurrent == nullptr) {
+    SoftwareDrawable *pNext = _drawables[_nextDrawable].get();
+    _presented.wait(lock, [pNext] { return !pNext->_pendingPresent; });
+    _pCurrent = pNext;
+    _nextDrawable = (_nextDrawable + 1) % _drawables.size();
+  }
+  return _pCurrent;
+}
+
+const SoftwareDrawable *SoftwareView::presentedDrawable() {
+  std::lock_guard<std::mutex> lock(_mutex);
+  return _pPresented;
+}
+
+std::uint64_t SoftwareView::presentedCount() {
+  std::lock_guard<std::mutex> lock(_mutex);
+  return _presentedCount;
+}
+
+void SoftwareView::schedulePresent(SoftwareDrawable *pDrawable) {
+  std::lock_guard<std::mutex> lock(_mutex);
+  pDrawable->_pendingPresent = true;
+  if (_pCurrent == pDrawable) {
+    _pCurrent = nullptr;
+  }
+}
+
+void SoftwareView::present(SoftwareDrawable *pDrawable) {
+  {
+    std::lock_guard<std::mutex> lock(_mutex);
+    pDrawable->_pendingPresent = false;
+    _pPresented = pDrawable;
+    ++_presentedCount;
+  }
+  _presented.notify_all();
+}
+
+}  // namespace Gfx
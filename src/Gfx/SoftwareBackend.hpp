@@ -0,0 +1,503 @@
+#pragma once
+
+#include <Gfx/Backend.hpp>
+
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+// Headless reference implementation of the backend interface. Command
+// buffers record their render and blit passes and execute them on the CPU,
+// rendering into plain host memory.
+//
+// By default a command buffer executes synchronously inside commit(). When
+// the device is created with a completion latency, each queue instead owns a
+// worker thread that plays the role of the GPU: committed buffers execute in
+// order on that thread and each one occupies it for at least the configured
+// latency before its completion handlers run.
+namespace Gfx {
+
+class SoftwareIndirectCommandBuffer;
+class SoftwareView;
+
+class SoftwareBuffer final : public Buffer {
+ public:
+  static constexpr std::size_t kAlignment = 256;
+
+  explicit SoftwareBuffer(std::size_t length);
+  // Placed in memory it does not own, for buffers in a SoftwareHeap.
+  SoftwareBuffer(void *pContents, std::size_t length)
+      : _pContents(pContents), _length(length), _owned(false) {}
+  ~SoftwareBuffer() override;
+
+  SoftwareBuffer(const SoftwareBuffer &) = delete;
+  SoftwareBuffer &operator=(const SoftwareBuffer &) = delete;
+
+  void *contents() override { return _pContents; }
+  [[nodiscard]] std::size_t length() const override { return _length; }
+
+ private:
+  void *_pContents;
+  std::size_t _length;
+  bool _owned = true;
+};
+
+// One allocation of host memory; placing a buffer only wraps a pointer into
+// it. Placed buffers start out with whatever their range held last.
+class SoftwareHeap final : public Heap {
+ public:
+  explicit SoftwareHeap(std::size_t size);
+  ~SoftwareHeap() override;
+
+  SoftwareHeap(const SoftwareHeap &) = delete;
+  SoftwareHeap &operator=(const SoftwareHeap &) = delete;
+
+  [[nodiscard]] std::size_t size() const override { return _size; }
+  std::unique_ptr<Buffer> newBuffer(std::size_t length,
+                                    std::size_t offset) override;
+
+ private:
+  std::uint8_t *_pContents;
+  std::size_t _size;
+};
+
+// Listeners run on the thread that signals: the queue's worker thread, or
+// the committing thread when command buffers execute synchronously.
+class SoftwareSharedEvent final : public SharedEvent {
+ public:
+  [[nodiscard]] std::uint64_t signaledValue() const override {
+    return _value.load(std::memory_order_acquire);
+  }
+  void notify(std::uint64_t value, NotificationFunction function) override;
+
+  // Raises the value; like Metal's, it never goes back down.
+  void signal(std::uint64_t value);
+  // Blocks until the value has reached value.
+  void wait(std::uint64_t value);
+
+ private:
+  struct Listener {
+    std::uint64_t value;
+    NotificationFunction function;
+  };
+
+  std::mutex _mutex;
+  std::condition_variable _signaled;
+  std::atomic<std::uint64_t> _value = 0;
+  std::vector<Listener> _listeners;
+};
+
+class SoftwareTexture final : public Texture {
+ public:
+  SoftwareTexture(std::uint32_t width, std::uint32_t height,
+                  PixelFormat pixelFormat);
+
+  [[nodiscard]] std::uint32_t width() const override { return _width; }
+  [[nodiscard]] std::uint32_t height() const override { return _height; }
+  [[nodiscard]] PixelFormat pixelFormat() const override {
+    return _pixelFormat;
+  }
+
+  [[nodiscard]] std::size_t bytesPerRow() const;
+  std::uint8_t *contents() { return _storage.data(); }
+  [[nodiscard]] const std::uint8_t *contents() const {
+    return _storage.data();
+  }
+
+  void clear(const ClearColor &color);
+
+ private:
+  // Clears formats that clear() has no hand-written fill for.
+  void fillConverted(const ClearColor &color);
+
+  std::uint32_t _width;
+  std::uint32_t _height;
+  PixelFormat _pixelFormat;
+  std::vector<std::uint8_t> _storage;
+};
+
+class SoftwareDrawable final : public Drawable {
+ public:
+  SoftwareDrawable(SoftwareView *pView, std::uint32_t width,
+                   std::uint32_t height, PixelFormat pixelFormat);
+
+  SoftwareTexture *texture() override { return &_texture; }
+  [[nodiscard]] SoftwareView *view() const { return _pView; }
+
+ private:
+  friend class SoftwareView;
+
+  SoftwareView *_pView;
+  SoftwareTexture _texture;
+  bool _pendingPresent = false;
+};
+
+// Keeps the descriptor it was compiled from.
+class SoftwareRenderPipelineState final : public RenderPipelineState {
+ public:
+  explicit SoftwareRenderPipelineState(
+      const RenderPipelineDescriptor &descriptor)
+      : _descriptor(descriptor) {}
+
+  [[nodiscard]] const RenderPipelineDescriptor &descriptor() const {
+    return _descriptor;
+  }
+
+ private:
+  RenderPipelineDescriptor _descriptor;
+};
+
+struct SoftwareCommand {
+  enum class Type : std::uint8_t {
+    SetRenderPipelineState,
+    SetVertexBuffer,
+    SetVertexBufferOffset,
+    SetFragmentTexture,
+    SetViewport,
+    SetScissorRect,
+    SetCullMode,
+    SetFrontFacingWinding,
+    DrawPrimitives,
+    ExecuteCommandsInBuffer,
+  };
+
+  Type type;
+  PrimitiveType primitiveType;
+  // Binding index, or for viewports and scissor rects the index into the
+  // encoder's list of them.
+  std::uint32_t index;
+  Buffer *pBuffer;
+  // Buffer offset, first vertex, first indirect command, cull mode or
+  // winding.
+  std::size_t start;
+  // Vertex count or indirect command count.
+  std::size_t vertexCount;
+  std::uint32_t instanceCount = 1;
+  std::uint32_t baseInstance = 0;
+  SoftwareIndirectCommandBuffer *pCommands = nullptr;
+  Texture *pTexture = nullptr;
+  RenderPipelineState *pPipelineState = nullptr;
+};
+
+// Keeps every command's bindings and draw. Executing a command replays it
+// as the setVertexBuffer() calls and the draw it was encoded with, on top of
+// the encoder's other state, so a pass that executes indirect commands has
+// the same digest as one that encodes the same draws directly.
+class SoftwareIndirectCommandBuffer final : public IndirectCommandBuffer {
+ public:
+  SoftwareIndirectCommandBuffer(
+      const IndirectCommandBufferDescriptor &descriptor,
+      std::size_t maxCommandCount);
+
+  [[nodiscard]] std::size_t size() const override { return _draws.size(); }
+  void setVertexBuffer(std::size_t command, Buffer *pBuffer,
+                       std::size_t offset, std::size_t index) override;
+  void drawPrimitives(std::size_t command, PrimitiveType primitiveType,
+                      std::size_t vertexStart, std::size_t vertexCount,
+                      std::size_t instanceCount,
+                      std::size_t baseInstance) override;
+  void reset(const IndirectCommandBufferExecutionRange &range) override;
+
+  // Appends command's replay to commands; nothing for a command without a
+  // draw.
+  void replay(std::size_t command,
+              std::vector<SoftwareCommand> &commands) const;
+
+ private:
+  struct Binding {
+    Buffer *pBuffer = nullptr;
+    std::size_t offset = 0;
+  };
+
+  std::size_t _maxVertexBufferBindCount;
+  // maxVertexBufferBindCount per command.
+  std::vector<Binding> _bindings;
+  // A draw with a vertexCount of 0 is no draw.
+  std::vector<SoftwareCommand> _draws;
+};
+
+// Records into its own command list, so the encoders of a parallel pass can
+// record at the same time. Draws are replayed at execution but not
+// rasterized; only render pass load actions touch the attachments.
+class SoftwareRenderCommandEncoder final : public RenderCommandEncoder {
+ public:
+  void setRenderPipelineState(RenderPipelineState *pState) override;
+  void setVertexBuffer(Buffer *pBuffer, std::size_t offset,
+                       std::size_t index) override;
+  void setVertexBufferOffset(std::size_t offset, std::size_t index) override;
+  void setFragmentTexture(Texture *pTexture, std::size_t index) override;
+  void setViewport(const Viewport &viewport) override;
+  void setScissorRect(const ScissorRect &rect) override;
+  void setCullMode(CullMode cullMode) override;
+  void setFrontFacingWinding(Winding winding) override;
+  void drawPrimitives(PrimitiveType primitiveType, std::size_t vertexStart,
+                      std::size_t vertexCount) override;
+  void useResource(Buffer *pBuffer) override;
+  void executeCommandsInBuffer(
+      IndirectCommandBuffer *pCommands,
+      const IndirectCommandBufferExecutionRange &range) override;
+  void endEncoding() override { _encoding = false; }
+
+ private:
+  friend class SoftwareCommandBuffer;
+  friend class SoftwareParallelRenderCommandEncoder;
+
+  void begin(bool retainedReferences);
+  void reset();
+
+  std::vector<SoftwareCommand> _commands;
+  std::vector<Viewport> _viewports;
+  std::vector<ScissorRect> _scissorRects;
+  // Buffers and textures.
+  std::vector<const void *> _referencedResources;
+  std::size_t _drawCount = 0;
+  bool _retainedReferences = true;
+  bool _encoding = false;
+};
+
+class SoftwareCommandBuffer;
+
+class SoftwareParallelRenderCommandEncoder final
+    : public ParallelRenderCommandEncoder {
+ public:
+  explicit SoftwareParallelRenderCommandEncoder(
+      SoftwareCommandBuffer *pCommandBuffer)
+      : _pCommandBuffer(pCommandBuffer) {}
+
+  SoftwareRenderCommandEncoder *renderCommandEncoder() override;
+  void endEncoding() override;
+
+ private:
+  friend class SoftwareCommandBuffer;
+
+  SoftwareCommandBuffer *_pCommandBuffer;
+  bool _encoding = false;
+};
+
+// Records texture to buffer and buffer to buffer copies, which execute in
+// pass order with the command buffer's render passes.
+class SoftwareBlitCommandEncoder final : public BlitCommandEncoder {
+ public:
+  explicit SoftwareBlitCommandEncoder(SoftwareCommandBuffer *pCommandBuffer)
+      : _pCommandBuffer(pCommandBuffer) {}
+
+  void copyFromTexture(Texture *pTexture, Buffer *pBuffer,
+                       std::size_t destinationOffset,
+                       std::size_t destinationBytesPerRow) override;
+  void copyFromBuffer(Buffer *pSource, std::size_t sourceOffset,
+                      Buffer *pDestination, std::size_t destinationOffset,
+                      std::size_t size) override;
+  void endEncoding() override { _encoding = false; }
+
+ private:
+  friend class SoftwareCommandBuffer;
+
+  SoftwareCommandBuffer *_pCommandBuffer;
+  bool _encoding = false;
+};
+
+class SoftwareCommandQueue;
+
+class SoftwareCommandBuffer final : public CommandBuffer {
+ public:
+  enum class Status : std::uint8_t {
+    NotEnqueued,
+    Committed,
+    Completed,
+  };
+
+  explicit SoftwareCommandBuffer(SoftwareCommandQueue *pQueue)
+      : _pQueue(pQueue), _parallelEncoder(this), _blitEncoder(this) {}
+
+  void addCompletedHandler(const HandlerFunction &function) override;
+  SoftwareRenderCommandEncoder *renderCommandEncoder(
+      const RenderPassDescriptor &descriptor) override;
+  SoftwareParallelRenderCommandEncoder *parallelRenderCommandEncoder(
+      const RenderPassDescriptor &descriptor) override;
+  SoftwareBlitCommandEncoder *blitCommandEncoder() override;
+  // Executing a wait blocks the executing thread, so without a completion
+  // latency the value has to be signaled by the time the buffer is
+  // committed.
+  void encodeWait(SharedEvent *pEvent, std::uint64_t value) override;
+  void encodeSignalEvent(SharedEvent *pEvent, std::uint64_t value) override;
+  void presentDrawable(Drawable *pDrawable) override;
+  void commit() override;
+  void waitUntilCompleted() override;
+
+  [[nodiscard]] Status status() const {
+    return _status.load(std::memory_order_acquire);
+  }
+  // Draws encoded directly; indirect commands only count once executed, in
+  // the digest.
+  [[nodiscard]] std::size_t drawCount() const;
+  // Resources this buffer holds on to until it completes; always empty
+  // without retained references.
+  [[nodiscard]] std::size_t referencedResourceCount() const;
+  // Hash of every draw in execution order together with the state it
+  // executes with, valid once completed. Two command buffers that make the
+  // same draws with the same state in the same order have the same digest,
+  // however they were encoded and whatever redundant state they set.
+  [[nodiscard]] std::uint64_t executionDigest() const {
+    return _executionDigest;
+  }
+
+ private:
+  friend class SoftwareCommandQueue;
+  friend class SoftwareParallelRenderCommandEncoder;
+  friend class SoftwareBlitCommandEncoder;
+
+  // From pTexture, or from pSource at sourceOffset without one.
+  struct Copy {
+    SoftwareTexture *pTexture;
+    Buffer *pSource;
+    std::size_t sourceOffset;
+    Buffer *pBuffer;
+    std::size_t offset;
+    // Row pitch of a texture copy, length of a buffer copy.
+    std::size_t bytesPerRow;
+  };
+
+  // A blit pass has no attachment and no encoders, only copies; an event
+  // pass has nothing but its event.
+  struct Pass {
+    RenderPassDescriptor descriptor;
+    std::size_t firstEncoder;
+    std::size_t encoderCount;
+    std::size_t firstCopy = 0;
+    std::size_t copyCount = 0;
+    SoftwareSharedEvent *pWaitEvent = nullptr;
+    SoftwareSharedEvent *pSignalEvent = nullptr;
+    std::uint64_t eventValue = 0;
+  };
+
+  SoftwareRenderCommandEncoder *acquireEncoder();
+  [[nodiscard]] bool isEncoding() const;
+  void reset(const CommandBufferDescriptor &descriptor);
+  void execute();
+  // Adds encoder's draws to the digest.
+  void executeEncoder(const SoftwareRenderCommandEncoder &encoder);
+  void complete();
+
+  SoftwareCommandQueue *_pQueue;
+  std::atomic<Status> _status = Status::NotEnqueued;
+  std::vector<Pass> _passes;
+  // Reused across frames; the first _encoderCount belong to this one.
+  std::vector<std::unique_ptr<SoftwareRenderCommandEncoder>> _encoders;
+  std::size_t _encoderCount = 0;
+  SoftwareParallelRenderCommandEncoder _parallelEncoder;
+  SoftwareBlitCommandEncoder _blitEncoder;
+  std::vector<Copy> _copies;
+  std::vector<SoftwareDrawable *> _drawables;
+  std::vector<HandlerFunction> _completedHandlers;
+  bool _retainedReferences = true;
+  std::uint64_t _executionDigest = 0;
+  // Scratch of execute() for indirect commands.
+  std::vector<SoftwareCommand> _replayedCommands;
+};
+
+class SoftwareCommandQueue final : public CommandQueue {
+ public:
+  explicit SoftwareCommandQueue(
+      std::chrono::microseconds completionLatency = {});
+  ~SoftwareCommandQueue() override;
+
+  SoftwareCommandQueue(const SoftwareCommandQueue &) = delete;
+  SoftwareCommandQueue &operator=(const SoftwareCommandQueue &) = delete;
+
+  using CommandQueue::commandBuffer;
+  SoftwareCommandBuffer *commandBuffer(
+      const CommandBufferDescriptor &descriptor) override;
+
+ private:
+  friend class SoftwareCommandBuffer;
+
+  void enqueue(SoftwareCommandBuffer *pCommandBuffer);
+  void waitUntilCompleted(const SoftwareCommandBuffer *pCommandBuffer);
+  void run();
+
+  std::chrono::microseconds _completionLatency;
+  std::vector<std::unique_ptr<SoftwareCommandBuffer>> _commandBuffers;
+
+  std::mutex _mutex;
+  std::condition_variable _submitted;
+  std::condition_variable _completed;
+  std::deque<SoftwareCommandBuffer *> _pending;
+  bool _stopping = false;
+  std::thread _worker;
+};
+
+// Compiling a render pipeline stands in for the shader compiler by taking
+// the device's pipeline compile time; like on Metal, a pipeline without a
+// vertex function fails to compile.
+class SoftwareDevice final : public Device {
+ public:
+  explicit SoftwareDevice(std::chrono::microseconds completionLatency = {},
+                          std::chrono::microseconds pipelineCompileTime = {})
+      : _completionLatency(completionLatency),
+        _pipelineCompileTime(pipelineCompileTime) {}
+
+  std::unique_ptr<CommandQueue> newCommandQueue() override;
+  std::unique_ptr<Buffer> newBuffer(std::size_t length) override;
+  // Buffers take whole SoftwareBuffer::kAlignment blocks.
+  SizeAndAlign heapBufferSizeAndAlign(std::size_t length) override;
+  std::unique_ptr<Heap> newHeap(std::size_t size) override;
+  std::unique_ptr<SharedEvent> newSharedEvent() override;
+  std::unique_ptr<IndirectCommandBuffer> newIndirectCommandBuffer(
+      const IndirectCommandBufferDescriptor &descriptor,
+      std::size_t maxCommandCount) override;
+  std::unique_ptr<RenderPipelineState> newRenderPipelineState(
+      const RenderPipelineDescriptor &descriptor) override;
+  std::unique_ptr<Texture> newTexture(std::uint32_t width,
+                                      std::uint32_t height,
+                                      PixelFormat pixelFormat) override;
+
+ private:
+  std::chrono::microseconds _completionLatency;
+  std::chrono::microseconds _pipelineCompileTime;
+};
+
+// Stand-in for MTK::View: owns a small swap chain of CPU drawables and hands
+// out the next one each frame. Like CAMetalLayer, acquiring a drawable that
+// is still queued for presentation blocks until it has been presented.
+class SoftwareView final : public View {
+ public:
+  SoftwareView(std::uint32_t width, std::uint32_t height,
+               PixelFormat colorPixelFormat, std::size_t drawableCount = 3);
+
+  void setClearColor(const ClearColor &clearColor) {
+    _clearColor = clearColor;
+  }
+  [[nodiscard]] ClearColor clearColor() const { return _clearColor; }
+
+  RenderPassDescriptor currentRenderPassDescriptor() override;
+  SoftwareDrawable *currentDrawable() override;
+
+  // Most recently presented drawable, or nullptr before the first present.
+  [[nodiscard]] const SoftwareDrawable *presentedDrawable();
+  [[nodiscard]] std::uint64_t presentedCount();
+
+ private:
+  friend class SoftwareCommandBuffer;
+
+  void schedulePresent(SoftwareDrawable *pDrawable);
+  void present(SoftwareDrawable *pDrawable);
+
+  ClearColor _clearColor = ClearColor::Make(0.0, 0.0, 0.0, 1.0);
+  std::vector<std::unique_ptr<SoftwareDrawable>> _drawables;
+  std::size_t _nextDrawable = 0;
+
+  std::mutex _mutex;
+  std::condition_variable _presented;
+  SoftwareDrawable *_pCurrent = nullptr;
+  SoftwareDrawable *_pPresented = nullptr;
+  std::uint64_t _presentedCount = 0;
+};
+
+}  // namespace Gfx
@@ -0,0 +1,301 @@
+#include <Gfx/TlsfAllocator.hpp>
+
+#include <algorithm>
+#include <bit>
+#include <cassert>
+
+namespace Gfx {
+
+namespace {
+
+std::uint64_t alignUp(std::uint64_t value, std::uint64_t alignment) {
+  return (value + alignment - 1) & ~(alignment - 1);
+}
+
+}  // namespace
+
+TlsfAllocator::SizeClass TlsfAllocator::sizeClass(std::uint64_t units) {
+  if (units < kSecondLevelCount) {
+    return {0, static_cast<std::uint32_t>(units)};
+  }
+  const int topBit = std::bit_width(units) - 1;
+  return {static_cast<std::uint32_t>(topBit - kSecondLevelBits + 1),
+          static_cast<std::uint32_t>((units >> (topBit - kSecondLevelBits)) &
+                                     (kSecondLevelCount - 1))};
+}
+
+std::uint64_t TlsfAllocator::roundUpToSizeClass(std::uint64_t units) {
+  if (units < kSecondLevelCount) {
+    return units;
+  }
+  const int topBit = std::bit_width(units) - 1;
+  const std::uint64_t step = std::uint64_t{1} << (topBit - kSecondLevelBits);
+  return (units + step - 1) & ~(step - 1);
+}
+
+TlsfAllocator::TlsfAllocator(std::uint64_t size, std::uint64_t granularity)
+    : _size(size),
+      _granularity(granularity),
+      _granularityShift(std::countr_zero(granularity)) {
+  assert(std::has_single_bit(granularity));
+  reset();
+}
+
+TlsfAllocator::Allocation TlsfAllocator::allocate(std::uint64_t size,
+                                                  std::uint64_t alignment) {
+  assert(std::has_single_bit(alignment));
+  const std::uint64_t units =
+      std::max<std::uint64_t>(1, (size + _granularity - 1) >>
+                                     _granularityShift);
+  const std::uint64_t alignUnits =
+      std::max<std::uint64_t>(1, alignment >> _granularityShift);
+  const std::uint32_t node = findFree(units, alignUnits);
+  if (node == kInvalidNode) {
+    return {};
+  }
+  removeFree(node);
+
+  // Leading space the alignment skips stays free. Its physical predecessor
+  // is in use, as free blocks never touch.
+  const std::uint64_t offset = _blocks[node].offset;
+  const std::uint64_t alignedOffset = alignUp(offset, alignUnits);
+  if (alignedOffset != offset) {
+    const std::uint32_t previous = _blocks[node].previousPhysical;
+    const std::uint32_t padding =
+        newNode({offset, alignedOffset - offset, previous, node, kInvalidNode,
+                 kInvalidNode, false});
+    if (previous != kInvalidNode) {
+      _blocks[previous].nextPhysical = padding;
+    } else {
+      _firstNode = padding;
+    }
+    _blocks[node].previousPhysical = padding;
+    _blocks[node].offset = alignedOffset;
+    _blocks[node].size -= alignedOffset - offset;
+    insertFree(padding);
+  }
+
+  if (_blocks[node].size > units) {
+    const std::uint32_t next = _blocks[node].nextPhysical;
+    const std::uint32_t rest =
+        newNode({alignedOffset + units, _blocks[node].size - units, node, next,
+                 kInvalidNode, kInvalidNode, false});
+    if (next != kInvalidNode) {
+      _blocks[next].previousPhysical = rest;
+    }
+    _blocks[node].nextPhysical = rest;
+    _blocks[node].size = units;
+    insertFree(rest);
+  }
+
+  _blocks[node].used = true;
+  _usedUnits += units;
+  ++_allocationCount;
+  return {alignedOffset << _granularityShift, units << _granularityShift,
+          node};
+}
+
+void TlsfAllocator::free(const Allocation &allocation) {
+  const std::uint32_t node = allocation.node;
+  if (node == kInvalidNode) {
+    return;
+  }
+  assert(node < _blocks.size() && _blocks[node].used);
+  _blocks[node].used = false;
+  _usedUnits -= _blocks[node].size;
+  --_allocationCount;
+
+  const std::uint32_t previous = _blocks[node].previousPhysical;
+  if (previous != kInvalidNode && !_blocks[previous].used) {
+    removeFree(previous);
+    const std::uint32_t beforePrevious = _blocks[previous].previousPhysical;
+    _blocks[node].offset = _blocks[previous].offset;
+    _blocks[node].size += _blocks[previous].size;
+    _blocks[node].previousPhysical = beforePrevious;
+    if (beforePrevious != kInvalidNode) {
+      _blocks[beforePrevious].nextPhysical = node;
+    } else {
+      _firstNode = node;
+    }
+    releaseNode(previous);
+  }
+  const std::uint32_t next = _blocks[node].nextPhysical;
+  if (next != kInvalidNode && !_blocks[next].used) {
+    removeFree(next);
+    const std::uint32_t afterNext = _blocks[next].nextPhysical;
+    _blocks[node].size += _blocks[next].size;
+    _blocks[node].nextPhysical = afterNext;
+    if (afterNext != kInvalidNode) {
+      _blocks[afterNext].previousPhysical = node;
+    }
+    releaseNode(next);
+  }
+  insertFree(node);
+}
+
+void TlsfAllocator::reset() {
+  _blocks.clear();
+  _unusedNodes.clear();
+  _firstLevelMap = 0;
+  std::fill(std::begin(_secondLevelMaps), std::end(_secondLevelMaps), 0);
+  for (auto &heads : _freeHeads) {
+    std::fill(std::begin(heads), std::end(heads), kInvalidNode);
+  }
+  _usedUnits = 0;
+  _allocationCount = 0;
+  _freeBlockCount = 0;
+  _firstNode = kInvalidNode;
+  const std::uint64_t units = _size >> _granularityShift;
+  if (units > 0) {
+    _firstNode = newNode({0, units, kInvalidNode, kInvalidNode, kInvalidNode,
+                          kInvalidNode, false});
+    insertFree(_firstNode);
+  }
+}
+
+TlsfAllocator::Statistics TlsfAllocator::statistics() const {
+  const std::uint64_t totalUnits = _size >> _granularityShift;
+  return {_size,
+          _usedUnits << _granularityShift,
+          (totalUnits - _usedUnits) << _granularityShift,
+          largestFreeUnits() << _granularityShift,
+          _allocationCount,
+          _freeBlockCount};
+}
+
+double TlsfAllocator::fragmentation() const {
+  const std::uint64_t freeUnits = (_size >> _granularityShift) - _usedUnits;
+  if (freeUnits == 0) {
+    return 0.0;
+  }
+  return 1.0 - static_cast<double>(largestFreeUnits()) /
+                   static_cast<double>(freeUnits);
+}
+
+std::vector<TlsfAllocator::Allocation> TlsfAllocator::defragmentationCandidates(
+    std::size_t maxCount) const {
+  // Blocks in physical order, each with the largest free block before it.
+  std::vector<std::pair<std::uint32_t, std::uint64_t>> blocks;
+  blocks.reserve(_allocationCount + _freeBlockCount);
+  std::uint64_t largestFree = 0;
+  for (std::uint32_t node = _firstNode; node != kInvalidNode;
+       node = _blocks[node].nextPhysical) {
+    blocks.emplace_back(node, largestFree);
+    if (!_blocks[node].used) {
+      largestFree = std::max(largestFree, _blocks[node].size);
+    }
+  }
+
+  std::vector<Allocation> candidates;
+  for (auto it = blocks.rbegin();
+       it != blocks.rend() && candidates.size() < maxCount; ++it) {
+    const Block &block = _blocks[it->first];
+    if (block.used && block.size <= it->second) {
+      candidates.push_back({block.offset << _granularityShift,
+                            block.size << _granularityShift, it->first});
+    }
+  }
+  return candidates;
+}
+
+std::uint32_t TlsfAllocator::newNode(const Block &block) {
+  if (_unusedNodes.empty()) {
+    _blocks.push_back(block);
+    return static_cast<std::uint32_t>(_blocks.size() - 1);
+  }
+  const std::uint32_t node = _unusedNodes.back();
+  _unusedNodes.pop_back();
+  _blocks[node] = block;
+  return node;
+}
+
+void TlsfAllocator::releaseNode(std::uint32_t node) {
+  _unusedNodes.push_back(node);
+}
+
+void TlsfAllocator::insertFree(std::uint32_t node) {
+  const SizeClass bin = sizeClass(_blocks[node].size);
+  std::uint32_t &head = _freeHeads[bin.firstLevel][bin.secondLevel];
+  _blocks[node].previousFree = kInvalidNode;
+  _blocks[node].nextFree = head;
+  if (head != kInvalidNode) {
+    _blocks[head].previousFree = node;
+  }
+  head = node;
+  _firstLevelMap |= std::uint64_t{1} << bin.firstLevel;
+  _secondLevelMaps[bin.firstLevel] |= 1U << bin.secondLevel;
+  ++_freeBlockCount;
+}
+
+void TlsfAllocator::removeFree(std::uint32_t node) {
+  const Block &block = _blocks[node];
+  if (block.previousFree != kInvalidNode) {
+    _blocks[block.previousFree].nextFree = block.nextFree;
+  } else {
+    const SizeClass bin = sizeClass(block.size);
+    _freeHeads[bin.firstLevel][bin.secondLevel] = block.nextFree;
+    if (block.nextFree == kInvalidNode) {
+      _secondLevelMaps[bin.firstLevel] &= ~(1U << bin.secondLevel);
+      if (_secondLevelMaps[bin.firstLevel] == 0) {
+        _firstLevelMap &= ~(std::uint64_t{1} << bin.firstLevel);
+      }
+    }
+  }
+  if (block.nextFree != kInvalidNode) {
+    _blocks[block.nextFree].previousFree = block.previousFree;
+  }
+  --_freeBlockCount;
+}
+
+std::uint32_t TlsfAllocator::findFree(std::uint64_t units,
+                                      std::uint64_t alignUnits) const {
+  // Any block of units + alignUnits - 1 can be aligned; rounding up to the
+  // next bin makes every block in it fit, so the first one will do.
+  SizeClass bin = sizeClass(roundUpToSizeClass(units + alignUnits - 1));
+  std::uint32_t secondLevelMap =
+      _secondLevelMaps[bin.firstLevel] & (~0U << bin.secondLevel);
+  if (secondLevelMap == 0) {
+    const std::uint64_t firstLevelMap =
+        bin.firstLevel + 1 < kFirstLevelCount
+            ? _firstLevelMap & (~std::uint64_t{0} << (bin.firstLevel + 1))
+            : 0;
+    if (firstLevelMap != 0) {
+      bin.firstLevel = std::countr_zero(firstLevelMap);
+      secondLevelMap = _secondLevelMaps[bin.firstLevel];
+    }
+  }
+  if (secondLevelMap != 0) {
+    bin.secondLevel = std::countr_zero(secondLevelMap);
+    return _freeHeads[bin.firstLevel][bin.secondLevel];
+  }
+
+  // Nothing is that large, but the bin units itself falls into can still
+  // hold a block that fits.
+  bin = sizeClass(units);
+  for (std::uint32_t node = _freeHeads[bin.firstLevel][bin.secondLevel];
+       node != kInvalidNode; node = _blocks[node].nextFree) {
+    const Block &block = _blocks[node];
+    const std::uint64_t padding = alignUp(block.offset, alignUnits) -
+                                  block.offset;
+    if (block.size >= padding + units) {
+      return node;
+    }
+  }
+  return kInvalidNode;
+}
+
+std::uint64_t TlsfAllocator::largestFreeUnits() const {
+  if (_firstLevelMap == 0) {
+    return 0;
+  }
+  const int firstLevel = std::bit_width(_firstLevelMap) - 1;
+  const int secondLevel = std::bit_width(_secondLevelMaps[firstLevel]) - 1;
+  std::uint64_t largest = 0;
+  for (std::uint32_t node = _freeHeads[firstLevel][secondLevel];
+       node != kInvalidNode; node = _blocks[node].nextFree) {
+    largest = std::max(largest, _blocks[node].size);
+  }
+  return largest;
+}
+
+}  // namespace Gfx
@@ -0,0 +1,118 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+namespace Gfx {
+
+// Two-Level Segregated Fit allocator (Masmano et al., "TLSF: a New Dynamic
+// Memory Allocator for Real-Time Systems", 2004) over a range of offsets
+// rather than memory it owns, so it can place buffers in a GPU heap the CPU
+// never touches. Free blocks are binned by size: a power of two split into
+// 16 linear steps. Two levels of bitmaps find the smallest bin that fits in
+// constant time, and freed blocks merge with free neighbours right away.
+//
+// Sizes and offsets are kept in units of the granularity, the smallest block
+// and alignment the allocator hands out. Not thread safe.
+class TlsfAllocator {
+ public:
+  static constexpr std::uint32_t kInvalidNode = ~std::uint32_t{0};
+
+  struct Allocation {
+    std::uint64_t offset = 0;
+    std::uint64_t size = 0;
+    // Identifies the allocation to free(); kInvalidNode if it failed.
+    std::uint32_t node = kInvalidNode;
+
+    explicit operator bool() const { return node != kInvalidNode; }
+  };
+
+  struct Statistics {
+    std::uint64_t size;
+    std::uint64_t usedBytes;
+    std::uint64_t freeBytes;
+    std::uint64_t largestFreeBlock;
+    std::size_t allocationCount;
+    std::size_t freeBlockCount;
+  };
+
+  // granularity has to be a power of two.
+  TlsfAllocator(std::uint64_t size, std::uint64_t granularity);
+
+  // Rounds size up to the granularity; alignment has to be a power of two.
+  // Fails, rather than growing, once no free block fits.
+  [[nodiscard]] Allocation allocate(std::uint64_t size,
+                                    std::uint64_t alignment);
+  // Does nothing for an allocation that failed.
+  void free(const Allocation &allocation);
+  // Frees every allocation at once.
+  void reset();
+
+  [[nodiscard]] std::uint64_t size() const { return _size; }
+  [[nodiscard]] std::uint64_t granularity() const { return _granularity; }
+  [[nodiscard]] bool empty() const { return _allocationCount == 0; }
+  [[nodiscard]] Statistics statistics() const;
+  // 1 - largest free block / free bytes: 0 while the free space is one
+  // block, approaching 1 as it splinters.
+  [[nodiscard]] double fragmentation() const;
+  // Allocations to move to compact the range: up to maxCount of those
+  // nearest its end that would fit into a free block before them, last
+  // first. Allocating each anew before freeing it, as a copy does, tends to
+  // move it down and merges the space it leaves into the free end.
+  [[nodiscard]] std::vector<Allocation> defragmentationCandidates(
+      std::size_t maxCount) const;
+
+ private:
+  static constexpr int kSecondLevelBits = 4;
+  static constexpr std::uint32_t kSecondLevelCount = 1 << kSecondLevelBits;
+  static constexpr std::uint32_t kFirstLevelCount = 64;
+
+  // Bin of a block: sizes below kSecondLevelCount units get one each, and
+  // each power of two above is split into kSecondLevelCount equal steps.
+  struct SizeClass {
+    std::uint32_t firstLevel;
+    std::uint32_t secondLevel;
+  };
+
+  // A run of units, in physical order with its neighbours and, while free,
+  // in the list of its bin.
+  struct Block {
+    std::uint64_t offset;
+    std::uint64_t size;
+    std::uint32_t previousPhysical;
+    std::uint32_t nextPhysical;
+    std::uint32_t previousFree;
+    std::uint32_t nextFree;
+    bool used;
+  };
+
+  static SizeClass sizeClass(std::uint64_t units);
+  // Rounds units up to the smallest size of a bin, so every block in the bin
+  // of the result is at least units long.
+  static std::uint64_t roundUpToSizeClass(std::uint64_t units);
+
+  std::uint32_t newNode(const Block &block);
+  void releaseNode(std::uint32_t node);
+  void insertFree(std::uint32_t node);
+  void removeFree(std::uint32_t node);
+  // A free block of at least units that can be aligned to alignUnits.
+  [[nodiscard]] std::uint32_t findFree(std::uint64_t units,
+                                       std::uint64_t alignUnits) const;
+  [[nodiscard]] std::uint64_t largestFreeUnits() const;
+
+  std::uint64_t _size;
+  std::uint64_t _granularity;
+  int _granularityShift;
+  std::vector<Block> _blocks;
+  std::vector<std::uint32_t> _unusedNodes;
+  std::uint32_t _firstNode = kInvalidNode;
+  std::uint64_t _firstLevelMap = 0;
+  std::uint32_t _secondLevelMaps[kFirstLevelCount] = {};
+  std::uint32_t _freeHeads[kFirstLevelCount][kSecondLevelCount];
+  std::uint64_t _usedUnits = 0;
+  std::size_t _allocationCount = 0;
+  std::size_t _freeBlockCount = 0;
+};
+
+}  // namespace Gfx
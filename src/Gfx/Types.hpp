@@ -0,0 +1,138 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+
+namespace Gfx {
+
+// The MTL::PixelFormat values the backends and PixelConversion.hpp handle, in
+// Metal's order.
+enum class PixelFormat : std::uint8_t {
+  Invalid,
+  RGBA8Unorm,
+  RGBA8Unorm_sRGB,
+  RGB10A2Unorm,
+  RG11B10Float,
+  BGRA8Unorm,
+  BGRA8Unorm_sRGB,
+  BGR10A2Unorm,
+  RGBA16Float,
+  RGBA32Float,
+  Depth16Unorm,
+  Depth32Float,
+};
+
+enum class LoadAction : std::uint8_t {
+  DontCare,
+  Load,
+  Clear,
+};
+
+enum class StoreAction : std::uint8_t {
+  DontCare,
+  Store,
+};
+
+enum class PrimitiveType : std::uint8_t {
+  Point,
+  Line,
+  LineStrip,
+  Triangle,
+  TriangleStrip,
+};
+
+enum class CullMode : std::uint8_t {
+  None,
+  Front,
+  Back,
+};
+
+enum class Winding : std::uint8_t {
+  Clockwise,
+  CounterClockwise,
+};
+
+enum class VertexFormat : std::uint8_t {
+  Invalid,
+  UChar4Normalized,
+  Float,
+  Float2,
+  Float3,
+  Float4,
+};
+
+// Same values as MTL::VertexStepFunction.
+enum class VertexStepFunction : std::uint8_t {
+  Constant,
+  PerVertex,
+  PerInstance,
+};
+
+// Same values as MTL::BlendFactor.
+enum class BlendFactor : std::uint8_t {
+  Zero,
+  One,
+  SourceColor,
+  OneMinusSourceColor,
+  SourceAlpha,
+  OneMinusSourceAlpha,
+  DestinationColor,
+  OneMinusDestinationColor,
+  DestinationAlpha,
+  OneMinusDestinationAlpha,
+};
+
+// Same values as MTL::BlendOperation.
+enum class BlendOperation : std::uint8_t {
+  Add,
+  Subtract,
+  ReverseSubtract,
+  Min,
+  Max,
+};
+
+// MTL::ColorWriteMask bits.
+enum ColorWriteMask : std::uint8_t {
+  ColorWriteMaskNone = 0,
+  ColorWriteMaskAlpha = 1,
+  ColorWriteMaskBlue = 2,
+  ColorWriteMaskGreen = 4,
+  ColorWriteMaskRed = 8,
+  ColorWriteMaskAll = 15,
+};
+
+// Same layout as MTL::Viewport.
+struct Viewport {
+  double originX;
+  double originY;
+  double width;
+  double height;
+  double znear;
+  double zfar;
+
+  friend bool operator==(const Viewport &, const Viewport &) = default;
+};
+
+// Same layout as MTL::ScissorRect.
+struct ScissorRect {
+  std::size_t x;
+  std::size_t y;
+  std::size_t width;
+  std::size_t height;
+
+  friend bool operator==(const ScissorRect &, const ScissorRect &) = default;
+};
+
+struct ClearColor {
+  static constexpr ClearColor Make(double red, double green, double blue,
+                                   double alpha) {
+    return {red, green, blue, alpha};
+  }
+
+  double red{};
+  double green{};
+  double blue{};
+  double alpha{};
+};
+
+}  // namespace Gfx
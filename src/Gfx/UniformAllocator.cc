@@ -0,0 +1,45 @@
+#include <Gfx/UniformAllocator.hpp>
+
+#include <bit>
+#include <cassert>
+
+namespace Gfx {
+
+UniformAllocator::UniformAllocator(Device *pDevice, std::size_t bytesPerFrame,
+                                   std::size_t frameCount,
+                                   std::size_t alignment)
+    : _bytesPerFrame((bytesPerFrame + alignment - 1) & ~(alignment - 1)),
+      _frameCount(frameCount),
+      _alignment(alignment) {
+  assert(std::has_single_bit(alignment));
+  assert(frameCount > 0);
+  _pBuffer = pDevice->newBuffer(_bytesPerFrame * _frameCount);
+  _pContents = static_cast<std::uint8_t *>(_pBuffer->contents());
+}
+
+void UniformAllocator::beginFrame(std::size_t slot) {
+  assert(slot < _frameCount);
+  _highWaterMark =
+      std::max(_highWaterMark, _head.load(std::memory_order_relaxed));
+  _frameOffset = slot * _bytesPerFrame;
+  _head.store(0, std::memory_order_relaxed);
+}
+
+UniformAllocation UniformBlockAllocator::refill(std::size_t size,
+                                                std::size_t alignedSize) {
+  if (alignedSize >= _blockSize) {
+    return _pAllocator->allocate(size);
+  }
+  // The rest of the old block is given up.
+  _block = _pAllocator->allocate(_blockSize);
+  if (!_block) {
+    // Near the end of the region a whole block may not fit where the slice
+    // still does.
+    _remaining = 0;
+    return _pAllocator->allocate(size);
+  }
+  _remaining = _blockSize;
+  return allocate(size);
+}
+
+}  // namespace Gfx
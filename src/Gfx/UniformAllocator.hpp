@@ -0,0 +1,156 @@
+#pragma once
+
+#include <Gfx/Backend.hpp>
+
+#include <algorithm>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <memory>
+
+namespace Gfx {
+
+// A slice of the uniform buffer: bind pBuffer at offset, write through
+// pContents. Empty when the frame's region is full.
+struct UniformAllocation {
+  Buffer *pBuffer = nullptr;
+  std::size_t offset = 0;
+  void *pContents = nullptr;
+
+  explicit operator bool() const { return pContents != nullptr; }
+};
+
+// Linear allocator for per-draw constants. One persistent shared buffer is
+// split into a region per frame in flight; each frame bumps through its own
+// region, so constants cost a copy into memory the GPU already reads instead
+// of a buffer or a setVertexBytes copy per draw.
+//
+// allocate() is one atomic fetch-add and may be called from any number of
+// encoding threads at once. beginFrame() is not thread safe: call it from
+// the frame's thread once the slot's previous frame has completed, before
+// any thread allocates.
+class UniformAllocator {
+ public:
+  // The largest constant buffer offset alignment Metal asks for.
+  static constexpr std::size_t kDefaultAlignment = 256;
+
+  UniformAllocator(Device *pDevice, std::size_t bytesPerFrame,
+                   std::size_t frameCount,
+                   std::size_t alignment = kDefaultAlignment);
+
+  UniformAllocator(const UniformAllocator &) = delete;
+  UniformAllocator &operator=(const UniformAllocator &) = delete;
+
+  // Starts over in slot's region.
+  void beginFrame(std::size_t slot);
+
+  // size bytes at an offset aligned to alignment().
+  UniformAllocation allocate(std::size_t size) {
+    const std::size_t alignedSize = (size + _alignment - 1) & ~(_alignment - 1);
+    const std::size_t offset =
+        _head.fetch_add(alignedSize, std::memory_order_relaxed);
+    if (offset + alignedSize > _bytesPerFrame) {
+      _overflowCount.fetch_add(1, std::memory_order_relaxed);
+      return {};
+    }
+    return {_pBuffer.get(), _frameOffset + offset,
+            _pContents + _frameOffset + offset};
+  }
+  // Copies value into a new slice.
+  template <typename T>
+  UniformAllocation push(const T &value) {
+    const UniformAllocation allocation = allocate(sizeof(T));
+    if (allocation) {
+      std::memcpy(allocation.pContents, &value, sizeof(T));
+    }
+    return allocation;
+  }
+
+  [[nodiscard]] Buffer *buffer() const { return _pBuffer.get(); }
+  [[nodiscard]] std::size_t bytesPerFrame() const { return _bytesPerFrame; }
+  [[nodiscard]] std::size_t frameCount() const { return _frameCount; }
+  [[nodiscard]] std::size_t alignment() const { return _alignment; }
+  // Bytes handed out in the current frame so far.
+  [[nodiscard]] std::size_t usedBytes() const {
+    return std::min(_head.load(std::memory_order_relaxed), _bytesPerFrame);
+  }
+  // Most bytes an earlier frame asked for, including requests that failed;
+  // a region this large would have fit every one of them.
+  [[nodiscard]] std::size_t highWaterMark() const { return _highWaterMark; }
+  // Allocations that failed since the allocator was created.
+  [[nodiscard]] std::uint64_t overflowCount() const {
+    return _overflowCount.load(std::memory_order_relaxed);
+  }
+
+ private:
+  std::unique_ptr<Buffer> _pBuffer;
+  std::uint8_t *_pContents;
+  std::size_t _bytesPerFrame;
+  std::size_t _frameCount;
+  std::size_t _alignment;
+  std::size_t _frameOffset = 0;
+  std::size_t _highWaterMark = 0;
+  // Alone on its cache line, so bumping it does not invalidate the fields
+  // every allocate() reads.
+  alignas(64) std::atomic<std::size_t> _head{0};
+  alignas(64) std::atomic<std::uint64_t> _overflowCount{0};
+};
+
+// Per-thread front end of a UniformAllocator: reserves blocks of it, one
+// fetch-add each, and hands out slices of the block without touching shared
+// state. On x86 every atomic add also waits for the thread's pending stores,
+// which for freshly written constants are cache misses, so amortizing the
+// add over a block is what keeps many small draws cheap. Not thread safe;
+// give each encoding thread or job its own for the frame.
+class UniformBlockAllocator {
+ public:
+  static constexpr std::size_t kDefaultBlockSize = 16 * 1024;
+
+  explicit UniformBlockAllocator(UniformAllocator *pAllocator,
+                                 std::size_t blockSize = kDefaultBlockSize)
+      : _pAllocator(pAllocator), _blockSize(blockSize) {}
+
+  // size bytes at an offset aligned to the allocator's alignment. Slices
+  // larger than a block come from the allocator directly.
+  UniformAllocation allocate(std::size_t size) {
+    const std::size_t alignment = _pAllocator->alignment();
+    const std::size_t alignedSize = (size + alignment - 1) & ~(alignment - 1);
+    if (alignedSize > _remaining) {
+      return refill(size, alignedSize);
+    }
+    const UniformAllocation allocation{
+        _block.pBuffer, _block.offset,
+        static_cast<std::uint8_t *>(_block.pContents)};
+    _block.offset += alignedSize;
+    _block.pContents = static_cast<std::uint8_t *>(_block.pContents) +
+                       alignedSize;
+    _remaining -= alignedSize;
+    return allocation;
+  }
+  template <typename T>
+  UniformAllocation push(const T &value) {
+    const UniformAllocation allocation = allocate(sizeof(T));
+    if (allocation) {
+      std::memcpy(allocation.pContents, &value, sizeof(T));
+    }
+    return allocation;
+  }
+
+  // Drops the current block, for reuse in a new frame.
+  void reset() {
+    _block = {};
+    _remaining = 0;
+  }
+
+ private:
+  UniformAllocation refill(std::size_t size, std::size_t alignedSize);
+
+  UniformAllocator *_pAllocator;
+  std::size_t _blockSize;
+  // The unused rest of the current block.
+  UniformAllocation _block;
+  std::size_t _remaining = 0;
+};
+
+}  // namespace Gfx
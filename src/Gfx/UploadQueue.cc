@@ -0,0 +1,153 @@
+#include <Gfx/UploadQueue.hpp>
+
+#include <algorithm>
+#include <cassert>
+#include <cstring>
+
+namespace Gfx {
+
+UploadQueue::UploadQueue(Device *pDevice,
+                         const UploadQueueDescriptor &descriptor)
+    : _descriptor(descriptor),
+      _pEvent(pDevice->newSharedEvent()),
+      _pCommandQueue(pDevice->newCommandQueue()) {
+  assert(_descriptor.stagingBufferSize % kCopyAlignment == 0);
+  assert(_descriptor.stagingBufferCount > 0);
+  _stagingBuffers.resize(_descriptor.stagingBufferCount);
+  for (StagingBuffer &staging : _stagingBuffers) {
+    staging.pBuffer = pDevice->newBuffer(_descriptor.stagingBufferSize);
+  }
+}
+
+UploadQueue::~UploadQueue() {
+  {
+    std::lock_guard<std::mutex> lock(_mutex);
+    submit();
+  }
+  // Every notification has to be done with this, not just the last batch.
+  std::unique_lock<std::mutex> lock(_completionMutex);
+  _completed.wait(lock, [this] { return _pendingNotifications == 0; });
+}
+
+std::uint64_t UploadQueue::upload(Buffer *pDestination,
+                                  std::size_t destinationOffset,
+                                  const void *pData, std::size_t size) {
+  const auto *pBytes = static_cast<const std::uint8_t *>(pData);
+  std::lock_guard<std::mutex> lock(_mutex);
+  ++_statistics.uploadCount;
+  _statistics.uploadedBytes += size;
+  if (size == 0) {
+    return _regions.empty() ? _submittedValue : _submittedValue + 1;
+  }
+  while (size > 0) {
+    std::size_t chunk = std::min(size, _descriptor.stagingBufferSize - _head);
+    if (chunk < size) {
+      // Split where both halves stay copyable.
+      chunk &= ~(kCopyAlignment - 1);
+    }
+    if (chunk == 0) {
+      submit();
+      continue;
+    }
+    acquireStagingBuffer();
+    auto *pStaging = static_cast<std::uint8_t *>(
+        _stagingBuffers[_current].pBuffer->contents());
+    std::memcpy(pStaging + _head, pBytes, chunk);
+    Region *pLast = _regions.empty() ? nullptr : &_regions.back();
+    if (pLast != nullptr && pLast->pDestination == pDestination &&
+        pLast->destinationOffset + pLast->size == destinationOffset &&
+        pLast->stagingOffset + pLast->size == _head) {
+      pLast->size += chunk;
+    } else {
+      _regions.push_back({pDestination, destinationOffset, _head, chunk});
+    }
+    _head = (_head + chunk + kCopyAlignment - 1) & ~(kCopyAlignment - 1);
+    pBytes += chunk;
+    destinationOffset += chunk;
+    size -= chunk;
+  }
+  return _submittedValue + 1;
+}
+
+std::uint64_t UploadQueue::flush() {
+  std::lock_guard<std::mutex> lock(_mutex);
+  return submit();
+}
+
+void UploadQueue::wait(std::uint64_t value) {
+  {
+    std::lock_guard<std::mutex> lock(_mutex);
+    if (value > _submittedValue) {
+      submit();
+    }
+    assert(value <= _submittedValue);
+  }
+  std::unique_lock<std::mutex> lock(_completionMutex);
+  _completed.wait(lock, [this, value] { return _completedValue >= value; });
+}
+
+UploadQueueStatistics UploadQueue::statistics() {
+  std::lock_guard<std::mutex> lock(_mutex);
+  return _statistics;
+}
+
+void UploadQueue::acquireStagingBuffer() {
+  if (_acquired) {
+    return;
+  }
+  const std::uint64_t value = _stagingBuffers[_current].value;
+  std::unique_lock<std::mutex> lock(_completionMutex);
+  if (_completedValue < value) {
+    ++_statistics.stallCount;
+    _completed.wait(lock, [this, value] { return _completedValue >= value; });
+  }
+  _acquired = true;
+}
+
+std::uint64_t UploadQueue::submit() {
+  if (_regions.empty()) {
+    return _submittedValue;
+  }
+  StagingBuffer &staging = _stagingBuffers[_current];
+  const std::uint64_t value = ++_submittedValue;
+
+  // The staging buffers outlive every batch, and destinations are the
+  // caller's to keep alive.
+  CommandBuffer *pCommandBuffer =
+      _pCommandQueue->commandBuffer({.retainedReferences = false});
+  BlitCommandEncoder *pBlit = pCommandBuffer->blitCommandEncoder();
+  for (const Region &region : _regions) {
+    pBlit->copyFromBuffer(staging.pBuffer.get(), region.stagingOffset,
+                          region.pDestination, region.destinationOffset,
+                          region.size);
+  }
+  pBlit->endEncoding();
+  pCommandBuffer->encodeSignalEvent(_pEvent.get(), value);
+  {
+    std::lock_guard<std::mutex> lock(_completionMutex);
+    ++_pendingNotifications;
+  }
+  _pEvent->notify(value, [this](std::uint64_t signaledValue) {
+    completed(signaledValue);
+  });
+  pCommandBuffer->commit();
+
+  ++_statistics.batchCount;
+  _statistics.copyCount += _regions.size();
+  staging.value = value;
+  _regions.clear();
+  _head = 0;
+  _current = (_current + 1) % _stagingBuffers.size();
+  _acquired = false;
+  return value;
+}
+
+void UploadQueue::completed(std::uint64_t value) {
+  std::lock_guard<std::mutex> lock(_completionMutex);
+  _completedValue = std::max(_completedValue, value);
+  --_pendingNotifications;
+  // Under the lock: the destructor may be waiting to destroy this.
+  _completed.notify_all();
+}
+
+}  // namespace Gfx
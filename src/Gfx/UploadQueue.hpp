@@ -0,0 +1,123 @@
+#pragma once
+
+#include <Gfx/Backend.hpp>
+
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <vector>
+
+// Streams data into GPU buffers through a ring of shared staging buffers.
+// upload() copies the data into the current staging buffer and queues a
+// region; flush() turns the queued regions into one command buffer with a
+// single blit encoder, merging regions that continue one another into one
+// copy, and signals the queue's shared event with the batch's value. Render
+// command buffers that read the uploads wait for that value with
+// encodeWait(), so neither side blocks on the CPU.
+namespace Gfx {
+
+struct UploadQueueDescriptor {
+  // Staging memory per batch; uploads that don't fit are split.
+  std::size_t stagingBufferSize = std::size_t{8} << 20;
+  // Batches in flight before upload() waits for one to complete.
+  std::size_t stagingBufferCount = 3;
+};
+
+struct UploadQueueStatistics {
+  std::uint64_t uploadCount;
+  std::uint64_t uploadedBytes;
+  std::uint64_t batchCount;
+  // Blit copies encoded, after merging.
+  std::uint64_t copyCount;
+  // Times upload() waited for a staging buffer.
+  std::uint64_t stallCount;
+};
+
+// Thread safe. Destinations are not retained: keep them alive until their
+// upload has completed.
+class UploadQueue {
+ public:
+  // Staging offsets are kept to multiples of this, which is what Metal on
+  // macOS asks of buffer copies. Destination offsets and sizes should be
+  // multiples of it too.
+  static constexpr std::size_t kCopyAlignment = 4;
+
+  UploadQueue(Device *pDevice, const UploadQueueDescriptor &descriptor =
+                                   UploadQueueDescriptor());
+  // Flushes and waits for every upload to complete.
+  ~UploadQueue();
+
+  UploadQueue(const UploadQueue &) = delete;
+  UploadQueue &operator=(const UploadQueue &) = delete;
+
+  // Queues a copy of size bytes from pData to pDestination at
+  // destinationOffset; pData can be reused as soon as this returns. Returns
+  // the event value that signals once the copy has completed.
+  std::uint64_t upload(Buffer *pDestination, std::size_t destinationOffset,
+                       const void *pData, std::size_t size);
+  // Commits the queued uploads, if any, and returns the value of the last
+  // batch committed.
+  std::uint64_t flush();
+
+  [[nodiscard]] bool isComplete(std::uint64_t value) const {
+    return _pEvent->signaledValue() >= value;
+  }
+  // Flushes if value isn't committed yet, then blocks until it completes.
+  void wait(std::uint64_t value);
+
+  // Signaled with the value of every batch as it completes.
+  [[nodiscard]] SharedEvent *event() const { return _pEvent.get(); }
+  [[nodiscard]] const UploadQueueDescriptor &descriptor() const {
+    return _descriptor;
+  }
+  [[nodiscard]] UploadQueueStatistics statistics();
+
+ private:
+  struct Region {
+    Buffer *pDestination;
+    std::size_t destinationOffset;
+    std::size_t stagingOffset;
+    std::size_t size;
+  };
+
+  struct StagingBuffer {
+    std::unique_ptr<Buffer> pBuffer;
+    // Value of the last batch that used the buffer.
+    std::uint64_t value = 0;
+  };
+
+  // Both with _mutex held.
+  void acquireStagingBuffer();
+  std::uint64_t submit();
+  // Notification that the batch with value has completed.
+  void completed(std::uint64_t value);
+
+  UploadQueueDescriptor _descriptor;
+  std::unique_ptr<SharedEvent> _pEvent;
+
+  // Serializes producers, encoding and commits.
+  std::mutex _mutex;
+  std::vector<StagingBuffer> _stagingBuffers;
+  std::size_t _current = 0;
+  // Whether _current's previous batch has been waited for.
+  bool _acquired = false;
+  std::size_t _head = 0;
+  std::vector<Region> _regions;
+  std::uint64_t _submittedValue = 0;
+  UploadQueueStatistics _statistics{};
+
+  // Taken by completion notifications, which must not wait for _mutex: a
+  // backend may run them inside commit().
+  std::mutex _completionMutex;
+  std::condition_variable _completed;
+  std::uint64_t _completedValue = 0;
+  std::size_t _pendingNotifications = 0;
+
+  // Destroyed first, so that a worker thread behind it is done with the
+  // staging buffers and the event.
+  std::unique_ptr<CommandQueue> _pCommandQueue;
+};
+
+}  // namespace Gfx
@@ -0,0 +1,139 @@
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <type_traits>
+#include <vector>
+
+namespace Gfx {
+
+// Chase-Lev work-stealing deque, with the memory orderings of Lê et al.,
+// "Correct and Efficient Work-Stealing for Weak Memory Models" (PPoPP 2013).
+//
+// One owner thread pushes and pops at the bottom (LIFO, so it keeps working
+// on what it touched last); any number of thieves steal from the top (FIFO,
+// so they take the oldest and usually largest pieces of work). The buffer
+// grows when full. Old buffers are kept until the deque is destroyed, since a
+// thief may still be reading one.
+template <typename T>
+class WorkStealingDeque {
+  static_assert(std::is_trivially_copyable_v<T>);
+
+ public:
+  explicit WorkStealingDeque(std::size_t capacity = 256)
+      : _pArray(new Array(capacity)) {
+    _arrays.emplace_back(_pArray.load(std::memory_order_relaxed));
+  }
+
+  WorkStealingDeque(const WorkStealingDeque &) = delete;
+  WorkStealingDeque &operator=(const WorkStealingDeque &) = delete;
+
+  // Owner only.
+  void push(T item) {
+    const std::int64_t bottom = _bottom.load(std::memory_order_relaxed);
+    const std::int64_t top = _top.load(std::memory_order_acquire);
+    Array *pArray = _pArray.load(std::memory_order_relaxed);
+    if (bottom - top > pArray->mask) {
+      pArray = grow(pArray, top, bottom);
+    }
+    pArray->put(bottom, item);
+    // A release store rather than the paper's fence plus relaxed store: the
+    // same instructions, but visible to ThreadSanitizer.
+    _bottom.store(bottom + 1, std::memory_order_release);
+  }
+
+  // Owner only. Returns false when the deque is empty.
+  bool pop(T &item) {
+    const std::int64_t bottom = _bottom.load(std::memory_order_relaxed) - 1;
+    Array *pArray = _pArray.load(std::memory_order_relaxed);
+    _bottom.store(bottom, std::memory_order_relaxed);
+    std::atomic_thread_fence(std::memory_order_seq_cst);
+    std::int64_t top = _top.load(std::memory_order_relaxed);
+    if (top > bottom) {
+      _bottom.store(bottom + 1, std::memory_order_relaxed);
+      return false;
+    }
+    item = pArray->get(bottom);
+    if (top == bottom) {
+      // Last item: race the thieves for it.
+      const bool won = _top.compare_exchange_strong(
+          top, top + 1, std::memory_order_seq_cst, std::memory_order_relaxed);
+      _bottom.store(bottom + 1, std::memory_order_relaxed);
+      return won;
+    }
+    return true;
+  }
+
+  // Any thread. Returns false when the deque is empty or another thread took
+  // the item first.
+  bool steal(T &item) {
+    std::int64_t top = _top.load(std::memory_order_acquire);
+    std::atomic_thread_fence(std::memory_order_seq_cst);
+    const std::int64_t bottom = _bottom.load(std::memory_order_acquire);
+    if (top >= bottom) {
+      return false;
+    }
+    const Array *pArray = _pArray.load(std::memory_order_acquire);
+    const T stolen = pArray->get(top);
+    if (!_top.compare_exchange_strong(top, top + 1,
+                                      std::memory_order_seq_cst,
+                                      std::memory_order_relaxed)) {
+      return false;
+    }
+    item = stolen;
+    return true;
+  }
+
+  // A snapshot; exact only on the owner thread with no thieves running.
+  [[nodiscard]] std::size_t size() const {
+    const std::int64_t bottom = _bottom.load(std::memory_order_relaxed);
+    const std::int64_t top = _top.load(std::memory_order_relaxed);
+    return bottom > top ? static_cast<std::size_t>(bottom - top) : 0;
+  }
+
+ private:
+  struct Array {
+    explicit Array(std::size_t capacity)
+        : mask(static_cast<std::int64_t>(roundUp(capacity)) - 1),
+          items(new std::atomic<T>[mask + 1]) {}
+
+    static std::size_t roundUp(std::size_t capacity) {
+      std::size_t rounded = 1;
+      while (rounded < capacity) {
+        rounded <<= 1;
+      }
+      return rounded;
+    }
+
+    [[nodiscard]] T get(std::int64_t index) const {
+      return items[index & mask].load(std::memory_order_relaxed);
+    }
+    void put(std::int64_t index, T item) {
+      items[index & mask].store(item, std::memory_order_relaxed);
+    }
+
+    std::int64_t mask;
+    std::unique_ptr<std::atomic<T>[]> items;
+  };
+
+  Array *grow(Array *pArray, std::int64_t top, std::int64_t bottom) {
+    auto *pGrown = new Array(static_cast<std::size_t>(pArray->mask + 1) * 2);
+    _arrays.emplace_back(pGrown);
+    for (std::int64_t i = top; i < bottom; ++i) {
+      pGrown->put(i, pArray->get(i));
+    }
+    _pArray.store(pGrown, std::memory_order_release);
+    return pGrown;
+  }
+
+  // Owner and thieves hammer different ends; keep them on separate lines.
+  alignas(64) std::atomic<std::int64_t> _top = 0;
+  alignas(64) std::atomic<std::int64_t> _bottom = 0;
+  alignas(64) std::atomic<Array *> _pArray;
+  // Every buffer ever used, owned here; only the owner appends.
+  std::vector<std::unique_ptr<Array>> _arrays;
+};
+
+}  // namespace Gfx
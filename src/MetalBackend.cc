@@ -0,0 +1,542 @@
+#include "MetalBackend.hpp"
+
+namespace Gfx {
+
+namespace {
+
+PixelFormat toPixelFormat(MTL::PixelFormat pixelFormat) {
+  switch (pixelFormat) {
+    case MTL::PixelFormatRGBA8Unorm:
+      return PixelFormat::RGBA8Unorm;
+    case MTL::PixelFormatRGBA8Unorm_sRGB:
+      return PixelFormat::RGBA8Unorm_sRGB;
+    case MTL::PixelFormatRGB10A2Unorm:
+      return PixelFormat::RGB10A2Unorm;
+    case MTL::PixelFormatRG11B10Float:
+      return PixelFormat::RG11B10Float;
+    case MTL::PixelFormatBGRA8Unorm:
+      return PixelFormat::BGRA8Unorm;
+    case MTL::PixelFormatBGRA8Unorm_sRGB:
+      return PixelFormat::BGRA8Unorm_sRGB;
+    case MTL::PixelFormatBGR10A2Unorm:
+      return PixelFormat::BGR10A2Unorm;
+    case MTL::PixelFormatRGBA16Float:
+      return PixelFormat::RGBA16Float;
+    case MTL::PixelFormatRGBA32Float:
+      return PixelFormat::RGBA32Float;
+    case MTL::PixelFormatDepth16Unorm:
+      return PixelFormat::Depth16Unorm;
+    case MTL::PixelFormatDepth32Float:
+      return PixelFormat::Depth32Float;
+    default:
+      return PixelFormat::Invalid;
+  }
+}
+
+MTL::PixelFormat toMTLPixelFormat(PixelFormat pixelFormat) {
+  switch (pixelFormat) {
+    case PixelFormat::RGBA8Unorm:
+      return MTL::PixelFormatRGBA8Unorm;
+    case PixelFormat::RGBA8Unorm_sRGB:
+      return MTL::PixelFormatRGBA8Unorm_sRGB;
+    case PixelFormat::RGB10A2Unorm:
+      return MTL::PixelFormatRGB10A2Unorm;
+    case PixelFormat::RG11B10Float:
+      return MTL::PixelFormatRG11B10Float;
+    case PixelFormat::BGRA8Unorm:
+      return MTL::PixelFormatBGRA8Unorm;
+    case PixelFormat::BGRA8Unorm_sRGB:
+      return MTL::PixelFormatBGRA8Unorm_sRGB;
+    case PixelFormat::BGR10A2Unorm:
+      return MTL::PixelFormatBGR10A2Unorm;
+    case PixelFormat::RGBA16Float:
+      return MTL::PixelFormatRGBA16Float;
+    case PixelFormat::RGBA32Float:
+      return MTL::PixelFormatRGBA32Float;
+    case PixelFormat::Depth16Unorm:
+      return MTL::PixelFormatDepth16Unorm;
+    case PixelFormat::Depth32Float:
+      return MTL::PixelFormatDepth32Float;
+    case PixelFormat::Invalid:
+      break;
+  }
+  return MTL::PixelFormatInvalid;
+}
+
+MTL::VertexFormat toMTLVertexFormat(VertexFormat vertexFormat) {
+  switch (vertexFormat) {
+    case VertexFormat::UChar4Normalized:
+      return MTL::VertexFormatUChar4Normalized;
+    case VertexFormat::Float:
+      return MTL::VertexFormatFloat;
+    case VertexFormat::Float2:
+      return MTL::VertexFormatFloat2;
+    case VertexFormat::Float3:
+      return MTL::VertexFormatFloat3;
+    case VertexFormat::Float4:
+      return MTL::VertexFormatFloat4;
+    case VertexFormat::Invalid:
+      break;
+  }
+  return MTL::VertexFormatInvalid;
+}
+
+NS::SharedPtr<MTL::Function> newFunction(MTL::Library *pLibrary,
+                                         const std::string &name) {
+  if (pLibrary == nullptr || name.empty()) {
+    return {};
+  }
+  return NS::TransferPtr(pLibrary->newFunction(
+      NS::String::string(name.c_str(), NS::UTF8StringEncoding)));
+}
+
+MTL::LoadAction toMTLLoadAction(LoadAction loadAction) {
+  switch (loadAction) {
+    case LoadAction::DontCare:
+      return MTL::LoadActionDontCare;
+    case LoadAction::Load:
+      return MTL::LoadActionLoad;
+    case LoadAction::Clear:
+      return MTL::LoadActionClear;
+  }
+  return MTL::LoadActionDontCare;
+}
+
+MTL::StoreAction toMTLStoreAction(StoreAction storeAction) {
+  return storeAction == StoreAction::Store ? MTL::StoreActionStore
+                                           : MTL::StoreActionDontCare;
+}
+
+MTL::PrimitiveType toMTLPrimitiveType(PrimitiveType primitiveType) {
+  switch (primitiveType) {
+    case PrimitiveType::Point:
+      return MTL::PrimitiveTypePoint;
+    case PrimitiveType::Line:
+      return MTL::PrimitiveTypeLine;
+    case PrimitiveType::LineStrip:
+      return MTL::PrimitiveTypeLineStrip;
+    case PrimitiveType::Triangle:
+      return MTL::PrimitiveTypeTriangle;
+    case PrimitiveType::TriangleStrip:
+      return MTL::PrimitiveTypeTriangleStrip;
+  }
+  return MTL::PrimitiveTypeTriangle;
+}
+
+}  // namespace
+
+void MetalSharedEvent::notify(std::uint64_t value,
+                              NotificationFunction function) {
+  _pEvent->notifyListener(
+      _pListener.get(), value,
+      ^(MTL::SharedEvent *, std::uint64_t signaledValue) {
+        function(signaledValue);
+      });
+}
+
+void MetalIndirectCommandBuffer::setVertexBuffer(std::size_t command,
+                                                 Buffer *pBuffer,
+                                                 std::size_t offset,
+                                                 std::size_t index) {
+  _pCommands->indirectRenderCommand(command)->setVertexBuffer(
+      pBuffer != nullptr ? static_cast<MetalBuffer *>(pBuffer)->buffer()
+                         : nullptr,
+      offset, index);
+}
+
+void MetalIndirectCommandBuffer::drawPrimitives(
+    std::size_t command, PrimitiveType primitiveType, std::size_t vertexStart,
+    std::size_t vertexCount, std::size_t instanceCount,
+    std::size_t baseInstance) {
+  _pCommands->indirectRenderCommand(command)->drawPrimitives(
+      toMTLPrimitiveType(primitiveType), vertexStart, vertexCount,
+      instanceCount, baseInstance);
+}
+
+void MetalIndirectCommandBuffer::reset(
+    const IndirectCommandBufferExecutionRange &range) {
+  _pCommands->reset(NS::Range::Make(range.location, range.length));
+}
+
+std::uint32_t MetalTexture::width() const {
+  return static_cast<std::uint32_t>(_pTexture->width());
+}
+
+std::uint32_t MetalTexture::height() const {
+  return static_cast<std::uint32_t>(_pTexture->height());
+}
+
+PixelFormat MetalTexture::pixelFormat() const {
+  return toPixelFormat(_pTexture->pixelFormat());
+}
+
+MetalDrawable::MetalDrawable(CA::MetalDrawable *pDrawable)
+    : _pDrawable(pDrawable), _texture(pDrawable->texture()) {}
+
+void MetalRenderCommandEncoder::setRenderPipelineState(
+    RenderPipelineState *pState) {
+  _pEncoder->setRenderPipelineState(
+      static_cast<MetalRenderPipelineState *>(pState)->renderPipelineState());
+}
+
+void MetalRenderCommandEncoder::setVertexBuffer(Buffer *pBuffer,
+                                                std::size_t offset,
+                                                std::size_t index) {
+  _pEncoder->setVertexBuffer(
+      pBuffer != nullptr ? static_cast<MetalBuffer *>(pBuffer)->buffer()
+                         : nullptr,
+      offset, index);
+}
+
+void MetalRenderCommandEncoder::setVertexBufferOffset(std::size_t offset,
+                                                      std::size_t index) {
+  _pEncoder->setVertexBufferOffset(offset, index);
+}
+
+void MetalRenderCommandEncoder::setFragmentTexture(Texture *pTexture,
+                                                   std::size_t index) {
+  _pEncoder->setFragmentTexture(
+      pTexture != nullptr ? static_cast<MetalTexture *>(pTexture)->texture()
+                          : nullptr,
+      index);
+}
+
+void MetalRenderCommandEncoder::setViewport(const Viewport &viewport) {
+  MTL::Viewport mtlViewport;
+  std::memcpy(&mtlViewport, &viewport, sizeof(mtlViewport));
+  _pEncoder->setViewport(mtlViewport);
+}
+
+void MetalRenderCommandEncoder::setScissorRect(const ScissorRect &rect) {
+  MTL::ScissorRect mtlRect;
+  std::memcpy(&mtlRect, &rect, sizeof(mtlRect));
+  _pEncoder->setScissorRect(mtlRect);
+}
+
+void MetalRenderCommandEncoder::setCullMode(CullMode cullMode) {
+  _pEncoder->setCullMode(static_cast<MTL::CullMode>(cullMode));
+}
+
+void MetalRenderCommandEncoder::setFrontFacingWinding(Winding winding) {
+  _pEncoder->setFrontFacingWinding(static_cast<MTL::Winding>(winding));
+}
+
+void MetalRenderCommandEncoder::drawPrimitives(PrimitiveType primitiveType,
+                                               std::size_t vertexStart,
+                                               std::size_t vertexCount) {
+  _pEncoder->drawPrimitives(toMTLPrimitiveType(primitiveType), vertexStart,
+                            vertexCount);
+}
+
+void MetalRenderCommandEncoder::useResource(Buffer *pBuffer) {
+  _pEncoder->useResource(static_cast<MetalBuffer *>(pBuffer)->buffer(),
+                         MTL::ResourceUsageRead, MTL::RenderStageVertex);
+}
+
+void MetalRenderCommandEncoder::executeCommandsInBuffer(
+    IndirectCommandBuffer *pCommands,
+    const IndirectCommandBufferExecutionRange &range) {
+  _pEncoder->executeCommandsInBuffer(
+      static_cast<MetalIndirectCommandBuffer *>(pCommands)
+          ->indirectCommandBuffer(),
+      NS::Range::Make(range.location, range.length));
+}
+
+void MetalRenderCommandEncoder::endEncoding() {
+  _pEncoder->endEncoding();
+  _pEncoder = nullptr;
+}
+
+RenderCommandEncoder *
+MetalParallelRenderCommandEncoder::renderCommandEncoder() {
+  if (_encoderCount == _encoders.size()) {
+    _encoders.push_back(std::make_unique<MetalRenderCommandEncoder>());
+  }
+  MetalRenderCommandEncoder *pEncoder = _encoders[_encoderCount++].get();
+  pEncoder->_pEncoder = _pEncoder->renderCommandEncoder();
+  return pEncoder;
+}
+
+void MetalParallelRenderCommandEncoder::endEncoding() {
+  _pEncoder->endEncoding();
+  _pEncoder = nullptr;
+  _encoderCount = 0;
+}
+
+void MetalBlitCommandEncoder::copyFromTexture(
+    Texture *pTexture, Buffer *pBuffer, std::size_t destinationOffset,
+    std::size_t destinationBytesPerRow) {
+  MTL::Texture *pSource = static_cast<MetalTexture *>(pTexture)->texture();
+  _pEncoder->copyFromTexture(
+      pSource, 0, 0, MTL::Origin::Make(0, 0, 0),
+      MTL::Size::Make(pSource->width(), pSource->height(), 1),
+      static_cast<MetalBuffer *>(pBuffer)->buffer(), destinationOffset,
+      destinationBytesPerRow, destinationBytesPerRow * pSource->height());
+}
+
+void MetalBlitCommandEncoder::copyFromBuffer(Buffer *pSource,
+                                             std::size_t sourceOffset,
+                                             Buffer *pDestination,
+                                             std::size_t destinationOffset,
+                                             std::size_t size) {
+  _pEncoder->copyFromBuffer(static_cast<MetalBuffer *>(pSource)->buffer(),
+                            sourceOffset,
+                            static_cast<MetalBuffer *>(pDestination)->buffer(),
+                            destinationOffset, size);
+}
+
+void MetalBlitCommandEncoder::endEncoding() {
+  _pEncoder->endEncoding();
+  _pEncoder = nullptr;
+}
+
+MetalCommandBuffer::MetalCommandBuffer()
+    : _pRenderPassDescriptor(
+          NS::TransferPtr(MTL::RenderPassDescriptor::alloc()->init())) {}
+
+void MetalCommandBuffer::addCompletedHandler(const HandlerFunction &function) {
+  _pCommandBuffer->addCompletedHandler(
+      [function](MTL::CommandBuffer *) { function(); });
+}
+
+MTL::RenderPassDescriptor *MetalCommandBuffer::renderPassDescriptor(
+    const RenderPassDescriptor &descriptor) {
+  const RenderPassColorAttachmentDescriptor &color = descriptor.colorAttachment;
+
+  MTL::RenderPassDescriptor *pRpd = _pRenderPassDescriptor.get();
+  MTL::RenderPassColorAttachmentDescriptor *pColor =
+      pRpd->colorAttachments()->object(0);
+  pColor->setTexture(static_cast<MetalTexture *>(color.pTexture)->texture());
+  pColor->setLoadAction(toMTLLoadAction(color.loadAction));
+  pColor->setStoreAction(toMTLStoreAction(color.storeAction));
+  pColor->setClearColor(MTL::ClearColor::Make(
+      color.clearColor.red, color.clearColor.green, color.clearColor.blue,
+      color.clearColor.alpha));
+  return pRpd;
+}
+
+RenderCommandEncoder *MetalCommandBuffer::renderCommandEncoder(
+    const RenderPassDescriptor &descriptor) {
+  MTL::RenderPassDescriptor *pRpd = renderPassDescriptor(descriptor);
+  _encoder._pEncoder = _pCommandBuffer->renderCommandEncoder(pRpd);
+  // Don't keep the drawable's texture alive until the next frame.
+  pRpd->colorAttachments()->object(0)->setTexture(nullptr);
+  return &_encoder;
+}
+
+ParallelRenderCommandEncoder *MetalCommandBuffer::parallelRenderCommandEncoder(
+    const RenderPassDescriptor &descriptor) {
+  MTL::RenderPassDescriptor *pRpd = renderPassDescriptor(descriptor);
+  _parallelEncoder._pEncoder =
+      _pCommandBuffer->parallelRenderCommandEncoder(pRpd);
+  pRpd->colorAttachments()->object(0)->setTexture(nullptr);
+  return &_parallelEncoder;
+}
+
+BlitCommandEncoder *MetalCommandBuffer::blitCommandEncoder() {
+  _blitEncoder._pEncoder = _pCommandBuffer->blitCommandEncoder();
+  return &_blitEncoder;
+}
+
+void MetalCommandBuffer::encodeWait(SharedEvent *pEvent,
+                                    std::uint64_t value) {
+  _pCommandBuffer->encodeWait(static_cast<MetalSharedEvent *>(pEvent)->event(),
+                              value);
+}
+
+void MetalCommandBuffer::encodeSignalEvent(SharedEvent *pEvent,
+                                           std::uint64_t value) {
+  _pCommandBuffer->encodeSignalEvent(
+      static_cast<MetalSharedEvent *>(pEvent)->event(), value);
+}
+
+void MetalCommandBuffer::presentDrawable(Drawable *pDrawable) {
+  _pCommandBuffer->presentDrawable(
+      static_cast<MetalDrawable *>(pDrawable)->drawable());
+}
+
+void MetalCommandBuffer::commit() { _pCommandBuffer->commit(); }
+
+void MetalCommandBuffer::waitUntilCompleted() {
+  _pCommandBuffer->waitUntilCompleted();
+}
+
+std::unique_ptr<Buffer> MetalHeap::newBuffer(std::size_t length,
+                                             std::size_t offset) {
+  return std::make_unique<MetalBuffer>(NS::TransferPtr(
+      _pHeap->newBuffer(length, MTL::ResourceStorageModeShared, offset)));
+}
+
+MetalCommandQueue::MetalCommandQueue(
+    NS::SharedPtr<MTL::CommandQueue> pCommandQueue)
+    : _pCommandQueue(std::move(pCommandQueue)),
+      _pCommandBufferDescriptor(
+          NS::TransferPtr(MTL::CommandBufferDescriptor::alloc()->init())) {}
+
+CommandBuffer *MetalCommandQueue::commandBuffer(
+    const CommandBufferDescriptor &descriptor) {
+  if (descriptor.retainedReferences != _retainedReferences) {
+    _retainedReferences = descriptor.retainedReferences;
+    _pCommandBufferDescriptor->setRetainedReferences(_retainedReferences);
+  }
+  _commandBuffer._pCommandBuffer =
+      _pCommandQueue->commandBuffer(_pCommandBufferDescriptor.get());
+  return &_commandBuffer;
+}
+
+std::unique_ptr<CommandQueue> MetalDevice::newCommandQueue() {
+  return std::make_unique<MetalCommandQueue>(
+      NS::TransferPtr(_pDevice->newCommandQueue()));
+}
+
+std::unique_ptr<Buffer> MetalDevice::newBuffer(std::size_t length) {
+  return std::make_unique<MetalBuffer>(NS::TransferPtr(
+      _pDevice->newBuffer(length, MTL::ResourceStorageModeShared)));
+}
+
+SizeAndAlign MetalDevice::heapBufferSizeAndAlign(std::size_t length) {
+  const MTL::SizeAndAlign sizeAndAlign = _pDevice->heapBufferSizeAndAlign(
+      length, MTL::ResourceStorageModeShared);
+  return {sizeAndAlign.size, sizeAndAlign.align};
+}
+
+std::unique_ptr<Heap> MetalDevice::newHeap(std::size_t size) {
+  NS::SharedPtr<MTL::HeapDescriptor> pDescriptor =
+      NS::TransferPtr(MTL::HeapDescriptor::alloc()->init());
+  pDescriptor->setType(MTL::HeapTypePlacement);
+  pDescriptor->setStorageMode(MTL::StorageModeShared);
+  pDescriptor->setSize(size);
+  return std::make_unique<MetalHeap>(
+      NS::TransferPtr(_pDevice->newHeap(pDescriptor.get())));
+}
+
+std::unique_ptr<SharedEvent> MetalDevice::newSharedEvent() {
+  return std::make_unique<MetalSharedEvent>(
+      NS::TransferPtr(_pDevice->newSharedEvent()));
+}
+
+std::unique_ptr<IndirectCommandBuffer> MetalDevice::newIndirectCommandBuffer(
+    const IndirectCommandBufferDescriptor &descriptor,
+    std::size_t maxCommandCount) {
+  NS::SharedPtr<MTL::IndirectCommandBufferDescriptor> pDescriptor =
+      NS::TransferPtr(MTL::IndirectCommandBufferDescriptor::alloc()->init());
+  pDescriptor->setCommandTypes(MTL::IndirectCommandTypeDraw);
+  pDescriptor->setInheritPipelineState(true);
+  pDescriptor->setInheritBuffers(false);
+  pDescriptor->setMaxVertexBufferBindCount(
+      descriptor.maxVertexBufferBindCount);
+  return std::make_unique<MetalIndirectCommandBuffer>(
+      NS::TransferPtr(_pDevice->newIndirectCommandBuffer(
+          pDescriptor.get(), maxCommandCount,
+          MTL::ResourceStorageModeShared)));
+}
+
+std::unique_ptr<RenderPipelineState> MetalDevice::newRenderPipelineState(
+    const RenderPipelineDescriptor &descriptor) {
+  // Compiles usually run on job threads, which have no pool of their own.
+  NS::ScopedAutoreleasePool pool;
+  NS::SharedPtr<MTL::Function> pVertexFunction =
+      newFunction(_pLibrary.get(), descriptor.vertexFunction);
+  NS::SharedPtr<MTL::Function> pFragmentFunction =
+      newFunction(_pLibrary.get(), descriptor.fragmentFunction);
+  if (!pVertexFunction) {
+    return nullptr;
+  }
+
+  NS::SharedPtr<MTL::RenderPipelineDescriptor> pDescriptor =
+      NS::TransferPtr(MTL::RenderPipelineDescriptor::alloc()->init());
+  pDescriptor->setVertexFunction(pVertexFunction.get());
+  pDescriptor->setFragmentFunction(pFragmentFunction.get());
+  const VertexDescriptor &vertexDescriptor = descriptor.vertexDescriptor;
+  if (!vertexDescriptor.attributes.empty()) {
+    NS::SharedPtr<MTL::VertexDescriptor> pVertexDescriptor =
+        NS::TransferPtr(MTL::VertexDescriptor::alloc()->init());
+    for (std::size_t i = 0; i < vertexDescriptor.attributes.size(); ++i) {
+      const VertexAttributeDescriptor &attribute =
+          vertexDescriptor.attributes[i];
+      MTL::VertexAttributeDescriptor *pAttribute =
+          pVertexDescriptor->attributes()->object(i);
+      pAttribute->setFormat(toMTLVertexFormat(attribute.format));
+      pAttribute->setOffset(attribute.offset);
+      pAttribute->setBufferIndex(attribute.bufferIndex);
+    }
+    for (std::size_t i = 0; i < vertexDescriptor.layouts.size(); ++i) {
+      const VertexBufferLayoutDescriptor &layout = vertexDescriptor.layouts[i];
+      MTL::VertexBufferLayoutDescriptor *pLayout =
+          pVertexDescriptor->layouts()->object(i);
+      pLayout->setStride(layout.stride);
+      pLayout->setStepFunction(
+          static_cast<MTL::VertexStepFunction>(layout.stepFunction));
+      pLayout->setStepRate(layout.stepRate);
+    }
+    pDescriptor->setVertexDescriptor(pVertexDescriptor.get());
+  }
+  const RenderPipelineColorAttachmentDescriptor &color =
+      descriptor.colorAttachment;
+  MTL::RenderPipelineColorAttachmentDescriptor *pColor =
+      pDescriptor->colorAttachments()->object(0);
+  pColor->setPixelFormat(toMTLPixelFormat(color.pixelFormat));
+  pColor->setBlendingEnabled(color.blendingEnabled);
+  pColor->setSourceRGBBlendFactor(
+      static_cast<MTL::BlendFactor>(color.sourceRGBBlendFactor));
+  pColor->setDestinationRGBBlendFactor(
+      static_cast<MTL::BlendFactor>(color.destinationRGBBlendFactor));
+  pColor->setRgbBlendOperation(
+      static_cast<MTL::BlendOperation>(color.rgbBlendOperation));
+  pColor->setSourceAlphaBlendFactor(
+      static_cast<MTL::BlendFactor>(color.sourceAlphaBlendFactor));
+  pColor->setDestinationAlphaBlendFactor(
+      static_cast<MTL::BlendFactor>(color.destinationAlphaBlendFactor));
+  pColor->setAlphaBlendOperation(
+      static_cast<MTL::BlendOperation>(color.alphaBlendOperation));
+  pColor->setWriteMask(static_cast<MTL::ColorWriteMask>(color.writeMask));
+  pDescriptor->setDepthAttachmentPixelFormat(
+      toMTLPixelFormat(descriptor.depthAttachmentPixelFormat));
+  pDescriptor->setRasterSampleCount(descriptor.sampleCount);
+
+  NS::Error *pError = nullptr;
+  MTL::RenderPipelineState *pState =
+      _pDevice->newRenderPipelineState(pDescriptor.get(), &pError);
+  if (pState == nullptr) {
+    return nullptr;
+  }
+  return std::make_unique<MetalRenderPipelineState>(NS::TransferPtr(pState));
+}
+
+std::unique_ptr<Texture> MetalDevice::newTexture(std::uint32_t width,
+                                                 std::uint32_t height,
+                                                 PixelFormat pixelFormat) {
+  NS::SharedPtr<MTL::TextureDescriptor> pDescriptor =
+      NS::TransferPtr(MTL::TextureDescriptor::alloc()->init());
+  pDescriptor->setTextureType(MTL::TextureType2D);
+  pDescriptor->setPixelFormat(toMTLPixelFormat(pixelFormat));
+  pDescriptor->setWidth(width);
+  pDescriptor->setHeight(height);
+  pDescriptor->setStorageMode(MTL::StorageModePrivate);
+  pDescriptor->setUsage(MTL::TextureUsageRenderTarget |
+                        MTL::TextureUsageShaderRead);
+  return std::make_unique<MetalTexture>(
+      NS::TransferPtr(_pDevice->newTexture(pDescriptor.get())));
+}
+
+RenderPassDescriptor MetalView::currentRenderPassDescriptor() {
+  const MTL::ClearColor clearColor = _pView->clearColor();
+
+  RenderPassDescriptor descriptor;
+  descriptor.colorAttachment.pTexture = currentDrawable()->texture();
+  descriptor.colorAttachment.loadAction = LoadAction::Clear;
+  descriptor.colorAttachment.storeAction = StoreAction::Store;
+  descriptor.colorAttachment.clearColor =
+      ClearColor::Make(clearColor.red, clearColor.green, clearColor.blue,
+                       clearColor.alpha);
+  return descriptor;
+}
+
+Drawable *MetalView::currentDrawable() {
+  if (!_drawable) {
+    _drawable.emplace(_pView->currentDrawable());
+  }
+  return &*_drawable;
+}
+
+}  // namespace Gfx
@@ -0,0 +1,400 @@
+#pragma once
+
+#include <Gfx/Backend.hpp>
+#include <Gfx/DrawCuller.hpp>
+#include <Gfx/InstanceDescriptors.hpp>
+#include <Gfx/Math.hpp>
+
+#include <Metal/Metal.hpp>
+#include <MetalKit/MetalKit.hpp>
+
+#include <cstddef>
+#include <cstring>
+#include <memory>
+#include <optional>
+#include <utility>
+#include <vector>
+
+// Metal implementation of the Gfx backend interface. Every wrapper forwards
+// straight to the underlying metal-cpp object.
+namespace Gfx {
+
+// The Gfx packed types are bit-for-bit the MTL ones, so conversions are
+// copies and arrays can be reinterpreted in place.
+static_assert(sizeof(PackedFloat3) == sizeof(MTL::PackedFloat3) &&
+              alignof(PackedFloat3) == alignof(MTL::PackedFloat3));
+static_assert(sizeof(PackedFloat4x3) == sizeof(MTL::PackedFloat4x3) &&
+              alignof(PackedFloat4x3) == alignof(MTL::PackedFloat4x3));
+static_assert(sizeof(AxisAlignedBoundingBox) ==
+                  sizeof(MTL::AxisAlignedBoundingBox) &&
+              alignof(AxisAlignedBoundingBox) ==
+                  alignof(MTL::AxisAlignedBoundingBox));
+
+// InstanceDescriptorWriter fills instance buffers in the MTL descriptor
+// layouts; the Gfx mirrors have to agree on every offset.
+static_assert(sizeof(AccelerationStructureInstanceDescriptor) ==
+              sizeof(MTL::AccelerationStructureInstanceDescriptor));
+static_assert(offsetof(AccelerationStructureInstanceDescriptor, options) ==
+              offsetof(MTL::AccelerationStructureInstanceDescriptor, options));
+static_assert(
+    offsetof(AccelerationStructureInstanceDescriptor,
+             accelerationStructureIndex) ==
+    offsetof(MTL::AccelerationStructureInstanceDescriptor,
+             accelerationStructureIndex));
+static_assert(sizeof(AccelerationStructureUserIDInstanceDescriptor) ==
+              sizeof(MTL::AccelerationStructureUserIDInstanceDescriptor));
+static_assert(
+    offsetof(AccelerationStructureUserIDInstanceDescriptor, userID) ==
+    offsetof(MTL::AccelerationStructureUserIDInstanceDescriptor, userID));
+static_assert(sizeof(AccelerationStructureMotionInstanceDescriptor) ==
+              sizeof(MTL::AccelerationStructureMotionInstanceDescriptor));
+static_assert(
+    offsetof(AccelerationStructureMotionInstanceDescriptor,
+             motionStartBorderMode) ==
+    offsetof(MTL::AccelerationStructureMotionInstanceDescriptor,
+             motionStartBorderMode));
+static_assert(
+    offsetof(AccelerationStructureMotionInstanceDescriptor, motionEndTime) ==
+    offsetof(MTL::AccelerationStructureMotionInstanceDescriptor,
+             motionEndTime));
+// DrawCuller writes indirect arguments the GPU reads as the MTL structs.
+static_assert(sizeof(DrawPrimitivesIndirectArguments) ==
+              sizeof(MTL::DrawPrimitivesIndirectArguments));
+static_assert(
+    offsetof(DrawPrimitivesIndirectArguments, baseInstance) ==
+    offsetof(MTL::DrawPrimitivesIndirectArguments, baseInstance));
+static_assert(sizeof(DrawIndexedPrimitivesIndirectArguments) ==
+              sizeof(MTL::DrawIndexedPrimitivesIndirectArguments));
+static_assert(
+    offsetof(DrawIndexedPrimitivesIndirectArguments, baseVertex) ==
+    offsetof(MTL::DrawIndexedPrimitivesIndirectArguments, baseVertex));
+static_assert(
+    offsetof(DrawIndexedPrimitivesIndirectArguments, baseInstance) ==
+    offsetof(MTL::DrawIndexedPrimitivesIndirectArguments, baseInstance));
+static_assert(sizeof(IndirectCommandBufferExecutionRange) ==
+              sizeof(MTL::IndirectCommandBufferExecutionRange));
+static_assert(sizeof(Viewport) == sizeof(MTL::Viewport));
+static_assert(sizeof(ScissorRect) == sizeof(MTL::ScissorRect));
+static_assert(static_cast<NS::UInteger>(CullMode::Back) ==
+              MTL::CullModeBack);
+static_assert(static_cast<NS::UInteger>(Winding::CounterClockwise) ==
+              MTL::WindingCounterClockwise);
+static_assert(static_cast<NS::UInteger>(VertexStepFunction::PerInstance) ==
+              MTL::VertexStepFunctionPerInstance);
+static_assert(
+    static_cast<NS::UInteger>(BlendFactor::OneMinusDestinationAlpha) ==
+    MTL::BlendFactorOneMinusDestinationAlpha);
+static_assert(static_cast<NS::UInteger>(BlendOperation::Max) ==
+              MTL::BlendOperationMax);
+static_assert(ColorWriteMaskRed == MTL::ColorWriteMaskRed &&
+              ColorWriteMaskAll == MTL::ColorWriteMaskAll);
+static_assert(static_cast<std::uint32_t>(InstanceOptions::Opaque) ==
+              MTL::AccelerationStructureInstanceOptionOpaque);
+static_assert(static_cast<std::uint32_t>(MotionBorderMode::Vanish) ==
+              MTL::MotionBorderModeVanish);
+
+inline MTL::PackedFloat3 toMTLPackedFloat3(const PackedFloat3 &value) {
+  MTL::PackedFloat3 result;
+  std::memcpy(&result, &value, sizeof(result));
+  return result;
+}
+
+inline PackedFloat3 fromMTLPackedFloat3(const MTL::PackedFloat3 &value) {
+  PackedFloat3 result;
+  std::memcpy(&result, &value, sizeof(result));
+  return result;
+}
+
+inline MTL::PackedFloat4x3 toMTLPackedFloat4x3(const PackedFloat4x3 &value) {
+  MTL::PackedFloat4x3 result;
+  std::memcpy(&result, &value, sizeof(result));
+  return result;
+}
+
+inline PackedFloat4x3 fromMTLPackedFloat4x3(
+    const MTL::PackedFloat4x3 &value) {
+  PackedFloat4x3 result;
+  std::memcpy(&result, &value, sizeof(result));
+  return result;
+}
+
+inline MTL::AxisAlignedBoundingBox toMTLAxisAlignedBoundingBox(
+    const AxisAlignedBoundingBox &value) {
+  MTL::AxisAlignedBoundingBox result;
+  std::memcpy(&result, &value, sizeof(result));
+  return result;
+}
+
+inline AxisAlignedBoundingBox fromMTLAxisAlignedBoundingBox(
+    const MTL::AxisAlignedBoundingBox &value) {
+  AxisAlignedBoundingBox result;
+  std::memcpy(&result, &value, sizeof(result));
+  return result;
+}
+
+class MetalBuffer final : public Buffer {
+ public:
+  explicit MetalBuffer(NS::SharedPtr<MTL::Buffer> pBuffer)
+      : _pBuffer(std::move(pBuffer)) {}
+
+  void *contents() override { return _pBuffer->contents(); }
+  [[nodiscard]] std::size_t length() const override {
+    return _pBuffer->length();
+  }
+  [[nodiscard]] MTL::Buffer *buffer() const { return _pBuffer.get(); }
+
+ private:
+  NS::SharedPtr<MTL::Buffer> _pBuffer;
+};
+
+class MetalHeap final : public Heap {
+ public:
+  explicit MetalHeap(NS::SharedPtr<MTL::Heap> pHeap)
+      : _pHeap(std::move(pHeap)) {}
+
+  [[nodiscard]] std::size_t size() const override { return _pHeap->size(); }
+  std::unique_ptr<Buffer> newBuffer(std::size_t length,
+                                    std::size_t offset) override;
+
+ private:
+  NS::SharedPtr<MTL::Heap> _pHeap;
+};
+
+// Notifications are delivered through one listener per event, on the
+// listener's dispatch queue.
+class MetalSharedEvent final : public SharedEvent {
+ public:
+  explicit MetalSharedEvent(NS::SharedPtr<MTL::SharedEvent> pEvent)
+      : _pEvent(std::move(pEvent)),
+        _pListener(NS::TransferPtr(MTL::SharedEventListener::alloc()->init())) {
+  }
+
+  [[nodiscard]] std::uint64_t signaledValue() const override {
+    return _pEvent->signaledValue();
+  }
+  void notify(std::uint64_t value, NotificationFunction function) override;
+  [[nodiscard]] MTL::SharedEvent *event() const { return _pEvent.get(); }
+
+ private:
+  NS::SharedPtr<MTL::SharedEvent> _pEvent;
+  NS::SharedPtr<MTL::SharedEventListener> _pListener;
+};
+
+// Commands inherit the pipeline state and bind their own vertex buffers.
+class MetalIndirectCommandBuffer final : public IndirectCommandBuffer {
+ public:
+  explicit MetalIndirectCommandBuffer(
+      NS::SharedPtr<MTL::IndirectCommandBuffer> pCommands)
+      : _pCommands(std::move(pCommands)) {}
+
+  [[nodiscard]] std::size_t size() const override {
+    return _pCommands->size();
+  }
+  void setVertexBuffer(std::size_t command, Buffer *pBuffer,
+                       std::size_t offset, std::size_t index) override;
+  void drawPrimitives(std::size_t command, PrimitiveType primitiveType,
+                      std::size_t vertexStart, std::size_t vertexCount,
+                      std::size_t instanceCount,
+                      std::size_t baseInstance) override;
+  void reset(const IndirectCommandBufferExecutionRange &range) override;
+  [[nodiscard]] MTL::IndirectCommandBuffer *indirectCommandBuffer() const {
+    return _pCommands.get();
+  }
+
+ private:
+  NS::SharedPtr<MTL::IndirectCommandBuffer> _pCommands;
+};
+
+class MetalRenderPipelineState final : public RenderPipelineState {
+ public:
+  explicit MetalRenderPipelineState(
+      NS::SharedPtr<MTL::RenderPipelineState> pState)
+      : _pState(std::move(pState)) {}
+
+  [[nodiscard]] MTL::RenderPipelineState *renderPipelineState() const {
+    return _pState.get();
+  }
+
+ private:
+  NS::SharedPtr<MTL::RenderPipelineState> _pState;
+};
+
+class MetalTexture final : public Texture {
+ public:
+  explicit MetalTexture(MTL::Texture *pTexture = nullptr)
+      : _pTexture(pTexture) {}
+  // Owns the texture, for textures the device created.
+  explicit MetalTexture(NS::SharedPtr<MTL::Texture> pTexture)
+      : _pTexture(pTexture.get()), _pOwnedTexture(std::move(pTexture)) {}
+
+  void setTexture(MTL::Texture *pTexture) { _pTexture = pTexture; }
+  [[nodiscard]] MTL::Texture *texture() const { return _pTexture; }
+
+  [[nodiscard]] std::uint32_t width() const override;
+  [[nodiscard]] std::uint32_t height() const override;
+  [[nodiscard]] PixelFormat pixelFormat() const override;
+
+ private:
+  MTL::Texture *_pTexture;
+  NS::SharedPtr<MTL::Texture> _pOwnedTexture;
+};
+
+class MetalDrawable final : public Drawable {
+ public:
+  explicit MetalDrawable(CA::MetalDrawable *pDrawable);
+
+  Texture *texture() override { return &_texture; }
+  [[nodiscard]] CA::MetalDrawable *drawable() const { return _pDrawable; }
+
+ private:
+  CA::MetalDrawable *_pDrawable;
+  MetalTexture _texture;
+};
+
+class MetalRenderCommandEncoder final : public RenderCommandEncoder {
+ public:
+  void setRenderPipelineState(RenderPipelineState *pState) override;
+  void setVertexBuffer(Buffer *pBuffer, std::size_t offset,
+                       std::size_t index) override;
+  void setVertexBufferOffset(std::size_t offset, std::size_t index) override;
+  void setFragmentTexture(Texture *pTexture, std::size_t index) override;
+  void setViewport(const Viewport &viewport) override;
+  void setScissorRect(const ScissorRect &rect) override;
+  void setCullMode(CullMode cullMode) override;
+  void setFrontFacingWinding(Winding winding) override;
+  void drawPrimitives(PrimitiveType primitiveType, std::size_t vertexStart,
+                      std::size_t vertexCount) override;
+  void useResource(Buffer *pBuffer) override;
+  void executeCommandsInBuffer(
+      IndirectCommandBuffer *pCommands,
+      const IndirectCommandBufferExecutionRange &range) override;
+  void endEncoding() override;
+
+ private:
+  friend class MetalCommandBuffer;
+  friend class MetalParallelRenderCommandEncoder;
+
+  MTL::RenderCommandEncoder *_pEncoder = nullptr;
+};
+
+class MetalParallelRenderCommandEncoder final
+    : public ParallelRenderCommandEncoder {
+ public:
+  RenderCommandEncoder *renderCommandEncoder() override;
+  void endEncoding() override;
+
+ private:
+  friend class MetalCommandBuffer;
+
+  MTL::ParallelRenderCommandEncoder *_pEncoder = nullptr;
+  // Wrappers are reused across passes; only the first encoderCount are live.
+  std::vector<std::unique_ptr<MetalRenderCommandEncoder>> _encoders;
+  std::size_t _encoderCount = 0;
+};
+
+class MetalBlitCommandEncoder final : public BlitCommandEncoder {
+ public:
+  void copyFromTexture(Texture *pTexture, Buffer *pBuffer,
+                       std::size_t destinationOffset,
+                       std::size_t destinationBytesPerRow) override;
+  void copyFromBuffer(Buffer *pSource, std::size_t sourceOffset,
+                      Buffer *pDestination, std::size_t destinationOffset,
+                      std::size_t size) override;
+  void endEncoding() override;
+
+ private:
+  friend class MetalCommandBuffer;
+
+  MTL::BlitCommandEncoder *_pEncoder = nullptr;
+};
+
+class MetalCommandBuffer final : public CommandBuffer {
+ public:
+  MetalCommandBuffer();
+
+  void addCompletedHandler(const HandlerFunction &function) override;
+  RenderCommandEncoder *renderCommandEncoder(
+      const RenderPassDescriptor &descriptor) override;
+  ParallelRenderCommandEncoder *parallelRenderCommandEncoder(
+      const RenderPassDescriptor &descriptor) override;
+  BlitCommandEncoder *blitCommandEncoder() override;
+  void encodeWait(SharedEvent *pEvent, std::uint64_t value) override;
+  void encodeSignalEvent(SharedEvent *pEvent, std::uint64_t value) override;
+  void presentDrawable(Drawable *pDrawable) override;
+  void commit() override;
+  void waitUntilCompleted() override;
+
+ private:
+  friend class MetalCommandQueue;
+
+  MTL::RenderPassDescriptor *renderPassDescriptor(
+      const RenderPassDescriptor &descriptor);
+
+  MTL::CommandBuffer *_pCommandBuffer = nullptr;
+  MetalRenderCommandEncoder _encoder;
+  MetalParallelRenderCommandEncoder _parallelEncoder;
+  MetalBlitCommandEncoder _blitEncoder;
+  // Reused for every pass instead of an autoreleased descriptor per frame;
+  // Metal copies it when the encoder is created.
+  NS::SharedPtr<MTL::RenderPassDescriptor> _pRenderPassDescriptor;
+};
+
+class MetalCommandQueue final : public CommandQueue {
+ public:
+  explicit MetalCommandQueue(NS::SharedPtr<MTL::CommandQueue> pCommandQueue);
+
+  using CommandQueue::commandBuffer;
+  CommandBuffer *commandBuffer(
+      const CommandBufferDescriptor &descriptor) override;
+
+ private:
+  NS::SharedPtr<MTL::CommandQueue> _pCommandQueue;
+  // Allocated once; only messaged again when retainedReferences changes.
+  NS::SharedPtr<MTL::CommandBufferDescriptor> _pCommandBufferDescriptor;
+  bool _retainedReferences = true;
+  MetalCommandBuffer _commandBuffer;
+};
+
+// Pipeline functions come from pLibrary, or without one from the app's
+// default library.
+class MetalDevice final : public Device {
+ public:
+  explicit MetalDevice(MTL::Device *pDevice, MTL::Library *pLibrary = nullptr)
+      : _pDevice(NS::RetainPtr(pDevice)),
+        _pLibrary(pLibrary != nullptr
+                      ? NS::RetainPtr(pLibrary)
+                      : NS::TransferPtr(pDevice->newDefaultLibrary())) {}
+
+  std::unique_ptr<CommandQueue> newCommandQueue() override;
+  std::unique_ptr<Buffer> newBuffer(std::size_t length) override;
+  SizeAndAlign heapBufferSizeAndAlign(std::size_t length) override;
+  std::unique_ptr<Heap> newHeap(std::size_t size) override;
+  std::unique_ptr<SharedEvent> newSharedEvent() override;
+  std::unique_ptr<IndirectCommandBuffer> newIndirectCommandBuffer(
+      const IndirectCommandBufferDescriptor &descriptor,
+      std::size_t maxCommandCount) override;
+  std::unique_ptr<RenderPipelineState> newRenderPipelineState(
+      const RenderPipelineDescriptor &descriptor) override;
+  std::unique_ptr<Texture> newTexture(std::uint32_t width,
+                                      std::uint32_t height,
+                                      PixelFormat pixelFormat) override;
+
+ private:
+  NS::SharedPtr<MTL::Device> _pDevice;
+  NS::SharedPtr<MTL::Library> _pLibrary;
+};
+
+// Adapts an MTK::View for the duration of one drawInMTKView callback.
+class MetalView final : public View {
+ public:
+  explicit MetalView(MTK::View *pView) : _pView(pView) {}
+
+  RenderPassDescriptor currentRenderPassDescriptor() override;
+  Drawable *currentDrawable() override;
+
+ private:
+  MTK::View *_pView;
+  std::optional<MetalDrawable> _drawable;
+};
+
+}  // namespace Gfx
@@ -16,6 +16,7 @@
  */
 #include <cassert>
 #include <iostream>
+#include <memory>
 
 #define NS_PRIVATE_IMPLEMENTATION
 #define MTL_PRIVATE_IMPLEMENTATION
@@ -24,83 +25,60 @@
 #include <AppKit/AppKit.hpp>
 // #include <AppKit/NSEvent.h>
 
+#include <Gfx/Renderer.hpp>
 #include <Metal/Metal.hpp>
 #include <MetalKit/MetalKit.hpp>
 
-class Renderer {
- public:
-  explicit Renderer(MTL::Device *pDevice) : _pDevice(pDevice->retain()) {
-    _pCommandQueue = _pDevice->newCommandQueue();
-  }
-  ~Renderer() {
-    _pCommandQueue->release();
-    _pDevice->release();
-  }
-
-  void draw(MTK::View *pView) {
-    NS::AutoreleasePool *pPool = NS::AutoreleasePool::alloc()->init();
-
-    MTL::CommandBuffer *pCmd = _pCommandQueue->commandBuffer();
-    MTL::RenderPassDescriptor *pRpd = pView->currentRenderPassDescriptor();
-    MTL::RenderCommandEncoder *pEnc = pCmd->renderCommandEncoder(pRpd);
-    pEnc->endEncoding();
-    pCmd->presentDrawable(pView->currentDrawable());
-    pCmd->commit();
-
-    pPool->release();
-  }
-
- private:
-  MTL::Device *_pDevice;
-  MTL::CommandQueue *_pCommandQueue;
-};
+#include "MetalBackend.hpp"
 
 class MyMTKViewDelegate : public MTK::ViewDelegate {
  public:
   explicit MyMTKViewDelegate(MTL::Device *pDevice)
-      : MTK::ViewDelegate(), _pRenderer(new Renderer(pDevice)) {}
-  ~MyMTKViewDelegate() override { delete _pRenderer; }
-  void drawInMTKView(MTK::View *pView) override { _pRenderer->draw(pView); }
+      : MTK::ViewDelegate(), _device(pDevice), _renderer(&_device) {}
+  void drawInMTKView(MTK::View *pView) override {
+    NS::ScopedAutoreleasePool pool;
+
+    Gfx::MetalView view(pView);
+    _renderer.draw(&view);
+  }
 
  private:
-  Renderer *_pRenderer;
+  Gfx::MetalDevice _device;
+  Gfx::Renderer _renderer;
 };
 
 class MyAppDelegate : public NS::ApplicationDelegate {
  public:
-  ~MyAppDelegate() override {
-    _pMtkView->release();
-    _pWindow->release();
-    _pDevice->release();
-    delete _pViewDelegate;
-  }
-
+  // Titles are constant strings; the only string this autoreleases is the
+  // quit item's, which has to be composed at run time.
   static NS::Menu *createMenuBar() {
-    using NS::StringEncoding::UTF8StringEncoding;
+    using NS::MakeConstantString;
 
     NS::Menu *pMainMenu = NS::Menu::alloc()->init();
-    NS::MenuItem *pAppMenuItem = NS::MenuItem::alloc()->init();
-    NS::Menu *pAppMenu = NS::Menu::alloc()->init(
-        NS::String::string("Appname", UTF8StringEncoding));
+    NS::SharedPtr<NS::MenuItem> pAppMenuItem =
+        NS::TransferPtr(NS::MenuItem::alloc()->init());
+    NS::SharedPtr<NS::Menu> pAppMenu = NS::TransferPtr(
+        NS::Menu::alloc()->init(MakeConstantString("Appname")));
 
     NS::String *appName =
         NS::RunningApplication::currentApplication()->localizedName();
-    NS::String *quitItemName = NS::String::string("Quit ", UTF8StringEncoding)
-                                   ->stringByAppendingString(appName);
+    NS::String *quitItemName =
+        MakeConstantString("Quit ")->stringByAppendingString(appName);
     SEL quitCb = NS::MenuItem::registerActionCallback(
         "appQuit", [](void *, SEL, const NS::Object *pSender) {
           auto *pApp = NS::Application::sharedApplication();
           pApp->terminate(pSender);
         });
 
-    NS::MenuItem *pAppQuitItem = pAppMenu->addItem(
-        quitItemName, quitCb, NS::String::string("q", UTF8StringEncoding));
+    NS::MenuItem *pAppQuitItem =
+        pAppMenu->addItem(quitItemName, quitCb, MakeConstantString("q"));
     pAppQuitItem->setKeyEquivalentModifierMask(NS::EventModifierFlagCommand);
-    pAppMenuItem->setSubmenu(pAppMenu);
+    pAppMenuItem->setSubmenu(pAppMenu.get());
 
-    NS::MenuItem *pWindowMenuItem = NS::MenuItem::alloc()->init();
-    NS::Menu *pWindowMenu = NS::Menu::alloc()->init(
-        NS::String::string("Window", UTF8StringEncoding));
+    NS::SharedPtr<NS::MenuItem> pWindowMenuItem =
+        NS::TransferPtr(NS::MenuItem::alloc()->init());
+    NS::SharedPtr<NS::Menu> pWindowMenu = NS::TransferPtr(
+        NS::Menu::alloc()->init(MakeConstantString("Window")));
 
     SEL closeWindowCb = NS::MenuItem::registerActionCallback(
         "windowClose", [](void *, SEL, const NS::Object *) {
@@ -108,8 +86,8 @@ class MyAppDelegate : public NS::ApplicationDelegate {
           pApp->windows()->object<NS::Window>(0)->close();
         });
     NS::MenuItem *pCloseWindowItem = pWindowMenu->addItem(
-        NS::String::string("Close Window", UTF8StringEncoding), closeWindowCb,
-        NS::String::string("w", UTF8StringEncoding));
+        MakeConstantString("Close Window"), closeWindowCb,
+        MakeConstantString("w"));
     pCloseWindowItem->setKeyEquivalentModifierMask(
         NS::EventModifierFlagCommand);
 
@@ -118,19 +96,13 @@ class MyAppDelegate : public NS::ApplicationDelegate {
           std::cout << "Foo" << std::endl;
         });
     NS::MenuItem *pFoo = pWindowMenu->addItem(
-        NS::String::string("Foo", UTF8StringEncoding), fooCb,
-        NS::String::string("f", UTF8StringEncoding));
+        MakeConstantString("Foo"), fooCb, MakeConstantString("f"));
     pFoo->setKeyEquivalentModifierMask(NS::EventModifierFlagCommand);
 
-    pWindowMenuItem->setSubmenu(pWindowMenu);
-
-    pMainMenu->addItem(pAppMenuItem);
-    pMainMenu->addItem(pWindowMenuItem);
+    pWindowMenuItem->setSubmenu(pWindowMenu.get());
 
-    pAppMenuItem->release();
-    pWindowMenuItem->release();
-    pAppMenu->release();
-    pWindowMenu->release();
+    pMainMenu->addItem(pAppMenuItem.get());
+    pMainMenu->addItem(pWindowMenuItem.get());
 
     return pMainMenu->autorelease();
   }
@@ -149,22 +121,22 @@ class MyAppDelegate : public NS::ApplicationDelegate {
     std::cout << "applicationDidFinishLaunching Start" << std::endl;
     CGRect frame = (CGRect){{100.0, 100.0}, {512.0, 512.0}};
 
-    _pWindow = NS::Window::alloc()->init(frame, NS::WindowStyleMaskBorderless,
-                                         NS::BackingStoreBuffered, false);
+    _pWindow = NS::TransferPtr(NS::Window::alloc()->init(
+        frame, NS::WindowStyleMaskBorderless, NS::BackingStoreBuffered, false));
 
-    _pDevice = MTL::CreateSystemDefaultDevice();
+    _pDevice = NS::TransferPtr(MTL::CreateSystemDefaultDevice());
 
-    _pMtkView = MTK::View::alloc()->init(frame, _pDevice);
+    _pMtkView =
+        NS::TransferPtr(MTK::View::alloc()->init(frame, _pDevice.get()));
     _pMtkView->setColorPixelFormat(
         MTL::PixelFormat::PixelFormatBGRA8Unorm_sRGB);
     _pMtkView->setClearColor(MTL::ClearColor::Make(1.0, 1.0, 0.0, 1.0));
 
-    _pViewDelegate = new MyMTKViewDelegate(_pDevice);
-    _pMtkView->setDelegate(_pViewDelegate);
+    _pViewDelegate = std::make_unique<MyMTKViewDelegate>(_pDevice.get());
+    _pMtkView->setDelegate(_pViewDelegate.get());
 
-    _pWindow->setContentView(_pMtkView);
-    _pWindow->setTitle(NS::String::string(
-        "00 - Window", NS::StringEncoding::UTF8StringEncoding));
+    _pWindow->setContentView(_pMtkView.get());
+    _pWindow->setTitle(NS::MakeConstantString("00 - Window"));
 
     _pWindow->makeKeyAndOrderFront(nullptr);
 
@@ -180,15 +152,17 @@ class MyAppDelegate : public NS::ApplicationDelegate {
   }
 
  private:
-  NS::Window *_pWindow{};
+  // Declared first so the view delegate outlives the view that points at it.
+  std::unique_ptr<MyMTKViewDelegate> _pViewDelegate;
 
-  MTK::View *_pMtkView{};
-  MTL::Device *_pDevice{};
-  MyMTKViewDelegate *_pViewDelegate = nullptr;
+  NS::SharedPtr<NS::Window> _pWindow;
+
+  NS::SharedPtr<MTK::View> _pMtkView;
+  NS::SharedPtr<MTL::Device> _pDevice;
 };
 
 int main([[maybe_unused]] int argc, [[maybe_unused]] char *argv[]) {
-  NS::AutoreleasePool *pAutoreleasePool = NS::AutoreleasePool::alloc()->init();
+  NS::ScopedAutoreleasePool pool;
 
   MyAppDelegate del;
 
@@ -197,7 +171,5 @@ int main([[maybe_unused]] int argc, [[maybe_unused]] char *argv[]) {
   pSharedApplication->setDelegate(&del);
   pSharedApplication->run();
 
-  pAutoreleasePool->release();
-
   return 0;
 }